@@ -1,4 +1,3 @@
-
 #include "atmosphere.glsl"
 
 in INTERFACE {
@@ -6,23 +5,50 @@ in INTERFACE {
 } In ;
 
 uniform mat4 clipToWorld; ///< Clip-to-world space transformation matrix.
-uniform vec3 viewPos; ///< The position in view space.
 uniform vec3 lightDirection; ///< The light direction in world space.
 uniform float altitude; ///< height above the planet surface.
 uniform AtmosphereParameters atmoParams; ///< Custom atmosphere parameters.
-layout(binding = 0) uniform sampler2D precomputedScattering; ///< Secondary scattering lookup table.
+layout(binding = 0) uniform sampler2D skyView; ///< Precomputed sky radiance for the current sun direction and altitude.
+layout(binding = 1) uniform sampler2D transmittanceTable; ///< Transmittance lookup table.
 
 layout(location = 0) out vec3 fragColor; ///< Atmosphere color.
 
-/** Simulate sky color based on an atmospheric scattering approximate model. */
+/** Read a lookup table, with the first and last texel centers at 0 and 1.
+	\param table the table to read
+	\param uv the normalized coordinates
+	\return the filtered value
+*/
+vec3 sampleTable(sampler2D table, vec2 uv){
+	vec2 size = vec2(textureSize(table, 0));
+	return textureLod(table, (clamp(uv, 0.0, 1.0) * (size - 1.0) + 0.5) / size, 0.0).rgb;
+}
+
+/** Simulate sky color based on an atmospheric scattering model, using precomputed tables (see AtmosphereTables). */
 void main(){
 	// Move to -1,1
 	vec4 clipVertex = vec4(-1.0+2.0*In.uv, 0.0, 1.0);
 	// Then to world space.
 	vec3 viewRay = normalize((clipToWorld * clipVertex).xyz);
-	// We then move to the ground model space, where the ground is at y=0.
-	vec3 groundSpaceViewPos = viewPos + vec3(0.0, altitude, 0.0);
-	vec3 atmosphereColor = computeAtmosphereRadiance(groundSpaceViewPos, viewRay, lightDirection, precomputedScattering, atmoParams);
-	fragColor = atmosphereColor;
-}
 
+	// Viewer distance to the planet center and horizon, as used when computing the sky-view table.
+	float radius = atmoParams.groundRadius + clamp(altitude, 1.0, atmoParams.topRadius - atmoParams.groundRadius - 1.0);
+	float horizon = M_PI - asin(atmoParams.groundRadius / radius);
+
+	// Azimuth relative to the sun, the sky is symmetric on each side.
+	vec3 sunHorizontal = vec3(lightDirection.x, 0.0, lightDirection.z);
+	vec3 sunForward = length(sunHorizontal) > 1e-4 ? normalize(sunHorizontal) : vec3(1.0, 0.0, 0.0);
+	vec3 sunSide = cross(vec3(0.0, 1.0, 0.0), sunForward);
+	float azimuth = atan(abs(dot(viewRay, sunSide)), dot(viewRay, sunForward));
+	// Zenith angle, with square root mappings on each side of the horizon.
+	float zenith = acos(clamp(viewRay.y, -1.0, 1.0));
+	float v = zenith < horizon ? (0.5 - 0.5 * sqrt(max(1.0 - zenith / horizon, 0.0))) : (0.5 + 0.5 * sqrt(max((zenith - horizon) / (M_PI - horizon), 0.0)));
+	vec3 radiance = atmoParams.sunIntensity * sampleTable(skyView, vec2(azimuth / M_PI, v));
+
+	// The sun itself if we're looking at it and it's not hidden by the ground.
+	if(zenith < horizon && dot(viewRay, lightDirection) > atmoParams.sunAngularRadiusCos){
+		float relativeHeight = (radius - atmoParams.groundRadius) / (atmoParams.topRadius - atmoParams.groundRadius);
+		vec3 sunTransmittance = sampleTable(transmittanceTable, vec2(relativeHeight, 0.5 - 0.5 * viewRay.y));
+		radiance += sunTransmittance * atmoParams.sunColor / (M_PI * atmoParams.sunAngularRadius * atmoParams.sunAngularRadius);
+	}
+	fragColor = radiance;
+}
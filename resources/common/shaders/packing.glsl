@@ -0,0 +1,36 @@
+
+/** Decode a unit vector stored with an octahedral mapping.
+	\param e the encoded vector, in [-1,1]
+	\return the decoded unit vector
+*/
+vec3 decodeOctahedral(vec2 e){
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	// Unfold the lower hemisphere.
+	if(v.z < 0.0){
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(v);
+}
+
+/** Retrieve the local frame of a vertex, either from full precision attributes or from packed ones.
+	Packed attributes are used if no full precision normal is bound (the attribute then reads as zero).
+	\param n the full precision normal
+	\param tang the full precision tangent
+	\param binor the full precision binormal
+	\param packedNormal the octahedral normal
+	\param packedTangent the octahedral tangent, with the binormal sign in the fourth component
+	\param normal will contain the normal
+	\param tangent will contain the tangent
+	\param binormal will contain the binormal
+*/
+void decodeFrame(vec3 n, vec3 tang, vec3 binor, vec2 packedNormal, vec4 packedTangent, out vec3 normal, out vec3 tangent, out vec3 binormal){
+	if(dot(n, n) > 0.0){
+		normal = n;
+		tangent = tang;
+		binormal = binor;
+		return;
+	}
+	normal = decodeOctahedral(packedNormal);
+	tangent = decodeOctahedral(packedTangent.xy);
+	binormal = (packedTangent.w < 0.0 ? -1.0 : 1.0) * cross(normal, tangent);
+}
@@ -1,13 +1,11 @@
 
 in INTERFACE {
 	vec2 uv; ///< Texture coordinates.
+	flat vec4 color; ///< The inner glyph color.
+	flat vec4 edgeColor; ///< The outer glyph color.
+	flat float edgeWidth; ///< The outer edge width.
 } In ;
 
-uniform vec4 color; ///< The inner glyph color.
-uniform vec4 edgeColor; ///< The outer glyph color.
-uniform float edgeWidth = 0.0f;  ///< The outer edge width
-
-
 layout(binding = 0) uniform sampler2D fontSdfTexture; ///< The font signed-distance-function atlas.
 layout(location = 0) out vec4 fragColor; ///< Color.
 
@@ -15,11 +13,11 @@ layout(location = 0) out vec4 fragColor; ///< Color.
 void main(){
 	// Flip to [1, -1], where > 0 is outside.
 	float fontDistance = 1.0-2.0*texture(fontSdfTexture, In.uv).r;
-	if(fontDistance > edgeWidth){
+	if(fontDistance > In.edgeWidth){
 		discard;
 	} else if(fontDistance > 0.0){
-		fragColor = edgeColor;
+		fragColor = In.edgeColor;
 	} else {
-		fragColor = color;
+		fragColor = In.color;
 	}
 }
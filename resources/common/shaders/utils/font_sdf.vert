@@ -1,19 +1,32 @@
 
-// Attributes
-layout(location = 0) in vec3 v;///< Position.
-layout(location = 2) in vec2 uv;///< Uv coordinates.
-
 uniform float ratio = 1.0f; ///< The screen aspect ratio.
-uniform vec2 position; ///< The position of the anchor point on screen.
+
+layout(binding = 1) uniform samplerBuffer glyphs; ///< Glyphs data, five texels per glyph (see TextBatch).
 
 out INTERFACE {
 	vec2 uv; ///< Texture coordinates.
+	flat vec4 color; ///< The inner glyph color.
+	flat vec4 edgeColor; ///< The outer glyph color.
+	flat float edgeWidth; ///< The outer edge width.
 } Out ;
 
 
-/** Compute the 2D position of the glyph on screen. */
+/** Compute the 2D position of the glyph corner on screen, two triangles per glyph. */
 void main(){
-	gl_Position.xy = position + v.xy * vec2(ratio, 1.0);
+	int glyph = gl_VertexID / 6;
+	int vertex = gl_VertexID % 6;
+	// Corners (0,0), (1,0), (1,1) then (0,0), (1,1), (0,1).
+	vec2 corner = vec2(vertex == 1 || vertex == 2 || vertex == 4, vertex == 2 || vertex == 4 || vertex == 5);
+
+	vec4 corners = texelFetch(glyphs, 5 * glyph);
+	vec4 uvs = texelFetch(glyphs, 5 * glyph + 1);
+	vec4 anchorAndEdge = texelFetch(glyphs, 5 * glyph + 4);
+
+	vec2 v = mix(corners.xy, corners.zw, corner);
+	gl_Position.xy = anchorAndEdge.xy + v * vec2(ratio, 1.0);
 	gl_Position.zw = vec2(1.0);
-	Out.uv = uv ;
+	Out.uv = mix(uvs.xy, uvs.zw, corner);
+	Out.color = texelFetch(glyphs, 5 * glyph + 2);
+	Out.edgeColor = texelFetch(glyphs, 5 * glyph + 3);
+	Out.edgeWidth = anchorAndEdge.z;
 }
@@ -1,14 +1,18 @@
+#include "terrain_clipmap.glsl"
+
 in INTERFACE {
 	vec3 pos; ///< World position
 	vec2 uv; ///< Texture coordinates
+	vec2 mapPos; ///< Position in map texels.
+	float lod; ///< Clipmap level of detail.
 } In ;
 
 uniform vec3 lightDirection; ///< Sun light direction.
 uniform bool debugCol; ///< Use debug color instead of shading.
 uniform vec3 camPos; ///< Camera world position.
 
-layout(binding=0) uniform sampler2D heightMap; ///< Terrain height map, height in R, normals in GBA.
-layout(binding=1) uniform sampler2D shadowMap; ///<Terrain shadowing factor, ground level in R, water level in G.
+layout(binding=0) uniform sampler2DArray heightMap; ///< Terrain height clipmap, height in R, normals in GBA.
+layout(binding=1) uniform sampler2DArray shadowMap; ///<Terrain shadowing clipmap, ground level in R, water level in G.
 layout(binding=2) uniform sampler2D surfaceNoise; ///< Noise surface normal map.
 layout(binding=3) uniform sampler2D glitterNoise; ///< Noise specular map.
 layout(binding=4) uniform sampler2D sandMapSteep; ///< Normal map for steep dunes.
@@ -23,7 +27,7 @@ void main(){
 	fragWorldPos = In.pos;
 
 	// Get clean normal and height.
-	vec4 heightAndNor = textureLod(heightMap, In.uv, 0.0);
+	vec4 heightAndNor = terrainSample(heightMap, In.mapPos, In.lod);
 	vec3 n = normalize(heightAndNor.yzw);
 	vec3 v = normalize(camPos - fragWorldPos);
 
@@ -53,7 +57,7 @@ void main(){
 	vec3 finalN = normalize(vec3(nMap.xy + surfN.xy, nMap.z*surfN.z));
 
 	// Shadow
-	float shadow = textureLod(shadowMap, In.uv, 0.0).r;
+	float shadow = terrainSample(shadowMap, In.mapPos, In.lod).r;
 	
 	// Colors.
 	float colorBlend = texture(surfaceNoise, 150.0*(In.uv + vec2(0.73, 0.19))).a;
@@ -1,49 +1,54 @@
+#include "terrain_clipmap.glsl"
+
+#define TERRAIN_PATCHES_MAX 100
 
 // Attributes
-layout(location = 0) in vec3 v; ///< Position.
+layout(location = 0) in vec3 v; ///< Position in the patch.
 
 uniform mat4 mvp; ///< MVP transformation matrix.
-uniform vec3 shift; ///< Terrain shift in world space.
-uniform float texelSize; ///< Height map texel world size.
-uniform float invMapSize; ///< Height map inverse size.
-uniform float invGridSize; ///< Grid mesh inverse size.
+uniform vec3 shift; ///< Grid center in world space.
+uniform float patchSize; ///< Number of grid squares along a patch side.
+uniform int maxLevel; ///< Coarsest grid level.
+
+layout(binding=0) uniform sampler2DArray heightMap; ///< Terrain height clipmap, height in R, normals in GBA.
 
-layout(binding=0) uniform sampler2D heightMap; ///< Terrain height map, height in R, normals in GBA.
+/** Visible patches placement. */
+layout(std140, binding = 0) uniform Patches {
+	vec4 patches[TERRAIN_PATCHES_MAX]; ///< Origin relative to the grid center in map texels, grid level.
+};
 
 out INTERFACE {
 	vec3 pos; ///< World position.
 	vec2 uv; ///< Texture coordinates.
+	vec2 mapPos; ///< Position in map texels.
+	float lod; ///< Clipmap level of detail.
 } Out ;
 
-/** Apply the transformation to the input vertex.
-  Compute the tangent-to-view space transformation matrix.
- */
+/** Apply the transformation to the input vertex, morphing towards the coarser grid level at the border of each ring, and read the terrain height. */
 void main(){
 
-	// Compute discretization level to move grid in lockstep.
-	float levelSize = exp2(v.y) * texelSize;
-	vec3 worldPos = texelSize * v + round(shift/levelSize)*levelSize;
-
-	// Compute LOD level to read from the heightmap.
-	vec2 dpos = abs(worldPos.xz - shift.xz);
-	float tsize = max(0.5, max(dpos.x, dpos.y) * 2.0 * invGridSize);
-	float fetchLod = max(log2(tsize) - 0.75, 0.0);
-	float baseLod = floor(fetchLod);
-	float nextLod = baseLod + 1.0;
-	float fracLod = fetchLod - baseLod;
-	// Half texel offset, to only read inbetween texels.
-	float halfTexNext = exp2(baseLod);
-	float halfTexBase = halfTexNext*0.5;
-	// Shifted UVs.
-	vec2 uv = (worldPos.xz/texelSize);
-	vec2 baseCoords = (uv + halfTexBase) * invMapSize + 0.5;
-	vec2 nextCoords = (uv + halfTexNext) * invMapSize + 0.5;
-	// Custom trilinear 
-	float lowHeight = textureLod(heightMap, baseCoords, baseLod).r;
-	float nextHeight = textureLod(heightMap, nextCoords, nextLod).r;
-	// Final height and projected position.
-	worldPos.y = mix(lowHeight, nextHeight, fracLod);
-    gl_Position = mvp * vec4(worldPos, 1.0);
-	Out.uv = (uv + 0.5) * invMapSize + 0.5;
+	vec4 instance = patches[gl_InstanceID];
+	float level = instance.z;
+	float levelSize = exp2(level);
+	// Position relative to the grid center, in map texels.
+	vec2 gridPos = instance.xy + levelSize * v.xz;
+
+	// Morph to the coarser level when approaching the outer border of the ring.
+	float ringRadius = 2.0 * patchSize * levelSize;
+	float dist = max(abs(gridPos.x), abs(gridPos.y)) / ringRadius;
+	float morph = int(level) < maxLevel ? smoothstep(0.8, 1.0, dist) : 0.0;
+	vec2 coarseSize = vec2(2.0 * levelSize);
+	gridPos -= fract(gridPos / coarseSize) * coarseSize * morph;
+
+	vec3 worldPos = shift + vec3(gridPos.x, 0.0, gridPos.y) * terrainTexelSize;
+	vec2 mapPos = terrainMapPosition(worldPos.xz);
+	// Read the height from the matching clipmap level, or a coarser one if the viewer window doesn't cover the vertex yet.
+	float lod = max(level + morph, terrainMinLod(mapPos));
+	worldPos.y = terrainSample(heightMap, mapPos, lod).r;
+
+	gl_Position = mvp * vec4(worldPos, 1.0);
+	Out.uv = (mapPos + 0.5) / terrainSize;
+	Out.mapPos = mapPos;
+	Out.lod = lod;
 	Out.pos = worldPos;
 }
@@ -1,5 +1,6 @@
 
 #include "gerstner_waves.glsl"
+#include "terrain_clipmap.glsl"
 
 in INTERFACE {
 	vec3 pos; ///< World position.
@@ -14,8 +15,6 @@ uniform bool distantProxy; ///< Are we currently rendering the distant proxy.
 uniform vec2 invTargetSize; ///< Destination framebuffer size.
 uniform float waterGridHalf; ///< Half-size of the water grid.
 uniform float groundGridHalf; ///< Half-size of the terrain grid.
-uniform float invTexelSize; ///< Size of a terrain map texel in world space.
-uniform float invMapSize; ///< Inverse terrain map size.
 uniform bool underwater; ///< Is the camera underwater.
 uniform bool useTerrain; ///< Is the terrain currently renderer (for shadows)
 
@@ -27,7 +26,7 @@ layout(binding = 4) uniform sampler2D absorpScatterLUT; ///< Ocean absorption/sc
 layout(binding = 5) uniform sampler2D waveNormals; ///< Waves normal map.
 layout(binding = 6) uniform samplerCube envmap; ///< Environment map.
 layout(binding = 7) uniform sampler2D brdfCoeffs; ///< Linearized BRDF look-up table.
-layout(binding = 8) uniform sampler2D shadowMap; ///< Terrain shadow map (ocean level in the G channel).
+layout(binding = 8) uniform sampler2DArray shadowMap; ///< Terrain shadow clipmap (ocean level in the G channel).
 
 /** Gerstner waves parameters. */
 layout(std140, binding = 0) uniform Waves {
@@ -162,10 +161,11 @@ void main(){
 	float specularShadow = 1.0;
 	float diffuseShadow = 1.0;
 	if(!distantProxy || aroundIsland){
-		// Compute heightmap UV and read shadow map.
+		// Read the shadow clipmap.
 		// The second channel contains shadowing computed for an initial height of 0.0, the ocean plane.
-		vec2 uvGround = ((worldPos.xz * invTexelSize) + 0.5) * invMapSize;
-		float shadow = useTerrain ? textureLod(shadowMap, uvGround + 0.5, 0.0).g : 1.0;
+		vec2 mapPos = terrainMapPosition(worldPos.xz);
+		float shadow = useTerrain ? terrainSample(shadowMap, mapPos, terrainMinLod(mapPos)).g : 1.0;
+		vec2 uvGround = mapPos / terrainSize - 0.5;
 		// Attenuate on edges.
 		float attenShadow = smoothstep(0.05, 0.25, (dot(uvGround, uvGround)));
 		specularShadow = mix(shadow, 1.0, attenShadow);
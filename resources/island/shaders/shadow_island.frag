@@ -1,19 +1,21 @@
+#include "terrain_clipmap.glsl"
 
 in INTERFACE {
 	vec2 uv; ///< UV coordinates.
 } In ;
 
 uniform vec3 lDir; ///< Light direction.
-uniform uint stepCount; ///< Raymarching step count.
-uniform float texelSize; ///< Size of a texel in world space.
+uniform int level; ///< Clip level to generate.
+uniform float maxHeight; ///< Maximum terrain height.
 
-layout(binding = 0) uniform sampler2D heightMap; ///< Height map.
+layout(binding = 0) uniform sampler2DArray heightMap; ///< Height clipmap.
 
 layout(location = 0) out vec2 shadow; ///< Shadowing factors.
 
-/** Ray-march against the height map to determine shadows at sea and ground level.*/
+/** Ray-march against the height clipmap to determine shadows at sea and ground level, for one clip level.
+ Steps grow with the texel size of the coarser levels traversed. */
 void main(){
-	
+
 	if(lDir.y >= 0.999){
 		// Vertical sun, no shadowing.
 		shadow = vec2(1.0);
@@ -24,38 +26,45 @@ void main(){
 		return;
 	}
 
-	vec2 wh = textureSize(heightMap, 0).xy;
-	float hStart = textureLod(heightMap, In.uv, 0.0).r;
-
-	// Compute ray height.
-	bool occGround = false;
-	bool occWater = false;
-	vec2 texSize = wh * texelSize;
-	vec2 initPosPlane = texSize * (In.uv - 0.5);
-	vec3 initPos = vec3(initPosPlane.x, hStart, initPosPlane.y);
-
-	for(uint i = 0; i < stepCount; ++i){
-		// Jut step based on 3D dir.
-		vec3 pos = initPos + (float(i)) * texelSize * lDir;
-		// Reproject onto the texture plane.
-		vec2 grPos = pos.xz / texSize + 0.5;
-		if(any(lessThan(grPos, vec2(0.0))) || any(greaterThanEqual(grPos, vec2(1.0)))){
+	// Find the map texel stored in the current clip level texel, with toroidal addressing.
+	vec4 window = clipWindows[level];
+	vec2 first = window.xy / window.z;
+	vec2 slot = floor(In.uv * clipSize);
+	vec2 mapPos = (first + mod(slot - first, clipSize)) * window.z;
+	float hStart = terrainFetch(heightMap, mapPos, level).r;
+
+	// Soft shadows, estimated from the closest approach of the ray to the terrain.
+	const float softness = 16.0;
+	float occGround = 1.0;
+	float occWater = 1.0;
+	float horizontal = max(length(lDir.xz), 1e-4);
+	vec2 mapDir = lDir.xz / terrainTexelSize;
+	float t = 0.0;
+
+	for(int i = 0; i < 512; ++i){
+		// Advance by a texel of the finest level available, in world space.
+		int stepLevel = terrainLevel(mapPos + t * mapDir, level);
+		t += clipWindows[stepLevel].z * terrainTexelSize / horizontal;
+		vec2 grPos = mapPos + t * mapDir;
+		if(any(lessThan(grPos, vec2(0.0))) || any(greaterThanEqual(grPos, vec2(terrainSize)))){
 			break;
 		}
-		// Read corresponding height and compare, for both the ground and water height.
-		float hRef = textureLod(heightMap, grPos, 0.0).r;
-		if(pos.y < hRef){
-			occGround = true;
-		}
-		if(pos.y - hStart < hRef){
-			occWater = true;
+		// Both rays are above the terrain, stop.
+		float hGround = hStart + t * lDir.y;
+		float hWater = t * lDir.y;
+		if(min(hGround, hWater) > maxHeight){
+			break;
 		}
-		if(occGround && occWater){
+		// Read corresponding height and compare, for both the ground and water height.
+		float hRef = terrainFetch(heightMap, grPos, terrainLevel(grPos, level)).r;
+		occGround = min(occGround, softness * (hGround - hRef) / t);
+		occWater = min(occWater, softness * (hWater - hRef) / t);
+		if(occGround <= 0.0 && occWater <= 0.0){
 			break;
 		}
 	}
 	// Modulate when getting close to the horizon.
 	float modu = min((lDir.y - -0.06)/0.06, 1.0);
-	shadow.x = modu * float(!occGround);
-	shadow.y = modu * float(!occWater);
+	shadow.x = modu * clamp(occGround, 0.0, 1.0);
+	shadow.y = modu * clamp(occWater, 0.0, 1.0);
 }
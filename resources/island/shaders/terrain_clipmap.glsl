@@ -0,0 +1,88 @@
+
+#define TERRAIN_LEVELS_MAX 8
+
+uniform vec4 clipWindows[TERRAIN_LEVELS_MAX]; ///< Clip level windows: first texel in map texels, level texel size (0 if unavailable).
+uniform int clipLevels; ///< Number of clip levels.
+uniform float clipSize; ///< Size of a clip level, in texels.
+uniform float terrainSize; ///< Size of the terrain map, in texels.
+uniform float terrainTexelSize; ///< Size of a terrain map texel in world space.
+
+/** Convert a world space position to terrain map texel coordinates.
+ \param worldXZ the position in the horizontal plane
+ \return the position in map texels
+ */
+vec2 terrainMapPosition(vec2 worldXZ){
+	return worldXZ / terrainTexelSize + 0.5 * terrainSize;
+}
+
+/** Estimate how far a position is from the border of a clip level window.
+ \param mapPos the position in map texels
+ \param level the clip level
+ \return a value in [0,1] inside the window, reaching 1 at its border, larger outside or if the level is unavailable.
+ */
+float clipDistance(vec2 mapPos, int level){
+	vec4 window = clipWindows[level];
+	if(window.z == 0.0){
+		return 2.0;
+	}
+	// Keep a margin for bilinear filtering.
+	float halfSize = 0.5 * clipSize - 2.0;
+	vec2 center = window.xy / window.z + 0.5 * clipSize - 0.5;
+	vec2 delta = abs(mapPos / window.z - center);
+	return max(delta.x, delta.y) / halfSize;
+}
+
+/** Find the finest available clip level containing a position.
+ \param mapPos the position in map texels
+ \param minLevel the finest level to consider
+ \return the clip level
+ */
+int terrainLevel(vec2 mapPos, int minLevel){
+	for(int level = minLevel; level < clipLevels - 1; ++level){
+		if(clipDistance(mapPos, level) < 1.0){
+			return level;
+		}
+	}
+	return clipLevels - 1;
+}
+
+/** Compute the minimal level of detail usable at a position, transitioning smoothly before the border of each window.
+ \param mapPos the position in map texels
+ \return the fractional level of detail
+ */
+float terrainMinLod(vec2 mapPos){
+	int level = terrainLevel(mapPos, 0);
+	if(level == clipLevels - 1){
+		return float(level);
+	}
+	return float(level) + smoothstep(0.8, 1.0, clipDistance(mapPos, level));
+}
+
+/** Sample a clip level of a terrain texture at a given position.
+ \param map the clipmap texture array
+ \param mapPos the position in map texels
+ \param level the clip level
+ \return the filtered value
+ */
+vec4 terrainFetch(sampler2DArray map, vec2 mapPos, int level){
+	// Toroidal addressing, the texture wraps around.
+	vec2 uv = (mapPos / clipWindows[level].z + 0.5) / clipSize;
+	return textureLod(map, vec3(uv, float(level)), 0.0);
+}
+
+/** Sample a terrain texture at a given position and level of detail, blending between clip levels.
+ \param map the clipmap texture array
+ \param mapPos the position in map texels
+ \param lod the fractional level of detail
+ \return the filtered value
+ */
+vec4 terrainSample(sampler2DArray map, vec2 mapPos, float lod){
+	int level = terrainLevel(mapPos, int(floor(max(lod, 0.0))));
+	int nextLevel = terrainLevel(mapPos, min(level + 1, clipLevels - 1));
+	float blend = clamp(lod - float(level), 0.0, 1.0);
+	vec4 base = terrainFetch(map, mapPos, level);
+	if(blend == 0.0 || nextLevel == level){
+		return base;
+	}
+	return mix(base, terrainFetch(map, mapPos, nextLevel), blend);
+}
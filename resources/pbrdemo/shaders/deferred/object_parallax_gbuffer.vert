@@ -1,3 +1,4 @@
+#include "packing.glsl"
 
 // Attributes
 layout(location = 0) in vec3 v; ///< Position.
@@ -5,6 +6,8 @@ layout(location = 1) in vec3 n; ///< Normal.
 layout(location = 2) in vec2 uv; ///< Texture coordinates.
 layout(location = 3) in vec3 tang; ///< Tangent.
 layout(location = 4) in vec3 binor; ///< Binormal.
+layout(location = 6) in vec2 packedNormal; ///< Octahedral normal (packed layout).
+layout(location = 7) in vec4 packedTangent; ///< Octahedral tangent and binormal sign (packed layout).
 
 uniform mat4 mvp; ///< MVP transformation matrix.
 uniform mat4 mv; ///< MV transformation matrix.
@@ -28,9 +31,11 @@ void main(){
 	Out.uv = uv;
 
 	// Compute the TBN matrix (from tangent space to view space).
-	vec3 T = normalize(normalMatrix * tang);
-	vec3 B = normalize(normalMatrix * binor);
-	vec3 N = normalize(normalMatrix * n);
+	vec3 vn, vt, vb;
+	decodeFrame(n, tang, binor, packedNormal, packedTangent, vn, vt, vb);
+	vec3 T = normalize(normalMatrix * vt);
+	vec3 B = normalize(normalMatrix * vb);
+	vec3 N = normalize(normalMatrix * vn);
 	Out.tbn = mat3(T, B, N);
 	
 	Out.viewSpacePosition = (mv * vec4(v,1.0)).xyz;
@@ -6,7 +6,7 @@
 #define DIRECTIONAL 1
 #define SPOT 2
 
-#define MAX_LIGHTS_COUNT 50
+#define GPU_LIGHT_SIZE 9
 
 /** \brief Represent a light in the forward renderer. */
 struct GPULight {
@@ -18,6 +18,39 @@ struct GPULight {
 	vec4 angles; ///< Cone inner and outer angles.
 };
 
+/** Read a light information from the lights buffer.
+ \param lightsData the lights buffer, storing each light as a series of GPU_LIGHT_SIZE consecutive texels
+ \param lid the index of the light
+ \return the light information
+ */
+GPULight fetchLight(samplerBuffer lightsData, int lid){
+	int base = GPU_LIGHT_SIZE * lid;
+	GPULight light;
+	light.viewToLight = mat4(texelFetch(lightsData, base), texelFetch(lightsData, base + 1), texelFetch(lightsData, base + 2), texelFetch(lightsData, base + 3));
+	light.colorAndBias = texelFetch(lightsData, base + 4);
+	light.positionAndRadius = texelFetch(lightsData, base + 5);
+	light.directionAndPlane = texelFetch(lightsData, base + 6);
+	light.typeModeLayer = texelFetch(lightsData, base + 7);
+	light.angles = texelFetch(lightsData, base + 8);
+	return light;
+}
+
+/** Find the cluster containing a point and return the range of lights affecting it.
+ \param clusters the clusters buffer, storing the offset and count of the lights of each cluster
+ \param clustersSize the number of clusters along each axis
+ \param clustersParams scale and bias to apply to the logarithm of the view depth to obtain the cluster slice
+ \param screenUV the point screen coordinates, in [0,1]
+ \param viewDepth the point view space depth (positive)
+ \return the offset of the first light index in the indices buffer, and the number of lights
+ */
+uvec2 clusterLights(usamplerBuffer clusters, ivec3 clustersSize, vec2 clustersParams, vec2 screenUV, float viewDepth){
+	int slice = int(floor(log(max(viewDepth, 1e-4)) * clustersParams.x - clustersParams.y));
+	ivec3 cluster = ivec3(ivec2(screenUV * vec2(clustersSize.xy)), slice);
+	cluster = clamp(cluster, ivec3(0), clustersSize - 1);
+	int cid = (cluster.z * clustersSize.y + cluster.y) * clustersSize.x + cluster.x;
+	return texelFetch(clusters, cid).rg;
+}
+
 /** Compute a light contribution for a given point in forward shading.
  \param light the light information
  \param viewSpacePos the point position in view space
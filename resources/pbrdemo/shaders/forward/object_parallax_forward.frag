@@ -33,11 +33,11 @@ uniform float maxLod; ///< Mip level count for background map.
 uniform mat4 p; ///< Projection matrix.
 uniform vec2 invScreenSize; ///< Destination size.
 
-uniform int lightsCount; ///< Number of active lights.
-/// Store the lights in a continuous buffer (UBO).
-layout(std140, binding = 0) uniform Lights {
-	GPULight lights[MAX_LIGHTS_COUNT];
-};
+layout(binding = 9) uniform samplerBuffer lightsData; ///< Lights data.
+layout(binding = 10) uniform usamplerBuffer clusters; ///< Offset and count of the lights of each cluster.
+layout(binding = 11) uniform usamplerBuffer lightIndices; ///< Lights indices, grouped by cluster.
+uniform ivec3 clustersSize; ///< Number of clusters along each axis.
+uniform vec2 clustersParams; ///< Scale and bias to compute a cluster slice from a view depth.
 
 layout (location = 0) out vec4 fragColor; ///< Ambient contribution.
 
@@ -100,18 +100,20 @@ void main(){
 	// Normalized diffuse contribution. Metallic materials have no diffuse contribution.
 	vec3 diffuseL = INV_M_PI * (1.0 - metallic) * baseColor * (1.0 - F0);
 
-	for(int lid = 0; lid < MAX_LIGHTS_COUNT; ++lid){
-		if(lid >= lightsCount){
-			break;
-		}
+	vec2 screenUV = gl_FragCoord.xy * invScreenSize;
+	// Only iterate over the lights affecting the fragment cluster.
+	uvec2 lightsRange = clusterLights(clusters, clustersSize, clustersParams, screenUV, -newViewSpacePosition.z);
+	for(uint i = 0u; i < lightsRange.y; ++i){
+		int lid = int(texelFetch(lightIndices, int(lightsRange.x + i)).r);
+		GPULight light = fetchLight(lightsData, lid);
 		float shadowing;
 		vec3 l;
-		if(!applyLight(lights[lid], newViewSpacePosition, shadowMapsCube, shadowMaps2D, l, shadowing)){
+		if(!applyLight(light, newViewSpacePosition, shadowMapsCube, shadowMaps2D, l, shadowing)){
 			continue;
 		}
 		// Orientation: basic diffuse shadowing.
 		float orientation = max(0.0, dot(l,n));
 		vec3 specularL = ggx(n, v, l, F0, roughness);
-		fragColor.rgb += shadowing * orientation * (diffuseL + specularL) * lights[lid].colorAndBias.rgb;
+		fragColor.rgb += shadowing * orientation * (diffuseL + specularL) * light.colorAndBias.rgb;
 	}
 }
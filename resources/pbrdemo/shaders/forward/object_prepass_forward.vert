@@ -1,8 +1,10 @@
+#include "packing.glsl"
 
 // Attributes
 layout(location = 0) in vec3 v; ///< Position.
 layout(location = 1) in vec3 n; ///< Normal.
 layout(location = 2) in vec2 uv; ///< Texture coordinates.
+layout(location = 6) in vec2 packedNormal; ///< Octahedral normal (packed layout).
 
 uniform mat4 mvp; ///< MVP transformation matrix.
 uniform mat3 normalMatrix; ///< Normal transformation matrix.
@@ -20,6 +22,8 @@ void main(){
 	gl_Position = mvp * vec4(v, 1.0);
 
 	Out.uv = hasUV ? uv : vec2(0.5);
-	Out.n = normalize(normalMatrix * n);
+	// Fall back to the packed normal if the full precision one is not bound.
+	vec3 vn = dot(n, n) > 0.0 ? n : decodeOctahedral(packedNormal);
+	Out.n = normalize(normalMatrix * vn);
 	
 }
@@ -9,11 +9,12 @@
 #include "system/System.hpp"
 #include "generation/Random.hpp"
 #include "system/Config.hpp"
+#include "system/Query.hpp"
 #include "Common.hpp"
 
 #include "AtmosphereApp.hpp"
 
-AtmosphereApp::AtmosphereApp(RenderingConfig & config) : CameraApp(config), _scattering("Scattering LUT") {
+AtmosphereApp::AtmosphereApp(RenderingConfig & config) : CameraApp(config), _transmittance("Transmittance LUT"), _skyView("Sky view LUT") {
 	_userCamera.projection(config.screenResolution[0] / config.screenResolution[1], 1.34f, 0.1f, 100.0f);
 	// Framebuffer to store the rendered atmosphere result before tonemapping and upscaling to the window size.
 	const glm::vec2 renderRes = _config.renderingResolution();
@@ -24,7 +25,7 @@ AtmosphereApp::AtmosphereApp(RenderingConfig & config) : CameraApp(config), _sca
 	_tonemap = Resources::manager().getProgram2D("tonemap");
 	// Sun direction.
 	_lightDirection = glm::normalize(glm::vec3(0.337f, 0.174f, -0.925f));
-	// Populate lookup table.
+	// Populate lookup tables.
 	updateSky();
 
 	checkGLError();
@@ -48,7 +49,6 @@ void AtmosphereApp::draw() {
 	const glm::mat4 camToWorldNoT = glm::mat4(glm::mat3(camToWorld));
 	const glm::mat4 clipToWorld	  = camToWorldNoT * clipToCam;
 	_atmosphere->uniform("clipToWorld", clipToWorld);
-	_atmosphere->uniform("viewPos", _userCamera.position());
 	_atmosphere->uniform("lightDirection", _lightDirection);
 	_atmosphere->uniform("altitude", _altitude);
 	// Send the atmosphere parameters.
@@ -64,7 +64,7 @@ void AtmosphereApp::draw() {
 	_atmosphere->uniform("atmoParams.sunAngularRadius", _atmoParams.sunRadius);
 	_atmosphere->uniform("atmoParams.sunAngularRadiusCos", _atmoParams.sunRadiusCos);
 
-	ScreenQuad::draw(_scattering);
+	ScreenQuad::draw({&_skyView, &_transmittance});
 
 	// Tonemapping and final screen.
 	GLUtilities::setViewport(0, 0, int(_config.screenResolution[0]), int(_config.screenResolution[1]));
@@ -102,28 +102,32 @@ void AtmosphereApp::update() {
 		ImGui::DragFloat("Altitude", &_altitude, 10.0f, 0.0f, 0.0f, "%.0fm", 2.0f);
 
 		if(ImGui::CollapsingHeader("Atmosphere parameters")) {
-			bool updateScattering = false;
-
-			updateScattering = ImGui::InputInt("Resolution", &_tableRes) || updateScattering;
-			updateScattering = ImGui::InputInt("Samples", &_tableSamples) || updateScattering;
+			// Tables are updated at the end of the frame if needed.
+			if(ImGui::InputScalar("Resolution", ImGuiDataType_U32, &_tablesSettings.transmittanceResolution)) {
+				_tablesSettings.transmittanceResolution = std::max(_tablesSettings.transmittanceResolution, 2u);
+			}
+			if(ImGui::InputScalar("Samples", ImGuiDataType_U32, &_tablesSettings.transmittanceSamples)) {
+				_tablesSettings.transmittanceSamples = std::max(_tablesSettings.transmittanceSamples, 1u);
+			}
+			ImGui::InputScalar("Scattering orders", ImGuiDataType_U32, &_tablesSettings.orders);
+			if(ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("0 to sum all orders.");
+			}
+			ImGui::SliderFloat("Ground albedo", &_tablesSettings.groundAlbedo, 0.0f, 1.0f);
 
 			if(ImGui::Button("Reset")) {
-				_atmoParams		 = Sky::AtmosphereParameters();
-				updateScattering = true;
+				_atmoParams		= Sky::AtmosphereParameters();
+				_tablesSettings = AtmosphereTables::Settings();
 			}
-			updateScattering = ImGui::SliderFloat("Mie height", &_atmoParams.heightMie, 100.0f, 20000.0f) || updateScattering;
-
-			updateScattering = ImGui::SliderFloat("Mie K", &_atmoParams.kMie, 1e-6f, 100e-6f, "%.6f") || updateScattering;
+			ImGui::SliderFloat("Mie height", &_atmoParams.heightMie, 100.0f, 20000.0f);
 
-			updateScattering = ImGui::SliderFloat("Rayleigh height", &_atmoParams.heightRayleigh, 100.0f, 20000.0f) || updateScattering;
-			updateScattering = ImGui::SliderFloat3("Rayleigh K", &_atmoParams.kRayleigh[0], 1e-6f, 100e-6f, "%.6f") || updateScattering;
+			ImGui::SliderFloat("Mie K", &_atmoParams.kMie, 1e-6f, 100e-6f, "%.6f");
 
-			updateScattering = ImGui::SliderFloat("Ground radius", &_atmoParams.groundRadius, 1e6f, 10e6f) || updateScattering;
-			updateScattering = ImGui::SliderFloat("Atmosphere radius", &_atmoParams.topRadius, 1e6f, 10e6f) || updateScattering;
+			ImGui::SliderFloat("Rayleigh height", &_atmoParams.heightRayleigh, 100.0f, 20000.0f);
+			ImGui::SliderFloat3("Rayleigh K", &_atmoParams.kRayleigh[0], 1e-6f, 100e-6f, "%.6f");
 
-			if(updateScattering) {
-				updateSky();
-			}
+			ImGui::SliderFloat("Ground radius", &_atmoParams.groundRadius, 1e6f, 10e6f);
+			ImGui::SliderFloat("Atmosphere radius", &_atmoParams.topRadius, 1e6f, 10e6f);
 
 			ImGui::SliderFloat("Mie G", &_atmoParams.gMie, 0.0f, 1.0f);
 			if(ImGui::SliderFloat("Sun diameter", &_atmoParams.sunRadius, 0.0f, 0.1f)) {
@@ -134,73 +138,39 @@ void AtmosphereApp::update() {
 		}
 	}
 	ImGui::End();
+
+	updateSky();
 }
 
 void AtmosphereApp::resize() {
 	_atmosphereBuffer->resize(_config.renderingResolution());
 }
 
-void AtmosphereApp::precomputeTable(const Sky::AtmosphereParameters & params, uint samples, Image & table) {
-
-	// Parameters.
-	const uint res = table.width;
-
-	System::forParallel(0, res, [&](size_t y) {
-		for(size_t x = 0; x < res; ++x) {
-			// Move to 0,1.
-			// No need to take care of the 0.5 shift as we are working with indices
-			const float xf = float(x) / (res - 1.0f);
-			const float yf = float(y) / (res - 1.0f);
-			// Position and ray direction.
-			// x becomes the height
-			// y become the cosine
-			const glm::vec3 currPos = glm::vec3(0.0f, (params.topRadius - params.groundRadius) * xf + params.groundRadius, 0.0f);
-			const float cosA		= 2.0f * yf - 1.0f;
-			const float sinA		= std::sqrt(1.0f - cosA * cosA);
-			const glm::vec3 sunDir	= -glm::normalize(glm::vec3(sinA, cosA, 0.0f));
-			// Check when the ray leaves the atmosphere.
-			glm::vec2 interSecondTop;
-			const bool didHitSecondTop = Intersection::sphere(currPos, sunDir, params.topRadius, interSecondTop);
-			// Divide the distance traveled through the atmosphere in samplesCount parts.
-			const float secondStepSize = didHitSecondTop ? interSecondTop.y / float(samples) : 0.0f;
-
-			// Accumulate optical distance for both scatterings.
-			float rayleighSecondDist = 0.0;
-			float mieSecondDist		 = 0.0;
-
-			// March along the secondary ray.
-			for(unsigned int j = 0; j < samples; ++j) {
-				// Compute the current position along the ray, ...
-				const glm::vec3 currSecondPos = currPos + (float(j) + 0.5f) * secondStepSize * sunDir;
-				// ...and its distance to the ground (as we are in planet space).
-				const float currSecondHeight = glm::length(currSecondPos) - params.groundRadius;
-				// Compute density based on the characteristic height of Rayleigh and Mie.
-				const float rayleighSecondStep = exp(-currSecondHeight / params.heightRayleigh) * secondStepSize;
-				const float mieSecondStep	   = exp(-currSecondHeight / params.heightMie) * secondStepSize;
-				// Accumulate optical distances.
-				rayleighSecondDist += rayleighSecondStep;
-				mieSecondDist += mieSecondStep;
-			}
-
-			// Compute associated attenuation.
-			const glm::vec3 secondaryAttenuation = exp(-(params.kMie * mieSecondDist + params.kRayleigh * rayleighSecondDist));
-			table.rgb(int(x), int(y))			 = secondaryAttenuation;
-		}
-	});
-}
-
 void AtmosphereApp::updateSky() {
-	Log::Info() << Log::Resources << "Updating sky..." << std::flush;
-	_scattering.width = _scattering.height = uint(_tableRes);
-	_scattering.levels = _scattering.depth = 1;
-	_scattering.shape					   = TextureShape::D2;
-	_scattering.clean();
-	_scattering.images.emplace_back(_scattering.width, _scattering.height, 3);
-
-	// Update the lookup table.
-	precomputeTable(_atmoParams, uint(_tableSamples), _scattering.images[0]);
-
-	_scattering.upload({Layout::RGB32F, Filter::LINEAR, Wrap::CLAMP}, false);
+	Query timer;
+	timer.begin();
+	// Only outdated tables are computed again.
+	const AtmosphereTables::Updates updates = _tables.update(_atmoParams, _tablesSettings, _lightDirection, _altitude);
+	timer.end();
+
+	if(updates.transmittance) {
+		uploadTable(_tables.transmittance(), _transmittance);
+	}
+	if(updates.skyView) {
+		uploadTable(_tables.skyView(), _skyView);
+	}
+	if(updates.transmittance || updates.multiScattering) {
+		Log::Verbose() << Log::Resources << "Updated sky tables in " << (float(timer.value()) / 1000000.0f) << "ms." << std::endl;
+	}
+}
 
-	Log::Info() << " done." << std::endl;
+void AtmosphereApp::uploadTable(const Image & table, Texture & texture) {
+	texture.width  = table.width;
+	texture.height = table.height;
+	texture.levels = texture.depth = 1;
+	texture.shape				   = TextureShape::D2;
+	texture.clean();
+	texture.images.emplace_back(table.width, table.height, table.components);
+	texture.images[0].pixels = table.pixels;
+	texture.upload({Layout::RGB32F, Filter::LINEAR, Wrap::CLAMP}, false);
 }
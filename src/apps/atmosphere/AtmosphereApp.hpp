@@ -1,4 +1,5 @@
 #pragma once
+#include "AtmosphereTables.hpp"
 #include "Application.hpp"
 #include "scene/Sky.hpp"
 #include "graphics/Framebuffer.hpp"
@@ -7,6 +8,7 @@
 
 /** \brief Demo application for the atmospheric scattering shader. Demonstrate real-time approximate atmospheric scattering simulation.
  * Based on Precomputed Atmospheric Scattering, E. Bruneton, F. Neyret, EGSR 2008
+ * Single and multiple scattering are precomputed in lookup tables (see AtmosphereTables), updated when parameters change, so that rendering the sky only requires a few texture reads.
  \ingroup AtmosphericScattering
  */
 class AtmosphereApp final : public CameraApp {
@@ -26,28 +28,27 @@ public:
 	/** \copydoc CameraApp::resize */
 	void resize() override;
 
-	/**
-	 Compute a scattering lookup table for real-time atmosphere rendering.
-	 \param params the atmosphere parameters
-	 \param samples number of samples along a ray
-	 \param table the image to fill.
-	 */
-	static void precomputeTable(const Sky::AtmosphereParameters & params, uint samples, Image & table);
-	
 private:
 
-	/** Update the lookup table based on internal atmosphere parameters.*/
+	/** Update the outdated lookup tables based on internal atmosphere parameters.*/
 	void updateSky();
 
+	/** Upload a lookup table to the GPU.
+	 \param table the table data
+	 \param texture the texture to update
+	 */
+	static void uploadTable(const Image & table, Texture & texture);
+
 	std::unique_ptr<Framebuffer> _atmosphereBuffer; ///< Scene framebuffer.
 	const Program * _atmosphere; ///< Atmospheric scattering shader.
 	const Program * _tonemap; ///< Tonemapping shader.
-	Texture _scattering; ///< Scattering lookup table.
+	Texture _transmittance; ///< Transmittance lookup table.
+	Texture _skyView; ///< Sky radiance lookup table.
+	AtmosphereTables _tables; ///< Lookup tables precomputation.
 
 	// Atmosphere parameters.
 	Sky::AtmosphereParameters _atmoParams; ///< Atmosphere parameters.
-	int _tableRes = 256; ///< Scattering table resolution.
-	int _tableSamples = 64;	///< Scattering table sample count.
+	AtmosphereTables::Settings _tablesSettings; ///< Lookup tables settings.
 	
 	// Real-time parameters.
 	glm::vec3 _lightDirection;		///< Sun light direction.
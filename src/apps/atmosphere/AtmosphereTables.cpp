@@ -0,0 +1,247 @@
+#include "AtmosphereTables.hpp"
+#include "raycaster/Intersection.hpp"
+#include "system/System.hpp"
+
+AtmosphereTables::Updates AtmosphereTables::update(const Sky::AtmosphereParameters & params, const Settings & settings, const glm::vec3 & sunDir, float altitude) {
+	Updates updates;
+	// Each stage is outdated if its own inputs changed, or if a stage it depends on has been computed again.
+	updates.transmittance = _transmittance.width == 0 || !sameMedium(params, _params)
+		|| settings.transmittanceResolution != _settings.transmittanceResolution
+		|| settings.transmittanceSamples != _settings.transmittanceSamples;
+
+	updates.multiScattering = updates.transmittance || _multiScattering.width == 0
+		|| settings.multiScatteringResolution != _settings.multiScatteringResolution
+		|| settings.multiScatteringDirections != _settings.multiScatteringDirections
+		|| settings.multiScatteringSamples != _settings.multiScatteringSamples
+		|| settings.orders != _settings.orders || settings.groundAlbedo != _settings.groundAlbedo;
+
+	updates.skyView = updates.multiScattering || _skyView.width == 0
+		|| settings.skyViewResolution != _settings.skyViewResolution
+		|| settings.skyViewSamples != _settings.skyViewSamples
+		|| params.gMie != _params.gMie || sunDir != _sunDir || altitude != _altitude;
+
+	if(updates.transmittance) {
+		_transmittance = Image(settings.transmittanceResolution, settings.transmittanceResolution, 3);
+		computeTransmittance(params, settings.transmittanceSamples, _transmittance);
+	}
+	if(updates.multiScattering) {
+		_multiScattering = Image(settings.multiScatteringResolution, settings.multiScatteringResolution, 3);
+		computeMultiScattering(params, settings, _transmittance, _multiScattering);
+	}
+	if(updates.skyView) {
+		_skyView = Image(settings.skyViewResolution.x, settings.skyViewResolution.y, 3);
+		computeSkyView(params, settings, sunDir, altitude, _transmittance, _multiScattering, _skyView);
+	}
+
+	_params = params;
+	_settings = settings;
+	_sunDir = sunDir;
+	_altitude = altitude;
+	return updates;
+}
+
+void AtmosphereTables::computeTransmittance(const Sky::AtmosphereParameters & params, uint samples, Image & table) {
+
+	const uint width = table.width;
+	const uint height = table.height;
+
+	System::forParallel(0, height, [&](size_t y) {
+		// Each row shares the same direction, relative to the vertical, see Sky::transmittanceCoordinates.
+		// y becomes the cosine
+		const float yf = float(y) / (float(height) - 1.0f);
+		const float cosA = 1.0f - 2.0f * yf;
+
+		for(size_t x = 0; x < width; ++x) {
+			// x becomes the height
+			// No need to take care of the 0.5 shift as we are working with indices
+			const float xf = float(x) / (float(width) - 1.0f);
+			const float radius = (params.topRadius - params.groundRadius) * xf + params.groundRadius;
+			// Distance to the top of the atmosphere, along the ray.
+			const float discriminant = radius * radius * (cosA * cosA - 1.0f) + params.topRadius * params.topRadius;
+			const float distance = std::max(-radius * cosA + std::sqrt(std::max(discriminant, 0.0f)), 0.0f);
+			// Divide the distance traveled through the atmosphere in samplesCount parts.
+			const float stepSize = distance / float(samples);
+
+			// Accumulate optical distance for both scatterings.
+			// The loop has no branch and only depends on the step index, to help vectorization.
+			float rayleighDist = 0.0f;
+			float mieDist = 0.0f;
+			for(uint j = 0; j < samples; ++j) {
+				// Compute the current distance to the planet center along the ray, and the height above the ground.
+				const float t = (float(j) + 0.5f) * stepSize;
+				const float currHeight = std::sqrt(radius * radius + 2.0f * radius * cosA * t + t * t) - params.groundRadius;
+				// Compute density based on the characteristic height of Rayleigh and Mie.
+				rayleighDist += std::exp(-currHeight / params.heightRayleigh);
+				mieDist += std::exp(-currHeight / params.heightMie);
+			}
+
+			// Compute associated attenuation.
+			table.rgb(int(x), int(y)) = glm::exp(-stepSize * (params.kMie * mieDist + params.kRayleigh * rayleighDist));
+		}
+	});
+}
+
+void AtmosphereTables::computeMultiScattering(const Sky::AtmosphereParameters & params, const Settings & settings, const Image & transmittance, Image & table) {
+
+	// Directions are placed on a regular grid over the sphere.
+	const uint side = std::max(uint(std::round(std::sqrt(float(settings.multiScatteringDirections)))), 1u);
+	std::vector<glm::vec3> directions;
+	directions.reserve(side * side);
+	for(uint j = 0; j < side; ++j) {
+		const float cosTheta = 1.0f - 2.0f * (float(j) + 0.5f) / float(side);
+		const float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+		for(uint i = 0; i < side; ++i) {
+			const float phi = 2.0f * glm::pi<float>() * (float(i) + 0.5f) / float(side);
+			directions.emplace_back(sinTheta * std::cos(phi), cosTheta, sinTheta * std::sin(phi));
+		}
+	}
+	const float weight = 1.0f / float(directions.size());
+
+	System::forParallel(0, table.height, [&](size_t y) {
+		// Same layout as the transmittance table, with the sun direction along y.
+		const float cosSun = 1.0f - 2.0f * float(y) / (float(table.height) - 1.0f);
+		const glm::vec3 sunDir(std::sqrt(std::max(1.0f - cosSun * cosSun, 0.0f)), cosSun, 0.0f);
+
+		for(size_t x = 0; x < table.width; ++x) {
+			const float xf = float(x) / (float(table.width) - 1.0f);
+			// Stay slightly above the ground to avoid degenerate rays.
+			const float radius = std::max((params.topRadius - params.groundRadius) * xf + params.groundRadius, params.groundRadius + 1.0f);
+			const glm::vec3 position(0.0f, radius, 0.0f);
+
+			// Second order scattering, and fraction of light transferred by one more scattering event.
+			// The isotropic phase function integrated over the sphere cancels out with the solid angle.
+			glm::vec3 secondOrder(0.0f);
+			glm::vec3 transfer(0.0f);
+			for(const glm::vec3 & dir : directions) {
+				glm::vec3 luminance, dirTransfer;
+				integrateIsotropic(params, settings, transmittance, position, dir, sunDir, luminance, dirTransfer);
+				secondOrder += weight * luminance;
+				transfer += weight * dirTransfer;
+			}
+
+			// Higher orders form a geometric series.
+			glm::vec3 series(0.0f);
+			if(settings.orders == 0) {
+				series = 1.0f / (1.0f - transfer);
+			} else if(settings.orders > 1) {
+				series = (1.0f - glm::pow(transfer, glm::vec3(float(settings.orders - 1)))) / (1.0f - transfer);
+			}
+			table.rgb(int(x), int(y)) = secondOrder * series;
+		}
+	});
+}
+
+void AtmosphereTables::computeSkyView(const Sky::AtmosphereParameters & params, const Settings & settings, const glm::vec3 & sunDir, float altitude, const Image & transmittance, const Image & multiScattering, Image & table) {
+
+	const float radius = params.groundRadius + glm::clamp(altitude, 1.0f, params.topRadius - params.groundRadius - 1.0f);
+	const glm::vec3 position(0.0f, radius, 0.0f);
+	const float horizon = Sky::horizonZenith(params, radius);
+	// Horizontal frame around the sun, any frame works for a vertical sun.
+	const glm::vec3 sunHorizontal(sunDir.x, 0.0f, sunDir.z);
+	const glm::vec3 sunForward = glm::length(sunHorizontal) > 1e-4f ? glm::normalize(sunHorizontal) : glm::vec3(1.0f, 0.0f, 0.0f);
+	const glm::vec3 sunSide = glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), sunForward);
+	const uint samples = settings.skyViewSamples;
+
+	System::forParallel(0, table.height, [&](size_t y) {
+		const float zenith = Sky::coordinateToZenith(float(y) / (float(table.height) - 1.0f), horizon);
+		const float cosZenith = std::cos(zenith);
+		const float sinZenith = std::sin(zenith);
+
+		for(size_t x = 0; x < table.width; ++x) {
+			// The sky is symmetric with respect to the vertical plane containing the sun, only store half the azimuths.
+			const float azimuth = glm::pi<float>() * float(x) / (float(table.width) - 1.0f);
+			const glm::vec3 rayDir = glm::normalize(sinZenith * (std::cos(azimuth) * sunForward + std::sin(azimuth) * sunSide) + glm::vec3(0.0f, cosZenith, 0.0f));
+
+			// Stop at the ground or at the top of the atmosphere.
+			glm::vec2 interTop(0.0f);
+			glm::vec2 interGround(0.0f);
+			Intersection::sphere(position, rayDir, params.topRadius, interTop);
+			const bool didHitGround = Intersection::sphere(position, rayDir, params.groundRadius, interGround) && interGround.x > 0.0f;
+			const float stepSize = (didHitGround ? interGround.x : interTop.y) / float(samples);
+
+			const float cosViewSun = glm::dot(rayDir, sunDir);
+			const float phaseRayleigh = Sky::rayleighPhase(cosViewSun);
+			const float phaseMie = Sky::miePhase(cosViewSun, params.gMie);
+
+			glm::vec3 radiance(0.0f);
+			glm::vec3 throughput(1.0f);
+			for(uint j = 0; j < samples; ++j) {
+				const glm::vec3 currPos = position + (float(j) + 0.5f) * stepSize * rayDir;
+				const float currRadius = glm::length(currPos);
+				const Medium coeffs = medium(params, currRadius);
+				const glm::vec3 stepTransmittance = glm::exp(-coeffs.extinction * stepSize);
+
+				// Single scattering from the sun, and all higher orders from the table.
+				const float cosSun = glm::dot(currPos, sunDir) / currRadius;
+				const glm::vec3 sunTransmittance = inShadow(params, currPos, sunDir) ? glm::vec3(0.0f) : Sky::sampleTable(transmittance, Sky::transmittanceCoordinates(params, currRadius, cosSun));
+				const glm::vec3 multiple = Sky::sampleTable(multiScattering, Sky::transmittanceCoordinates(params, currRadius, cosSun));
+				const glm::vec3 scattered = sunTransmittance * (phaseRayleigh * coeffs.rayleigh + phaseMie * coeffs.mie) + multiple * (coeffs.rayleigh + coeffs.mie);
+
+				// Integrate analytically over the step, assuming constant scattering.
+				radiance += throughput * scattered * (1.0f - stepTransmittance) / glm::max(coeffs.extinction, 1e-12f);
+				throughput *= stepTransmittance;
+			}
+			table.rgb(int(x), int(y)) = radiance;
+		}
+	});
+}
+
+AtmosphereTables::Medium AtmosphereTables::medium(const Sky::AtmosphereParameters & params, float radius) {
+	const float height = std::max(radius - params.groundRadius, 0.0f);
+	Medium coeffs;
+	coeffs.rayleigh = params.kRayleigh * std::exp(-height / params.heightRayleigh);
+	coeffs.mie = glm::vec3(params.kMie * std::exp(-height / params.heightMie));
+	coeffs.extinction = coeffs.rayleigh + coeffs.mie;
+	return coeffs;
+}
+
+bool AtmosphereTables::inShadow(const Sky::AtmosphereParameters & params, const glm::vec3 & position, const glm::vec3 & sunDir) {
+	glm::vec2 interGround(0.0f);
+	return Intersection::sphere(position, sunDir, params.groundRadius, interGround) && interGround.y > 0.0f;
+}
+
+void AtmosphereTables::integrateIsotropic(const Sky::AtmosphereParameters & params, const Settings & settings, const Image & transmittance, const glm::vec3 & position, const glm::vec3 & rayDir, const glm::vec3 & sunDir, glm::vec3 & luminance, glm::vec3 & transfer) {
+	luminance = glm::vec3(0.0f);
+	transfer = glm::vec3(0.0f);
+
+	// Stop at the ground or at the top of the atmosphere.
+	glm::vec2 interTop(0.0f);
+	glm::vec2 interGround(0.0f);
+	if(!Intersection::sphere(position, rayDir, params.topRadius, interTop)) {
+		return;
+	}
+	const bool didHitGround = Intersection::sphere(position, rayDir, params.groundRadius, interGround) && interGround.x > 0.0f;
+	const float distance = didHitGround ? interGround.x : interTop.y;
+	const float stepSize = distance / float(settings.multiScatteringSamples);
+	const float isotropicPhase = 1.0f / (4.0f * glm::pi<float>());
+
+	glm::vec3 throughput(1.0f);
+	for(uint j = 0; j < settings.multiScatteringSamples; ++j) {
+		const glm::vec3 currPos = position + (float(j) + 0.5f) * stepSize * rayDir;
+		const float currRadius = glm::length(currPos);
+		const Medium coeffs = medium(params, currRadius);
+		const glm::vec3 stepTransmittance = glm::exp(-coeffs.extinction * stepSize);
+		const glm::vec3 scattering = coeffs.rayleigh + coeffs.mie;
+		const glm::vec3 stepIntegral = throughput * (1.0f - stepTransmittance) / glm::max(coeffs.extinction, 1e-12f);
+
+		const glm::vec3 sunTransmittance = inShadow(params, currPos, sunDir) ? glm::vec3(0.0f) : Sky::sampleTable(transmittance, Sky::transmittanceCoordinates(params, currRadius, glm::dot(currPos, sunDir) / currRadius));
+		luminance += stepIntegral * sunTransmittance * scattering * isotropicPhase;
+		transfer += stepIntegral * scattering;
+		throughput *= stepTransmittance;
+	}
+
+	// Light reflected by a diffuse ground.
+	if(didHitGround) {
+		const glm::vec3 groundPos = position + distance * rayDir;
+		const float cosSun = glm::dot(glm::normalize(groundPos), sunDir);
+		if(cosSun > 0.0f) {
+			const glm::vec3 sunTransmittance = Sky::sampleTable(transmittance, Sky::transmittanceCoordinates(params, params.groundRadius, cosSun));
+			luminance += throughput * sunTransmittance * cosSun * settings.groundAlbedo / glm::pi<float>();
+		}
+	}
+}
+
+bool AtmosphereTables::sameMedium(const Sky::AtmosphereParameters & a, const Sky::AtmosphereParameters & b) {
+	return a.kRayleigh == b.kRayleigh && a.kMie == b.kMie && a.heightRayleigh == b.heightRayleigh
+		&& a.heightMie == b.heightMie && a.groundRadius == b.groundRadius && a.topRadius == b.topRadius;
+}
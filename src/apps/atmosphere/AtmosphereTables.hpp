@@ -0,0 +1,133 @@
+#pragma once
+#include "scene/Sky.hpp"
+#include "resources/Image.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Precompute the lookup tables used to render the atmosphere in real-time.
+ \details Three stages are computed on the CPU, each one relying on the previous ones:
+ - transmittance towards the top of the atmosphere, parameterized by altitude and zenith angle (see Sky::transmittanceCoordinates);
+ - multiple scattering, parameterized by altitude and sun zenith angle. Light scattered twice or more is assumed isotropic, so that all orders can be summed as a geometric series of the second order (see A Scalable and Production Ready Sky and Atmosphere Rendering Technique, S. Hillaire, EGSR 2020);
+ - sky-view radiance for the current sun direction and viewer altitude, parameterized by the azimuth relative to the sun and the view zenith angle, with more precision around the horizon (see Sky::zenithToCoordinate).
+ Each stage stores the inputs it was computed with, and is only computed again when one of them changes. For instance, moving the sun only updates the sky-view table. Tables are computed for a unit sun intensity.
+ \ingroup AtmosphericScattering
+ */
+class AtmosphereTables {
+public:
+
+	/** \brief Tables resolutions and quality settings. */
+	struct Settings {
+		uint transmittanceResolution = 256; ///< Transmittance table side size.
+		uint transmittanceSamples = 64; ///< Number of samples along transmittance rays.
+		uint multiScatteringResolution = 32; ///< Multiple scattering table side size.
+		uint multiScatteringDirections = 64; ///< Number of directions integrated for multiple scattering, rounded to a square.
+		uint multiScatteringSamples = 20; ///< Number of samples along multiple scattering rays.
+		uint orders = 0; ///< Number of scattering orders to sum, 0 for all of them.
+		float groundAlbedo = 0.3f; ///< Ground diffuse albedo, contributing to multiple scattering.
+		glm::uvec2 skyViewResolution = glm::uvec2(192, 108); ///< Sky-view table size.
+		uint skyViewSamples = 32; ///< Number of samples along view rays.
+	};
+
+	/** \brief Stages computed during the last update. */
+	struct Updates {
+		bool transmittance = false; ///< The transmittance table was computed.
+		bool multiScattering = false; ///< The multiple scattering table was computed.
+		bool skyView = false; ///< The sky-view table was computed.
+	};
+
+	/** Compute the tables that are outdated for the given parameters.
+	 \param params the atmosphere parameters
+	 \param settings the tables settings
+	 \param sunDir the sun direction
+	 \param altitude the viewer altitude above the ground
+	 \return the stages that were computed
+	 */
+	Updates update(const Sky::AtmosphereParameters & params, const Settings & settings, const glm::vec3 & sunDir, float altitude);
+
+	/** \return the transmittance table */
+	const Image & transmittance() const { return _transmittance; }
+
+	/** \return the multiple scattering table */
+	const Image & multiScattering() const { return _multiScattering; }
+
+	/** \return the sky-view table */
+	const Image & skyView() const { return _skyView; }
+
+	/** Compute the transmittance table.
+	 \param params the atmosphere parameters
+	 \param samples number of samples along a ray
+	 \param table the image to fill, its width and height give the resolution
+	 */
+	static void computeTransmittance(const Sky::AtmosphereParameters & params, uint samples, Image & table);
+
+	/** Compute the multiple scattering table.
+	 \param params the atmosphere parameters
+	 \param settings the tables settings
+	 \param transmittance the transmittance table
+	 \param table the image to fill, its width and height give the resolution
+	 */
+	static void computeMultiScattering(const Sky::AtmosphereParameters & params, const Settings & settings, const Image & transmittance, Image & table);
+
+	/** Compute the sky-view table.
+	 \param params the atmosphere parameters
+	 \param settings the tables settings
+	 \param sunDir the sun direction
+	 \param altitude the viewer altitude above the ground
+	 \param transmittance the transmittance table
+	 \param multiScattering the multiple scattering table
+	 \param table the image to fill, its width and height give the resolution
+	 */
+	static void computeSkyView(const Sky::AtmosphereParameters & params, const Settings & settings, const glm::vec3 & sunDir, float altitude, const Image & transmittance, const Image & multiScattering, Image & table);
+
+private:
+
+	/** \brief Scattering and extinction coefficients at a point. */
+	struct Medium {
+		glm::vec3 rayleigh; ///< Rayleigh scattering.
+		glm::vec3 mie; ///< Mie scattering.
+		glm::vec3 extinction; ///< Total extinction.
+	};
+
+	/** Evaluate the atmosphere coefficients at a given position.
+	 \param params the atmosphere parameters
+	 \param radius the distance to the planet center
+	 \return the medium coefficients
+	 */
+	static Medium medium(const Sky::AtmosphereParameters & params, float radius);
+
+	/** Check if the sun is hidden by the planet.
+	 \param params the atmosphere parameters
+	 \param position the position in planet space
+	 \param sunDir the sun direction
+	 \return true if the planet occludes the sun
+	 */
+	static bool inShadow(const Sky::AtmosphereParameters & params, const glm::vec3 & position, const glm::vec3 & sunDir);
+
+	/** Integrate the light scattered once along a ray, assuming an isotropic phase function and a unit sun illuminance.
+	 \param params the atmosphere parameters
+	 \param settings the tables settings
+	 \param transmittance the transmittance table
+	 \param position the ray origin in planet space
+	 \param rayDir the ray direction
+	 \param sunDir the sun direction
+	 \param luminance will contain the scattered luminance, including light reflected by the ground
+	 \param transfer will contain the fraction of light scattered back towards the origin
+	 */
+	static void integrateIsotropic(const Sky::AtmosphereParameters & params, const Settings & settings, const Image & transmittance, const glm::vec3 & position, const glm::vec3 & rayDir, const glm::vec3 & sunDir, glm::vec3 & luminance, glm::vec3 & transfer);
+
+	/** Check if two sets of parameters describe the same medium.
+	 \param a the first parameters
+	 \param b the second parameters
+	 \return true if the scattering coefficients and geometry are identical
+	 */
+	static bool sameMedium(const Sky::AtmosphereParameters & a, const Sky::AtmosphereParameters & b);
+
+	Image _transmittance; ///< Transmittance table.
+	Image _multiScattering; ///< Multiple scattering table.
+	Image _skyView; ///< Sky-view table.
+
+	Sky::AtmosphereParameters _params; ///< Parameters used for the current tables.
+	Settings _settings; ///< Settings used for the current tables.
+	glm::vec3 _sunDir = glm::vec3(0.0f); ///< Sun direction used for the sky-view table.
+	float _altitude = -1.0f; ///< Viewer altitude used for the sky-view table.
+};
@@ -5,6 +5,7 @@
 #include "system/System.hpp"
 #include "generation/Random.hpp"
 #include "system/Config.hpp"
+#include "system/TextUtilities.hpp"
 #include "Common.hpp"
 
 /**
@@ -36,13 +37,16 @@ public:
 				samples = std::stoi(values[0]);
 			} else if(key == "resolution" && !values.empty()) {
 				resolution = size_t(std::stoi(values[0]));
+			} else if(key == "orders" && !values.empty()) {
+				orders = uint(std::stoi(values[0]));
 			}
 		}
 
 		registerSection("Atmospheric scattering");
-		registerArgument("output", "", "Output lookup table path (if specified, will only precompute and save the table).", "path/to/output.exr");
+		registerArgument("output", "", "Output transmittance table path (if specified, will only precompute and save the tables, the multiple scattering table is saved next to it).", "path/to/output.exr");
 		registerArgument("samples", "", "Number of samples per-pixel.", "count");
 		registerArgument("resolution", "", "Output image side size.", "size");
+		registerArgument("orders", "", "Number of scattering orders in the multiple scattering table, 0 for all.", "count");
 	}
 
 	std::string outputPath = ""; ///< Lookup table output path.
@@ -50,6 +54,8 @@ public:
 	unsigned int samples = 256; ///< Number of samples for iterative sampling.
 
 	size_t resolution = 512; ///< Output image resolution.
+
+	uint orders = 0; ///< Number of scattering orders, 0 for all.
 };
 
 
@@ -71,13 +77,21 @@ int main(int argc, char ** argv) {
 	// If an output path has been specified, precompute the table and save
 	if(!config.outputPath.empty()){
 
-		Log::Info() << Log::Utilities << "Generating scattering lookup table." << std::endl;
+		Log::Info() << Log::Utilities << "Generating scattering lookup tables." << std::endl;
 		// Default Earth-like atmosphere.
 		const auto params = Sky::AtmosphereParameters();
+		AtmosphereTables::Settings settings;
+		settings.orders = config.orders;
 		Image transmittanceTable(int(config.resolution), int(config.resolution), 3);
-		AtmosphereApp::precomputeTable(params, config.samples, transmittanceTable);
+		AtmosphereTables::computeTransmittance(params, config.samples, transmittanceTable);
 		transmittanceTable.save(config.outputPath, true);
 
+		Image multiScatteringTable(settings.multiScatteringResolution, settings.multiScatteringResolution, 3);
+		AtmosphereTables::computeMultiScattering(params, settings, transmittanceTable, multiScatteringTable);
+		std::string multiScatteringPath = config.outputPath;
+		const std::string ext = TextUtilities::splitExtension(multiScatteringPath);
+		multiScatteringTable.save(multiScatteringPath + "_multiscattering" + ext, true);
+
 		Log::Info() << Log::Utilities << "Done." << std::endl;
 		return 0;
 	}
@@ -1,5 +1,6 @@
 #include "IslandApp.hpp"
 
+#include "graphics/FramebufferPool.hpp"
 #include "resources/Library.hpp"
 
 IslandApp::IslandApp(RenderingConfig & config) : CameraApp(config),
@@ -14,9 +15,6 @@ IslandApp::IslandApp(RenderingConfig & config) : CameraApp(config),
 	const glm::vec2 renderRes = _config.renderingResolution();
 	const std::vector<Descriptor> descriptors = {{Layout::RGB32F, Filter::LINEAR_NEAREST, Wrap::CLAMP}, {Layout::RGB32F, Filter::LINEAR_NEAREST, Wrap::CLAMP}};
 	_sceneBuffer.reset(new Framebuffer(uint(renderRes[0]), uint(renderRes[1]), descriptors, true, "Scene"));
-	_waterPos.reset(new Framebuffer(uint(renderRes[0]), uint(renderRes[1]), {descriptors[1]}, false, "Water position"));
-	_waterEffectsHalf.reset(new Framebuffer(uint(renderRes[0])/2, uint(renderRes[1])/2, {descriptors[0]}, false, "Water effect half"));
-	_waterEffectsBlur.reset(new Framebuffer(uint(renderRes[0])/2, uint(renderRes[1])/2, {descriptors[0]}, false, "Water effect blur"));
 	_environment.reset(new Framebuffer(TextureShape::Cube, 512, 512, 6, 1, {{Layout::RGB16F, Filter::LINEAR_NEAREST, Wrap::CLAMP}}, false, "Environment"));
 
 	// Lookup table.
@@ -174,6 +172,14 @@ void IslandApp::draw() {
 		_shouldUpdateSky = false;
 	}
 
+	// Move the terrain grid and clipmaps in front of the camera.
+	const glm::vec3 frontPos = camPos + camDir;
+	// Clamp based on the terrain heightmap dimensions in world space.
+	const float extent = 0.25f * std::abs(float(_terrain->mapSize()) * _terrain->texelSize() - 0.5f*_terrain->meshSize());
+	glm::vec3 frontPosClamped = glm::clamp(frontPos, -extent, extent);
+	frontPosClamped[1] = 0.0f;
+	_terrain->update(frontPosClamped);
+
 	_sceneBuffer->bind();
 	_sceneBuffer->setViewport();
 	_sceneBuffer->clear(glm::vec4(10000.0f), 1.0f);
@@ -186,25 +192,20 @@ void IslandApp::draw() {
 	// Render the ground.
 	if(_showTerrain){
 
-		const glm::vec3 frontPos = camPos + camDir;
-		// Clamp based on the terrain heightmap dimensions in world space.
-		const float extent = 0.25f * std::abs(float(_terrain->map().width) * _terrain->texelSize() - 0.5f*_terrain->meshSize());
-		glm::vec3 frontPosClamped = glm::clamp(frontPos, -extent, extent);
-		frontPosClamped[1] = 0.0f;
-
-		// Compensate for grid translation.
 		const Frustum camFrustum(mvp);
+		const uint patchCount = _terrain->cullPatches(camFrustum);
 
 		_groundProgram->use();
 		_groundProgram->uniform("mvp", mvp);
-		_groundProgram->uniform("shift", frontPosClamped);
+		_groundProgram->uniform("shift", _terrain->gridCenter());
 		_groundProgram->uniform("lightDirection", _lightDirection);
 		_groundProgram->uniform("camDir", camDir);
 		_groundProgram->uniform("camPos", camPos);
-		_groundProgram->uniform("texelSize", _terrain->texelSize());
-		_groundProgram->uniform("invMapSize", 1.0f/float(_terrain->map().width));
-		_groundProgram->uniform("invGridSize", 1.0f/float(_terrain->gridSize()));
+		_groundProgram->uniform("patchSize", float(_terrain->patchSize()));
+		_groundProgram->uniform("maxLevel", _terrain->gridLevels() - 1);
+		_terrain->setClipmapUniforms(*_groundProgram);
 
+		GLUtilities::bindBuffer(_terrain->patches(), 0);
 		GLUtilities::bindTexture(_terrain->map(), 0);
 		GLUtilities::bindTexture(_terrain->shadowMap(), 1);
 		GLUtilities::bindTexture(_surfaceNoise, 2);
@@ -212,26 +213,17 @@ void IslandApp::draw() {
 		GLUtilities::bindTexture(_sandMapSteep, 4);
 		GLUtilities::bindTexture(_sandMapFlat, 5);
 
-
-		for(const Terrain::Cell & cell : _terrain->cells()){
-			// Compute equivalent of vertex shader vertex transformation.
-			const float levelSize = std::exp2(float(cell.level)) * _terrain->texelSize();
-			glm::vec3 mini = _terrain->texelSize() * cell.mesh.bbox.minis + glm::round(frontPosClamped/levelSize) * levelSize;
-			glm::vec3 maxi = _terrain->texelSize() * cell.mesh.bbox.maxis + glm::round(frontPosClamped/levelSize) * levelSize;
-			mini[1] = -5.0f; maxi[1] = 5.0f;
-			BoundingBox box(mini, maxi);
-			if(!camFrustum.intersects(box)){
-				continue;
-			}
+		// All visible patches in a single draw call.
+		if(patchCount > 0){
 			_groundProgram->uniform("debugCol", false);
-			GLUtilities::drawMesh(cell.mesh);
+			GLUtilities::drawInstancedMesh(_terrain->patchMesh(), patchCount);
 
 			// Debug view.
 			if(_showWire){
 				GLUtilities::setPolygonState(PolygonMode::LINE);
 				GLUtilities::setDepthState(true, TestFunction::LEQUAL, true);
 				_groundProgram->uniform("debugCol", true);
-				GLUtilities::drawMesh(cell.mesh);
+				GLUtilities::drawInstancedMesh(_terrain->patchMesh(), patchCount);
 				GLUtilities::setPolygonState(PolygonMode::FILL);
 				GLUtilities::setDepthState(true, TestFunction::LESS, true);
 			}
@@ -259,21 +251,29 @@ void IslandApp::draw() {
 	if(_showOcean){
 		const bool isUnderwater = camPos.y < 0.00f;
 
+		// Underwater terrain targets are only needed while rendering the ocean.
+		FramebufferPool & pool = FramebufferPool::manager();
+		const uint width = _sceneBuffer->width();
+		const uint height = _sceneBuffer->height();
+		Framebuffer * waterPos = pool.acquire(width, height, _sceneBuffer->descriptor(1), "Water position");
+		Framebuffer * waterEffectsHalf = pool.acquire(width/2, height/2, _sceneBuffer->descriptor(0), "Water effect half");
+		Framebuffer * waterEffectsBlur = pool.acquire(width/2, height/2, _sceneBuffer->descriptor(0), "Water effect blur");
+
 		// Start by copying the visible terrain info.
 		// Blit full res position map.
-		GLUtilities::blit(*_sceneBuffer->texture(1), *_waterPos, Filter::NEAREST);
+		GLUtilities::blit(*_sceneBuffer->texture(1), *waterPos, Filter::NEAREST);
 
 		if(isUnderwater){
 			// Blit color as-is if underwater (blur will happen later)
-			GLUtilities::blit(*_sceneBuffer->texture(0), *_waterEffectsHalf, Filter::LINEAR);
+			GLUtilities::blit(*_sceneBuffer->texture(0), *waterEffectsHalf, Filter::LINEAR);
 		} else {
 			// Else copy, downscale, apply caustics and blur.
 			GLUtilities::setDepthState(false);
 			GLUtilities::setCullState(true, Faces::BACK);
 			GLUtilities::setBlendState(false);
 
-			_waterEffectsHalf->bind();
-			_waterEffectsHalf->setViewport();
+			waterEffectsHalf->bind();
+			waterEffectsHalf->setViewport();
 			_waterCopy->use();
 			GLUtilities::bindTexture(_sceneBuffer->texture(0), 0);
 			GLUtilities::bindTexture(_sceneBuffer->texture(1), 1);
@@ -282,7 +282,7 @@ void IslandApp::draw() {
 			_waterCopy->uniform("time", time);
 			ScreenQuad::draw();
 
-			_blur.process(_waterEffectsHalf->texture(0), *_waterEffectsBlur);
+			_blur.process(waterEffectsHalf->texture(0), *waterEffectsBlur);
 		}
 
 		// Render the ocean waves.
@@ -305,15 +305,14 @@ void IslandApp::draw() {
 		_oceanProgram->uniform("distantProxy", false);
 		_oceanProgram->uniform("time", time);
 		_oceanProgram->uniform("invTargetSize", invRenderSize);
-		_oceanProgram->uniform("invTexelSize", 1.0f/_terrain->texelSize());
-		_oceanProgram->uniform("invMapSize", 1.0f/float(_terrain->map().width));
+		_terrain->setClipmapUniforms(*_oceanProgram);
 		_oceanProgram->uniform("useTerrain", _showTerrain);
 
 		GLUtilities::bindBuffer(_waves, 0);
 		GLUtilities::bindTexture(_foam, 0);
-		GLUtilities::bindTexture(_waterEffectsHalf->texture(0), 1);
-		GLUtilities::bindTexture(_waterPos->texture(0), 2);
-		GLUtilities::bindTexture(_waterEffectsBlur->texture(0), 3);
+		GLUtilities::bindTexture(waterEffectsHalf->texture(0), 1);
+		GLUtilities::bindTexture(waterPos->texture(0), 2);
+		GLUtilities::bindTexture(waterEffectsBlur->texture(0), 3);
 		GLUtilities::bindTexture(_absorbScatterOcean, 4);
 		GLUtilities::bindTexture(_waveNormals, 5);
 		GLUtilities::bindTexture(_environment->texture(), 6);
@@ -337,8 +336,8 @@ void IslandApp::draw() {
 			GLUtilities::setDepthState(false);
 			GLUtilities::setBlendState(false);
 
-			_waterEffectsHalf->bind();
-			_waterEffectsHalf->setViewport();
+			waterEffectsHalf->bind();
+			waterEffectsHalf->setViewport();
 			_waterCopy->use();
 			GLUtilities::bindTexture(_sceneBuffer->texture(0), 0);
 			GLUtilities::bindTexture(_sceneBuffer->texture(1), 1);
@@ -347,10 +346,10 @@ void IslandApp::draw() {
 			_waterCopy->uniform("time", time);
 			ScreenQuad::draw();
 
-			_blur.process(_waterEffectsHalf->texture(0), *_waterEffectsBlur);
+			_blur.process(waterEffectsHalf->texture(0), *waterEffectsBlur);
 
 			// Blit full res position map.
-			GLUtilities::blit(*_sceneBuffer->texture(1), *_waterPos, Filter::NEAREST);
+			GLUtilities::blit(*_sceneBuffer->texture(1), *waterPos, Filter::NEAREST);
 
 			// Render full screen effect.
 			_sceneBuffer->bind();
@@ -368,9 +367,9 @@ void IslandApp::draw() {
 
 			GLUtilities::bindBuffer(_waves, 0);
 			GLUtilities::bindTexture(_foam, 0);
-			GLUtilities::bindTexture(_waterEffectsHalf->texture(0), 1);
-			GLUtilities::bindTexture(_waterPos->texture(0), 2);
-			GLUtilities::bindTexture(_waterEffectsBlur->texture(0), 3);
+			GLUtilities::bindTexture(waterEffectsHalf->texture(0), 1);
+			GLUtilities::bindTexture(waterPos->texture(0), 2);
+			GLUtilities::bindTexture(waterEffectsBlur->texture(0), 3);
 			GLUtilities::bindTexture(_absorbScatterOcean, 4);
 			GLUtilities::bindTexture(_waveNormals, 5);
 			GLUtilities::bindTexture(_environment->texture(), 6);
@@ -393,15 +392,14 @@ void IslandApp::draw() {
 			_farOceanProgram->uniform("groundGridHalf", _terrain->meshSize()*0.5f);
 			_farOceanProgram->uniform("invTargetSize", invRenderSize);
 			_farOceanProgram->uniform("underwater", isUnderwater);
-			_farOceanProgram->uniform("invTexelSize", 1.0f/_terrain->texelSize());
-			_farOceanProgram->uniform("invMapSize", 1.0f/float(_terrain->map().width));
+			_terrain->setClipmapUniforms(*_farOceanProgram);
 			_farOceanProgram->uniform("useTerrain", _showTerrain);
 
 			GLUtilities::bindBuffer(_waves, 0);
 			GLUtilities::bindTexture(_foam, 0);
-			GLUtilities::bindTexture(_waterEffectsHalf->texture(0), 1);
-			GLUtilities::bindTexture(_waterPos->texture(0), 2);
-			GLUtilities::bindTexture(_waterEffectsBlur->texture(0), 3);
+			GLUtilities::bindTexture(waterEffectsHalf->texture(0), 1);
+			GLUtilities::bindTexture(waterPos->texture(0), 2);
+			GLUtilities::bindTexture(waterEffectsBlur->texture(0), 3);
 			GLUtilities::bindTexture(_absorbScatterOcean, 4);
 			GLUtilities::bindTexture(_waveNormals, 5);
 			GLUtilities::bindTexture(_environment->texture(), 6);
@@ -418,7 +416,9 @@ void IslandApp::draw() {
 				GLUtilities::setPolygonState(PolygonMode::FILL);
 			}
 		}
-
+		pool.release(waterPos);
+		pool.release(waterEffectsHalf);
+		pool.release(waterEffectsBlur);
 	}
 	_primsOcean.end();
 
@@ -525,9 +525,6 @@ void IslandApp::update() {
 
 void IslandApp::resize() {
 	_sceneBuffer->resize(_config.renderingResolution());
-	_waterPos->resize(_config.renderingResolution());
-	_waterEffectsHalf->resize(_config.renderingResolution()/2.0f);
-	_waterEffectsBlur->resize(_config.renderingResolution()/2.0f);
 }
 
 IslandApp::~IslandApp() {
@@ -57,9 +57,6 @@ private:
 
 	// Buffers.
 	std::unique_ptr<Framebuffer> _sceneBuffer; ///< Scene framebuffer.
-	std::unique_ptr<Framebuffer> _waterEffectsHalf; ///< Underwater terrain with caustics.
-	std::unique_ptr<Framebuffer> _waterPos; ///< Underwater terrain world positions.
-	std::unique_ptr<Framebuffer> _waterEffectsBlur; ///< Blurred underwater terrain.
 	std::unique_ptr<Framebuffer> _environment; ///< Environment cubemap.
 	BoxBlur _blur = BoxBlur(true); ///< Underwater terrain blurring.
 
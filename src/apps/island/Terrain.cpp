@@ -2,220 +2,255 @@
 #include "resources/ResourcesManager.hpp"
 #include "graphics/GLUtilities.hpp"
 #include "graphics/ScreenQuad.hpp"
-
-Terrain::Cell::Cell(uint l, uint x, uint z) : mesh("Cell (" + std::to_string(l) + "," + std::to_string(x) + "," + std::to_string(z) + ")"), level(l) {
-}
-
-Terrain::Terrain(uint resolution, uint seed) : _gaussBlur(2, 1), _resolution(resolution), _seed(seed) {
+#include "renderers/DebugViewer.hpp"
+#include "system/System.hpp"
+
+Terrain::Terrain(uint resolution, uint seed) : _patches(_maxPatches, BufferType::UNIFORM, DataUse::DYNAMIC), _resolution(resolution), _seed(seed) {
+	// Keep one core for the main thread.
+	const uint threadCount = glm::clamp(std::thread::hardware_concurrency(), 2u, 6u) - 1u;
+	for(uint tid = 0; tid < threadCount; ++tid){
+		_workers.emplace_back(&Terrain::generationLoop, this);
+	}
+	_mapCenter = glm::vec2(0.5f * float(_resolution));
 	generateMesh();
 	generateMap();
-	_shadowBuffer.reset(new Framebuffer(resolution, resolution, {Layout::RG8, Filter::LINEAR_LINEAR, Wrap::CLAMP}, false, "Terrain shadow"));
 }
 
 void Terrain::generateMesh(){
-	// Clear any existing mesh.
-	for(Cell & cell : _cells){
-		cell.mesh.clean();
-	}
-	_cells.clear();
-
-	const int numLevels = _mshOpts.levels;
-	const int baseLevelTexelSize = _mshOpts.size;
-	const int elementCount = baseLevelTexelSize/2;
-	// Update the world space mesh side size.
-	_meshSize = float((1 << numLevels) * (elementCount + 1));
-
-	for(int lid = 0; lid < numLevels; ++lid){
-		// Size of a basic square.
-		const int currSize = 1 << lid;
-		const int prevSize = std::max(1 << (lid-1), 0);
-		const int rad = currSize * (elementCount + 1);
-
-		// We need a special 8x8 partitioning.
-		const int hSize = elementCount * prevSize;
-		std::array<int, 9> bounds = {-rad, -rad + hSize/2, -hSize, -hSize/2, 0, hSize/2, hSize, rad-hSize/2, rad-1};
-
-		for(int cellZ = 0; cellZ < 8; ++cellZ){
-			for(int cellX = 0; cellX < 8; ++cellX){
-				// Check if the current cell falls inside one of the previous levels.
-				if(lid > 0 && (cellZ >= 2 && cellZ < 6) && (cellX >= 2 && cellX < 6)){
-					continue;
-				}
-
-				// Generate positions and triangles for the cell.
-				std::vector<glm::vec3> positions;
-				std::vector<uint> indices;
-				uint baseId = 0;
-
-				for(int z = bounds[cellZ]; z <= bounds[cellZ+1]; z += currSize){
-					for(int x = bounds[cellX]; x <= bounds[cellX+1]; x += currSize){
-						// Compute positions for corners, edge centers and square center.
-						const glm::vec3 pNW(x, lid, z);
-						const glm::vec3 pNE(x + currSize, lid, z);
-						const glm::vec3 pSW(x, lid, z + currSize);
-						const glm::vec3 pSE(x + currSize, lid, z + currSize);
-						const glm::vec3 pN = 0.5f * (pNW + pNE);
-						const glm::vec3 pS = 0.5f * (pSW + pSE);
-						const glm::vec3 pW = 0.5f * (pNW + pSW);
-						const glm::vec3 pE = 0.5f * (pNE + pSE);
-						const glm::vec3 pC = 0.5f * (pNW + pSE);
-						positions.push_back(pNW);
-						positions.push_back(pN);
-						positions.push_back(pNE);
-						positions.push_back(pW);
-						positions.push_back(pC);
-						positions.push_back(pE);
-						positions.push_back(pSW);
-						positions.push_back(pS);
-						positions.push_back(pSE);
-
-
-						// Special processing at borders.
-						if(x == -rad){
-							// We do a larger triangle to connect to the next level.
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 0);
-							indices.push_back(baseId + 6);
-						} else {
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 0);
-							indices.push_back(baseId + 3);
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 3);
-							indices.push_back(baseId + 6);
-						}
-
-						if(z == -rad){
-							// We do a larger triangle to connect to the next level.
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 2);
-							indices.push_back(baseId + 0);
-						} else {
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 2);
-							indices.push_back(baseId + 1);
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 1);
-							indices.push_back(baseId + 0);
-						}
-
-						if(x + currSize >= rad){
-							// We do a larger triangle to connect to the next level.
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 8);
-							indices.push_back(baseId + 2);
-						} else {
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 8);
-							indices.push_back(baseId + 5);
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 5);
-							indices.push_back(baseId + 2);
-						}
-
-						if(z + currSize >= rad){
-							// We do a larger triangle to connect to the next level.
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 6);
-							indices.push_back(baseId + 8);
-						} else {
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 6);
-							indices.push_back(baseId + 7);
-							indices.push_back(baseId + 4);
-							indices.push_back(baseId + 7);
-							indices.push_back(baseId + 8);
-						}
-
-						baseId += 9;
-					}
-				}
-
-				if(positions.empty()){
+	_patchMesh.clean();
+	_allPatches.clear();
+
+	// Patches origins have to be aligned on the coarser level grid.
+	_mshOpts.size = std::max(8, (_mshOpts.size / 8) * 8);
+	_mshOpts.levels = glm::clamp(_mshOpts.levels, 1, _maxLevels);
+	const int patchSize = _mshOpts.size / 4;
+	// Update the mesh side size, in texels.
+	_meshSize = float(4 * patchSize * (1 << (_mshOpts.levels - 1)));
+
+	// Single patch, with shared vertices.
+	const uint rowSize = uint(patchSize) + 1;
+	for(int z = 0; z <= patchSize; ++z){
+		for(int x = 0; x <= patchSize; ++x){
+			_patchMesh.positions.emplace_back(float(x), 0.0f, float(z));
+		}
+	}
+	for(uint z = 0; z < uint(patchSize); ++z){
+		for(uint x = 0; x < uint(patchSize); ++x){
+			const uint i00 = z * rowSize + x;
+			const uint i10 = i00 + 1;
+			const uint i01 = i00 + rowSize;
+			const uint i11 = i01 + 1;
+			_patchMesh.indices.push_back(i00);
+			_patchMesh.indices.push_back(i01);
+			_patchMesh.indices.push_back(i11);
+			_patchMesh.indices.push_back(i00);
+			_patchMesh.indices.push_back(i11);
+			_patchMesh.indices.push_back(i10);
+		}
+	}
+	_patchMesh.computeBoundingBox();
+	_patchMesh.upload();
+
+	// Each level is a 4x4 grid of patches, the central 2x2 being covered by the finer levels.
+	for(int lid = 0; lid < _mshOpts.levels; ++lid){
+		const int levelSize = patchSize * (1 << lid);
+		for(int pz = 0; pz < 4; ++pz){
+			for(int px = 0; px < 4; ++px){
+				if(lid > 0 && (pz == 1 || pz == 2) && (px == 1 || px == 2)){
 					continue;
 				}
-				_cells.emplace_back(lid, cellX, cellZ);
-				_cells.back().level = lid;
-				Mesh & mesh = _cells.back().mesh;
-				mesh.clean();
-				mesh.positions = positions;
-				mesh.indices = indices;
+				_allPatches.emplace_back(float((px - 2) * levelSize), float((pz - 2) * levelSize), float(lid), 0.0f);
 			}
 		}
 	}
-	for(Cell & cell : _cells){
-		cell.mesh.computeBoundingBox();
-		cell.mesh.upload();
-	}
 }
 
 void Terrain::generateMap(){
+	// Invalidate all previous requests.
+	++_generation;
+	{
+		std::lock_guard<std::mutex> lock(_requestsMutex);
+		_requests.clear();
+	}
+	{
+		std::lock_guard<std::mutex> lock(_resultsMutex);
+		_results.clear();
+	}
+	_pendingTiles.clear();
+	_tiles.clear();
+
+	std::shared_ptr<MapSettings> settings(new MapSettings());
+	settings->generation = _genOpts;
+	settings->erosion = _erOpts;
+	settings->resolution = _resolution;
+	settings->seed = _seed;
+	settings->texelSize = _texelSize;
+	_settings = settings;
+
+	resetClipmaps();
+
+	// The coarsest level covers the whole map and is generated immediately.
+	const int coarsest = int(_levels.size()) - 1;
+	const int tileCount = _clipSize / _tileSize;
+	std::vector<Image> tiles(tileCount * tileCount);
+	System::forParallel(0, tiles.size(), [this, &tiles, coarsest, tileCount](size_t tid){
+		TileRequest request;
+		request.id.level = coarsest;
+		request.id.coords = glm::ivec2(int(tid) % tileCount, int(tid) / tileCount);
+		request.generation = _generation;
+		request.settings = _settings;
+		tiles[tid] = generateTile(request, _perlin);
+	});
+	for(size_t tid = 0; tid < tiles.size(); ++tid){
+		TileId id;
+		id.level = coarsest;
+		id.coords = glm::ivec2(int(tid) % tileCount, int(tid) / tileCount);
+		Tile & tile = _tiles[id];
+		tile.data = std::move(tiles[tid]);
+		tile.lastUse = _frame;
+	}
+	moveWindow(coarsest, glm::ivec2(0));
+	// Populate finer levels around the current center.
+	for(int lid = coarsest - 1; lid >= 0; --lid){
+		moveWindow(lid, windowOrigin(lid, _mapCenter));
+	}
+}
 
-	Random::seed(_seed);
+void Terrain::resetClipmaps(){
+	// Clip levels are needed until the coarsest one covers the whole map.
+	_resolution = glm::clamp(_resolution, _clipSize, _clipSize << (_maxLevels - 1));
+	int levelCount = 1;
+	while((_clipSize << (levelCount - 1)) < _resolution){
+		++levelCount;
+	}
+	_levels.assign(levelCount, ClipLevel());
 
-	Image heightMap(_resolution, _resolution, 1);
-	// Generate FBM noise with multiple layers of Perlin noise.
-	_perlin.generateLayers(heightMap, _genOpts.octaves, _genOpts.gain, _genOpts.lacunarity, _genOpts.scale);
+	_map.clean();
+	_map.width = _map.height = _clipSize;
+	_map.depth = uint(levelCount);
+	_map.levels = 1;
+	_map.shape = TextureShape::Array2D;
+	// Wrap around to use toroidal addressing.
+	GLUtilities::setupTexture(_map, {Layout::RGBA32F, Filter::LINEAR, Wrap::REPEAT});
+	DebugViewer::trackDefault(&_map);
+
+	_shadowBuffer.reset(new Framebuffer(TextureShape::Array2D, _clipSize, _clipSize, uint(levelCount), 1, {{Layout::RG8, Filter::LINEAR, Wrap::REPEAT}}, false, "Terrain shadow"));
+}
 
-	// Adjust to create the island overall shape and scale.
-	const float invSize = 1.0f/float(heightMap.width);
-	for(uint y = 0; y < heightMap.height; ++y){
-		for(uint x = 0; x < heightMap.width; ++x){
+Image Terrain::generateTile(const TileRequest & request, const PerlinNoise & perlin){
+	const MapSettings & settings = *request.settings;
+	const GenerationSettings & genOpts = settings.generation;
+	const int size = _tileSize + 2 * _apron;
+	// Texel spacing of the level, in map texels.
+	const int step = 1 << request.id.level;
+	const glm::ivec2 firstTexel = request.id.coords * _tileSize - _apron;
+
+	// Generate FBM noise with multiple layers of Perlin noise, adjusted to create the island overall shape and scale.
+	Image heightMap(size, size, 1);
+	const float invSize = 1.0f / float(settings.resolution);
+	for(int y = 0; y < size; ++y){
+		for(int x = 0; x < size; ++x){
+			const glm::vec2 pos = glm::vec2(step * (firstTexel + glm::ivec2(x, y)));
+			const float val = perlin.sampleLayers(glm::vec3(pos, 0.0f), genOpts.octaves, genOpts.gain, genOpts.lacunarity, genOpts.scale);
 			// Compute UV.
-			const glm::vec2 uv = 2.0f * invSize * glm::vec2(x,y) - 1.0f;
+			const glm::vec2 uv = 2.0f * invSize * pos - 1.0f;
 			const float dst2 = glm::dot(uv, uv);
-			const float scale = _genOpts.rescale * std::pow(std::max(1.0f - dst2, 0.0f), _genOpts.falloff);
-			const float val = heightMap.r(x,y);
-			heightMap.r(x,y) = _genOpts.maxHeight * (scale * (val + 1.0f) - 1.0f);
+			const float scale = genOpts.rescale * std::pow(std::max(1.0f - dst2, 0.0f), genOpts.falloff);
+			heightMap.r(x,y) = genOpts.maxHeight * (scale * (val + 1.0f) - 1.0f);
 		}
 	}
 
 	// Then smooth to avoid pinches.
-	Image dst(heightMap.width, heightMap.height, 1);
-	for(int y = 0; y < int(heightMap.height); ++y){
-		for(int x = 0; x < int(heightMap.width); ++x){
+	Image dst(size, size, 1);
+	for(int y = 0; y < size; ++y){
+		for(int x = 0; x < size; ++x){
 			const int xm = std::max(x-1, 0);
-			const int xp = std::min(x+1, int(heightMap.width)-1);
+			const int xp = std::min(x+1, size-1);
 			const int ym = std::max(y-1, 0);
-			const int yp = std::min(y+1, int(heightMap.height)-1);
+			const int yp = std::min(y+1, size-1);
 			const float & rN = heightMap.r(xm, y);
 			const float & rS = heightMap.r(xp, y);
 			const float & rW = heightMap.r(x, ym);
 			const float & rE = heightMap.r(x, yp);
 			const float & r  = heightMap.r(x,y);
-			const float newHeight = 0.35f * r + 0.25f * 0.65f * (rN + rS + rW + rE);
-			dst.r(x,y) = newHeight;
+			dst.r(x,y) = 0.35f * r + 0.25f * 0.65f * (rN + rS + rW + rE);
 		}
 	}
-	// Final copy.
-	for(int y = 0; y < int(heightMap.height); ++y){
-		for(int x = 0; x < int(heightMap.width); ++x){
-			heightMap.r(x,y) = dst.r(x,y);
+	std::swap(heightMap, dst);
+
+	// Erosion. Droplets are spawned in cells of the level grid, seeded by the cell coordinates,
+	// so that overlapping regions of neighbouring tiles see the same droplets.
+	const ErosionSettings & erOpts = settings.erosion;
+	if(erOpts.apply){
+		const int cellCount = size / _apron;
+		const float cellDrops = float(erOpts.dropsCount) * float(_apron * _apron) / (1024.0f * 1024.0f);
+		for(int cy = 0; cy < cellCount; ++cy){
+			for(int cx = 0; cx < cellCount; ++cx){
+				const glm::ivec2 cell = firstTexel / _apron + glm::ivec2(cx, cy);
+				std::seed_seq seeds = {uint32_t(settings.seed), uint32_t(request.id.level), uint32_t(cell.x), uint32_t(cell.y)};
+				std::mt19937 rng(seeds);
+				std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+				const float drops = std::floor(cellDrops) + (dist(rng) < glm::fract(cellDrops) ? 1.0f : 0.0f);
+				erode(heightMap, erOpts, rng, int(drops), glm::vec2(cx * _apron, cy * _apron), float(_apron));
+			}
 		}
 	}
 
-	// Erosion.
-	if(_erOpts.apply){
-		erode(heightMap);
-	}
+	// Compute normals for the tile core.
+	Image tile(_tileSize, _tileSize, 4);
+	const glm::ivec2 maxPos = glm::ivec2(size-1);
+	const int rad = 4;
+	const float dWorld = 2.0f * float(rad) * float(step) * settings.texelSize;
+	for(int y = 0; y < _tileSize; ++y){
+		for(int x = 0; x < _tileSize; ++x){
+			const glm::ivec2 pix(x + _apron, y + _apron);
+			// Compute normal using smooth finite differences.
+			glm::vec2 dh(0.0f);
+			float total = 0.0f;
+			for(int ds = -2; ds < 2; ++ds){
+				const float weight = 1.0f / (std::abs(ds) + 1.0f);
+				total += weight;
+				for(int dds = 1; dds <= rad; ++dds){
+
+					const glm::ivec2 pixXp = glm::clamp(pix + glm::ivec2(dds, ds), glm::ivec2(0), maxPos);
+					const glm::ivec2 pixXm = glm::clamp(pix - glm::ivec2(dds, ds), glm::ivec2(0), maxPos);
+					dh[0] += weight * (heightMap.r(pixXp[0], pixXp[1]) - heightMap.r(pixXm[0], pixXm[1]));
+
+					const glm::ivec2 pixZp = glm::clamp(pix + glm::ivec2(ds, dds), glm::ivec2(0), maxPos);
+					const glm::ivec2 pixZm = glm::clamp(pix - glm::ivec2(ds, dds), glm::ivec2(0), maxPos);
+					dh[1] += weight * (heightMap.r(pixZp[0], pixZp[1]) - heightMap.r(pixZm[0], pixZm[1]));
+				}
+			}
+			dh /= (float(rad) * total);
 
-	// Compute normals and mips.
-	transferAndUpdateMap(heightMap);
+			glm::vec3 n = glm::cross(glm::vec3(0.0f, dh[1], dWorld), glm::vec3(dWorld, dh[0], 0.0f));
+			n = glm::normalize(n);
 
+			tile.rgba(x,y) = glm::vec4(heightMap.r(pix[0], pix[1]), n);
+		}
+	}
+	return tile;
 }
 
-void Terrain::erode(Image & img){
+void Terrain::erode(Image & img, const ErosionSettings & settings, std::mt19937 & rng, int drops, const glm::vec2 & origin, float size){
 
-	const glm::ivec2 maxPos = glm::ivec2(img.width-1);
-	for(int did = 0; did < _erOpts.dropsCount; ++did){
+	const glm::ivec2 maxPos = glm::ivec2(img.width-1, img.height-1);
+	std::uniform_real_distribution<float> dist(0.0f, size);
+	const int rad = settings.gatherRadius;
+	const int tsize = 2*rad+1;
+	std::vector<float> wis(tsize * tsize);
+
+	for(int did = 0; did < drops; ++did){
 		// Draw a point at random.
-		glm::vec2 pos(Random::Float(0.0f, float(maxPos[0])), Random::Float(0.0f, float(maxPos[1])));
+		const float px = dist(rng);
+		const float py = dist(rng);
+		glm::vec2 pos = glm::min(origin + glm::vec2(px, py), glm::vec2(maxPos));
 		glm::vec2 dir(0.0f, 0.0f);
 		float velocity = 1.0f;
 		float water = 1.0f;
 		float sediment = 0.0f;
 
-		for(int sid = 0; sid < _erOpts.stepsMax; ++sid){
+		for(int sid = 0; sid < settings.stepsMax; ++sid){
 			if(water < 0.00001f){
 				break;
 			}
@@ -233,7 +268,7 @@ void Terrain::erode(Image & img){
 								 (h01 - h00) * (1.0f - dpos.x) + (h11 - h10) * (dpos.x));
 
 			// We go down the slope, with some inertia.
-			dir = _erOpts.inertia * dir - (1.0f - _erOpts.inertia) * grad;
+			dir = settings.inertia * dir - (1.0f - settings.inertia) * grad;
 			if(dir[0] != 0.0f || dir[1] != 0.0f){
 				dir = glm::normalize(dir);
 			}
@@ -259,11 +294,11 @@ void Terrain::erode(Image & img){
 			}
 
 			const float dHeight = newHeight - oldHeight;
-			const float capacity = std::max(-dHeight, _erOpts.minSlope) * velocity * water * _erOpts.capacityBase;
+			const float capacity = std::max(-dHeight, settings.minSlope) * velocity * water * settings.capacityBase;
 
 			if(sediment > capacity || dHeight > 0.0){
 				// Deposit at the old location.
-				const float deposit = dHeight > 0.0 ? std::min(sediment, dHeight) : ((sediment - capacity) * _erOpts.deposition);
+				const float deposit = dHeight > 0.0 ? std::min(sediment, dHeight) : ((sediment - capacity) * settings.deposition);
 				sediment -= deposit;
 				img.r( ipos[0],  ipos[1]) += (1.0f - dpos.x) * (1.0f - dpos.y) * deposit;
 				img.r( ipos[0], inpos[1]) += (1.0f - dpos.x) * (dpos.y) * deposit;
@@ -272,17 +307,14 @@ void Terrain::erode(Image & img){
 			} else {
 
 				// Take some from the old location surroundings.
-				float gather = std::min((capacity - sediment) * _erOpts.erosion, -dHeight);
+				float gather = std::min((capacity - sediment) * settings.erosion, -dHeight);
 				sediment += gather;
 				float total = 0.0f;
-				const int rad = _erOpts.gatherRadius;
-				const int tsize = 2*rad+1;
-				std::vector<std::vector<float>> wis(tsize, std::vector<float>(tsize));
 				for(int dy = -rad; dy <= rad; ++dy){
 					for(int dx = -rad; dx <= rad; ++dx){
 						const float wi = std::max(0.0f, rad - glm::distance(glm::vec2(ipos[0]+dx, ipos[1]+dy), oldPos));
 						total += wi;
-						wis[dy+rad][dx+rad] = wi;
+						wis[(dy+rad) * tsize + (dx+rad)] = wi;
 					}
 				}
 				for(int dy = -rad; dy <= rad; ++dy){
@@ -291,143 +323,241 @@ void Terrain::erode(Image & img){
 						if(nnpos[0] < 0 || nnpos[1] < 0 || nnpos[0] > maxPos[0] || nnpos[1] > maxPos[1]){
 							continue;
 						}
-						img.r(nnpos[0], nnpos[1]) -= gather * wis[dy+rad][dx+rad]/total;
+						img.r(nnpos[0], nnpos[1]) -= gather * wis[(dy+rad) * tsize + (dx+rad)]/total;
 					}
 				}
 
 			}
-			water *= (1.0f - _erOpts.evaporation);
-			velocity = std::sqrt(std::max(0.0f, velocity*velocity + dHeight * _erOpts.gravity));
+			water *= (1.0f - settings.evaporation);
+			velocity = std::sqrt(std::max(0.0f, velocity*velocity + dHeight * settings.gravity));
 		}
 
 	}
 }
 
-void Terrain::transferAndUpdateMap(Image & heightMap){
-
-	_map.width = _map.height = _resolution;
-	_map.levels = _map.depth = 1;
-	_map.shape = TextureShape::D2;
-	_map.clean();
+void Terrain::generationLoop(){
+	while(true){
+		TileRequest request;
+		{
+			std::unique_lock<std::mutex> lock(_requestsMutex);
+			_requestsCondition.wait(lock, [this]{ return _stopWorkers || !_requests.empty(); });
+			if(_stopWorkers){
+				return;
+			}
+			request = _requests.front();
+			_requests.pop_front();
+		}
+		Image tile = generateTile(request, _perlin);
+		{
+			std::lock_guard<std::mutex> lock(_resultsMutex);
+			_results.emplace_back(request, std::move(tile));
+		}
+	}
+}
 
-	_map.images.emplace_back(_map.width, _map.height, 4);
-	const glm::ivec2 maxPos = glm::ivec2(_map.width-1);
-	const int rad = 4;
-	const float dWorld = 2.0f * float(rad) * _texelSize;
-	for(uint y = 0; y < _map.height; ++y){
-		for(uint x = 0; x < _map.width; ++x){
-			// Compute normal using smooth finite differences.
-			glm::vec2 dh(0.0f);
-			float total = 0.0f;
-			for(int ds = -2; ds < 2; ++ds){
-				const float weight = 1.0f / (std::abs(ds) + 1.0f);
-				total += weight;
-				for(int dds = 1; dds <= rad; ++dds){
+void Terrain::collectTiles(){
+	std::vector<std::pair<TileRequest, Image>> results;
+	{
+		std::lock_guard<std::mutex> lock(_resultsMutex);
+		std::swap(results, _results);
+	}
+	for(auto & result : results){
+		// Skip tiles generated with outdated settings.
+		if(result.first.generation != _generation){
+			continue;
+		}
+		_pendingTiles.erase(result.first.id);
+		Tile & tile = _tiles[result.first.id];
+		tile.data = std::move(result.second);
+		tile.lastUse = _frame;
+	}
+}
 
-					const glm::ivec2 pixXp = glm::clamp(glm::ivec2(x + dds, y + ds), glm::ivec2(0), maxPos);
-					const float heightXp = heightMap.r(pixXp[0], pixXp[1]);
-					const glm::ivec2 pixXm = glm::clamp(glm::ivec2(x - dds, y - ds), glm::ivec2(0), maxPos);
-					const float heightXm = heightMap.r(pixXm[0], pixXm[1]);
-					dh[0] += weight * (heightXp - heightXm);
-
-					const glm::ivec2 pixZp = glm::clamp(glm::ivec2(x + ds, y + dds), glm::ivec2(0), maxPos);
-					const float heightZp = heightMap.r(pixZp[0], pixZp[1]);
-					const glm::ivec2 pixZm = glm::clamp(glm::ivec2(x - ds, y - dds), glm::ivec2(0), maxPos);
-					const float heightZm = heightMap.r(pixZm[0], pixZm[1]);
-					dh[1] += weight * (heightZp - heightZm);
-				}
-			}
-			dh /= (float(rad) * total);
+void Terrain::requestTile(const TileId & tile){
+	if(_tiles.count(tile) > 0 || _pendingTiles.count(tile) > 0){
+		return;
+	}
+	_pendingTiles.insert(tile);
+	TileRequest request;
+	request.id = tile;
+	request.generation = _generation;
+	request.settings = _settings;
+	{
+		std::lock_guard<std::mutex> lock(_requestsMutex);
+		_requests.push_back(request);
+	}
+	_requestsCondition.notify_one();
+}
 
-			glm::vec3 n = glm::cross(glm::vec3(0.0f, dh[1], dWorld), glm::vec3(dWorld, dh[0], 0.0f));
-			n = glm::normalize(n);
+glm::ivec2 Terrain::windowOrigin(int level, const glm::vec2 & center) const {
+	const int tileCount = _clipSize / _tileSize;
+	// Center in tiles of the level.
+	const glm::vec2 tileCenter = center / float((1 << level) * _tileSize);
+	return glm::ivec2(glm::round(tileCenter)) - tileCount / 2;
+}
 
-			_map.images[0].rgba(x,y) = glm::vec4(heightMap.r(x,y), n);
+bool Terrain::moveWindow(int level, const glm::ivec2 & origin){
+	const int tileCount = _clipSize / _tileSize;
+	// Check that all tiles are available, requesting the missing ones.
+	bool ready = true;
+	for(int y = 0; y < tileCount; ++y){
+		for(int x = 0; x < tileCount; ++x){
+			TileId id;
+			id.level = level;
+			id.coords = origin + glm::ivec2(x, y);
+			auto tile = _tiles.find(id);
+			if(tile == _tiles.end()){
+				requestTile(id);
+				ready = false;
+				continue;
+			}
+			tile->second.lastUse = _frame;
+		}
+	}
+	if(!ready){
+		return false;
+	}
 
+	// Upload tiles that were not part of the previous window, in place.
+	ClipLevel & clip = _levels[level];
+	for(int y = 0; y < tileCount; ++y){
+		for(int x = 0; x < tileCount; ++x){
+			const glm::ivec2 coords = origin + glm::ivec2(x, y);
+			const glm::ivec2 prevCoords = coords - clip.origin;
+			if(clip.valid && glm::all(glm::greaterThanEqual(prevCoords, glm::ivec2(0))) && glm::all(glm::lessThan(prevCoords, glm::ivec2(tileCount)))){
+				continue;
+			}
+			TileId id;
+			id.level = level;
+			id.coords = coords;
+			const glm::ivec2 slot = ((coords % tileCount) + tileCount) % tileCount;
+			GLUtilities::uploadTextureRegion(_map, _tiles[id].data, uint(level), 0, uint(slot.x * _tileSize), uint(slot.y * _tileSize));
 		}
 	}
-	
-	// Build mipmaps.
-	_map.levels = _map.getMaxMipLevel();
-	std::array<float, 9> weights = {1.0f/16.0f, 1.0f/8.0f, 1.0f/16.0f,
-									1.0f/8.0f, 1.0f/4.0f, 1.0f/8.0f,
-									1.0f/16.0f, 1.0f/8.0f, 1.0f/16.0f};
-	for(uint lid = 1; lid < _map.levels; ++lid){
-		const uint w = _map.width / (1 << lid);
-		const uint h = _map.height / (1 << lid);
-		_map.images.emplace_back(w, h, 4);
-		const glm::ivec2 maxPos(w*2-1, h*2-1);
-		Image & currImg = _map.images[lid];
-		Image & prevImg = _map.images[lid-1];
-
-		for(uint y = 0; y < h; ++y){
-			for(uint x = 0; x < w; ++x){
-				const glm::vec2 prevCoords = 2.0f * glm::vec2(x,y) + 0.5f;
-				glm::vec4 total(0.0f);
-				for(int dy = -1; dy <= 1; ++dy){
-					for(int dx = -1; dx <= 1; ++dx){
-						glm::ivec2 coords = glm::ivec2(glm::round(prevCoords + glm::vec2(dx, dy)));
-						coords = glm::clamp(coords, glm::ivec2(0), maxPos);
-						const float & weight = weights[3*(dy+1) + (dx+1)];
-						total += weight * prevImg.rgba(coords[0], coords[1]);
-					}
-				}
-				currImg.rgba(x,y) = total;
+	clip.origin = origin;
+	clip.valid = true;
+	// Finer levels raymarch through this one.
+	for(int lid = 0; lid <= level; ++lid){
+		_levels[lid].shadowDirty = true;
+	}
+	return true;
+}
+
+void Terrain::evictTiles(){
+	const size_t tileCount = size_t((_clipSize / _tileSize) * (_clipSize / _tileSize));
+	const size_t maxTiles = (_levels.size() + 2) * tileCount;
+	while(_tiles.size() > maxTiles){
+		auto oldest = _tiles.end();
+		for(auto tile = _tiles.begin(); tile != _tiles.end(); ++tile){
+			if(oldest == _tiles.end() || tile->second.lastUse < oldest->second.lastUse){
+				oldest = tile;
 			}
 		}
+		// Never evict tiles needed by the current windows.
+		if(oldest->second.lastUse == _frame){
+			break;
+		}
+		_tiles.erase(oldest);
+	}
+}
+
+void Terrain::update(const glm::vec3 & center){
+	++_frame;
+	collectTiles();
+
+	const float halfMap = 0.5f * float(_resolution);
+	_mapCenter = glm::vec2(center.x, center.z) / _texelSize + halfMap;
+	// Snap the grid on the coarsest morphing grid, to keep vertices aligned with the texels of their level.
+	const float snap = float(1 << _mshOpts.levels);
+	const glm::vec2 gridCenter = glm::round(_mapCenter / snap) * snap;
+	_gridCenter = glm::vec3(gridCenter.x - halfMap, 0.0f, gridCenter.y - halfMap) * _texelSize;
+
+	// The coarsest level covers the whole map, move the others, coarse ones first.
+	for(int lid = int(_levels.size()) - 2; lid >= 0; --lid){
+		const glm::ivec2 origin = windowOrigin(lid, _mapCenter);
+		ClipLevel & clip = _levels[lid];
+		if(clip.valid && clip.origin == origin){
+			continue;
+		}
+		moveWindow(lid, origin);
 	}
-	
-	// Send to the GPU.
-	_map.upload({Layout::RGBA32F, Filter::LINEAR_LINEAR, Wrap::CLAMP}, false);
-
-	// Build low res version, with conservative depth estimation.
-	_mapLowRes.width = _mapLowRes.height = _resolution/2;
-	_mapLowRes.levels = _mapLowRes.depth = 1;
-	_mapLowRes.shape = TextureShape::D2;
-	_mapLowRes.clean();
-	_mapLowRes.images.emplace_back(_mapLowRes.width, _mapLowRes.height, 1);
-
-	for(uint y = 0; y < _mapLowRes.height; ++y){
-		for(uint x = 0; x < _mapLowRes.width; ++x){
-			const glm::ivec2 pix(2*x, 2*y);
-			const glm::ivec2 pixi = glm::min(pix+1, maxPos);
-			const float & h00 = _map.images[0].r( pix.x,  pix.y);
-			const float & h10 = _map.images[0].r(pixi.x,  pix.y);
-			const float & h01 = _map.images[0].r( pix.x, pixi.y);
-			const float & h11 = _map.images[0].r(pixi.x, pixi.y);
-			_mapLowRes.images[0].r(x,y) = std::max(std::max(h00, h01), std::max(h10, h11));
+	evictTiles();
+	updateShadows();
+}
+
+uint Terrain::cullPatches(const Frustum & frustum){
+	// Conservative height bounds.
+	const float extent = _genOpts.maxHeight * (1.0f + 3.0f * _genOpts.rescale);
+	const float patchSize = float(_mshOpts.size / 4);
+	uint count = 0;
+	for(const glm::vec4 & patch : _allPatches){
+		const float size = patchSize * float(1 << int(patch.z)) * _texelSize;
+		const glm::vec3 mini = _gridCenter + glm::vec3(patch.x * _texelSize, -extent, patch.y * _texelSize);
+		const glm::vec3 maxi = mini + glm::vec3(size, 2.0f * extent, size);
+		if(frustum.intersects(BoundingBox(mini, maxi))){
+			_patches.data[count++] = patch;
 		}
 	}
-	_mapLowRes.upload({Layout::R32F, Filter::LINEAR_NEAREST, Wrap::CLAMP}, false);
+	if(count > 0){
+		_patches.upload();
+	}
+	return count;
 }
 
+void Terrain::setClipmapUniforms(const Program & program) const {
+	program.uniform("terrainTexelSize", _texelSize);
+	program.uniform("terrainSize", float(_resolution));
+	program.uniform("clipSize", float(_clipSize));
+	program.uniform("clipLevels", int(_levels.size()));
+	for(size_t lid = 0; lid < _levels.size(); ++lid){
+		const ClipLevel & clip = _levels[lid];
+		const float step = float(1 << lid);
+		const glm::vec2 origin = glm::vec2(clip.origin * _tileSize) * step;
+		program.uniform("clipWindows[" + std::to_string(lid) + "]", glm::vec4(origin, clip.valid ? step : 0.0f, 0.0f));
+	}
+}
 
 void Terrain::generateShadowMap(const glm::vec3 & lightDir){
+	_lightDirection = lightDir;
+	for(ClipLevel & clip : _levels){
+		clip.shadowDirty = true;
+	}
+	updateShadows();
+}
 
-	const auto prog = Resources::manager().getProgram2D("shadow_island");
+void Terrain::updateShadows(){
+	bool dirty = false;
+	for(const ClipLevel & clip : _levels){
+		dirty = dirty || (clip.valid && clip.shadowDirty);
+	}
+	if(!dirty){
+		return;
+	}
 
-	const Texture & map = _mapLowRes;
-	// Adjust texel size for potentially smaller map.
-	const float texelSize = _texelSize * float(_map.width) / float(map.width);
-	const uint stepCount = 2 * std::max(map.width, map.height);
+	const auto prog = Resources::manager().getProgram2D("shadow_island");
 	// Make sure light direction is normalized.
-	const glm::vec3 lDir = glm::normalize(lightDir);
+	const glm::vec3 lDir = glm::normalize(_lightDirection);
 
-	_shadowBuffer->bind();
 	_shadowBuffer->setViewport();
 	GLUtilities::setDepthState(false);
 	GLUtilities::setBlendState(false);
 	GLUtilities::setCullState(true, Faces::BACK);
 	prog->use();
-	prog->uniform("stepCount", stepCount);
 	prog->uniform("lDir", lDir);
-	prog->uniform("texelSize", texelSize);
-
-	GLUtilities::bindTexture(map, 0);
-	ScreenQuad::draw();
-
-	// Post process shadow map.
-	_gaussBlur.process(_shadowBuffer->texture(0), *_shadowBuffer);
+	prog->uniform("maxHeight", _genOpts.maxHeight * (1.0f + 3.0f * _genOpts.rescale));
+	setClipmapUniforms(*prog);
+	GLUtilities::bindTexture(_map, 0);
+
+	for(size_t lid = 0; lid < _levels.size(); ++lid){
+		ClipLevel & clip = _levels[lid];
+		if(!clip.valid || !clip.shadowDirty){
+			continue;
+		}
+		_shadowBuffer->bind(lid);
+		prog->uniform("level", int(lid));
+		ScreenQuad::draw();
+		clip.shadowDirty = false;
+	}
 }
 
 bool Terrain::interface(){
@@ -471,6 +601,8 @@ bool Terrain::interface(){
 		dirtyErosion = ImGui::SliderFloat("Deposition", &_erOpts.deposition, 0.0f, 1.0f) || dirtyErosion;
 		ImGui::TreePop();
 	}
+	ImGui::Text("Tiles: %zu cached, %zu pending", _tiles.size(), _pendingTiles.size());
+
 	if(dirtyTerrain || dirtyErosion){
 		generateMap();
 		return true;
@@ -479,8 +611,14 @@ bool Terrain::interface(){
 }
 
 Terrain::~Terrain() {
-	_map.clean();
-	for(Cell & cell : _cells){
-		cell.mesh.clean();
+	{
+		std::lock_guard<std::mutex> lock(_requestsMutex);
+		_stopWorkers = true;
+	}
+	_requestsCondition.notify_all();
+	for(std::thread & worker : _workers){
+		worker.join();
 	}
+	_map.clean();
+	_patchMesh.clean();
 }
@@ -2,49 +2,65 @@
 #include "resources/Image.hpp"
 #include "resources/Texture.hpp"
 #include "resources/Mesh.hpp"
-#include "processing/GaussianBlur.hpp"
+#include "resources/Buffer.hpp"
 #include "graphics/Framebuffer.hpp"
+#include "graphics/Program.hpp"
 #include "generation/PerlinNoise.hpp"
 #include "generation/Random.hpp"
 #include "Common.hpp"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <random>
+
 /** \brief Generate a terrain with Perlin noise and erosion.
  Represent the terrain, regrouping elevation and shadow data and the underlying GPU representation to render it.
+
+ The terrain is rendered using a single small grid patch, instanced to form nested rings of increasing density around the viewer. Vertices close to the outer border of a ring are progressively moved to the positions of the coarser ring, to avoid cracks.
+
+ Elevation and shadows are stored in clipmaps: each level is a fixed-size layer of a texture array, covering a window around the viewer with a texel size doubling at each level. The coarsest level covers the whole terrain. Windows are made of square tiles, generated on demand by background threads and uploaded in place using toroidal addressing when the viewer moves. Memory use thus only grows logarithmically with the terrain resolution.
  \ingroup Island
  */
 class Terrain {
 public:
 
-	/** Terrain mesh cell. */
-	struct Cell {
-		Mesh mesh; ///< The geometry covering this cell.
-		uint level; ///< The density level used to generate the mesh of this cell.
-
-		/** Constructor.
-		 \param l the level of detail
-		 \param x cell x coordinate
-		 \param z cell z coordinate
-		 */
-		Cell(uint l, uint x, uint z);
-	};
-
 	/** Constructor
 	 \param resolution the terrain map resolution
 	 \param seed the random seed for terrain generation
 	 */
 	Terrain(uint resolution, uint seed);
 
-	/** Generate the grid mesh.*/
+	/** Generate the grid patch mesh.*/
 	void generateMesh();
 
-	/** Generate the terrain map for the current seed. */
+	/** Generate the terrain map for the current seed and settings. Only the coarsest level is generated immediately. */
 	void generateMap();
 
-	/** Generate the shadow map for the current terrain and a sun direction.
+	/** Generate the shadow maps for the current terrain and a sun direction.
 	 \param lightDir the sun direction
 	 */
 	void generateShadowMap(const glm::vec3 & lightDir);
 
+	/** Move the grid and clipmaps windows around a new position, uploading generated tiles and updating shadows if needed.
+	 \param center the new center in world space
+	 */
+	void update(const glm::vec3 & center);
+
+	/** Determine which grid patches are visible and upload their placement.
+	 \param frustum the view frustum
+	 \return the number of visible patches, to draw as instances of the patch mesh
+	 */
+	uint cullPatches(const Frustum & frustum);
+
+	/** Set the uniforms needed to sample the terrain clipmaps (see terrain_clipmap.glsl).
+	 \param program the program to update
+	 */
+	void setClipmapUniforms(const Program & program) const;
+
 	/** Display terrain options in GUI, in a currently opened window.
 	 \return true if any option was modified
 	 */
@@ -58,9 +74,19 @@ public:
 		return _texelSize;
 	}
 
-	/** \return the size of the grid. */
-	int gridSize() const {
-		return _mshOpts.size;
+	/** \return the size of the terrain map, in texels. */
+	int mapSize() const {
+		return _resolution;
+	}
+
+	/** \return the number of grid squares along a patch side. */
+	int patchSize() const {
+		return _mshOpts.size / 4;
+	}
+
+	/** \return the number of grid levels. */
+	int gridLevels() const {
+		return _mshOpts.levels;
 	}
 
 	/** \return the size of the grid in world space. */
@@ -68,32 +94,48 @@ public:
 		return _meshSize * _texelSize;
 	}
 
-	/** \return the terrain height and normal map. */
+	/** \return the center of the grid in world space. */
+	const glm::vec3 & gridCenter() const {
+		return _gridCenter;
+	}
+
+	/** \return the grid patch mesh. */
+	const Mesh & patchMesh() const {
+		return _patchMesh;
+	}
+
+	/** \return the visible patches placement (origin relative to the grid center in map texels, and level). */
+	const BufferBase & patches() const {
+		return _patches;
+	}
+
+	/** \return the terrain height and normal clipmap, height in R channel, normals in GBA channels. */
 	const Texture & map() const {
 		return _map;
 	}
 
-	/** \return the terrain shadow map, with self shadowing in the R channel and ocean plane shadowing in the G channel. */
+	/** \return the terrain shadow clipmap, with self shadowing in the R channel and ocean plane shadowing in the G channel. */
 	const Texture * shadowMap() const {
 		return _shadowBuffer->texture(0);
 	}
 
-	/** \return the grid mesh cells. */
-	const std::vector<Cell> & cells() const {
-		return _cells;
-	}
-
-private:
+	/** Copy constructor.*/
+	Terrain(const Terrain &) = delete;
 
-	/** Apply erosion on a height map.
-	 \param img the map to erode, in place
+	/** Copy assignment.
+	 \return a reference to the object assigned to
 	 */
-	void erode(Image & img);
+	Terrain & operator=(const Terrain &) = delete;
+
+	/** Move constructor.*/
+	Terrain(Terrain &&) = delete;
 
-	/** Compute terrain normals from height and uplaod the result to the GPU, with custom mip-map and low-res version.
-	 \param heightMap the map to update and upload
+	/** Move assignment.
+	 \return a reference to the object assigned to
 	 */
-	void transferAndUpdateMap(Image & heightMap);
+	Terrain & operator=(Terrain &&) = delete;
+
+private:
 
 	/** Noise map generation options. */
 	struct GenerationSettings {
@@ -108,7 +150,7 @@ private:
 
 	/** Grid mesh options. */
 	struct MeshSettings {
-		int size = 96; ///< Grid dimensions.
+		int size = 96; ///< Grid dimensions of the finest level.
 		int levels = 4; ///< Number of levels of detail.
 	};
 
@@ -122,22 +164,151 @@ private:
 		float evaporation = 0.02f; ///< Evaporation speed.
 		float deposition = 0.2f; ///< Deposition speed.
 		int gatherRadius = 3; ///< Gathering radius for contributions.
-		int dropsCount = 50000; ///< Number of droplets to sequentially simulate.
+		int dropsCount = 50000; ///< Number of droplets to sequentially simulate for a 1024x1024 region.
 		int stepsMax = 256; ///< Number of steps for each droplet simulation.
 		bool apply = true; ///< Should erosion be applied.
 	};
 
+	/** \brief All settings needed to generate a tile, shared with the generation threads. */
+	struct MapSettings {
+		GenerationSettings generation; ///< Noise settings.
+		ErosionSettings erosion; ///< Erosion settings.
+		int resolution = 1024; ///< Terrain map resolution.
+		uint seed = 0; ///< Generation seed.
+		float texelSize = 0.05f; ///< Size of a map texel in world space.
+	};
+
+	/** \brief Clipmap tile identifier. */
+	struct TileId {
+		int level = 0; ///< Clip level.
+		glm::ivec2 coords = glm::ivec2(0); ///< Tile coordinates, in tiles of the level.
+
+		/** Comparison operator.
+		 \param other the tile to compare to
+		 \return true if both identify the same tile
+		 */
+		bool operator==(const TileId & other) const {
+			return level == other.level && coords == other.coords;
+		}
+	};
+
+	/** \brief Hash a tile identifier. */
+	struct TileHash {
+		/** Compute the hash of a tile identifier.
+		 \param tile the tile
+		 \return the hash
+		 */
+		size_t operator()(const TileId & tile) const {
+			return std::hash<uint64_t>()((uint64_t(uint(tile.level)) << 56) ^ (uint64_t(uint(tile.coords.x) & 0xFFFFFFF) << 28) ^ uint64_t(uint(tile.coords.y) & 0xFFFFFFF));
+		}
+	};
+
+	/** \brief A generated tile, stored on the CPU. */
+	struct Tile {
+		Image data; ///< Height and normals.
+		uint64_t lastUse = 0; ///< Last frame the tile was part of a window.
+	};
+
+	/** \brief A tile generation request. */
+	struct TileRequest {
+		TileId id; ///< The tile to generate.
+		uint64_t generation = 0; ///< Map generation the request belongs to.
+		std::shared_ptr<const MapSettings> settings; ///< Settings to use.
+	};
+
+	/** \brief The window of tiles covered by a clip level. */
+	struct ClipLevel {
+		glm::ivec2 origin = glm::ivec2(0); ///< First tile of the window.
+		bool valid = false; ///< Has the window been uploaded.
+		bool shadowDirty = true; ///< Should the shadows be regenerated.
+	};
+
+	/** Generate a tile of the terrain map.
+	 \param request the tile and settings to use
+	 \param perlin the noise generator
+	 \return the tile height and normals
+	 */
+	static Image generateTile(const TileRequest & request, const PerlinNoise & perlin);
+
+	/** Apply erosion on a height map, with droplets starting in a square region.
+	 \param img the map to erode, in place
+	 \param settings the erosion settings
+	 \param rng the random generator to use
+	 \param drops the number of droplets to simulate
+	 \param origin the start region corner, in pixels
+	 \param size the start region size, in pixels
+	 */
+	static void erode(Image & img, const ErosionSettings & settings, std::mt19937 & rng, int drops, const glm::vec2 & origin, float size);
+
+	/** Generation thread main loop. */
+	void generationLoop();
+
+	/** Collect the tiles generated by the background threads since the last call. */
+	void collectTiles();
+
+	/** Request the generation of a tile if it is not already available or pending.
+	 \param tile the tile to generate
+	 */
+	void requestTile(const TileId & tile);
+
+	/** Compute the tile window of a clip level centered around a position.
+	 \param level the clip level
+	 \param center the center position, in map texels
+	 \return the first tile of the window
+	 */
+	glm::ivec2 windowOrigin(int level, const glm::vec2 & center) const;
+
+	/** Try to move a clip level window, if all its tiles are available.
+	 \param level the clip level
+	 \param origin the first tile of the new window
+	 \return true if the window was updated
+	 */
+	bool moveWindow(int level, const glm::ivec2 & origin);
+
+	/** Remove least recently used tiles from the cache if needed. */
+	void evictTiles();
+
+	/** Regenerate shadows for all clip levels that need it. */
+	void updateShadows();
+
+	/** Release generated data and create GPU clipmaps for the current resolution. */
+	void resetClipmaps();
+
+	static const int _tileSize = 128; ///< Tile size in texels.
+	static const int _clipSize = 512; ///< Clip level size in texels.
+	static const int _apron = 16; ///< Extra texels generated around each tile for filtering and erosion, also the erosion cell size.
+	static const int _maxPatches = 100; ///< Maximum number of grid patches (see ground_island.vert).
+	static const int _maxLevels = 8; ///< Maximum number of clip levels (see terrain_clipmap.glsl).
+
 	PerlinNoise _perlin; ///< Perlin noise generator.
-	std::vector<Cell> _cells; ///< Grid mesh cells.
-	Texture _map = Texture("Terrain"); ///< Terrain map, height in R channel, normals in GBA channels.
-	Texture _mapLowRes = Texture("Terrain low-res");///< Low resolution min-height terrain map.
-	std::unique_ptr<Framebuffer> _shadowBuffer; ///< Shadow map generation framebuffer.
-	GaussianBlur _gaussBlur; ///< Gaussian blur.
+	Mesh _patchMesh = Mesh("Terrain patch"); ///< Grid patch mesh, instanced.
+	Buffer<glm::vec4> _patches; ///< Visible patches placement and level.
+	std::vector<glm::vec4> _allPatches; ///< All patches placement and level.
+	Texture _map = Texture("Terrain"); ///< Terrain clipmap, height in R channel, normals in GBA channels.
+	std::unique_ptr<Framebuffer> _shadowBuffer; ///< Shadow clipmap.
 
 	GenerationSettings _genOpts; ///< Terrain generations settings.
 	MeshSettings _mshOpts; ///< Grid mesh options.
 	ErosionSettings _erOpts; ///< Erosion options.
 
+	std::vector<ClipLevel> _levels; ///< Clip levels state.
+	std::unordered_map<TileId, Tile, TileHash> _tiles; ///< Generated tiles.
+	std::unordered_set<TileId, TileHash> _pendingTiles; ///< Tiles currently requested.
+	std::shared_ptr<const MapSettings> _settings; ///< Settings of the current generation.
+	uint64_t _generation = 0; ///< Current map generation, incremented when settings change.
+	uint64_t _frame = 0; ///< Number of updates performed.
+
+	std::vector<std::thread> _workers; ///< Tile generation threads.
+	std::deque<TileRequest> _requests; ///< Tiles to generate.
+	std::vector<std::pair<TileRequest, Image>> _results; ///< Generated tiles to collect.
+	std::mutex _requestsMutex; ///< Requests queue lock.
+	std::mutex _resultsMutex; ///< Results list lock.
+	std::condition_variable _requestsCondition; ///< Notify threads of new requests.
+	bool _stopWorkers = false; ///< Should the generation threads stop.
+
+	glm::vec3 _gridCenter = glm::vec3(0.0f); ///< Grid center in world space.
+	glm::vec2 _mapCenter = glm::vec2(0.0f); ///< Clipmaps center, in map texels.
+	glm::vec3 _lightDirection = glm::vec3(0.0f, 1.0f, 0.0f); ///< Sun direction used for shadows.
 	int _resolution; ///< Height map resolution.
 	uint _seed; ///< Current generation seed.
 	float _texelSize = 0.05f; ///< Size of a map texel in world space.
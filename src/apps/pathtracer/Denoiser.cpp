@@ -0,0 +1,107 @@
+#include "Denoiser.hpp"
+#include "system/System.hpp"
+
+Denoiser::Denoiser(const Settings & settings) : _settings(settings) {
+}
+
+void Denoiser::process(Image & color, const Image & albedo, const Image & normal, const Image & depth) const {
+	const int w = int(color.width);
+	const int h = int(color.height);
+	if(albedo.width != color.width || albedo.height != color.height || normal.width != color.width || normal.height != color.height || depth.width != color.width || depth.height != color.height) {
+		Log::Error() << "[Denoiser] Feature buffers and image dimensions differ." << std::endl;
+		return;
+	}
+	// Avoid dividing by zero in dark regions.
+	const float minAlbedo = 0.01f;
+
+	// Demodulate the lighting from the albedo.
+	Image current(color.width, color.height, 3);
+	Image next(color.width, color.height, 3);
+	Image deviation(color.width, color.height, 1);
+	System::forParallel(0, size_t(h), [&](size_t y) {
+		for(int x = 0; x < w; ++x) {
+			current.rgb(x, int(y)) = color.rgb(x, int(y)) / glm::max(albedo.rgb(x, int(y)), minAlbedo);
+		}
+	});
+
+	// B3-spline coefficients.
+	const float kernel[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+	const float albedoScale = -1.0f / (_settings.albedoSigma * _settings.albedoSigma);
+	const float normalScale = -1.0f / _settings.normalSigma;
+	const float depthScale = -1.0f / _settings.depthSigma;
+	const glm::vec3 luminance(0.2126f, 0.7152f, 0.0722f);
+
+	for(int it = 0; it < _settings.iterations; ++it) {
+		const int step = 1 << it;
+
+		// Estimate the remaining noise level from the luminance variance in a 3x3 neighborhood.
+		System::forParallel(0, size_t(h), [&](size_t yy) {
+			const int y = int(yy);
+			for(int x = 0; x < w; ++x) {
+				float sum = 0.0f;
+				float sum2 = 0.0f;
+				float count = 0.0f;
+				for(int qy = std::max(y - 1, 0); qy <= std::min(y + 1, h - 1); ++qy) {
+					for(int qx = std::max(x - 1, 0); qx <= std::min(x + 1, w - 1); ++qx) {
+						const float lum = glm::dot(current.rgb(qx, qy), luminance);
+						sum += lum;
+						sum2 += lum * lum;
+						count += 1.0f;
+					}
+				}
+				const float mean = sum / count;
+				deviation.r(x, y) = std::sqrt(std::max(sum2 / count - mean * mean, 0.0f));
+			}
+		});
+
+		System::forParallel(0, size_t(h), [&](size_t yy) {
+			const int y = int(yy);
+			for(int x = 0; x < w; ++x) {
+				const glm::vec3 & cP = current.rgb(x, y);
+				const glm::vec3 & aP = albedo.rgb(x, y);
+				const glm::vec3 & nP = normal.rgb(x, y);
+				const float dP = depth.r(x, y);
+				// Luminance differences are compared to the local noise level.
+				const float lumP = glm::dot(cP, luminance);
+				const float colorScale = -1.0f / (_settings.colorSigma * deviation.r(x, y) + 1e-4f);
+
+				glm::vec3 sum(0.0f);
+				float weights = 0.0f;
+				for(int dy = -2; dy <= 2; ++dy) {
+					const int qy = y + dy * step;
+					if(qy < 0 || qy >= h) {
+						continue;
+					}
+					const float ky = kernel[std::abs(dy)];
+					for(int dx = -2; dx <= 2; ++dx) {
+						const int qx = x + dx * step;
+						if(qx < 0 || qx >= w) {
+							continue;
+						}
+						const glm::vec3 & cQ = current.rgb(qx, qy);
+						const float dL = std::abs(glm::dot(cQ, luminance) - lumP);
+						const glm::vec3 dA = albedo.rgb(qx, qy) - aP;
+						const float dN = std::max(0.0f, 1.0f - glm::dot(normal.rgb(qx, qy), nP));
+						const float dQ = depth.r(qx, qy);
+						// Background pixels have a null depth and never mix with surfaces.
+						const float dD = std::abs(dQ - dP) / (std::max(dQ, dP) + 1e-4f);
+						const float exponent = colorScale * dL + albedoScale * glm::dot(dA, dA) + normalScale * dN + depthScale * dD;
+						const float weight = ky * kernel[std::abs(dx)] * std::exp(exponent);
+						sum += weight * cQ;
+						weights += weight;
+					}
+				}
+				// The center tap always has a non-zero weight.
+				next.rgb(x, y) = sum / weights;
+			}
+		});
+		std::swap(current, next);
+	}
+
+	// Modulate back by the albedo.
+	System::forParallel(0, size_t(h), [&](size_t y) {
+		for(int x = 0; x < w; ++x) {
+			color.rgb(x, int(y)) = current.rgb(x, int(y)) * glm::max(albedo.rgb(x, int(y)), minAlbedo);
+		}
+	});
+}
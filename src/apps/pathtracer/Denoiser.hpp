@@ -0,0 +1,45 @@
+#pragma once
+#include "resources/Image.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Remove noise from a path traced rendering using feature buffers that describe the first surface seen in each pixel.
+ \details This is an edge-avoiding à-trous filter. Each pass is a 5x5 cross-bilateral filter, and the space between taps doubles after each pass. Tap weights depend on albedo, normal and depth differences, so edges visible in the feature buffers are preserved. Luminance differences are also compared to the local noise level, estimated before each pass, to keep lighting features such as shadow boundaries. Lighting is divided by the albedo before filtering and multiplied back afterwards, which keeps texture details sharp. Passes are processed on all threads, one row per job.
+ \ingroup PathtracerDemo
+ */
+class Denoiser {
+public:
+
+	/** \brief Filtering parameters. */
+	struct Settings {
+		int iterations = 5; ///< Number of passes, the filter footprint is 4*(2^iterations - 1)+1 pixels wide.
+		float colorSigma = 4.0f; ///< Tolerance to luminance differences, relative to the local noise level.
+		float albedoSigma = 0.1f; ///< Tolerance to albedo differences.
+		float normalSigma = 0.1f; ///< Tolerance to normal differences (one minus the cosine of the angle).
+		float depthSigma = 0.05f; ///< Tolerance to depth differences, relative to the pixel depth.
+	};
+
+	/** Default constructor. */
+	Denoiser() = default;
+
+	/** Constructor.
+	 \param settings the filtering parameters
+	 */
+	explicit Denoiser(const Settings & settings);
+
+	/** Filter an image in place.
+	 \param color the linear RGB image to denoise
+	 \param albedo the linear RGB first hit albedo
+	 \param normal the RGB first hit world space normal
+	 \param depth the single channel first hit distance to the camera, 0 for the background
+	 \note All images should have the same dimensions.
+	 */
+	void process(Image & color, const Image & albedo, const Image & normal, const Image & depth) const;
+
+	/** \return the filtering parameters */
+	Settings & settings() { return _settings; }
+
+private:
+
+	Settings _settings; ///< Filtering parameters.
+};
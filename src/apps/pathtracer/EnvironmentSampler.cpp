@@ -0,0 +1,126 @@
+#include "EnvironmentSampler.hpp"
+#include "generation/Random.hpp"
+
+EnvironmentSampler::EnvironmentSampler(const Texture & cubemap, uint resolution) {
+	if(cubemap.shape != TextureShape::Cube || cubemap.images.size() < 6) {
+		Log::Error() << "[PathTracer] Environment sampling requires a cubemap with CPU data." << std::endl;
+		return;
+	}
+	_cubemap = &cubemap;
+	_resolution = std::max(std::min(resolution, std::min(cubemap.width, cubemap.height)), 1u);
+
+	// Accumulate the luminance of all texels in each coarse texel.
+	const uint texelsCount = _resolution * _resolution;
+	std::vector<float> weights(6 * texelsCount, 0.0f);
+	for(int face = 0; face < 6; ++face) {
+		const Image & image = cubemap.images[face];
+		float * faceWeights = &weights[face * texelsCount];
+		for(uint y = 0; y < image.height; ++y) {
+			const uint cy = y * _resolution / image.height;
+			for(uint x = 0; x < image.width; ++x) {
+				const uint cx = x * _resolution / image.width;
+				const glm::vec3 & color = image.rgb(int(x), int(y));
+				faceWeights[cy * _resolution + cx] += glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+			}
+		}
+		// Convert to an average luminance, weighted by the texel solid angle.
+		const float texelsPerBin = float(image.width * image.height) / float(texelsCount);
+		const float binArea = 4.0f / float(texelsCount);
+		for(uint cy = 0; cy < _resolution; ++cy) {
+			for(uint cx = 0; cx < _resolution; ++cx) {
+				const glm::vec2 center = (glm::vec2(cx, cy) + 0.5f) / float(_resolution);
+				faceWeights[cy * _resolution + cx] *= binArea / (texelsPerBin * areaToSolidAngle(center));
+			}
+		}
+	}
+	_table = AliasTable(weights);
+}
+
+float EnvironmentSampler::sample(glm::vec3 & direction, glm::vec3 & radiance) const {
+	// Pick a coarse texel, then a uniform position in it.
+	const size_t id = _table.sample(Random::Float());
+	const uint texelsCount = _resolution * _resolution;
+	const int face = int(id / texelsCount);
+	const uint local = uint(id % texelsCount);
+	const glm::vec2 cell(local % _resolution, local / _resolution);
+	const glm::vec2 uv = (cell + glm::vec2(Random::Float(), Random::Float())) / float(_resolution);
+
+	direction = glm::normalize(faceDirection(face, uv));
+	radiance = eval(direction);
+	// Density over the face, converted to solid angle.
+	const float binArea = 4.0f / float(texelsCount);
+	return _table.pdf(id) / binArea * areaToSolidAngle(uv);
+}
+
+float EnvironmentSampler::pdf(const glm::vec3 & direction) const {
+	glm::vec2 uv;
+	const int face = faceCoordinates(direction, uv);
+	const glm::uvec2 cell = glm::min(glm::uvec2(uv * float(_resolution)), glm::uvec2(_resolution - 1));
+	const uint texelsCount = _resolution * _resolution;
+	const size_t id = size_t(face) * texelsCount + cell.y * _resolution + cell.x;
+	const float binArea = 4.0f / float(texelsCount);
+	return _table.pdf(id) / binArea * areaToSolidAngle(uv);
+}
+
+glm::vec3 EnvironmentSampler::eval(const glm::vec3 & direction) const {
+	glm::vec2 uv;
+	const int face = faceCoordinates(direction, uv);
+	const Image & image = _cubemap->images[face];
+	const int x = std::min(int(uv.x * float(image.width)), int(image.width) - 1);
+	const int y = std::min(int(uv.y * float(image.height)), int(image.height) - 1);
+	return image.rgb(x, y);
+}
+
+int EnvironmentSampler::faceCoordinates(const glm::vec3 & direction, glm::vec2 & uv) {
+	// Faces are stored in the following order: px, nx, py, ny, pz, nz
+	const glm::vec3 abs = glm::abs(direction);
+	int face = 0;
+	float x = 0.0f;
+	float y = 0.0f;
+	float denom = 1.0f;
+	if(abs.x >= abs.y && abs.x >= abs.z) {
+		denom = abs.x;
+		y = direction.y;
+		face = direction.x >= 0.0f ? 0 : 1;
+		x = direction.x >= 0.0f ? -direction.z : direction.z;
+	} else if(abs.y >= abs.z) {
+		denom = abs.y;
+		x = direction.x;
+		face = direction.y >= 0.0f ? 2 : 3;
+		y = direction.y >= 0.0f ? -direction.z : direction.z;
+	} else {
+		denom = abs.z;
+		y = direction.y;
+		face = direction.z >= 0.0f ? 4 : 5;
+		x = direction.z >= 0.0f ? direction.x : -direction.x;
+	}
+	denom = std::max(denom, 1e-8f);
+	uv = glm::clamp(glm::vec2(0.5f * (x / denom) + 0.5f, 0.5f * (-y / denom) + 0.5f), 0.0f, 1.0f);
+	return face;
+}
+
+glm::vec3 EnvironmentSampler::faceDirection(int face, const glm::vec2 & uv) {
+	const float x = 2.0f * uv.x - 1.0f;
+	const float y = 1.0f - 2.0f * uv.y;
+	switch(face) {
+		case 0:
+			return glm::vec3(1.0f, y, -x);
+		case 1:
+			return glm::vec3(-1.0f, y, x);
+		case 2:
+			return glm::vec3(x, 1.0f, -y);
+		case 3:
+			return glm::vec3(x, -1.0f, y);
+		case 4:
+			return glm::vec3(x, y, 1.0f);
+		default:
+			return glm::vec3(-x, y, -1.0f);
+	}
+}
+
+float EnvironmentSampler::areaToSolidAngle(const glm::vec2 & uv) {
+	// The face is at unit distance, with coordinates in [-1,1].
+	const glm::vec2 p = 2.0f * uv - 1.0f;
+	const float dist2 = 1.0f + glm::dot(p, p);
+	return dist2 * std::sqrt(dist2);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "generation/AliasTable.hpp"
+#include "resources/Texture.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Sample directions from a cubemap environment, with probabilities proportional to their contribution.
+ \details The cubemap faces are split in coarse texels, each weighted by its average luminance and solid angle, and an alias table is built over all of them. A direction is sampled by picking a coarse texel, then a uniform position in it. Radiance lookups use the nearest full resolution texel, avoiding filtering and border handling.
+ \ingroup PathtracerDemo
+ */
+class EnvironmentSampler {
+public:
+
+	/** Empty constructor. */
+	EnvironmentSampler() = default;
+
+	/** Constructor. Build the sampling distribution.
+	 \param cubemap the environment cubemap, with its six faces available on the CPU
+	 \param resolution the maximum resolution of each face of the sampling distribution
+	 */
+	explicit EnvironmentSampler(const Texture & cubemap, uint resolution = 128);
+
+	/** Sample a direction.
+	 \param direction will contain the sampled direction
+	 \param radiance will contain the environment radiance in this direction
+	 \return the sampling density, in solid angle measure
+	 */
+	float sample(glm::vec3 & direction, glm::vec3 & radiance) const;
+
+	/** Compute the density with which a direction would have been sampled.
+	 \param direction the normalized direction
+	 \return the sampling density, in solid angle measure
+	 */
+	float pdf(const glm::vec3 & direction) const;
+
+	/** Evaluate the environment radiance.
+	 \param direction the direction to query
+	 \return the radiance of the nearest texel
+	 */
+	glm::vec3 eval(const glm::vec3 & direction) const;
+
+	/** \return the integral of the luminance over all directions */
+	float power() const { return _table.total(); }
+
+	/** \return true if the sampler is ready */
+	bool valid() const { return _cubemap != nullptr; }
+
+private:
+
+	/** Find the face and position on this face for a direction, using the same conventions as Texture::sampleCubemap.
+	 \param direction the direction
+	 \param uv will contain the position on the face, in [0,1]
+	 \return the face index
+	 */
+	static int faceCoordinates(const glm::vec3 & direction, glm::vec2 & uv);
+
+	/** Compute the direction pointing to a position on a face.
+	 \param face the face index
+	 \param uv the position on the face, in [0,1]
+	 \return the (non-normalized) direction
+	 */
+	static glm::vec3 faceDirection(int face, const glm::vec2 & uv);
+
+	/** Convert a solid angle density into a density over the face surface.
+	 \param uv the position on the face, in [0,1]
+	 \return the ratio between the face area and the solid angle around the position
+	 */
+	static float areaToSolidAngle(const glm::vec2 & uv);
+
+	const Texture * _cubemap = nullptr; ///< The environment.
+	AliasTable _table; ///< Coarse texels distribution.
+	uint _resolution = 0; ///< Coarse texels count along each face side.
+};
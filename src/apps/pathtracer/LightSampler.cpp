@@ -0,0 +1,350 @@
+#include "LightSampler.hpp"
+#include "scene/lights/DirectionalLight.hpp"
+#include "scene/lights/PointLight.hpp"
+#include "scene/lights/SpotLight.hpp"
+#include "generation/Random.hpp"
+
+/// Above this number of emitters, the light BVH is used instead of a global power table.
+static const size_t maxTableEmitters = 16;
+
+/** Compute the luminance of a color.
+ \param color the linear color
+ \return the luminance
+ */
+static float luminance(const glm::vec3 & color) {
+	return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+LightSampler::LightSampler(const Scene & scene) : _scene(&scene) {
+
+	// Analytic lights.
+	const float sceneRadius = scene.boundingBox().getSphere().radius;
+	for(size_t lid = 0; lid < scene.lights.size(); ++lid) {
+		const auto & light = scene.lights[lid];
+		Emitter emitter;
+		emitter.light = long(lid);
+		const float intensity = luminance(light->intensity());
+		if(dynamic_cast<const DirectionalLight *>(light.get())) {
+			// Power received by the scene.
+			emitter.infinite = true;
+			emitter.power = intensity * glm::pi<float>() * sceneRadius * sceneRadius;
+		} else if(const PointLight * point = dynamic_cast<const PointLight *>(light.get())) {
+			emitter.bounds = BoundingBox(point->position(), point->position());
+			emitter.power = 4.0f * glm::pi<float>() * intensity;
+		} else if(const SpotLight * spot = dynamic_cast<const SpotLight *>(light.get())) {
+			emitter.bounds = BoundingBox(spot->position(), spot->position());
+			emitter.power = 4.0f * glm::pi<float>() * intensity;
+		} else {
+			continue;
+		}
+		_emitters.push_back(emitter);
+	}
+
+	// Skybox environment, sampled based on its luminance.
+	if(scene.backgroundMode == Scene::Background::SKYBOX && scene.background) {
+		_environment = EnvironmentSampler(*scene.background->textures()[0]);
+		if(_environment.valid() && _environment.power() > 0.0f) {
+			Emitter emitter;
+			emitter.infinite = true;
+			emitter.environment = true;
+			// Irradiance from a uniform environment is a quarter of its integral over the sphere.
+			emitter.power = 0.25f * _environment.power() * glm::pi<float>() * sceneRadius * sceneRadius;
+			_environmentId = long(_emitters.size());
+			_emitters.push_back(emitter);
+		}
+	}
+
+	// Each triangle of an emissive object is an area light.
+	_objectOffsets.resize(scene.objects.size(), -1);
+	for(size_t oid = 0; oid < scene.objects.size(); ++oid) {
+		const Object & object = scene.objects[oid];
+		if(object.type() != Object::Type::Emissive) {
+			continue;
+		}
+		const Mesh & mesh = *object.mesh();
+		if(mesh.positions.empty() || mesh.indices.size() < 3) {
+			continue;
+		}
+		_objectOffsets[oid] = long(_emitters.size());
+		const glm::mat4 & model = object.model();
+		for(size_t tid = 0; tid + 2 < mesh.indices.size(); tid += 3) {
+			Emitter emitter;
+			emitter.object = oid;
+			emitter.localId = tid;
+			emitter.v0 = glm::vec3(model * glm::vec4(mesh.positions[mesh.indices[tid]], 1.0f));
+			emitter.v1 = glm::vec3(model * glm::vec4(mesh.positions[mesh.indices[tid + 1]], 1.0f));
+			emitter.v2 = glm::vec3(model * glm::vec4(mesh.positions[mesh.indices[tid + 2]], 1.0f));
+			const glm::vec3 cross = glm::cross(emitter.v1 - emitter.v0, emitter.v2 - emitter.v0);
+			const float crossLength = glm::length(cross);
+			emitter.area = 0.5f * crossLength;
+			emitter.normal = crossLength > 0.0f ? (cross / crossLength) : glm::vec3(0.0f, 1.0f, 0.0f);
+			emitter.bounds = BoundingBox(emitter.v0, emitter.v1, emitter.v2);
+			// Emissive surfaces emit on both sides. Estimate the radiance at the triangle center.
+			const float radiance = luminance(emission(emitter, 1.0f / 3.0f, 1.0f / 3.0f));
+			emitter.power = 2.0f * glm::pi<float>() * emitter.area * radiance;
+			_emitters.push_back(emitter);
+		}
+	}
+
+	if(_emitters.empty()) {
+		return;
+	}
+
+	// For a few lights, a global power table is enough.
+	_useBVH = _emitters.size() > maxTableEmitters;
+	if(!_useBVH) {
+		std::vector<float> powers(_emitters.size());
+		for(size_t eid = 0; eid < _emitters.size(); ++eid) {
+			powers[eid] = _emitters[eid].power;
+		}
+		_powerTable = AliasTable(powers);
+		return;
+	}
+
+	// Else, infinite lights are sampled based on their power, and other emitters using the BVH.
+	std::vector<size_t> finite;
+	std::vector<float> infinitePowers;
+	for(size_t eid = 0; eid < _emitters.size(); ++eid) {
+		if(_emitters[eid].infinite) {
+			_infinite.push_back(eid);
+			infinitePowers.push_back(_emitters[eid].power);
+		} else {
+			finite.push_back(eid);
+		}
+	}
+	_powerTable = AliasTable(infinitePowers);
+	if(!finite.empty()) {
+		_paths.resize(_emitters.size());
+		_nodes.reserve(2 * finite.size());
+		build(finite, 0, finite.size(), Path());
+	}
+	_infiniteProbability = finite.empty() ? 1.0f : (float(_infinite.size()) / float(_infinite.size() + 1));
+	Log::Info() << "[PathTracer] Light BVH built over " << finite.size() << " emitters, with " << _nodes.size() << " nodes." << std::endl;
+}
+
+size_t LightSampler::build(std::vector<size_t> & ids, size_t begin, size_t end, const Path & path) {
+	const size_t nodeId = _nodes.size();
+	_nodes.emplace_back();
+
+	if(end - begin == 1) {
+		const size_t eid = ids[begin];
+		Node & node = _nodes[nodeId];
+		node.bounds = _emitters[eid].bounds;
+		node.power = _emitters[eid].power;
+		node.right = eid;
+		node.leaf = true;
+		_paths[eid] = path;
+		return nodeId;
+	}
+
+	// Split at the median along the largest axis of the emitters centers.
+	BoundingBox centers;
+	for(size_t i = begin; i < end; ++i) {
+		centers.merge(_emitters[ids[i]].bounds.getCentroid());
+	}
+	const glm::vec3 size = centers.getSize();
+	const int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+	const size_t mid = (begin + end) / 2;
+	std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end, [this, axis](size_t a, size_t b) {
+		return _emitters[a].bounds.getCentroid()[axis] < _emitters[b].bounds.getCentroid()[axis];
+	});
+
+	Path leftPath = path;
+	Path rightPath = path;
+	++leftPath.depth;
+	++rightPath.depth;
+	rightPath.bits |= (uint64_t(1) << path.depth);
+	build(ids, begin, mid, leftPath);
+	const size_t right = build(ids, mid, end, rightPath);
+
+	// Children have been created, references can be taken.
+	Node & node = _nodes[nodeId];
+	const Node & left = _nodes[nodeId + 1];
+	node.bounds = left.bounds;
+	node.bounds.merge(_nodes[right].bounds);
+	node.power = left.power + _nodes[right].power;
+	node.right = right;
+	return nodeId;
+}
+
+float LightSampler::importance(const Node & node, const glm::vec3 & position, const glm::vec3 & normal) {
+	if(node.power <= 0.0f) {
+		return 0.0f;
+	}
+	const BoundingSphere sphere = node.bounds.getSphere();
+	const glm::vec3 toCenter = sphere.center - position;
+	const float dist2 = glm::dot(toCenter, toCenter);
+	const float radius2 = sphere.radius * sphere.radius;
+	// Inside the bounds, no orientation or distance information can be relied on.
+	if(dist2 <= radius2) {
+		return node.power / std::max(radius2, 1e-6f);
+	}
+	// Angle between the normal and the direction to the bounds, minus the angle subtended by the bounds.
+	const float dist = std::sqrt(dist2);
+	const float cosNormal = glm::clamp(glm::dot(normal, toCenter / dist), -1.0f, 1.0f);
+	const float angleBounds = std::asin(glm::clamp(sphere.radius / dist, 0.0f, 1.0f));
+	const float angle = std::max(std::acos(cosNormal) - angleBounds, 0.0f);
+	if(angle >= glm::half_pi<float>()) {
+		return 0.0f;
+	}
+	return node.power * std::cos(angle) / dist2;
+}
+
+bool LightSampler::sample(const glm::vec3 & position, const glm::vec3 & normal, Sample & sample) const {
+	if(_emitters.empty()) {
+		return false;
+	}
+	// Pick an emitter.
+	size_t eid = 0;
+	float selection = 1.0f;
+	if(!_useBVH) {
+		eid = _powerTable.sample(Random::Float());
+		selection = _powerTable.pdf(eid);
+	} else if(Random::Float() < _infiniteProbability) {
+		const size_t iid = _powerTable.sample(Random::Float());
+		eid = _infinite[iid];
+		selection = _infiniteProbability * _powerTable.pdf(iid);
+	} else {
+		// Traverse the BVH, picking children based on their importance.
+		selection = 1.0f - _infiniteProbability;
+		size_t nid = 0;
+		while(!_nodes[nid].leaf) {
+			const size_t left = nid + 1;
+			const size_t right = _nodes[nid].right;
+			const float importanceLeft = importance(_nodes[left], position, normal);
+			const float importanceRight = importance(_nodes[right], position, normal);
+			const float total = importanceLeft + importanceRight;
+			if(total <= 0.0f) {
+				return false;
+			}
+			const float probaLeft = importanceLeft / total;
+			if(Random::Float() < probaLeft) {
+				nid = left;
+				selection *= probaLeft;
+			} else {
+				nid = right;
+				selection *= 1.0f - probaLeft;
+			}
+		}
+		eid = _nodes[nid].right;
+	}
+	if(selection <= 0.0f) {
+		return false;
+	}
+
+	const Emitter & emitter = _emitters[eid];
+	// Environment, can also be reached by rays.
+	if(emitter.environment) {
+		const float envPdf = _environment.sample(sample.direction, sample.radiance);
+		if(envPdf <= 0.0f || glm::dot(sample.direction, normal) <= 0.0f) {
+			return false;
+		}
+		sample.distance = 1e8f;
+		sample.pdf = selection * envPdf;
+		sample.area = true;
+		sample.shadows = true;
+		return true;
+	}
+	// Analytic lights.
+	if(emitter.light >= 0) {
+		const auto & light = _scene->lights[emitter.light];
+		float falloff = 0.0f;
+		sample.direction = light->sample(position, sample.distance, falloff);
+		sample.radiance = falloff * light->intensity();
+		sample.pdf = selection;
+		sample.area = false;
+		sample.shadows = light->castsShadow();
+		return falloff > 0.0f;
+	}
+
+	// Uniformly sample a point on the triangle.
+	const float su = std::sqrt(Random::Float());
+	const float u = Random::Float() * su;
+	const float v = 1.0f - su;
+	const glm::vec3 lightPos = (1.0f - u - v) * emitter.v0 + u * emitter.v1 + v * emitter.v2;
+	glm::vec3 direction = lightPos - position;
+	const float dist2 = glm::dot(direction, direction);
+	if(dist2 <= 0.0f || emitter.area <= 0.0f) {
+		return false;
+	}
+	sample.distance = std::sqrt(dist2);
+	direction /= sample.distance;
+	const float cosLight = std::abs(glm::dot(emitter.normal, direction));
+	if(cosLight < 1e-5f) {
+		return false;
+	}
+	// Convert from area to solid angle measure.
+	sample.direction = direction;
+	sample.pdf = selection * dist2 / (emitter.area * cosLight);
+	sample.radiance = emission(emitter, u, v);
+	sample.area = true;
+	sample.shadows = true;
+	return true;
+}
+
+float LightSampler::selectionPdf(size_t id, const glm::vec3 & position, const glm::vec3 & normal) const {
+	if(!_useBVH) {
+		return _powerTable.pdf(id);
+	}
+	// Infinite lights are picked from their own table.
+	if(_emitters[id].infinite) {
+		const auto it = std::find(_infinite.begin(), _infinite.end(), id);
+		return _infiniteProbability * _powerTable.pdf(size_t(it - _infinite.begin()));
+	}
+	// Replay the traversal along the path to the emitter.
+	const Path & path = _paths[id];
+	float selection = 1.0f - _infiniteProbability;
+	size_t nid = 0;
+	for(uint level = 0; level < path.depth; ++level) {
+		const size_t left = nid + 1;
+		const size_t right = _nodes[nid].right;
+		const float importanceLeft = importance(_nodes[left], position, normal);
+		const float importanceRight = importance(_nodes[right], position, normal);
+		const float total = importanceLeft + importanceRight;
+		if(total <= 0.0f) {
+			return 0.0f;
+		}
+		const bool goRight = (path.bits >> level) & 1;
+		selection *= (goRight ? importanceRight : importanceLeft) / total;
+		nid = goRight ? right : left;
+	}
+	return selection;
+}
+
+float LightSampler::pdf(const glm::vec3 & position, const glm::vec3 & normal, const Raycaster::Hit & hit, const glm::vec3 & hitPosition) const {
+	if(hit.meshId >= _objectOffsets.size() || _objectOffsets[hit.meshId] < 0) {
+		return 0.0f;
+	}
+	const size_t eid = size_t(_objectOffsets[hit.meshId]) + hit.localId / 3;
+	const Emitter & emitter = _emitters[eid];
+	const glm::vec3 direction = hitPosition - position;
+	const float dist2 = glm::dot(direction, direction);
+	if(dist2 <= 0.0f || emitter.area <= 0.0f) {
+		return 0.0f;
+	}
+	const float cosLight = std::abs(glm::dot(emitter.normal, direction)) / std::sqrt(dist2);
+	if(cosLight < 1e-5f) {
+		return 0.0f;
+	}
+	return selectionPdf(eid, position, normal) * dist2 / (emitter.area * cosLight);
+}
+
+float LightSampler::pdf(const glm::vec3 & position, const glm::vec3 & normal, const glm::vec3 & direction) const {
+	if(_environmentId < 0) {
+		return 0.0f;
+	}
+	return selectionPdf(size_t(_environmentId), position, normal) * _environment.pdf(direction);
+}
+
+glm::vec3 LightSampler::emission(const Emitter & emitter, float u, float v) const {
+	const Object & object = _scene->objects[emitter.object];
+	glm::vec2 uv(0.5f);
+	if(object.useTexCoords()) {
+		const Mesh & mesh = *object.mesh();
+		const unsigned long i0 = mesh.indices[emitter.localId];
+		const unsigned long i1 = mesh.indices[emitter.localId + 1];
+		const unsigned long i2 = mesh.indices[emitter.localId + 2];
+		uv = (1.0f - u - v) * mesh.texcoords[i0] + u * mesh.texcoords[i1] + v * mesh.texcoords[i2];
+	}
+	return glm::vec3(object.textures()[0]->images[0].rgbal(uv.x, uv.y));
+}
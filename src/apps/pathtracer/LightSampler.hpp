@@ -0,0 +1,148 @@
+#pragma once
+#include "EnvironmentSampler.hpp"
+#include "raycaster/Raycaster.hpp"
+#include "generation/AliasTable.hpp"
+#include "scene/Scene.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Select lights for next event estimation, with probabilities proportional to their estimated contribution to a shading point.
+ \details Analytic lights, the triangles of emissive objects and the skybox environment are all treated as emitters. For a few emitters, an alias table weighted by power is used. For many emitters, a light BVH is built: at each node, the traversal picks a child based on its power, distance and orientation relative to the shading point. Directional lights and the environment are sampled separately. Emissive triangles and the environment can also be reached by BRDF rays, so their sampling densities are exposed for multiple importance sampling.
+ \ingroup PathtracerDemo
+ */
+class LightSampler {
+public:
+
+	/** \brief A light sample as seen from a shading point. */
+	struct Sample {
+		glm::vec3 direction = glm::vec3(0.0f); ///< Normalized direction from the shading point to the light sample.
+		float distance = 0.0f; ///< Distance to the light sample.
+		glm::vec3 radiance = glm::vec3(0.0f); ///< Incoming radiance (area lights) or attenuated intensity (analytic lights).
+		float pdf = 0.0f; ///< Sampling density: selection probability, multiplied by the solid angle density for area lights.
+		bool area = false; ///< Is the sample on an area light, that could also be hit by rays.
+		bool shadows = true; ///< Should the visibility of the sample be checked.
+	};
+
+	/** Empty constructor. */
+	LightSampler() = default;
+
+	/** Constructor. Gather all emitters in the scene and build the sampling structures.
+	 \param scene the scene, with objects geometry available on the CPU
+	 */
+	explicit LightSampler(const Scene & scene);
+
+	/** Sample a light for a shading point.
+	 \param position the shading point
+	 \param normal the shading normal
+	 \param sample will contain the light sample information
+	 \return true if a light with a non-zero contribution was sampled
+	 */
+	bool sample(const glm::vec3 & position, const glm::vec3 & normal, Sample & sample) const;
+
+	/** Compute the density with which a point on an emissive triangle would have been sampled from a shading point.
+	 \param position the shading point
+	 \param normal the shading normal
+	 \param hit the intersection record of the ray with the emissive triangle
+	 \param hitPosition the intersection position
+	 \return the sampling density, in solid angle measure
+	 */
+	float pdf(const glm::vec3 & position, const glm::vec3 & normal, const Raycaster::Hit & hit, const glm::vec3 & hitPosition) const;
+
+	/** Compute the density with which an environment direction would have been sampled from a shading point.
+	 \param position the shading point
+	 \param normal the shading normal
+	 \param direction the direction towards the environment
+	 \return the sampling density, in solid angle measure, or 0 if the environment is not sampled
+	 */
+	float pdf(const glm::vec3 & position, const glm::vec3 & normal, const glm::vec3 & direction) const;
+
+	/** Evaluate the environment radiance, using the same lookup as environment samples.
+	 \param direction the direction towards the environment
+	 \return the radiance
+	 \warning Only valid if the environment is sampled.
+	 */
+	glm::vec3 environment(const glm::vec3 & direction) const { return _environment.eval(direction); }
+
+	/** \return true if the skybox environment is sampled */
+	bool hasEnvironment() const { return _environmentId >= 0; }
+
+	/** \return the number of emitters, including analytic lights */
+	size_t count() const { return _emitters.size(); }
+
+private:
+
+	/** \brief An analytic light, an emissive triangle or the environment. */
+	struct Emitter {
+		BoundingBox bounds; ///< World space bounds.
+		glm::vec3 v0 = glm::vec3(0.0f); ///< First triangle vertex, in world space.
+		glm::vec3 v1 = glm::vec3(0.0f); ///< Second triangle vertex, in world space.
+		glm::vec3 v2 = glm::vec3(0.0f); ///< Third triangle vertex, in world space.
+		glm::vec3 normal = glm::vec3(0.0f); ///< Triangle normal, in world space.
+		float area = 0.0f; ///< Triangle area.
+		float power = 0.0f; ///< Estimated emitted power.
+		long light = -1; ///< Index of the analytic light, or -1 for a triangle.
+		unsigned long object = 0; ///< Index of the emissive object.
+		unsigned long localId = 0; ///< Position of the triangle first vertex in the object mesh index buffer.
+		bool infinite = false; ///< Is the light infinitely far (directional or environment).
+		bool environment = false; ///< Is this the environment.
+	};
+
+	/** \brief Light BVH node. */
+	struct Node {
+		BoundingBox bounds; ///< Bounds of the emitters in the subtree.
+		float power = 0.0f; ///< Total power of the emitters in the subtree.
+		size_t right = 0; ///< Index of the second child (the first one is the next node), or of the emitter for leaves.
+		bool leaf = false; ///< Is the node a leaf.
+	};
+
+	/** \brief Path from the root to the leaf of an emitter. */
+	struct Path {
+		uint64_t bits = 0; ///< Child taken at each level (1 for the second child).
+		uint depth = 0; ///< Number of levels.
+	};
+
+	/** Recursively build the light BVH over a range of emitters.
+	 \param ids the emitters indices, will be reordered
+	 \param begin first emitter of the range in ids
+	 \param end past-the-end emitter of the range in ids
+	 \param path the path to the node being created
+	 \return the index of the created node
+	 */
+	size_t build(std::vector<size_t> & ids, size_t begin, size_t end, const Path & path);
+
+	/** Estimate the contribution of a subtree to a shading point.
+	 \param node the subtree root
+	 \param position the shading point
+	 \param normal the shading normal
+	 \return the importance of the subtree
+	 */
+	static float importance(const Node & node, const glm::vec3 & position, const glm::vec3 & normal);
+
+	/** Probability of selecting an emitter from a shading point.
+	 \param id the emitter index
+	 \param position the shading point
+	 \param normal the shading normal
+	 \return the selection probability
+	 */
+	float selectionPdf(size_t id, const glm::vec3 & position, const glm::vec3 & normal) const;
+
+	/** Evaluate the radiance emitted by a point on an emissive triangle.
+	 \param emitter the triangle
+	 \param u second barycentric coordinate
+	 \param v third barycentric coordinate
+	 \return the emitted radiance
+	 */
+	glm::vec3 emission(const Emitter & emitter, float u, float v) const;
+
+	const Scene * _scene = nullptr; ///< The scene.
+	EnvironmentSampler _environment; ///< Skybox sampler.
+	long _environmentId = -1; ///< Index of the environment emitter, or -1.
+	std::vector<Emitter> _emitters; ///< All emitters.
+	std::vector<long> _objectOffsets; ///< Index of the first triangle emitter of each object, or -1.
+	AliasTable _powerTable; ///< Power-based table, for all emitters or for infinite lights only.
+	std::vector<size_t> _infinite; ///< Infinite emitters (when using the BVH).
+	std::vector<Node> _nodes; ///< Light BVH over finite emitters.
+	std::vector<Path> _paths; ///< Path to each finite emitter leaf in the BVH.
+	float _infiniteProbability = 0.0f; ///< Probability of sampling an infinite light instead of traversing the BVH.
+	bool _useBVH = false; ///< Should the BVH be used.
+};
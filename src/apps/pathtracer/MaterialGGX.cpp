@@ -51,9 +51,15 @@ glm::vec3 MaterialGGX::GGX(const glm::vec3 & wo, const glm::vec3 & baseColor, fl
 	return brdf;
 }
 
-glm::vec3 MaterialGGX::sampleAndEval(const glm::vec3 & wo, const glm::vec3 & baseColor, float roughness, float metallic, glm::vec3 & wi){
+float MaterialGGX::specularProbability(const glm::vec3 & baseColor, float metallic){
+	return glm::mix(1.0f / (glm::dot(baseColor, glm::vec3(1.0f)) / 3.0f + 1.0f), 1.0f,  metallic);
+}
 
-	const float probaSpecular = glm::mix(1.0f / (glm::dot(baseColor, glm::vec3(1.0f)) / 3.0f + 1.0f), 1.0f,  metallic);
+glm::vec3 MaterialGGX::sampleAndEval(const glm::vec3 & wo, const glm::vec3 & baseColor, float roughness, float metallic, glm::vec3 & wi, float * pdf){
+	if(pdf){
+		*pdf = 0.0f;
+	}
+	const float probaSpecular = specularProbability(baseColor, metallic);
 	const float alpha = alphaFromRoughness(roughness);
 
 	if(Random::Float() < probaSpecular){
@@ -84,11 +90,25 @@ glm::vec3 MaterialGGX::sampleAndEval(const glm::vec3 & wo, const glm::vec3 & bas
 	const glm::vec3 brdf = GGX(wo, baseColor, alpha, metallic, wi, &pdfSpec);
 
 	// Evaluate the total PDF.
-	const float pdf = glm::mix(glm::one_over_pi<float>() * std::max(wi.z, 0.0f), pdfSpec, probaSpecular);
-	if(pdf == 0.0f){
+	const float pdfTotal = glm::mix(glm::one_over_pi<float>() * std::max(wi.z, 0.0f), pdfSpec, probaSpecular);
+	if(pdfTotal == 0.0f){
 		return glm::vec3(0.0f);
 	}
-	return brdf / pdf;
+	if(pdf){
+		*pdf = pdfTotal;
+	}
+	return brdf / pdfTotal;
+}
+
+float MaterialGGX::pdf(const glm::vec3 & wo, const glm::vec3 & baseColor, float roughness, float metallic, const glm::vec3 & wi){
+	if(wi.z < 0.0f){
+		return 0.0f;
+	}
+	const float probaSpecular = specularProbability(baseColor, metallic);
+	const float alpha = alphaFromRoughness(roughness);
+	float pdfSpec = 0.0f;
+	GGX(wo, baseColor, alpha, metallic, wi, &pdfSpec);
+	return glm::mix(glm::one_over_pi<float>() * wi.z, pdfSpec, probaSpecular);
 }
 
 glm::vec3 MaterialGGX::eval(const glm::vec3 & wo, const glm::vec3 & baseColor, float roughness, float metallic, const glm::vec3 & wi){
@@ -19,9 +19,20 @@ public:
 	 \param roughness the linear roughness of the surface
 	 \param metallic the metallicness of the surface (usually 0 or 1).
 	 \param wi will contain the sampled incoming ray direction (usually direction towards a light/surface)
+	 \param pdf if non null, will contain the PDF of the sampled direction
 	 \return the BRDF evaluated for the sampled direction, weighted by its PDF
 	 */
-	static glm::vec3 sampleAndEval(const glm::vec3 & wo, const glm::vec3 & baseColor, float roughness, float metallic, glm::vec3 & wi);
+	static glm::vec3 sampleAndEval(const glm::vec3 & wo, const glm::vec3 & baseColor, float roughness, float metallic, glm::vec3 & wi, float * pdf = nullptr);
+
+	/** Evaluate the PDF of sampling a given direction with sampleAndEval. Both directions are expressed in the local frame and have the surface point as origin.
+	 \param wo the outgoing ray direction (usually direction towards the camera)
+	 \param baseColor the surface albedo (for dieletrics) or specular tint (for conductors)
+	 \param roughness the linear roughness of the surface
+	 \param metallic the metallicness of the surface (usually 0 or 1)
+	 \param wi the incoming ray direction (usually direction towards a light/surface)
+	 \return the PDF of the incoming direction
+	 */
+	static float pdf(const glm::vec3 & wo, const glm::vec3 & baseColor, float roughness, float metallic, const glm::vec3 & wi);
 
 	/** Evaluate the BRDF value for a given set of directions and parameters. Both directions are expressed in the local frame and have the surface point as origin.
 	\param wo the outgoing ray direction (usually direction towards the camera)
@@ -57,6 +68,13 @@ private:
 	*/
 	static float V(float NdotL, float NdotV, float alpha);
 
+	/** Probability of sampling the specular lobe instead of the diffuse one.
+	 \param baseColor the surface albedo (for dieletrics) or specular tint (for conductors)
+	 \param metallic the metallicness of the surface (usually 0 or 1)
+	 \return the specular lobe probability
+	 */
+	static float specularProbability(const glm::vec3 & baseColor, float metallic);
+
 	/** Convert linear roughness to perceptual.
 	 \param roughness the linear roughness
 	 \return the perceptual roughness
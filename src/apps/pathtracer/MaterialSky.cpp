@@ -1,13 +1,161 @@
 #include "MaterialSky.hpp"
 #include "resources/ResourcesManager.hpp"
+#include "generation/Random.hpp"
+#include "system/System.hpp"
+#include "system/Query.hpp"
 
 const Sky::AtmosphereParameters MaterialSky::sky;
 
+void MaterialSky::build(const glm::vec3 & sunDir, float height){
+	// Tables are small enough for a few hundred thousand marching steps.
+	const uint viewWidth = 192;
+	const uint viewHeight = 108;
+	const uint transWidth = 64;
+	const uint transHeight = 256;
+
+	_sunDir = sunDir;
+	_height = height;
+	// Same offset as the direct evaluation, avoid being exactly on the ground.
+	_altitude = glm::clamp(height + 1.0f, 1.0f, sky.topRadius - sky.groundRadius - 1.0f);
+	_horizonZenith = Sky::horizonZenith(sky, sky.groundRadius + _altitude);
+
+	// Horizontal frame around the sun, any frame works for a vertical sun.
+	const glm::vec3 sunHorizontal(sunDir.x, 0.0f, sunDir.z);
+	_sunForward = glm::length(sunHorizontal) > 1e-4f ? glm::normalize(sunHorizontal) : glm::vec3(1.0f, 0.0f, 0.0f);
+	_sunSide = glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), _sunForward);
+
+	// Load the secondary table before spawning threads.
+	const Image & scatterTable = scatteringTable();
+	const glm::vec3 planetPos(0.0f, sky.groundRadius + _altitude, 0.0f);
+
+	// The sky is symmetric with respect to the vertical plane containing the sun, only store half the azimuths.
+	_skyView = Image(viewWidth, viewHeight, 3);
+	System::forParallel(0, viewHeight, [&](size_t y){
+		const float zenith = Sky::coordinateToZenith(float(y) / float(viewHeight - 1), _horizonZenith);
+		const float cosZenith = std::cos(zenith);
+		const float sinZenith = std::sin(zenith);
+		for(uint x = 0; x < viewWidth; ++x){
+			const float azimuth = glm::pi<float>() * float(x) / float(viewWidth - 1);
+			const glm::vec3 horizontal = std::cos(azimuth) * _sunForward + std::sin(azimuth) * _sunSide;
+			const glm::vec3 rayDir = glm::normalize(sinZenith * horizontal + glm::vec3(0.0f, cosZenith, 0.0f));
+			glm::vec3 transmittance;
+			march(planetPos, rayDir, _sunDir, scatterTable, _skyView.rgb(int(x), int(y)), transmittance);
+		}
+	});
+
+	// Transmittance only depends on the ray, see Sky::transmittanceCoordinates for the layout.
+	_transmittance = Image(transWidth, transHeight, 3);
+	System::forParallel(0, transHeight, [&](size_t y){
+		const float cosZenith = 1.0f - 2.0f * float(y) / float(transHeight - 1);
+		const glm::vec3 rayDir(std::sqrt(std::max(1.0f - cosZenith * cosZenith, 0.0f)), cosZenith, 0.0f);
+		for(uint x = 0; x < transWidth; ++x){
+			const float altitude = std::max(float(x) / float(transWidth - 1) * (sky.topRadius - sky.groundRadius), 1.0f);
+			const glm::vec3 origin(0.0f, sky.groundRadius + altitude, 0.0f);
+			glm::vec3 scattering;
+			march(origin, rayDir, _sunDir, scatterTable, scattering, _transmittance.rgb(int(x), int(y)));
+		}
+	});
+}
+
+glm::vec3 MaterialSky::lookup(const glm::vec3 & rayDir) const {
+	const glm::vec3 dir = glm::normalize(rayDir);
+	const float cosZenith = glm::clamp(dir.y, -1.0f, 1.0f);
+	// Azimuth relative to the sun, in [0, pi].
+	const float azimuth = std::atan2(std::abs(glm::dot(dir, _sunSide)), glm::dot(dir, _sunForward));
+	const glm::vec2 uv(azimuth / glm::pi<float>(), Sky::zenithToCoordinate(std::acos(cosZenith), _horizonZenith));
+	glm::vec3 radiance = Sky::sampleTable(_skyView, uv);
+
+	// Add the sun disk if not hidden by the ground.
+	const bool didHitGroundForward = std::acos(cosZenith) > _horizonZenith;
+	if(!didHitGroundForward){
+		const glm::vec3 sun = sunRadiance(dir, _sunDir);
+		if(sun != glm::vec3(0.0f)){
+			radiance += Sky::sampleTable(_transmittance, Sky::transmittanceCoordinates(sky, sky.groundRadius + _altitude, cosZenith)) * sun;
+		}
+	}
+	return radiance;
+}
+
+bool MaterialSky::matches(const glm::vec3 & sunDir, float height) const {
+	return _skyView.width != 0 && sunDir == _sunDir && height == _height;
+}
+
 glm::vec3 MaterialSky::eval(const glm::vec3 & rayOrigin, const glm::vec3 & rayDir, const glm::vec3 & sunDir){
 
 	// We move to the planet model space, where its center is in (0,0,0).
 	const glm::vec3 planetPos = rayOrigin + glm::vec3(0.0f, sky.groundRadius, 0.0f) + glm::vec3(0.0f, 1.0f, 0.0f);
-	static const Texture * scatterTable = Resources::manager().getTexture("scattering-precomputed", {Layout::RGB32F, Filter::LINEAR_LINEAR, Wrap::CLAMP}, Storage::CPU);
+
+	glm::vec3 scattering(0.0f);
+	glm::vec3 transmittance(0.0f);
+	const bool didHitGroundForward = !march(planetPos, rayDir, sunDir, scatteringTable(), scattering, transmittance);
+	// The sun itself if we're looking at it.
+	if(didHitGroundForward){
+		return scattering;
+	}
+	return scattering + transmittance * sunRadiance(rayDir, sunDir);
+}
+
+void MaterialSky::benchmark(size_t count){
+	const float elevations[] = {-0.05f, 0.02f, 0.1f, 0.3f, 0.8f};
+	std::vector<glm::vec3> directions(count);
+
+	for(const float elevation : elevations){
+		const glm::vec3 sunDir = glm::normalize(glm::vec3(std::sqrt(1.0f - elevation * elevation), elevation, 0.3f));
+		for(glm::vec3 & dir : directions){
+			dir = Random::sampleSphere();
+		}
+
+		Query timer;
+		timer.begin();
+		MaterialSky table;
+		table.build(sunDir, 0.0f);
+		timer.end();
+		const float buildTime = float(timer.value()) / 1000000.0f;
+
+		// Compare on a single thread.
+		std::vector<glm::vec3> reference(count);
+		std::vector<glm::vec3> approx(count);
+		timer.begin();
+		for(size_t did = 0; did < count; ++did){
+			reference[did] = eval(glm::vec3(0.0f), directions[did], sunDir);
+		}
+		timer.end();
+		const float marchTime = float(timer.value()) / float(count);
+
+		timer.begin();
+		for(size_t did = 0; did < count; ++did){
+			approx[did] = table.lookup(directions[did]);
+		}
+		timer.end();
+		const float lookupTime = float(timer.value()) / float(count);
+
+		// Relative luminance error, skip the sun disk whose edges are aliased by design.
+		const glm::vec3 luminance(0.2126f, 0.7152f, 0.0722f);
+		float meanError = 0.0f;
+		float maxError = 0.0f;
+		size_t validCount = 0;
+		for(size_t did = 0; did < count; ++did){
+			if(glm::dot(directions[did], sunDir) > sky.sunRadiusCos){
+				continue;
+			}
+			const float ref = glm::dot(reference[did], luminance);
+			const float error = std::abs(glm::dot(approx[did], luminance) - ref) / std::max(ref, 1e-4f);
+			meanError += error;
+			maxError = std::max(maxError, error);
+			++validCount;
+		}
+		meanError /= float(std::max(validCount, size_t(1)));
+
+		Log::Info() << "[PathTracer] Sky at sun elevation " << elevation << ": built in " << buildTime << "ms, "
+					<< "march " << marchTime << "ns, lookup " << lookupTime << "ns per query, "
+					<< "relative error " << (100.0f * meanError) << "% mean, " << (100.0f * maxError) << "% max." << std::endl;
+	}
+}
+
+bool MaterialSky::march(const glm::vec3 & planetPos, const glm::vec3 & rayDir, const glm::vec3 & sunDir, const Image & scatterTable, glm::vec3 & scattering, glm::vec3 & transmittance){
+
+	scattering = glm::vec3(0.0f);
+	transmittance = glm::vec3(0.0f);
 
 	// Check intersection with atmosphere.
 	glm::vec2 interTop(0.0f);
@@ -15,7 +163,7 @@ glm::vec3 MaterialSky::eval(const glm::vec3 & rayOrigin, const glm::vec3 & rayDi
 	const bool didHitTop = Intersection::sphere(planetPos, rayDir, sky.topRadius, interTop);
 	// If no intersection with the atmosphere, it's the dark void of space.
 	if(!didHitTop){
-		return glm::vec3(0.0f);
+		return true;
 	}
 	// Now intersect with the planet.
 	const bool didHitGround = Intersection::sphere(planetPos, rayDir, sky.groundRadius, interGround);
@@ -32,7 +180,6 @@ glm::vec3 MaterialSky::eval(const glm::vec3 & rayOrigin, const glm::vec3 & rayDi
 	// Accumulate contributions for both scatterings.
 	glm::vec3 rayleighScatt = glm::vec3(0.0f);
 	glm::vec3 mieScatt = glm::vec3(0.0f);
-	glm::vec3 transmittance = glm::vec3(0.0f);
 
 	// March along the ray.
 	for(uint i = 0; i < samplesCount; ++i){
@@ -62,7 +209,7 @@ glm::vec3 MaterialSky::eval(const glm::vec3 & rayOrigin, const glm::vec3 & rayDi
 		glm::vec2 attenuationUVs = (511.0f/512.0f)*glm::vec2(relativeHeight, relativeCosAngle)+0.5f/512.0f;
 		// Additional safety clamp required based on the CPU bilinear interpolation.
 		attenuationUVs = glm::clamp(attenuationUVs, 0.5f/512.0f, 511.0f/512.0f);
-		const glm::vec3 secondaryAttenuation = scatterTable->images[0].rgbl(attenuationUVs.x, attenuationUVs.y);
+		const glm::vec3 secondaryAttenuation = scatterTable.rgbl(attenuationUVs.x, attenuationUVs.y);
 
 		// Final attenuation.
 		const glm::vec3 attenuation = directAttenuation * secondaryAttenuation;
@@ -73,26 +220,21 @@ glm::vec3 MaterialSky::eval(const glm::vec3 & rayOrigin, const glm::vec3 & rayDi
 	}
 
 	// Final scattering participations.
-	const glm::vec3 rayleighParticipation = rayleighPhase(cosViewSun) * sky.kRayleigh * rayleighScatt;
-	const glm::vec3 mieParticipation = sky.kMie * miePhase(cosViewSun) * mieScatt;
+	const glm::vec3 rayleighParticipation = Sky::rayleighPhase(cosViewSun) * sky.kRayleigh * rayleighScatt;
+	const glm::vec3 mieParticipation = sky.kMie * Sky::miePhase(cosViewSun, sky.gMie) * mieScatt;
+	scattering = sky.sunIntensity * (rayleighParticipation + mieParticipation);
 
-	// The sun itself if we're looking at it.
-	glm::vec3 sunRadiance = glm::vec3(0.0f);
-	const bool didHitGroundForward = didHitGround && interGround.y > 0.0f;
-	if(!didHitGroundForward && glm::dot(rayDir, sunDir) > sky.sunRadiusCos){
-		sunRadiance = sky.sunColor / (glm::pi<float>() * sky.sunRadius * sky.sunRadius);
-	}
-
-	return sky.sunIntensity * (rayleighParticipation + mieParticipation) + transmittance * sunRadiance;
+	return !(didHitGround && interGround.y > 0.0f);
 }
 
-float MaterialSky::rayleighPhase(float cosAngle){
-	const float k = 1.0f/(4.0f*glm::pi<float>());
-	return k * 3.0f/4.0f * (1.0f + cosAngle*cosAngle);
+const Image & MaterialSky::scatteringTable(){
+	static const Texture * scatterTable = Resources::manager().getTexture("scattering-precomputed", {Layout::RGB32F, Filter::LINEAR_LINEAR, Wrap::CLAMP}, Storage::CPU);
+	return scatterTable->images[0];
 }
 
-float MaterialSky::miePhase(float cosAngle){
-	const float k = 1.0f/(4.0f*glm::pi<float>());
-	float g2 = sky.gMie*sky.gMie;
-	return k * 3.0f * (1.0f-g2) / (2.0f * (2.0f + g2)) * (1.0f + cosAngle*cosAngle) / std::pow(1.0f + g2 - 2.0f * sky.gMie * cosAngle, 3.0f/2.0f);
+glm::vec3 MaterialSky::sunRadiance(const glm::vec3 & rayDir, const glm::vec3 & sunDir){
+	if(glm::dot(rayDir, sunDir) > sky.sunRadiusCos){
+		return sky.sunColor / (glm::pi<float>() * sky.sunRadius * sky.sunRadius);
+	}
+	return glm::vec3(0.0f);
 }
@@ -1,17 +1,38 @@
 #pragma once
 #include "scene/Scene.hpp"
 #include "scene/Sky.hpp"
+#include "resources/Image.hpp"
 #include "Common.hpp"
 
 /**
  \brief CPU methods for evaluating the atmospheric scattering model used by the sky background.
+ \details Evaluating the model requires ray-marching through the atmosphere for each query. For a fixed sun direction and viewer altitude, the in-scattered radiance can instead be precomputed in a sky-view table, parameterized by the azimuth relative to the sun and the view zenith angle. The zenith parameterization is non-linear, to keep details close to the horizon. A transmittance table, parameterized by altitude and zenith angle, is used to add the sun disk analytically. Both tables use the parameterizations of Sky. Evaluation is then reduced to filtered lookups.
  \ingroup PathtracerDemo
  */
 class MaterialSky {
 public:
-	
-	/** Constructor. (deleted) */
-	MaterialSky() = delete;
+
+	/** Constructor. Tables are empty until built. */
+	MaterialSky() = default;
+
+	/** Precompute the sky-view and transmittance tables, in parallel.
+		\param sunDir the light direction
+		\param height the viewer vertical position in the scene
+	*/
+	void build(const glm::vec3 & sunDir, float height);
+
+	/** Compute the radiance for a given ray direction from the viewer, using the precomputed tables.
+		\param rayDir the ray direction
+		\return the estimated radiance
+	*/
+	glm::vec3 lookup(const glm::vec3 & rayDir) const;
+
+	/** Check if the tables are up to date for a given configuration.
+		\param sunDir the light direction
+		\param height the viewer vertical position in the scene
+		\return true if the tables have been built for this configuration
+	*/
+	bool matches(const glm::vec3 & sunDir, float height) const;
 
 	/** Compute the radiance for a given ray, based on the atmosphere scattering model.
 		\param rayOrigin the ray origin
@@ -21,21 +42,43 @@ public:
 	*/
 	static glm::vec3 eval(const glm::vec3 & rayOrigin, const glm::vec3 & rayDir, const glm::vec3 & sunDir);
 
+	/** Compare the table lookups against the ray-marched model, for a few sun elevations and random directions, and log the error and timings.
+		\param count the number of random directions to evaluate per sun elevation
+	*/
+	static void benchmark(size_t count);
+
 private:
 
-	/** Compute the Rayleigh phase.
-		\param cosAngle Cosine of the angle between the ray and the light directions
-		\return the phase
+	/** Ray-march the atmosphere scattering model.
+		\param planetPos the ray origin in planet space
+		\param rayDir the ray direction
+		\param sunDir the light direction
+		\param scatterTable the secondary attenuation table
+		\param scattering will contain the in-scattered radiance
+		\param transmittance will contain the accumulated attenuation towards the sun disk
+		\return true if the ray doesn't hit the ground in front of the viewer
 	*/
-	static float rayleighPhase(float cosAngle);
+	static bool march(const glm::vec3 & planetPos, const glm::vec3 & rayDir, const glm::vec3 & sunDir, const Image & scatterTable, glm::vec3 & scattering, glm::vec3 & transmittance);
+
+	/** \return the precomputed secondary attenuation table */
+	static const Image & scatteringTable();
 
-	/** Compute the Mie phase.
-		\param cosAngle Cosine of the angle between the ray and the light directions
-		\return the phase
+	/** Compute the radiance of the sun disk, if visible in a direction.
+		\param rayDir the ray direction
+		\param sunDir the light direction
+		\return the sun disk radiance, before attenuation
 	*/
-	static float miePhase(float cosAngle);
+	static glm::vec3 sunRadiance(const glm::vec3 & rayDir, const glm::vec3 & sunDir);
 
 	static const Sky::AtmosphereParameters sky; ///< Earth-like atmosphere parameters.
 	static const uint samplesCount = 16; ///< Number of samples to evaluate along the ray.
 
+	Image _skyView; ///< In-scattered radiance, azimuth relative to the sun along X, view zenith along Y.
+	Image _transmittance; ///< Attenuation towards the sun disk, altitude along X, view zenith cosine along Y.
+	glm::vec3 _sunDir = glm::vec3(0.0f); ///< Sun direction the tables were built for.
+	glm::vec3 _sunForward = glm::vec3(1.0f, 0.0f, 0.0f); ///< Horizontal direction towards the sun.
+	glm::vec3 _sunSide = glm::vec3(0.0f, 0.0f, 1.0f); ///< Horizontal direction orthogonal to the sun.
+	float _height = 0.0f; ///< Viewer vertical position the tables were built for.
+	float _altitude = 0.0f; ///< Viewer altitude above the ground.
+	float _horizonZenith = 0.5f * glm::pi<float>(); ///< View zenith angle of the horizon at the viewer altitude.
 };
@@ -18,9 +18,21 @@ PathTracer::PathTracer(const std::shared_ptr<Scene> & scene) {
 	}
 	_raycaster.updateHierarchy();
 	_scene = scene;
+	_lights = LightSampler(*scene);
+	// Precompute the sky for the reference viewpoint.
+	if(scene->backgroundMode == Scene::Background::ATMOSPHERE) {
+		const glm::vec3 & sunDir = dynamic_cast<const Sky *>(scene->background.get())->direction();
+		_sky.build(sunDir, scene->viewpoint().position().y);
+	}
+}
+
+float PathTracer::misWeight(float pdf, float otherPdf){
+	const float pdf2 = pdf * pdf;
+	const float sum = pdf2 + otherPdf * otherPdf;
+	return sum > 0.0f ? (pdf2 / sum) : 0.0f;
 }
 
-glm::vec3 PathTracer::evalBackground(const glm::vec3 & rayDir, const glm::vec3 & rayPos, const glm::vec2 & ndcPos, bool directHit) const {
+glm::vec3 PathTracer::evalBackground(const glm::vec3 & rayDir, const glm::vec2 & ndcPos, bool directHit) const {
 	const Scene::Background mode = _scene->backgroundMode;
 
 	glm::vec3 color(0.0f);
@@ -33,8 +45,7 @@ glm::vec3 PathTracer::evalBackground(const glm::vec3 & rayDir, const glm::vec3 &
 			const Texture * tex = _scene->background->textures()[0];
 			color = tex->sampleCubemap(glm::normalize(rayDir));
 		} else if(mode == Scene::Background::ATMOSPHERE) {
-			const glm::vec3 & sunDir = dynamic_cast<const Sky *>(_scene->background.get())->direction();
-			color = MaterialSky::eval(rayPos, glm::normalize(rayDir), sunDir);
+			color = _sky.lookup(rayDir);
 		} else {
 			color = _scene->backgroundColor;
 		}
@@ -43,11 +54,15 @@ glm::vec3 PathTracer::evalBackground(const glm::vec3 & rayDir, const glm::vec3 &
 
 	// Else, only environment maps and atmospheric simulations contribute to indirect illumination.
 	if(mode == Scene::Background::SKYBOX) {
+		// Use the same lookup as light samples when the environment is sampled.
+		if(_lights.hasEnvironment()) {
+			return _lights.environment(rayDir);
+		}
 		const Texture * tex = _scene->background->textures()[0];
 		color = tex->sampleCubemap(glm::normalize(rayDir));
 	} else if(mode == Scene::Background::ATMOSPHERE) {
-		const glm::vec3 & sunDir = dynamic_cast<const Sky *>(_scene->background.get())->direction();
-		color = MaterialSky::eval(rayPos, glm::normalize(rayDir), sunDir);
+		// Scene extents are negligible at the atmosphere scale, use the tables built at the viewer position.
+		color = _sky.lookup(rayDir);
 	}
 	return color;
 }
@@ -149,7 +164,99 @@ bool PathTracer::checkVisibility(const glm::vec3 & startPos, const glm::vec3 & r
 	return true;
 }
 
-void PathTracer::render(const Camera & camera, size_t samples, size_t depth, Image & render) {
+void PathTracer::PathStates::resize(size_t count){
+	origins.resize(count);
+	directions.resize(count);
+	attenuations.resize(count);
+	colors.resize(count);
+	prevPositions.resize(count);
+	prevNormals.resize(count);
+	prevPdfs.resize(count);
+	ndcs.resize(count);
+	bounced.resize(count);
+	hits.resize(count);
+	albedos.resize(count);
+	normals.resize(count);
+	depths.resize(count);
+}
+
+void PathTracer::ShadowQueue::push(uint path, const glm::vec3 & origin, const glm::vec3 & direction, float distance, const glm::vec3 & contribution){
+	paths.push_back(path);
+	origins.push_back(origin);
+	directions.push_back(direction);
+	distances.push_back(distance);
+	contributions.push_back(contribution);
+}
+
+void PathTracer::ShadowQueue::clear(){
+	paths.clear();
+	origins.clear();
+	directions.clear();
+	distances.clear();
+	contributions.clear();
+}
+
+bool PathTracer::russianRoulette(size_t bounce, glm::vec3 & attenuation){
+	// Always keep the first bounces, that gather most of the energy.
+	if(bounce < 2){
+		return true;
+	}
+	// Paths carrying little energy are likely to be terminated.
+	const float survival = glm::clamp(std::max(attenuation.r, std::max(attenuation.g, attenuation.b)), 0.05f, 0.95f);
+	if(Random::Float() >= survival){
+		return false;
+	}
+	// Compensate to keep the estimator unbiased.
+	attenuation /= survival;
+	return true;
+}
+
+void PathTracer::shadeSurface(const Object & obj, const Raycaster::Hit & hit, const glm::vec3 & p, const glm::vec3 & rayDir, const glm::vec2 & uv, const glm::vec4 & bCol, bool scatter, Interaction & interaction) const {
+	// Compute local tangent frame.
+	const glm::mat3 tbn = buildLocalFrame(obj, hit, rayDir, uv);
+	const glm::mat3 itbn = glm::transpose(tbn);
+	// For sampling and evaluating the BRDF, convert outgoing direction to the local frame.
+	const glm::vec3 wo = glm::normalize(itbn * (-rayDir));
+	const glm::vec3 baseColor = glm::pow(glm::vec3(bCol), glm::vec3(2.2f));
+	// Check other material attributes.
+	const Image & imageRMAO  = obj.textures()[2]->images[0];
+	const glm::vec4 rmao = imageRMAO.rgbal(uv.x, uv.y);
+
+	// Shift slightly to avoid grazing angle self-intersections.
+	interaction.position = p + 0.001f * tbn[2];
+	interaction.normal = tbn[2];
+	interaction.albedo = baseColor;
+
+	// Direct light sampling, picking lights and emissive triangles based on their estimated contribution.
+	LightSampler::Sample light;
+	interaction.lightSampled = false;
+	if(_lights.sample(interaction.position, tbn[2], light)){
+		const glm::vec3 lwi = glm::normalize(itbn * light.direction);
+		const glm::vec3 evalLight = MaterialGGX::eval(wo, baseColor, rmao.r, rmao.g, lwi);
+		// Area lights can also be reached by the next bounce, weight both strategies.
+		float weight = 1.0f;
+		if(light.area){
+			weight = misWeight(light.pdf, MaterialGGX::pdf(wo, baseColor, rmao.r, rmao.g, lwi));
+		}
+		interaction.lightContribution = weight * evalLight * light.radiance / light.pdf;
+		interaction.lightDirection = light.direction;
+		// Stop just before area lights when testing visibility.
+		interaction.lightDistance = light.area ? (light.distance - 0.002f) : light.distance;
+		interaction.lightShadows = light.shadows;
+		// No need to test visibility for samples that can't contribute.
+		interaction.lightSampled = glm::any(glm::greaterThan(interaction.lightContribution, glm::vec3(0.0f)));
+	}
+
+	if(!scatter){
+		return;
+	}
+	// Pick next direction based on the BRDF.
+	glm::vec3 wi;
+	interaction.weight = MaterialGGX::sampleAndEval(wo, baseColor, rmao.r, rmao.g, wi, &interaction.pdf);
+	interaction.direction = glm::normalize(tbn * wi);
+}
+
+void PathTracer::render(const Camera & camera, size_t samples, size_t depth, Image & render, Mode mode, Features * features, const Denoiser * denoiser) {
 
 	// Safety checks.
 	if(!_scene) {
@@ -165,130 +272,349 @@ void PathTracer::render(const Camera & camera, size_t samples, size_t depth, Ima
 		Log::Warning() << "[PathTracer] Non power-of-2 samples count. Using " << samples << " instead." << std::endl;
 	}
 
+	RenderSetup setup;
 	// Compute incremental pixel shifts.
-	glm::vec3 corner, dx, dy;
-	camera.pixelShifts(corner, dx, dy);
-	const glm::ivec2 cellCount = getSampleGrid(samples);
-	const glm::vec2 cellSize = 1.0f / glm::vec2(cellCount);
+	camera.pixelShifts(setup.corner, setup.dx, setup.dy);
+	setup.position = camera.position();
+	setup.cellCount = getSampleGrid(samples);
+	setup.cellSize = 1.0f / glm::vec2(setup.cellCount);
+	setup.samples = samples;
+	setup.depth = depth;
+
+	// Update the sky tables if the sun or the viewer moved.
+	if(_scene->backgroundMode == Scene::Background::ATMOSPHERE) {
+		const glm::vec3 & sunDir = dynamic_cast<const Sky *>(_scene->background.get())->direction();
+		if(!_sky.matches(sunDir, setup.position.y)) {
+			_sky.build(sunDir, setup.position.y);
+		}
+	}
+
+	// The denoiser always needs feature buffers.
+	Features localFeatures;
+	Features * firstHits = features ? features : (denoiser ? &localFeatures : nullptr);
+	if(firstHits) {
+		firstHits->albedo = Image(render.width, render.height, 3);
+		firstHits->normal = Image(render.width, render.height, 3);
+		firstHits->depth = Image(render.width, render.height, 1);
+	}
 
 	// Start chrono.
 	Query timer;
 	timer.begin();
 
 	// Parallelize on each row of the image.
-	System::forParallel(0, size_t(render.height), [&render, samples, &cellCount, &cellSize, &corner, &dx, &dy, &camera, depth, this](size_t y) {
-		for(size_t x = 0; x < size_t(render.width); ++x) {
-			for(size_t sid = 0; sid < samples; ++sid) {
-
-				// Get the position of the sample in screenspace.
-				const glm::vec2 screenPos = glm::vec2(x, y) + getSamplePosition(sid, cellCount, cellSize);
-				// Derive a position on the image plane from the pixel.
-				const glm::vec2 ndcPos = screenPos / glm::vec2(render.width, render.height);
-				// Place the point on the near plane in clip space.
-				const glm::vec3 worldPos = corner + ndcPos.x * dx + ndcPos.y * dy;
-				// Initial ray setup.
-				glm::vec3 rayPos = camera.position();
-				glm::vec3 rayDir = glm::normalize(worldPos - camera.position());
-				glm::vec3 sampleColor(0.0f);
-				glm::vec3 attenuation(1.0f);
-
-				for(size_t did = 0; did < depth; ++did) {
-					// Query closest intersection.
-					const Raycaster::Hit hit = _raycaster.intersects(rayPos, rayDir);
-					// If no hit, background.
-					if(!hit.hit) {
-						sampleColor += attenuation * evalBackground(rayDir, rayPos, ndcPos, did == 0);
-						break;
-					}
+	if(mode == Mode::WAVEFRONT){
+		System::forParallel(0, size_t(render.height), [&render, &setup, firstHits, this](size_t y) {
+			traceRowWavefront(setup, y, render, firstHits);
+		});
+	} else {
+		System::forParallel(0, size_t(render.height), [&render, &setup, firstHits, this](size_t y) {
+			traceRowScalar(setup, y, render, firstHits);
+		});
+	}
+
+	// Normalize.
+	System::forParallel(0, size_t(render.height), [&render, &samples, firstHits](size_t y) {
+		for(size_t x = 0; x < (render.width); ++x) {
+			render.rgb(int(x), int(y)) /= float(samples);
+			if(firstHits) {
+				firstHits->albedo.rgb(int(x), int(y)) /= float(samples);
+				firstHits->depth.r(int(x), int(y)) /= float(samples);
+				glm::vec3 & normal = firstHits->normal.rgb(int(x), int(y));
+				const float length = glm::length(normal);
+				normal = length > 0.0f ? (normal / length) : normal;
+			}
+		}
+	});
+
+	if(denoiser) {
+		denoiser->process(render, firstHits->albedo, firstHits->normal, firstHits->depth);
+	}
+
+	// Gamma correction.
+	System::forParallel(0, size_t(render.height), [&render](size_t y) {
+		for(size_t x = 0; x < (render.width); ++x) {
+			render.rgb(int(x), int(y)) = glm::pow(render.rgb(int(x), int(y)), glm::vec3(1.0f / 2.2f));
+		}
+	});
+
+	// Display duration.
+	timer.end();
+	Log::Info() << "[PathTracer] Rendering took " << float(timer.value()) / 1000000000.0f << "s at " << render.width << "x" << render.height << "." << std::endl;
+}
+
+void PathTracer::traceRowScalar(const RenderSetup & setup, size_t y, Image & render, Features * features) const {
+	const size_t depth = setup.depth;
+	for(size_t x = 0; x < size_t(render.width); ++x) {
+		for(size_t sid = 0; sid < setup.samples; ++sid) {
 
-					// Fetch geometry infos...
-					const Object & obj = _scene->objects[hit.meshId];
-					const Mesh & mesh  = *obj.mesh();
-					const glm::vec3 p  = rayPos + hit.dist * rayDir;
-					// Fetch material texel information.
-					const bool noUVs = !obj.useTexCoords();
-					const glm::vec2 uv = noUVs ? glm::vec2(0.5f, 0.5f) :  Raycaster::interpolateAttribute(hit, mesh, mesh.texcoords);
-					const Image & image  = obj.textures()[0]->images[0];
-					const glm::vec4 bCol = image.rgbal(uv.x, uv.y);
-					// In case of alpha cut-out, just update the position to the intersection and keep casting.
-					// The 'mini' margin will ensures that we don't reintersect the same surface.
-					if(obj.masked() && bCol.a < 0.01f) {
-						rayPos = p;
-						continue;
+			// Get the position of the sample in screenspace.
+			const glm::vec2 screenPos = glm::vec2(x, y) + getSamplePosition(sid, setup.cellCount, setup.cellSize);
+			// Derive a position on the image plane from the pixel.
+			const glm::vec2 ndcPos = screenPos / glm::vec2(render.width, render.height);
+			// Place the point on the near plane in clip space.
+			const glm::vec3 worldPos = setup.corner + ndcPos.x * setup.dx + ndcPos.y * setup.dy;
+			// Initial ray setup.
+			glm::vec3 rayPos = setup.position;
+			glm::vec3 rayDir = glm::normalize(worldPos - setup.position);
+			glm::vec3 sampleColor(0.0f);
+			glm::vec3 attenuation(1.0f);
+			// Previous scattering event, to weight emission from surfaces hit after a bounce.
+			glm::vec3 prevPos(0.0f);
+			glm::vec3 prevNormal(0.0f);
+			float prevPdf = 0.0f;
+			bool bounced = false;
+
+			for(size_t did = 0; did < depth; ++did) {
+				// Query closest intersection.
+				const Raycaster::Hit hit = _raycaster.intersects(rayPos, rayDir);
+				// If no hit, background.
+				if(!hit.hit) {
+					// The environment can also be reached by light sampling, weight both strategies.
+					float weight = 1.0f;
+					if(bounced){
+						weight = misWeight(prevPdf, _lights.pdf(prevPos, prevNormal, rayDir));
 					}
-					// For emissive we don't apply any BRDF or re-cast rays, we just receive emitted light.
-					if(obj.type() == Object::Type::Emissive){
-						// Should we gamma-correct emissive textures?
-						sampleColor += attenuation * glm::vec3(bCol);
-						// No need to continue further.
-						break;
+					sampleColor += weight * attenuation * evalBackground(rayDir, ndcPos, did == 0);
+					if(features && !bounced) {
+						features->albedo.rgb(int(x), int(y)) += glm::vec3(1.0f);
+						features->normal.rgb(int(x), int(y)) -= rayDir;
 					}
+					break;
+				}
 
-					// Compute local tangent frame.
-					const glm::mat3 tbn = buildLocalFrame(obj, hit, rayDir, uv);
-					const glm::mat3 itbn = glm::transpose(tbn);
-					// For sampling and evaluating the BRDF, convert outgoing direction to the local frame.
-					const glm::vec3 wo = glm::normalize(itbn * (-rayDir));
-					const glm::vec3 baseColor = glm::pow(glm::vec3(bCol), glm::vec3(2.2f));
-					// Check other material attributes.
-					const Image & imageRMAO  = obj.textures()[2]->images[0];
-					const glm::vec4 rmao = imageRMAO.rgbal(uv.x, uv.y);
-
-					// Direct light sampling.
-					if(!_scene->lights.empty()){
-						// Take a light at random.
-						const unsigned int lid = Random::Int(0, int(_scene->lights.size()-1));
-						const auto & light = _scene->lights[lid];
-						// Shift slightly to avoid grazing angle self-intersections.
-						const glm::vec3 pShift = p+0.001f*tbn[2];
-						// Sample a ray going from the surface of the object to the light.
-						float maxDist, falloff;
-						const glm::vec3 direction = light->sample(pShift, maxDist, falloff);
-						// Test visibility of needed..
-						bool visible = falloff > 0.0f;
-						if(visible && light->castsShadow()){
-							visible = checkVisibility(pShift, direction, maxDist);
-						}
-
-						// If visible, add contribution weighted by the surface BRDF.
-						if(visible){
-							const glm::vec3 lwi = glm::normalize(itbn * direction);
-							const glm::vec3 evalLight = MaterialGGX::eval(wo, baseColor, rmao.r, rmao.g, lwi);
-							const float lightPdf = 1.0f / float(_scene->lights.size());
-							const glm::vec3 illumination = falloff * evalLight * light->intensity() / lightPdf;
-							// Because we only sample analytical lights, we can't hit an emitter via the raycaster, so no double-hit case to consider for now.
-							sampleColor += attenuation * illumination;
-						}
+				// Fetch geometry infos...
+				const Object & obj = _scene->objects[hit.meshId];
+				const Mesh & mesh  = *obj.mesh();
+				const glm::vec3 p  = rayPos + hit.dist * rayDir;
+				// Fetch material texel information.
+				const bool noUVs = !obj.useTexCoords();
+				const glm::vec2 uv = noUVs ? glm::vec2(0.5f, 0.5f) :  Raycaster::interpolateAttribute(hit, mesh, mesh.texcoords);
+				const Image & image  = obj.textures()[0]->images[0];
+				const glm::vec4 bCol = image.rgbal(uv.x, uv.y);
+				// In case of alpha cut-out, just update the position to the intersection and keep casting.
+				// The 'mini' margin will ensures that we don't reintersect the same surface.
+				if(obj.masked() && bCol.a < 0.01f) {
+					rayPos = p;
+					continue;
+				}
+				// For emissive we don't apply any BRDF or re-cast rays, we just receive emitted light.
+				if(obj.type() == Object::Type::Emissive){
+					// Emissive triangles can also be reached by light sampling, weight both strategies.
+					float weight = 1.0f;
+					if(bounced){
+						weight = misWeight(prevPdf, _lights.pdf(prevPos, prevNormal, hit, p));
+					}
+					// Should we gamma-correct emissive textures?
+					sampleColor += weight * attenuation * glm::vec3(bCol);
+					if(features && !bounced) {
+						features->albedo.rgb(int(x), int(y)) += glm::vec3(bCol);
+						features->normal.rgb(int(x), int(y)) += buildLocalFrame(obj, hit, rayDir, uv)[2];
+						features->depth.r(int(x), int(y)) += glm::distance(setup.position, p);
 					}
+					// No need to continue further.
+					break;
+				}
 
-					// Pick next direction based on the BRDF.
-					glm::vec3 wi;
-					glm::vec3 eval = MaterialGGX::sampleAndEval(wo, baseColor, rmao.r, rmao.g, wi);
-					const glm::vec3 nextRayDir = glm::normalize(tbn * wi);
-					// Bounce decay.
-					attenuation *= eval;
-
-					// Update position and ray direction.
-					if(did < depth - 1) {
-						rayPos = p;
-						rayDir = glm::normalize(nextRayDir);
+				// No need to pick a next direction at the last bounce.
+				const bool last = did == depth - 1;
+				Interaction surface;
+				shadeSurface(obj, hit, p, rayDir, uv, bCol, !last, surface);
+				if(features && !bounced) {
+					features->albedo.rgb(int(x), int(y)) += surface.albedo;
+					features->normal.rgb(int(x), int(y)) += surface.normal;
+					features->depth.r(int(x), int(y)) += glm::distance(setup.position, p);
+				}
+				// Test visibility if needed and add the light contribution.
+				if(surface.lightSampled){
+					if(!surface.lightShadows || checkVisibility(surface.position, surface.lightDirection, surface.lightDistance)){
+						sampleColor += attenuation * surface.lightContribution;
 					}
 				}
-				// Clamp and store.
-				render.rgb(int(x), int(y)) += glm::min(sampleColor, 5.0f);
+				if(last){
+					break;
+				}
+				// Bounce decay.
+				attenuation *= surface.weight;
+				if(!russianRoulette(did, attenuation)){
+					break;
+				}
+				prevPos = surface.position;
+				prevNormal = surface.normal;
+				prevPdf = surface.pdf;
+				bounced = true;
+				// Update position and ray direction.
+				rayPos = p;
+				rayDir = surface.direction;
 			}
+			// Clamp and store.
+			render.rgb(int(x), int(y)) += glm::min(sampleColor, 5.0f);
 		}
-	});
+	}
+}
 
-	// Normalize and gamma correction.
-	System::forParallel(0, size_t(render.height), [&render, &samples](size_t y) {
-		for(size_t x = 0; x < (render.width); ++x) {
-			const glm::vec3 color	  = render.rgb(int(x), int(y)) / float(samples);
-			render.rgb(int(x), int(y)) = glm::pow(color, glm::vec3(1.0f / 2.2f));
+void PathTracer::traceRowWavefront(const RenderSetup & setup, size_t y, Image & render, Features * features) const {
+	// All samples of all pixels of the row are processed together.
+	const size_t width = size_t(render.width);
+	PathStates paths;
+	ShadowQueue shadows;
+	std::vector<uint> queue;
+	std::vector<uint> nextQueue;
+	generatePaths(setup, y, width, size_t(render.height), paths, queue);
+	nextQueue.reserve(queue.size());
+
+	// Each stage is applied to all alive paths before moving to the next.
+	for(size_t did = 0; did < setup.depth && !queue.empty(); ++did) {
+		extendPaths(queue, paths);
+		shadows.clear();
+		nextQueue.clear();
+		shadePaths(setup, queue, did, paths, shadows, nextQueue);
+		connectShadows(shadows, paths);
+		// Only surviving paths remain, in their initial order.
+		std::swap(queue, nextQueue);
+	}
+
+	// Clamp and store.
+	for(size_t pid = 0; pid < paths.colors.size(); ++pid) {
+		const int x = int(pid / setup.samples);
+		render.rgb(x, int(y)) += glm::min(paths.colors[pid], 5.0f);
+		if(features) {
+			features->albedo.rgb(x, int(y)) += paths.albedos[pid];
+			features->normal.rgb(x, int(y)) += paths.normals[pid];
+			features->depth.r(x, int(y)) += paths.depths[pid];
 		}
-	});
+	}
+}
 
-	// Display duration.
-	timer.end();
-	Log::Info() << "[PathTracer] Rendering took " << float(timer.value()) / 1000000000.0f << "s at " << render.width << "x" << render.height << "." << std::endl;
+void PathTracer::generatePaths(const RenderSetup & setup, size_t y, size_t width, size_t height, PathStates & paths, std::vector<uint> & queue) {
+	const size_t count = width * setup.samples;
+	paths.resize(count);
+	queue.resize(count);
+
+	for(size_t pid = 0; pid < count; ++pid) {
+		const size_t x = pid / setup.samples;
+		const size_t sid = pid % setup.samples;
+		// Get the position of the sample in screenspace.
+		const glm::vec2 screenPos = glm::vec2(x, y) + getSamplePosition(sid, setup.cellCount, setup.cellSize);
+		// Derive a position on the image plane from the pixel.
+		const glm::vec2 ndcPos = screenPos / glm::vec2(width, height);
+		// Place the point on the near plane in clip space.
+		const glm::vec3 worldPos = setup.corner + ndcPos.x * setup.dx + ndcPos.y * setup.dy;
+
+		paths.origins[pid] = setup.position;
+		paths.directions[pid] = glm::normalize(worldPos - setup.position);
+		paths.attenuations[pid] = glm::vec3(1.0f);
+		paths.colors[pid] = glm::vec3(0.0f);
+		paths.prevPositions[pid] = glm::vec3(0.0f);
+		paths.prevNormals[pid] = glm::vec3(0.0f);
+		paths.prevPdfs[pid] = 0.0f;
+		paths.ndcs[pid] = ndcPos;
+		paths.bounced[pid] = 0;
+		paths.albedos[pid] = glm::vec3(0.0f);
+		paths.normals[pid] = glm::vec3(0.0f);
+		paths.depths[pid] = 0.0f;
+		queue[pid] = uint(pid);
+	}
+}
+
+void PathTracer::extendPaths(const std::vector<uint> & queue, PathStates & paths) const {
+	for(const uint pid : queue) {
+		paths.hits[pid] = _raycaster.intersects(paths.origins[pid], paths.directions[pid]);
+	}
+}
+
+void PathTracer::shadePaths(const RenderSetup & setup, const std::vector<uint> & queue, size_t bounce, PathStates & paths, ShadowQueue & shadows, std::vector<uint> & nextQueue) const {
+	// No need to pick a next direction at the last bounce.
+	const bool last = bounce == setup.depth - 1;
+
+	for(const uint pid : queue) {
+		const Raycaster::Hit & hit = paths.hits[pid];
+		const glm::vec3 & rayPos = paths.origins[pid];
+		const glm::vec3 & rayDir = paths.directions[pid];
+		glm::vec3 & attenuation = paths.attenuations[pid];
+		// If no hit, background.
+		if(!hit.hit) {
+			float weight = 1.0f;
+			if(paths.bounced[pid]){
+				weight = misWeight(paths.prevPdfs[pid], _lights.pdf(paths.prevPositions[pid], paths.prevNormals[pid], rayDir));
+			}
+			paths.colors[pid] += weight * attenuation * evalBackground(rayDir, paths.ndcs[pid], bounce == 0);
+			if(!paths.bounced[pid]) {
+				paths.albedos[pid] = glm::vec3(1.0f);
+				paths.normals[pid] = -rayDir;
+			}
+			continue;
+		}
+
+		// Fetch geometry infos...
+		const Object & obj = _scene->objects[hit.meshId];
+		const Mesh & mesh  = *obj.mesh();
+		const glm::vec3 p  = rayPos + hit.dist * rayDir;
+		// Fetch material texel information.
+		const bool noUVs = !obj.useTexCoords();
+		const glm::vec2 uv = noUVs ? glm::vec2(0.5f, 0.5f) :  Raycaster::interpolateAttribute(hit, mesh, mesh.texcoords);
+		const Image & image  = obj.textures()[0]->images[0];
+		const glm::vec4 bCol = image.rgbal(uv.x, uv.y);
+		// In case of alpha cut-out, just update the position to the intersection and keep casting.
+		if(obj.masked() && bCol.a < 0.01f) {
+			paths.origins[pid] = p;
+			nextQueue.push_back(pid);
+			continue;
+		}
+		// For emissive we don't apply any BRDF or re-cast rays, we just receive emitted light.
+		if(obj.type() == Object::Type::Emissive){
+			float weight = 1.0f;
+			if(paths.bounced[pid]){
+				weight = misWeight(paths.prevPdfs[pid], _lights.pdf(paths.prevPositions[pid], paths.prevNormals[pid], hit, p));
+			}
+			paths.colors[pid] += weight * attenuation * glm::vec3(bCol);
+			if(!paths.bounced[pid]) {
+				paths.albedos[pid] = glm::vec3(bCol);
+				paths.normals[pid] = buildLocalFrame(obj, hit, rayDir, uv)[2];
+				paths.depths[pid] = glm::distance(setup.position, p);
+			}
+			continue;
+		}
+
+		Interaction surface;
+		shadeSurface(obj, hit, p, rayDir, uv, bCol, !last, surface);
+		if(!paths.bounced[pid]) {
+			paths.albedos[pid] = surface.albedo;
+			paths.normals[pid] = surface.normal;
+			paths.depths[pid] = glm::distance(setup.position, p);
+		}
+		// Defer visibility tests to the shadow stage.
+		if(surface.lightSampled){
+			const glm::vec3 contribution = attenuation * surface.lightContribution;
+			if(surface.lightShadows){
+				shadows.push(pid, surface.position, surface.lightDirection, surface.lightDistance, contribution);
+			} else {
+				paths.colors[pid] += contribution;
+			}
+		}
+		if(last){
+			continue;
+		}
+		// Bounce decay.
+		attenuation *= surface.weight;
+		if(!russianRoulette(bounce, attenuation)){
+			continue;
+		}
+		paths.prevPositions[pid] = surface.position;
+		paths.prevNormals[pid] = surface.normal;
+		paths.prevPdfs[pid] = surface.pdf;
+		paths.bounced[pid] = 1;
+		// Update position and ray direction.
+		paths.origins[pid] = p;
+		paths.directions[pid] = surface.direction;
+		nextQueue.push_back(pid);
+	}
+}
+
+void PathTracer::connectShadows(const ShadowQueue & shadows, PathStates & paths) const {
+	for(size_t rid = 0; rid < shadows.paths.size(); ++rid) {
+		if(checkVisibility(shadows.origins[rid], shadows.directions[rid], shadows.distances[rid])){
+			paths.colors[shadows.paths[rid]] += shadows.contributions[rid];
+		}
+	}
 }
@@ -1,4 +1,7 @@
 #pragma once
+#include "LightSampler.hpp"
+#include "Denoiser.hpp"
+#include "MaterialSky.hpp"
 #include "raycaster/Raycaster.hpp"
 #include "scene/Scene.hpp"
 #include "Common.hpp"
@@ -9,6 +12,20 @@
  */
 class PathTracer {
 public:
+
+	/** \brief Paths processing strategy. */
+	enum class Mode {
+		SCALAR, ///< Trace each sample path from start to end before moving to the next one.
+		WAVEFRONT ///< Process all paths of an image row together, one bounce at a time, with each stage run over a compacted queue of alive paths.
+	};
+
+	/** \brief Auxiliary buffers describing the first surface seen by each pixel, averaged over its samples. */
+	struct Features {
+		Image albedo; ///< Linear surface albedo (RGB).
+		Image normal; ///< World space shading normal (RGB).
+		Image depth; ///< Distance to the camera, 0 for the background (R).
+	};
+
 	/** Empty constructor. */
 	PathTracer() = default;
 
@@ -22,14 +39,155 @@ public:
 	 \param samples the number of samples per-pixel
 	 \param depth the maximum number of bounces for each path
 	 \param render the image, will be filled with the (gamma-corrected) result
+	 \param mode the paths processing strategy
+	 \param features if non null, will be filled with the first hit feature buffers
+	 \param denoiser if non null, will be applied to the linear result using the feature buffers
+	 \note Paths can be terminated early by Russian roulette after a few bounces.
 	 */
-	void render(const Camera & camera, size_t samples, size_t depth, Image & render);
+	void render(const Camera & camera, size_t samples, size_t depth, Image & render, Mode mode = Mode::SCALAR, Features * features = nullptr, const Denoiser * denoiser = nullptr);
 
 	/** \return the internal raycaster. */
 	const Raycaster & raycaster() const { return _raycaster; }
 
 private:
 
+	/** \brief Parameters shared by all paths of a rendering. */
+	struct RenderSetup {
+		glm::vec3 position; ///< Camera position.
+		glm::vec3 corner; ///< Bottom-left corner of the image plane.
+		glm::vec3 dx; ///< Horizontal image plane shift.
+		glm::vec3 dy; ///< Vertical image plane shift.
+		glm::ivec2 cellCount; ///< Samples grid dimensions.
+		glm::vec2 cellSize; ///< Samples grid spacing.
+		size_t samples; ///< Samples per pixel.
+		size_t depth; ///< Maximum number of bounces.
+	};
+
+	/** \brief Result of a path reaching a surface: light connection and next direction. */
+	struct Interaction {
+		glm::vec3 position; ///< Surface position, shifted along the normal.
+		glm::vec3 normal; ///< Shading normal.
+		glm::vec3 direction; ///< Next path direction.
+		glm::vec3 albedo; ///< Linear surface albedo.
+		glm::vec3 weight; ///< BRDF value divided by the next direction density.
+		float pdf = 0.0f; ///< Next direction density.
+		glm::vec3 lightDirection; ///< Light sample direction.
+		glm::vec3 lightContribution; ///< Light sample contribution if visible.
+		float lightDistance = 0.0f; ///< Distance to travel to test the light sample visibility.
+		bool lightSampled = false; ///< Is there a non-zero light sample contribution.
+		bool lightShadows = false; ///< Should the light sample visibility be tested.
+	};
+
+	/** \brief State of a batch of paths, stored as separate arrays for each attribute. */
+	struct PathStates {
+		std::vector<glm::vec3> origins; ///< Current ray origins.
+		std::vector<glm::vec3> directions; ///< Current ray directions.
+		std::vector<glm::vec3> attenuations; ///< Accumulated attenuations.
+		std::vector<glm::vec3> colors; ///< Accumulated colors.
+		std::vector<glm::vec3> prevPositions; ///< Previous scattering event positions.
+		std::vector<glm::vec3> prevNormals; ///< Previous scattering event normals.
+		std::vector<float> prevPdfs; ///< Previous scattering event direction densities.
+		std::vector<glm::vec2> ndcs; ///< Sample positions on the image plane.
+		std::vector<unsigned char> bounced; ///< Has the path already scattered on a surface.
+		std::vector<Raycaster::Hit> hits; ///< Current ray intersections.
+		std::vector<glm::vec3> albedos; ///< First hit albedos.
+		std::vector<glm::vec3> normals; ///< First hit normals.
+		std::vector<float> depths; ///< First hit distances to the camera.
+
+		/** Allocate storage for a number of paths.
+		 \param count the number of paths
+		 */
+		void resize(size_t count);
+	};
+
+	/** \brief Shadow rays to trace for a batch of paths. */
+	struct ShadowQueue {
+		std::vector<uint> paths; ///< Index of the path to contribute to.
+		std::vector<glm::vec3> origins; ///< Ray origins.
+		std::vector<glm::vec3> directions; ///< Ray directions.
+		std::vector<float> distances; ///< Maximum distances to travel.
+		std::vector<glm::vec3> contributions; ///< Contributions if visible.
+
+		/** Add a shadow ray.
+		 \param path the path to contribute to
+		 \param origin the ray origin
+		 \param direction the ray direction
+		 \param distance the maximum distance to travel
+		 \param contribution the contribution if visible
+		 */
+		void push(uint path, const glm::vec3 & origin, const glm::vec3 & direction, float distance, const glm::vec3 & contribution);
+
+		/** Remove all rays, keeping the allocated memory. */
+		void clear();
+	};
+
+	/** Trace all samples of an image row, one path after the other.
+	 \param setup the rendering parameters
+	 \param y the row index
+	 \param render the image to accumulate samples in
+	 \param features if non null, the feature buffers to accumulate first hits in
+	 */
+	void traceRowScalar(const RenderSetup & setup, size_t y, Image & render, Features * features) const;
+
+	/** Trace all samples of an image row at once, bounce after bounce.
+	 \param setup the rendering parameters
+	 \param y the row index
+	 \param render the image to accumulate samples in
+	 \param features if non null, the feature buffers to accumulate first hits in
+	 */
+	void traceRowWavefront(const RenderSetup & setup, size_t y, Image & render, Features * features) const;
+
+	/** Wavefront kernel: initialize the camera paths of all samples of an image row.
+	 \param setup the rendering parameters
+	 \param y the row index
+	 \param width the image width
+	 \param height the image height
+	 \param paths the paths states to initialize
+	 \param queue will contain all paths indices
+	 */
+	static void generatePaths(const RenderSetup & setup, size_t y, size_t width, size_t height, PathStates & paths, std::vector<uint> & queue);
+
+	/** Wavefront kernel: find the closest intersection of the current ray of each path in a queue.
+	 \param queue the indices of the paths to process
+	 \param paths the paths states
+	 */
+	void extendPaths(const std::vector<uint> & queue, PathStates & paths) const;
+
+	/** Wavefront kernel: accumulate emitted light, sample lights and pick the next direction for each path in a queue.
+	 \param setup the rendering parameters
+	 \param queue the indices of the paths to process
+	 \param bounce the current bounce index
+	 \param paths the paths states
+	 \param shadows will receive the light samples to test for visibility
+	 \param nextQueue will receive the indices of the paths still alive
+	 */
+	void shadePaths(const RenderSetup & setup, const std::vector<uint> & queue, size_t bounce, PathStates & paths, ShadowQueue & shadows, std::vector<uint> & nextQueue) const;
+
+	/** Wavefront kernel: test the visibility of light samples and accumulate their contributions.
+	 \param shadows the light samples to test
+	 \param paths the paths states
+	 */
+	void connectShadows(const ShadowQueue & shadows, PathStates & paths) const;
+
+	/** Sample a light and the material at a surface intersection.
+	 \param obj the intersected object
+	 \param hit the intersection record
+	 \param p the intersection position
+	 \param rayDir the direction of the ray that intersected
+	 \param uv the local texture coordinates (if valid)
+	 \param bCol the base color texel
+	 \param scatter should the next path direction be sampled
+	 \param interaction will contain the light sample and next direction
+	 */
+	void shadeSurface(const Object & obj, const Raycaster::Hit & hit, const glm::vec3 & p, const glm::vec3 & rayDir, const glm::vec2 & uv, const glm::vec4 & bCol, bool scatter, Interaction & interaction) const;
+
+	/** Randomly terminate a path based on its attenuation, after a few bounces.
+	 \param bounce the current bounce index
+	 \param attenuation the path attenuation, will be compensated if the path survives
+	 \return true if the path should continue
+	 */
+	static bool russianRoulette(size_t bounce, glm::vec3 & attenuation);
+
 	/** Compute the dimensions of a grid that contains a given number of samples.
 	 \param samples the number of samples to place on a regular grid
 	 \return the number of samples on each axis
@@ -64,13 +222,21 @@ private:
 
 	/** Evalutation the contribution from the scene background.
 	 \param rayDir the direction of the ray that intersected
-	 \param rayPos the ray world space position
 	 \param ndcPos the current pixel in the final image
 	 \param directHit was it a direct hit or a hit after bounces
 	 \return the background contribution
 	 */
-	glm::vec3 evalBackground(const glm::vec3 & rayDir, const glm::vec3 & rayPos, const glm::vec2 & ndcPos, bool directHit) const;
+	glm::vec3 evalBackground(const glm::vec3 & rayDir, const glm::vec2 & ndcPos, bool directHit) const;
+
+	/** Compute the multiple importance sampling weight of a strategy, using the power heuristic.
+	 \param pdf the density of the strategy used
+	 \param otherPdf the density of the other strategy
+	 \return the weight
+	 */
+	static float misWeight(float pdf, float otherPdf);
 
 	Raycaster _raycaster;		   ///< The internal raycaster.
+	LightSampler _lights;		   ///< Lights and emissive triangles sampler.
+	MaterialSky _sky;			   ///< Precomputed atmosphere tables.
 	std::shared_ptr<Scene> _scene; ///< The scene.
 };
@@ -55,7 +55,7 @@ void PathTracerApp::draw() {
 		// Render.
 		_renderTex.images.emplace_back(_renderTex.width, _renderTex.height, 3);
 		Image & render = _renderTex.images.back();
-		_pathTracer->render(_userCamera, _samples, _depth, render);
+		_pathTracer->render(_userCamera, _samples, _depth, render, _wavefront ? PathTracer::Mode::WAVEFRONT : PathTracer::Mode::SCALAR, nullptr, _denoise ? &_denoiser : nullptr);
 		// Upload to the GPU.
 		_renderTex.upload({Layout::SRGB8, Filter::LINEAR, Wrap::CLAMP}, false);
 		_showRender = true;
@@ -112,6 +112,19 @@ void PathTracerApp::update() {
 			_renderTex.width  = uint(std::round(_config.screenResolution[0] / _config.screenResolution[1] * float(_renderTex.height)));
 		}
 		ImGui::PopItemWidth();
+		ImGui::Checkbox("Wavefront", &_wavefront);
+		ImGui::SameLine();
+		ImGui::Checkbox("Denoise", &_denoise);
+		if(_denoise) {
+			Denoiser::Settings & settings = _denoiser.settings();
+			ImGui::PushItemWidth(100);
+			ImGui::SliderInt("Passes", &settings.iterations, 1, 8);
+			ImGui::SliderFloat("Color", &settings.colorSigma, 0.1f, 16.0f);
+			ImGui::SliderFloat("Albedo", &settings.albedoSigma, 0.01f, 1.0f);
+			ImGui::SliderFloat("Normal", &settings.normalSigma, 0.01f, 1.0f);
+			ImGui::SliderFloat("Depth", &settings.depthSigma, 0.001f, 1.0f);
+			ImGui::PopItemWidth();
+		}
 
 		// Perform rendering.
 		if(ImGui::Button("Render")) {
@@ -119,7 +132,7 @@ void PathTracerApp::update() {
 			// Render.
 			_renderTex.images.emplace_back(_renderTex.width, _renderTex.height, 3);
 			Image & render = _renderTex.images.back();
-			_pathTracer->render(_userCamera, _samples, _depth, render);
+			_pathTracer->render(_userCamera, _samples, _depth, render, _wavefront ? PathTracer::Mode::WAVEFRONT : PathTracer::Mode::SCALAR, nullptr, _denoise ? &_denoiser : nullptr);
 			// Upload to the GPU.
 			_renderTex.upload({Layout::SRGB8, Filter::LINEAR, Wrap::CLAMP}, false);
 			_showRender = true;
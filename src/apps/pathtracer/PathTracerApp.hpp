@@ -48,11 +48,14 @@ private:
 
 	std::shared_ptr<Scene> _scene;				///< The scene to render.
 	std::unique_ptr<PathTracer> _pathTracer;	///< The scene specific path tracer.
+	Denoiser _denoiser;							///< Path tracer output denoiser.
 	std::unique_ptr<BVHRenderer> _bvhRenderer;	///< The scene debug viewer.
 	std::unique_ptr<Framebuffer> _sceneFramebuffer; ///< Scene buffer.
 
 	int _samples		 = 8;		///< Samples count.
 	int _depth			 = 5;		///< Depth of each ray.
+	bool _wavefront		 = false;	///< Process paths bounce after bounce in batches.
+	bool _denoise		 = false;	///< Denoise the result using first hit features.
 	bool _showRender	 = false;	///< Should the result be displayed.
 	bool _lockLevel		 = true;	///< Lock the range of the BVH visualisation.
 	bool _liveRender	 = false;	///< Display the result in real-time.
@@ -1,4 +1,5 @@
 #include "PathTracerApp.hpp"
+#include "MaterialSky.hpp"
 #include "scene/Scene.hpp"
 #include "resources/ResourcesManager.hpp"
 #include "generation/Random.hpp"
@@ -42,6 +43,12 @@ public:
 				size[1] = std::stoi(values[1]);
 			} else if(key == "render") {
 				directRender = true;
+			} else if(key == "wavefront") {
+				wavefront = true;
+			} else if(key == "denoise") {
+				denoise = true;
+			} else if(key == "benchmark-sky") {
+				benchmarkSky = true;
 			}
 		}
 
@@ -66,6 +73,9 @@ public:
 		registerArgument("scene", "", "Name of the scene to load.", "string");
 		registerArgument("output", "", "Path for the output image.", "path");
 		registerArgument("render", "", "Disable the GUI and run a render immediatly.");
+		registerArgument("wavefront", "", "Process paths bounce after bounce in batches.");
+		registerArgument("denoise", "", "Denoise the result using first hit features.");
+		registerArgument("benchmark-sky", "", "Compare the precomputed sky against the ray-marched model and exit.");
 	}
 
 	glm::ivec2 size		   = glm::ivec2(1024); ///< Image size.
@@ -74,6 +84,9 @@ public:
 	std::string outputPath = "";			   ///< Output image path.
 	std::string scene	  = "";			   	   ///< Scene name.
 	bool directRender	  = false;			   ///< Disable the GUI and run a render immediatly.
+	bool wavefront		  = false;			   ///< Process paths bounce after bounce in batches.
+	bool denoise		  = false;			   ///< Denoise the result using first hit features.
+	bool benchmarkSky	  = false;			   ///< Compare the precomputed sky against the ray-marched model.
 };
 
 /** Load a scene and performs a path tracer rendering using the settings in the configuration.
@@ -101,7 +114,8 @@ void renderOneShot(const PathTracerConfig & config) {
 	PathTracer tracer(scene);
 
 	Log::Info() << "[PathTracer] Rendering..." << std::endl;
-	tracer.render(camera, config.samples, config.depth, render);
+	const Denoiser denoiser;
+	tracer.render(camera, config.samples, config.depth, render, config.wavefront ? PathTracer::Mode::WAVEFRONT : PathTracer::Mode::SCALAR, nullptr, config.denoise ? &denoiser : nullptr);
 
 	// Save image.
 	Log::Info() << "[PathTracer] Saving to " << config.outputPath << "." << std::endl;
@@ -124,7 +138,7 @@ int main(int argc, char ** argv) {
 		return 0;
 	}
 
-	if(config.scene.empty()) {
+	if(config.scene.empty() && !config.benchmarkSky) {
 		Log::Error() << "Missing scene name." << std::endl;
 		return 1;
 	}
@@ -138,6 +152,11 @@ int main(int argc, char ** argv) {
 	if(!config.resourcesPath.empty()){
 		Resources::manager().addResources(config.resourcesPath);
 	}
+
+	if(config.benchmarkSky) {
+		MaterialSky::benchmark(100000);
+		return 0;
+	}
 	
 	// Headless mode: use the scene reference camera to perform rendering immediatly and saving it to disk.
 	if(config.directRender) {
@@ -3,6 +3,7 @@
 #include "scene/Sky.hpp"
 #include "system/System.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "graphics/Profiler.hpp"
 
 DeferredRenderer::DeferredRenderer(const glm::vec2 & resolution, ShadowMode mode, bool ssao) :
 	_applySSAO(ssao), _shadowMode(mode) {
@@ -47,7 +48,7 @@ void DeferredRenderer::setScene(const std::shared_ptr<Scene> & scene) {
 		return;
 	}
 	_scene = scene;
-	_culler.reset(new Culler(_scene->objects));
+	_culler.reset(new Culler(*_scene));
 	_fwdLightsGPU.reset(new ForwardLight(_scene->lights.size()));
 	checkGLError();
 }
@@ -116,7 +117,7 @@ void DeferredRenderer::renderOpaque(const Culler::List & visibles, const glm::ma
 
 		// Bind the textures.
 		GLUtilities::bindTextures(object.textures());
-		GLUtilities::drawMesh(*object.mesh());
+		GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 	}
 
 }
@@ -143,7 +144,7 @@ void DeferredRenderer::renderTransparent(const Culler::List & visibles, const gl
 	_transparentProgram->uniform("cubemapCenter", environment.center());
 	_transparentProgram->uniform("cubemapExtent", environment.extent());
 	_transparentProgram->uniform("cubemapCosSin", environment.rotationCosSin());
-	_transparentProgram->uniform("lightsCount", int(_fwdLightsGPU->count()));
+	_fwdLightsGPU->updateUniforms(*_transparentProgram);
 	_transparentProgram->uniform("invScreenSize", invScreenSize);
 
 	for(const long & objectId : visibles) {
@@ -170,7 +171,7 @@ void DeferredRenderer::renderTransparent(const Culler::List & visibles, const gl
 		_transparentProgram->uniform("normalMatrix", normalMatrix);
 
 		// Bind the lights.
-		GLUtilities::bindBuffer(_fwdLightsGPU->data(), 0);
+		_fwdLightsGPU->bind(9);
 		GLUtilities::bindBuffer(*_scene->environment.shCoeffs(), 1);
 		// Bind the textures.
 		GLUtilities::bindTextures(object.textures());
@@ -189,10 +190,10 @@ void DeferredRenderer::renderTransparent(const Culler::List & visibles, const gl
 		// This won't solve all issues in case of concavities.
 		if(object.twoSided()) {
 			GLUtilities::setCullState(true, Faces::FRONT);
-			GLUtilities::drawMesh(*object.mesh());
+			GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 			GLUtilities::setCullState(true, Faces::BACK);
 		}
-		GLUtilities::drawMesh(*object.mesh());
+		GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 	}
 }
 
@@ -253,21 +254,27 @@ void DeferredRenderer::draw(const Camera & camera, Framebuffer & framebuffer, si
 
 	// Request list of visible objects from culler.
 	const auto & visibles = _culler->cullAndSort(view, proj, pos);
+	_lods.setView(proj * view, float(_gbuffer->height()));
 
 	// Render opaque objects and the background to the Gbuffer.
+	Profiler::manager().begin("G-buffer");
 	_gbuffer->bind();
 	_gbuffer->setViewport();
 	renderOpaque(visibles, view, proj);
 	renderBackground(view, proj, pos);
+	Profiler::manager().end();
 
 	// SSAO pass
+	Profiler::manager().begin("SSAO");
 	if(_applySSAO) {
 		_ssaoPass->process(proj, _gbuffer->depthBuffer(), _gbuffer->texture(int(TextureType::Normal)));
 	} else {
 		_ssaoPass->clear();
 	}
+	Profiler::manager().end();
 
 	// Gbuffer lighting pass
+	Profiler::manager().begin("Lighting");
 	_lightRenderer->updateCameraInfos(view, proj);
 	_lightRenderer->updateShadowMapInfos(_shadowMode, 0.002f);
 	_lightBuffer->bind();
@@ -279,20 +286,23 @@ void DeferredRenderer::draw(const Camera & camera, Framebuffer & framebuffer, si
 	}
 	// Blit the depth.
 	GLUtilities::blitDepth(*_gbuffer, *_lightBuffer);
+	Profiler::manager().end();
 	
 	// If transparent objects are present, prepare the forward pass.
 	if(_scene->transparent()){
+		Profiler::manager().begin("Transparent");
 		// Update forward light data.
 		_fwdLightsGPU->updateCameraInfos(view, proj);
 		_fwdLightsGPU->updateShadowMapInfos(_shadowMode, 0.002f);
 		for(const auto & light : _scene->lights) {
 			light->draw(*_fwdLightsGPU);
 		}
-		_fwdLightsGPU->data().upload();
+		_fwdLightsGPU->upload();
 		// Now render transparent effects in a forward fashion.
 		_lightBuffer->bind();
 		_lightBuffer->setViewport();
 		renderTransparent(visibles, view, proj);
+		Profiler::manager().end();
 	}
 
 	// Copy to the final framebuffer.
@@ -319,6 +329,7 @@ void DeferredRenderer::interface(){
 		ImGui::Combo("Blur quality", reinterpret_cast<int*>(&_ssaoPass->quality()), "Low\0Medium\0High\0\0");
 		ImGui::InputFloat("Radius", &_ssaoPass->radius(), 0.5f);
 	}
+	_lods.interface("Levels of detail");
 	if(_culler){
 		_culler->interface();
 	}
@@ -9,6 +9,7 @@
 #include "scene/Scene.hpp"
 #include "renderers/Renderer.hpp"
 #include "renderers/Culler.hpp"
+#include "renderers/LodSelector.hpp"
 
 #include "graphics/Framebuffer.hpp"
 #include "input/ControllableCamera.hpp"
@@ -58,6 +59,9 @@ public:
 	/** \copydoc Renderer::interface */
 	void interface() override;
 
+	/** \return the levels of detail selection settings */
+	LodSelector & lods() { return _lods; }
+
 	/** \return the framebuffer containing the scene depth information */
 	const Framebuffer * sceneDepth() const;
 
@@ -107,6 +111,7 @@ private:
 
 	std::shared_ptr<Scene> _scene;	///< The scene to render
 	std::unique_ptr<Culler>	_culler;	///< Objects culler.
+	LodSelector _lods; ///< Levels of detail selection.
 
 	bool _applySSAO			 = true;  ///< Screen space ambient occlusion.
 	ShadowMode  _shadowMode	 = ShadowMode::VARIANCE;  ///< Shadow mapping technique to use.
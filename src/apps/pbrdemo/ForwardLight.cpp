@@ -1,17 +1,26 @@
 #include "ForwardLight.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "system/System.hpp"
 
-const size_t ForwardLight::_maxLightCount = 50;
+const glm::ivec3 ForwardLight::_clustersSize = glm::ivec3(16, 9, 24);
+const size_t ForwardLight::_maxLightsPerCluster = 256;
 
 ForwardLight::ForwardLight(size_t count) :
-	_lightsData(_maxLightCount, BufferType::UNIFORM, DataUse::DYNAMIC) {
+	_lightsData(std::max(count, size_t(1)), BufferType::TEXTURE, DataUse::DYNAMIC),
+	_clustersData(size_t(_clustersSize.x * _clustersSize.y * _clustersSize.z), BufferType::TEXTURE, DataUse::DYNAMIC) {
 	_currentCount = count;
-	if(_currentCount > _maxLightCount){
-		Log::Warning() << "Forward light renderer can only handle the first " << _maxLightCount << " lights (requested " << _currentCount << ")." << std::endl;
-	}
+	_lightsBounds.resize(_lightsData.size());
+
+	const size_t clustersCount = _clustersData.size();
+	_clustersLights.resize(clustersCount);
+	_clustersBoxes.resize(clustersCount);
+	// Initial indices buffer, will be reallocated if needed.
+	_indicesData.reset(new Buffer<uint>(clustersCount, BufferType::TEXTURE, DataUse::DYNAMIC));
 
 	// Initial buffers creation and allocation.
 	_lightsData.setup();
+	_clustersData.setup();
+	_indicesData->setup();
 	_shadowMaps.resize(2, nullptr);
 }
 
@@ -29,10 +38,6 @@ void ForwardLight::updateShadowMapInfos(ShadowMode mode, float bias) {
 void ForwardLight::draw(const SpotLight * light) {
 	const size_t selectedId = _currentId;
 	_currentId				= (_currentId + 1) % _currentCount;
-	// Skip update if extraneous light.
-	if(selectedId >= _maxLightCount) {
-		return;
-	}
 
 	GPULight & currentLight					= _lightsData[selectedId];
 	const glm::vec3 lightPositionViewSpace	= glm::vec3(_view * glm::vec4(light->position(), 1.0f));
@@ -50,6 +55,23 @@ void ForwardLight::draw(const SpotLight * light) {
 	currentLight.angles[0] = glm::cos(light->angles()[0]);
 	currentLight.angles[1] = glm::cos(light->angles()[1]);
 
+	// Bounding sphere of the cone.
+	LightBounds & bounds = _lightsBounds[selectedId];
+	const float radius = light->radius();
+	const float angle = light->angles()[1];
+	bounds.global = false;
+	if(angle >= 0.5f * glm::pi<float>()){
+		bounds.center = lightPositionViewSpace;
+		bounds.radius = radius;
+	} else if(angle > 0.25f * glm::pi<float>()){
+		bounds.center = lightPositionViewSpace + glm::cos(angle) * radius * glm::normalize(lightDirectionViewSpace);
+		bounds.radius = glm::sin(angle) * radius;
+	} else {
+		const float halfRadius = 0.5f * radius / glm::cos(angle);
+		bounds.center = lightPositionViewSpace + halfRadius * glm::normalize(lightDirectionViewSpace);
+		bounds.radius = halfRadius;
+	}
+
 	if(light->castsShadow()){
 		_shadowMaps[0] = light->shadowMap().map;
 	}
@@ -58,10 +80,6 @@ void ForwardLight::draw(const SpotLight * light) {
 void ForwardLight::draw(const PointLight * light) {
 	const size_t selectedId = _currentId;
 	_currentId				= (_currentId + 1) % _currentCount;
-	// Skip update if extraneous light.
-	if(selectedId >= _maxLightCount) {
-		return;
-	}
 
 	GPULight & currentLight				   = _lightsData[selectedId];
 	const glm::vec3 lightPositionViewSpace = glm::vec3(_view * glm::vec4(light->position(), 1.0f));
@@ -75,6 +93,11 @@ void ForwardLight::draw(const PointLight * light) {
 	currentLight.typeModeLayer[1] = float(light->castsShadow() ? _shadowMode : ShadowMode::NONE);
 	currentLight.typeModeLayer[2] = float(light->shadowMap().layer);
 
+	LightBounds & bounds = _lightsBounds[selectedId];
+	bounds.center = lightPositionViewSpace;
+	bounds.radius = light->radius();
+	bounds.global = false;
+
 	if(light->castsShadow()){
 		_shadowMaps[1] = light->shadowMap().map;
 	}
@@ -83,10 +106,6 @@ void ForwardLight::draw(const PointLight * light) {
 void ForwardLight::draw(const DirectionalLight * light) {
 	const size_t selectedId = _currentId;
 	_currentId				= (_currentId + 1) % _currentCount;
-	// Skip update if extraneous light.
-	if(selectedId >= _maxLightCount) {
-		return;
-	}
 
 	GPULight & currentLight					= _lightsData[selectedId];
 	const glm::vec3 lightDirectionViewSpace = glm::vec3(_view * glm::vec4(light->direction(), 0.0));
@@ -99,7 +118,181 @@ void ForwardLight::draw(const DirectionalLight * light) {
 	currentLight.typeModeLayer[1] = float(light->castsShadow() ? _shadowMode : ShadowMode::NONE);
 	currentLight.typeModeLayer[2] = float(light->shadowMap().layer);
 
+	// Directional lights affect all clusters.
+	_lightsBounds[selectedId].global = true;
+
 	if(light->castsShadow()){
 		_shadowMaps[0] = light->shadowMap().map;
 	}
 }
+
+void ForwardLight::upload() {
+	updateClusters();
+	assignLights();
+
+	if(_currentCount > 0){
+		_lightsData.upload();
+	}
+	_clustersData.upload();
+}
+
+void ForwardLight::bind(size_t firstSlot) const {
+	GLUtilities::bindBuffer(_lightsData, Layout::RGBA32F, firstSlot);
+	GLUtilities::bindBuffer(_clustersData, Layout::RG32UI, firstSlot + 1);
+	GLUtilities::bindBuffer(*_indicesData, Layout::R32UI, firstSlot + 2);
+}
+
+void ForwardLight::updateUniforms(const Program & program) const {
+	program.uniform("clustersSize", _clustersSize);
+	program.uniform("clustersParams", _clustersParams);
+}
+
+void ForwardLight::updateClusters() {
+	if(_proj == _clustersProj){
+		return;
+	}
+	_clustersProj = _proj;
+	// Retrieve the near and far planes, assuming a perspective projection.
+	_planes[0] = _proj[3][2] / (_proj[2][2] - 1.0f);
+	_planes[1] = _proj[3][2] / (_proj[2][2] + 1.0f);
+	// Slices have exponentially increasing depths: slice = log(depth) * scale - bias
+	const float logRatio = std::log(_planes[1] / _planes[0]);
+	_clustersParams[0] = float(_clustersSize.z) / logRatio;
+	_clustersParams[1] = float(_clustersSize.z) * std::log(_planes[0]) / logRatio;
+
+	// For a perspective projection, the view space point at depth d projected on (x,y) in NDC is
+	// ((x + p20) * d / p00, (y + p21) * d / p11, -d).
+	const glm::vec2 scale(1.0f / _proj[0][0], 1.0f / _proj[1][1]);
+	const glm::vec2 shift(_proj[2][0], _proj[2][1]);
+	const glm::vec2 tileSize = 2.0f / glm::vec2(_clustersSize);
+
+	for(int z = 0; z < _clustersSize.z; ++z){
+		const float depthNear = _planes[0] * std::pow(_planes[1] / _planes[0], float(z) / float(_clustersSize.z));
+		const float depthFar = _planes[0] * std::pow(_planes[1] / _planes[0], float(z + 1) / float(_clustersSize.z));
+		for(int y = 0; y < _clustersSize.y; ++y){
+			for(int x = 0; x < _clustersSize.x; ++x){
+				const glm::vec2 ndcMin = glm::vec2(x, y) * tileSize - 1.0f;
+				const glm::vec2 ndcMax = ndcMin + tileSize;
+				BoundingBox & box = _clustersBoxes[(z * _clustersSize.y + y) * _clustersSize.x + x];
+				box = BoundingBox();
+				for(const float depth : {depthNear, depthFar}){
+					for(const glm::vec2 & ndc : {ndcMin, ndcMax, glm::vec2(ndcMin.x, ndcMax.y), glm::vec2(ndcMax.x, ndcMin.y)}){
+						box.merge(glm::vec3((ndc + shift) * scale * depth, -depth));
+					}
+				}
+			}
+		}
+	}
+}
+
+void ForwardLight::assignLights() {
+	const size_t lightsCount = std::min(_currentCount, _lightsBounds.size());
+
+	// Compute the range of clusters overlapped by each light bounding sphere.
+	std::vector<glm::ivec3> minClusters(lightsCount, glm::ivec3(0));
+	std::vector<glm::ivec3> maxClusters(lightsCount, _clustersSize - 1);
+	for(size_t lid = 0; lid < lightsCount; ++lid){
+		const LightBounds & bounds = _lightsBounds[lid];
+		if(bounds.global){
+			continue;
+		}
+		const float depth = -bounds.center.z;
+		const float depthMin = depth - bounds.radius;
+		const float depthMax = depth + bounds.radius;
+		// Lights outside of the depth range are skipped.
+		if(depthMax < _planes[0] || depthMin > _planes[1]){
+			minClusters[lid] = glm::ivec3(0);
+			maxClusters[lid] = glm::ivec3(-1);
+			continue;
+		}
+		const float sliceMin = std::log(std::max(depthMin, _planes[0])) * _clustersParams[0] - _clustersParams[1];
+		const float sliceMax = std::log(depthMax) * _clustersParams[0] - _clustersParams[1];
+		minClusters[lid].z = glm::clamp(int(std::floor(sliceMin)), 0, _clustersSize.z - 1);
+		maxClusters[lid].z = glm::clamp(int(std::floor(sliceMax)), 0, _clustersSize.z - 1);
+		// If the sphere crosses the near plane, we can't bound its projection.
+		if(depthMin <= _planes[0]){
+			continue;
+		}
+		// Else project the corners of the sphere bounding box.
+		glm::vec2 ndcMin(std::numeric_limits<float>::max());
+		glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+		const BoundingBox box(bounds.center - bounds.radius, bounds.center + bounds.radius);
+		for(const glm::vec3 & corner : box.getCorners()){
+			const glm::vec4 clip = _proj * glm::vec4(corner, 1.0f);
+			const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+		const glm::vec2 tileMin = glm::floor((0.5f * ndcMin + 0.5f) * glm::vec2(_clustersSize));
+		const glm::vec2 tileMax = glm::floor((0.5f * ndcMax + 0.5f) * glm::vec2(_clustersSize));
+		minClusters[lid].x = glm::clamp(int(tileMin.x), 0, _clustersSize.x - 1);
+		minClusters[lid].y = glm::clamp(int(tileMin.y), 0, _clustersSize.y - 1);
+		maxClusters[lid].x = glm::clamp(int(tileMax.x), 0, _clustersSize.x - 1);
+		maxClusters[lid].y = glm::clamp(int(tileMax.y), 0, _clustersSize.y - 1);
+		// Lights outside of the screen are skipped.
+		if(tileMax.x < 0.0f || tileMax.y < 0.0f || tileMin.x >= float(_clustersSize.x) || tileMin.y >= float(_clustersSize.y)){
+			maxClusters[lid] = glm::ivec3(-1);
+		}
+	}
+
+	// Each depth slice is processed independently.
+	System::forParallel(0, size_t(_clustersSize.z), [this, lightsCount, &minClusters, &maxClusters](size_t slice){
+		const int z = int(slice);
+		const int firstCluster = z * _clustersSize.x * _clustersSize.y;
+		for(int cid = 0; cid < _clustersSize.x * _clustersSize.y; ++cid){
+			_clustersLights[firstCluster + cid].clear();
+		}
+		for(size_t lid = 0; lid < lightsCount; ++lid){
+			const glm::ivec3 & minCluster = minClusters[lid];
+			const glm::ivec3 & maxCluster = maxClusters[lid];
+			if(z < minCluster.z || z > maxCluster.z){
+				continue;
+			}
+			const LightBounds & bounds = _lightsBounds[lid];
+			const float radius2 = bounds.radius * bounds.radius;
+			for(int y = minCluster.y; y <= maxCluster.y; ++y){
+				for(int x = minCluster.x; x <= maxCluster.x; ++x){
+					const size_t cid = size_t(firstCluster + y * _clustersSize.x + x);
+					std::vector<uint> & lights = _clustersLights[cid];
+					if(lights.size() >= _maxLightsPerCluster){
+						continue;
+					}
+					// Sphere-box intersection test.
+					if(!bounds.global){
+						const BoundingBox & box = _clustersBoxes[cid];
+						const glm::vec3 delta = glm::clamp(bounds.center, box.minis, box.maxis) - bounds.center;
+						if(glm::dot(delta, delta) > radius2){
+							continue;
+						}
+					}
+					lights.push_back(uint(lid));
+				}
+			}
+		}
+	});
+
+	// Flatten the lists.
+	size_t totalCount = 0;
+	for(size_t cid = 0; cid < _clustersLights.size(); ++cid){
+		const size_t count = _clustersLights[cid].size();
+		_clustersData[cid] = glm::uvec2(uint(totalCount), uint(count));
+		totalCount += count;
+	}
+	// Reallocate the indices buffer if needed.
+	if(totalCount > _indicesData->size()){
+		size_t newSize = _indicesData->size();
+		while(newSize < totalCount){
+			newSize *= 2;
+		}
+		_indicesData.reset(new Buffer<uint>(newSize, BufferType::TEXTURE, DataUse::DYNAMIC));
+		_indicesData->setup();
+	}
+	auto & indices = _indicesData->data;
+	for(size_t cid = 0; cid < _clustersLights.size(); ++cid){
+		const std::vector<uint> & lights = _clustersLights[cid];
+		std::copy(lights.begin(), lights.end(), indices.begin() + _clustersData[cid][0]);
+	}
+	if(totalCount > 0){
+		_indicesData->upload(0, totalCount);
+	}
+}
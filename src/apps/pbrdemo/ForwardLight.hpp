@@ -9,12 +9,15 @@
 #include "scene/lights/DirectionalLight.hpp"
 #include "scene/lights/SpotLight.hpp"
 #include "resources/Buffer.hpp"
+#include "resources/Bounds.hpp"
+#include "graphics/Program.hpp"
 
 #include "Common.hpp"
 
 
 /**
  \brief Store lights data for forward rendering in a GPU buffer.
+ \details To bound the shading cost, the view frustum is subdivided in clusters (screen tiles subdivided along the depth axis, with exponentially increasing depth), and each cluster stores the list of lights that can affect it. Lights are assigned to clusters on the CPU each frame.
  \ingroup PBRDemo
  */
 class ForwardLight final : public LightRenderer {
@@ -63,6 +66,21 @@ public:
 	 */
 	void draw(const DirectionalLight * light) override;
 
+	/** Assign the lights to the view clusters, and upload lights and clusters data to the GPU.
+	 \note Should be called after all lights have been drawn.
+	 */
+	void upload();
+
+	/** Bind the lights and clusters data.
+	 \param firstSlot the texture slot of the lights data, clusters and lights indices will use the two following slots
+	 */
+	void bind(size_t firstSlot) const;
+
+	/** Set the uniforms needed by a program to locate the cluster of a fragment.
+	 \param program the program to update, should be in use
+	 */
+	void updateUniforms(const Program & program) const;
+
 	/** \return the current number of lights */
 	size_t count() const {
 		return _currentCount;
@@ -73,17 +91,35 @@ public:
 		return _shadowMaps;
 	}
 
-	/** \return the GPU lights buffer */
-	Buffer<GPULight> & data(){
-		return _lightsData;
-	}
-
 private:
 
+	/** \brief Light influence region in view space, used for cluster assignment. */
+	struct LightBounds {
+		glm::vec3 center = glm::vec3(0.0f); ///< Bounding sphere center.
+		float radius = 0.0f; ///< Bounding sphere radius.
+		bool global = false; ///< Does the light affect all clusters.
+	};
+
+	/** Update the view space bounding boxes of the clusters, if the projection matrix changed. */
+	void updateClusters();
+
+	/** Assign lights to the clusters they intersect, in parallel over the depth slices. */
+	void assignLights();
+
 	size_t _currentId = 0; ///< Current insertion location.
 	size_t _currentCount = 0; ///< Number of lights to store.
-	const static size_t _maxLightCount; ///< Maximum allowed number of lights (see forward_lights.glsl).
-	Buffer<GPULight> _lightsData; ///< GPU buffer.
+	Buffer<GPULight> _lightsData; ///< GPU lights buffer.
+	std::vector<LightBounds> _lightsBounds; ///< Lights influence regions.
+
+	const static glm::ivec3 _clustersSize; ///< Number of clusters along each axis.
+	const static size_t _maxLightsPerCluster; ///< Maximum number of lights per cluster.
+	Buffer<glm::uvec2> _clustersData; ///< For each cluster, the offset and count of its lights in the indices buffer.
+	std::unique_ptr<Buffer<uint>> _indicesData; ///< Light indices, grouped by cluster.
+	std::vector<std::vector<uint>> _clustersLights; ///< Light indices of each cluster.
+	std::vector<BoundingBox> _clustersBoxes; ///< View space bounding box of each cluster.
+	glm::mat4 _clustersProj = glm::mat4(0.0f); ///< Projection matrix used to compute the clusters bounding boxes.
+	glm::vec2 _clustersParams = glm::vec2(0.0f); ///< Scale and bias to compute a cluster slice from a view depth.
+	glm::vec2 _planes = glm::vec2(0.1f, 100.0f); ///< Near and far planes of the projection matrix.
 
 	glm::mat4 _view = glm::mat4(1.0f); ///< Cached camera view matrix.
 	glm::mat4 _proj = glm::mat4(1.0f); ///< Cached camera projection matrix.
@@ -3,6 +3,7 @@
 #include "scene/Sky.hpp"
 #include "system/System.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "graphics/Profiler.hpp"
 #include "graphics/ScreenQuad.hpp"
 
 ForwardRenderer::ForwardRenderer(const glm::vec2 & resolution, ShadowMode mode, bool ssao) :
@@ -41,7 +42,7 @@ void ForwardRenderer::setScene(const std::shared_ptr<Scene> & scene) {
 		return;
 	}
 	_scene = scene;
-	_culler.reset(new Culler(_scene->objects));
+	_culler.reset(new Culler(*_scene));
 	_lightsGPU.reset(new ForwardLight(_scene->lights.size()));
 	checkGLError();
 }
@@ -90,7 +91,7 @@ void ForwardRenderer::renderDepth(const Culler::List & visibles, const glm::mat4
 		}
 		// Backface culling state.
 		GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
-		GLUtilities::drawMesh(*object.mesh());
+		GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 	}
 }
 
@@ -129,7 +130,7 @@ void ForwardRenderer::renderOpaque(const Culler::List & visibles, const glm::mat
 			}
 			// Bind the textures.
 			GLUtilities::bindTextures(object.textures());
-			GLUtilities::drawMesh(*object.mesh());
+			GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 			GLUtilities::setCullState(true, Faces::BACK);
 			continue;
 		}
@@ -161,7 +162,7 @@ void ForwardRenderer::renderOpaque(const Culler::List & visibles, const glm::mat
 		// Backface culling state.
 		GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
 		// Bind the lights.
-		GLUtilities::bindBuffer(_lightsGPU->data(), 0);
+		_lightsGPU->bind(9);
 		GLUtilities::bindBuffer(*_scene->environment.shCoeffs(), 1);
 		// Bind the textures.
 		GLUtilities::bindTextures(object.textures());
@@ -175,7 +176,7 @@ void ForwardRenderer::renderOpaque(const Culler::List & visibles, const glm::mat
 			GLUtilities::bindTexture(shadowMaps[1], 7);
 		}
 		GLUtilities::bindTexture(_ssaoPass->texture(), 8);
-		GLUtilities::drawMesh(*object.mesh());
+		GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 	}
 
 }
@@ -213,7 +214,7 @@ void ForwardRenderer::renderTransparent(const Culler::List & visibles, const glm
 		_transparentProgram->uniform("normalMatrix", normalMatrix);
 
 		// Bind the lights.
-		GLUtilities::bindBuffer(_lightsGPU->data(), 0);
+		_lightsGPU->bind(9);
 		GLUtilities::bindBuffer(*_scene->environment.shCoeffs(), 1);
 		// Bind the textures.
 		GLUtilities::bindTextures(object.textures());
@@ -232,10 +233,10 @@ void ForwardRenderer::renderTransparent(const Culler::List & visibles, const glm
 		// This won't solve all issues in case of concavities.
 		if(object.twoSided()) {
 			GLUtilities::setCullState(true, Faces::FRONT);
-			GLUtilities::drawMesh(*object.mesh());
+			GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 			GLUtilities::setCullState(true, Faces::BACK);
 		}
-		GLUtilities::drawMesh(*object.mesh());
+		GLUtilities::drawMesh(*object.mesh(), _lods.select(*object.mesh(), object.model()));
 	}
 }
 
@@ -293,25 +294,32 @@ void ForwardRenderer::draw(const Camera & camera, Framebuffer & framebuffer, siz
 	const glm::mat4 & proj = camera.projection();
 	const glm::vec3 & pos  = camera.position();
 	// --- Update lights data ----
+	Profiler::manager().begin("Lights clustering");
 	_lightsGPU->updateCameraInfos(view, proj);
 	_lightsGPU->updateShadowMapInfos(_shadowMode, 0.002f);
 	for(const auto & light : _scene->lights) {
 		light->draw(*_lightsGPU);
 	}
-	_lightsGPU->data().upload();
+	_lightsGPU->upload();
+	Profiler::manager().end();
 
 	// Select visible objects.
 	const auto & visibles = _culler->cullAndSort(view, proj, pos);
+	_lods.setView(proj * view, float(_sceneFramebuffer->height()));
 
 	// Depth and normas prepass.
+	Profiler::manager().begin("Prepass");
 	renderDepth(visibles, view, proj);
+	Profiler::manager().end();
 
 	// SSAO pass
+	Profiler::manager().begin("SSAO");
 	if(_applySSAO) {
 		_ssaoPass->process(proj, _sceneFramebuffer->depthBuffer(), _sceneFramebuffer->texture());
 	} else {
 		_ssaoPass->clear();
 	}
+	Profiler::manager().end();
 
 	// Update all shaders shared parameters.
 	{
@@ -329,7 +337,7 @@ void ForwardRenderer::draw(const Camera & camera, Framebuffer & framebuffer, siz
 			prog->uniform("cubemapCenter", environment.center());
 			prog->uniform("cubemapExtent", environment.extent());
 			prog->uniform("cubemapCosSin", environment.rotationCosSin());
-			prog->uniform("lightsCount", int(_lightsGPU->count()));
+			_lightsGPU->updateUniforms(*prog);
 			prog->uniform("invScreenSize", invScreenSize);
 		}
 		_parallaxProgram->use();
@@ -340,11 +348,17 @@ void ForwardRenderer::draw(const Camera & camera, Framebuffer & framebuffer, siz
 	_sceneFramebuffer->bind();
 	_sceneFramebuffer->setViewport();
 	// Render opaque objects.
+	Profiler::manager().begin("Opaque");
 	renderOpaque(visibles, view, proj);
+	Profiler::manager().end();
 	// Render the backgound.
+	Profiler::manager().begin("Background");
 	renderBackground(view, proj, pos);
+	Profiler::manager().end();
 	// Render transparent objects.
+	Profiler::manager().begin("Transparent");
 	renderTransparent(visibles, view, proj);
+	Profiler::manager().end();
 
 	// Final composite pass
 	GLUtilities::blit(*_sceneFramebuffer, framebuffer, 0, layer, Filter::LINEAR);
@@ -366,6 +380,7 @@ void ForwardRenderer::interface(){
 		ImGui::Combo("Blur quality", reinterpret_cast<int*>(&_ssaoPass->quality()), "Low\0Medium\0High\0\0");
 		ImGui::InputFloat("Radius", &_ssaoPass->radius(), 0.5f);
 	}
+	_lods.interface("Levels of detail");
 	if(_culler){
 		_culler->interface();
 	}
@@ -7,6 +7,7 @@
 #include "scene/Scene.hpp"
 #include "renderers/Renderer.hpp"
 #include "renderers/Culler.hpp"
+#include "renderers/LodSelector.hpp"
 
 #include "graphics/Framebuffer.hpp"
 #include "input/ControllableCamera.hpp"
@@ -46,6 +47,9 @@ public:
 	/** \copydoc Renderer::interface */
 	void interface() override;
 
+	/** \return the levels of detail selection settings */
+	LodSelector & lods() { return _lods; }
+
 	/** \return the framebuffer containing the scene depth information */
 	const Framebuffer * sceneDepth() const;
 
@@ -101,6 +105,7 @@ private:
 
 	std::shared_ptr<Scene>  _scene;  ///< The scene to render
 	std::unique_ptr<Culler> _culler; ///<Objects culler.
+	LodSelector _lods; ///< Levels of detail selection.
 
 	bool _applySSAO			 = true;  ///< Screen space ambient occlusion.
 	ShadowMode  _shadowMode	 = ShadowMode::VARIANCE;  ///< Shadow mapping technique to use.
@@ -1,21 +1,47 @@
 #include "PBRDemo.hpp"
 #include "renderers/shadowmaps/VarianceShadowMapArray.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "graphics/Profiler.hpp"
+#include "graphics/AsyncReadback.hpp"
 #include "input/Input.hpp"
 
-PBRDemo::PBRDemo(RenderingConfig & config) :
-	CameraApp(config) {
+PBRDemoConfig::PBRDemoConfig(const std::vector<std::string> & argv) :
+	RenderingConfig(argv) {
+	for(const auto & arg : arguments()) {
+		const std::string key = arg.key;
+		const std::vector<std::string> & values = arg.values;
+		if(key == "scene" && !values.empty()) {
+			scene = values[0];
+		} else if(key == "shadow-cache" && !values.empty()) {
+			const std::string & mode = values[0];
+			if(mode == "none" || mode == "all" || mode == "split") {
+				cacheShadows = mode != "none";
+				splitShadows = mode == "split";
+			} else {
+				Log::Warning() << "Unknown shadow caching mode \"" << mode << "\", expected none, all or split." << std::endl;
+			}
+		}
+	}
+
+	registerSection("PBR demo");
+	registerArgument("scene", "", "Scene to load at startup.", "name");
+	registerArgument("shadow-cache", "", "Shadow maps caching: none, all (default) or split (static casters cached separately).", "mode");
+}
+
+PBRDemo::PBRDemo(PBRDemoConfig & config) :
+	CameraApp(config), _cacheShadows(config.cacheShadows), _splitShadows(config.splitShadows) {
 
 	const glm::vec2 renderRes = _config.renderingResolution();
 	_defRenderer.reset(new DeferredRenderer(renderRes, ShadowMode::VARIANCE, true));
 	_forRenderer.reset(new ForwardRenderer(renderRes, ShadowMode::VARIANCE, true));
-	_postprocess.reset(new PostProcessStack(renderRes));
+	_postprocess.reset(new PostProcessStack());
 	_debugRenderer.reset(new DebugRenderer());
 	_finalRender.reset(new Framebuffer(uint(renderRes[0]), uint(renderRes[1]), {Layout::RGB16F, Filter::LINEAR_LINEAR, Wrap::CLAMP}, true, "Final render"));
 
 	_finalProgram = Resources::manager().getProgram2D("sharpening");
 	
 	_probesRenderer.reset(new DeferredRenderer(glm::vec2(256,256), ShadowMode::BASIC, false));
+	_probesRenderer->lods().bias = _probesLodBias;
 
 	// Load all existing scenes, with associated names.
 	std::map<std::string, std::string> sceneInfos;
@@ -29,7 +55,12 @@ PBRDemo::PBRDemo(RenderingConfig & config) :
 		const auto & sceneName = _sceneNames[i];
 		_scenes.emplace_back(new Scene(sceneName));
 	}
-	// Load the first scene by default.
+	// Load the requested scene, if any.
+	for(size_t i = 1; i < _sceneNames.size(); ++i) {
+		if(_sceneNames[i] == config.scene) {
+			_currentScene = i;
+		}
+	}
 	setScene(_scenes[_currentScene]);
 }
 
@@ -40,7 +71,8 @@ void PBRDemo::setScene(const std::shared_ptr<Scene> & scene) {
 	}
 	freezeCamera(false);
 
-	scene->init(Storage::GPU);
+	// Keep positions on the CPU for occlusion culling, and generate levels of detail.
+	scene->init(Storage::GPU | Storage::POSITIONS | Storage::LODS | Storage::PACKED);
 
 	_userCamera.apply(scene->viewpoint());
 	_userCamera.ratio(_config.screenResolution[0] / _config.screenResolution[1]);
@@ -81,6 +113,10 @@ void PBRDemo::setScene(const std::shared_ptr<Scene> & scene) {
 	if(!lightsCube.empty()){
 		_shadowMaps.emplace_back(new VarianceShadowMapCubeArray(lightsCube, 512));
 	}
+	for(auto & map : _shadowMaps) {
+		map->setCaching(_cacheShadows, _splitShadows);
+		map->lods().bias = _shadowsLodBias;
+	}
 
 	// Recreate probes
 	// Delete existing probes.
@@ -105,21 +141,26 @@ void PBRDemo::setScene(const std::shared_ptr<Scene> & scene) {
 			probe->convolveRadiance(1.2f, 1, 5);
 			probe->prepareIrradiance();
 			probe->estimateIrradiance(5.0f);
-			GLUtilities::sync();
+			// Wait for the coefficients before the first frame.
+			AsyncReadback::manager().flush();
 		}
 	}
 }
 
 void PBRDemo::updateMaps(){
 	// Light shadows pass.
+	Profiler::manager().begin("Shadow maps");
 	_shadowTime.begin();
+	_shadowLayers = 0;
 	for(const auto & map : _shadowMaps) {
 		map->draw(*_scenes[_currentScene]);
+		_shadowLayers += map->updatedLayers();
 	}
 	_shadowTime.end();
+	Profiler::manager().end();
 
 	// Probes pass.
-
+	Profiler::manager().begin("Probes");
 	for(auto & probe : _probes) {
 		if(_frameID % _frameCount == 0){
 			_probesTime.begin();
@@ -145,7 +186,7 @@ void PBRDemo::updateMaps(){
 			_inteTime.end();
 		}
 	}
-
+	Profiler::manager().end();
 }
 
 void PBRDemo::draw() {
@@ -164,17 +205,21 @@ void PBRDemo::draw() {
 
 	// Renderer and postproc passes.
 	_rendererTime.begin();
+	Profiler::manager().begin("Renderer");
 	if(_mode == RendererMode::DEFERRED) {
 		_defRenderer->draw(_userCamera, *_finalRender);
 	} else if(_mode == RendererMode::FORWARD) {
 		_forRenderer->draw(_userCamera, *_finalRender);
 	}
+	Profiler::manager().end();
 	_rendererTime.end();
 
 	const Framebuffer * depthSrc = _mode == RendererMode::FORWARD ? _forRenderer->sceneDepth() : _defRenderer->sceneDepth();
 
 	_postprocessTime.begin();
+	Profiler::manager().begin("Postprocess");
 	_postprocess->process(_finalRender->texture(), _userCamera.projection(), depthSrc->depthBuffer(), *_finalRender);
+	Profiler::manager().end();
 	_postprocessTime.end();
 
 	if(_showDebug){
@@ -203,7 +248,7 @@ void PBRDemo::update() {
 	if(ImGui::Begin("Performance")){
 		ImGui::Text("%.1f ms, %.1f fps", frameTime() * 1000.0f, frameRate());
 		ImGui::Text("Total CPU time: %05.1fms", float(_totalTime.value())/1000000.0f);
-		ImGui::Text("Shadow maps update: %05.1fms", float(_shadowTime.value())/1000000.0f);
+		ImGui::Text("Shadow maps update: %05.1fms (%lu layers)", float(_shadowTime.value())/1000000.0f, (unsigned long)_shadowLayers);
 		ImGui::Text("Probes update: %05.1fms", float(_probesTime.value())/1000000.0f);
 		ImGui::Text("Probes integration: %05.1fms", float(_inteTime.value())/1000000.0f);
 		ImGui::Text("Probes copy: %05.1fms", float(_copyTime.value())/1000000.0f);
@@ -268,6 +313,9 @@ void PBRDemo::update() {
 			} else {
 				_forRenderer->interface();
 			}
+			if(ImGui::SliderFloat("LOD bias##probes", &_probesLodBias, 1.0f, 16.0f, "%.1f", 2.0f)){
+				_probesRenderer->lods().bias = _probesLodBias;
+			}
 		}
 
 		if(ImGui::CollapsingHeader("Postprocess")){
@@ -278,6 +326,24 @@ void PBRDemo::update() {
 			_userCamera.interface();
 		}
 
+		if(ImGui::CollapsingHeader("Shadows")){
+			bool updateCaching = ImGui::Checkbox("Cache shadow maps", &_cacheShadows);
+			if(_cacheShadows){
+				updateCaching = ImGui::Checkbox("Split static casters", &_splitShadows) || updateCaching;
+			}
+			if(updateCaching){
+				for(auto & map : _shadowMaps) {
+					map->setCaching(_cacheShadows, _splitShadows);
+				}
+			}
+			if(ImGui::SliderFloat("LOD bias##shadows", &_shadowsLodBias, 1.0f, 16.0f, "%.1f", 2.0f)){
+				for(auto & map : _shadowMaps) {
+					map->lods().bias = _shadowsLodBias;
+					map->invalidate();
+				}
+			}
+		}
+
 		ImGui::Checkbox("Pause animation", &_paused);
 		ImGui::PopItemWidth();
 		ImGui::ColorEdit3("Background", &(_scenes[_currentScene]->backgroundColor[0]), ImGuiColorEditFlags_Float);
@@ -12,9 +12,26 @@
 #include "renderers/shadowmaps/ShadowMap.hpp"
 #include "input/ControllableCamera.hpp"
 #include "system/Query.hpp"
+#include "system/Config.hpp"
 
 #include "Common.hpp"
 
+/** \brief PBR demo configuration, with initial scene and shadow settings for unattended runs.
+	\ingroup PBRDemo
+ */
+class PBRDemoConfig : public RenderingConfig {
+public:
+
+	/** Setup the demo configuration.
+	 \param argv the arguments
+	 */
+	explicit PBRDemoConfig(const std::vector<std::string> & argv);
+
+	std::string scene; ///< Name of the scene to load at startup (none by default).
+	bool cacheShadows = true; ///< Only re-render shadow maps affected by moving lights or casters.
+	bool splitShadows = false; ///< Cache static casters separately in shadow maps.
+};
+
 /**
  \brief PBR rendering demonstration and interactions.
  \ingroup PBRDemo
@@ -25,7 +42,7 @@ public:
 	/** Constructor.
 	 \param config the configuration to apply when setting up
 	 */
-	explicit PBRDemo(RenderingConfig & config);
+	explicit PBRDemo(PBRDemoConfig & config);
 
 	/** \copydoc CameraApp::draw */
 	void draw() override;
@@ -81,6 +98,11 @@ private:
 	const int _frameCount = 3;	 ///< Number of frames to count before looping.
 	int _frameID		= 0; 	 ///< Current frame count (will loop)
 
+	size_t _shadowLayers = 0;	 ///< Number of shadow map layers re-rendered at the last update.
+	bool _cacheShadows	= true;  ///< Only re-render shadow maps affected by moving lights or casters.
+	bool _splitShadows	= false; ///< Cache static casters separately in shadow maps.
+	float _shadowsLodBias = 2.0f; ///< Levels of detail bias for shadow casters.
+	float _probesLodBias = 4.0f; ///< Levels of detail bias for objects rendered in probes.
 	bool _paused		= false; ///< Pause animations.
 	bool _showDebug		= false; ///< Debug scene objects.
 };
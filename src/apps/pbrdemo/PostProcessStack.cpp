@@ -3,22 +3,12 @@
 #include "scene/Sky.hpp"
 #include "system/System.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "graphics/FramebufferPool.hpp"
+#include "graphics/Profiler.hpp"
 #include "graphics/ScreenQuad.hpp"
 
-PostProcessStack::PostProcessStack(const glm::vec2 & resolution){
-	const int renderWidth	= int(resolution[0]);
-	const int renderHeight	= int(resolution[1]);
+PostProcessStack::PostProcessStack(){
 	const Descriptor desc = {Layout::RGB16F, Filter::LINEAR_NEAREST, Wrap::CLAMP};
-	_bloomBuffer	= std::unique_ptr<Framebuffer>(new Framebuffer(renderWidth, renderHeight, desc, false, "Bloom"));
-	_toneMapBuffer 	= std::unique_ptr<Framebuffer>(new Framebuffer(renderWidth, renderHeight, desc, false, "Tonemap"));
-	_resultFramebuffer = std::unique_ptr<Framebuffer>(new Framebuffer(renderWidth, renderHeight, desc, false, "Postproc. result"));
-
-	// Depth of field is performed at half resolution.
-	const Descriptor dofCocDesc = {Layout::RG16F, Filter::NEAREST, Wrap::CLAMP};
-	const Descriptor dofGatherDesc = {Layout::RGBA16F, Filter::LINEAR_NEAREST, Wrap::CLAMP};
-	_dofCocBuffer 	= std::unique_ptr<Framebuffer>(new Framebuffer(renderWidth/2, renderHeight/2, {desc, dofCocDesc}, false, "DoF CoC"));
-	_dofGatherBuffer = std::unique_ptr<Framebuffer>(new Framebuffer(renderWidth/2, renderHeight/2, dofGatherDesc, false, "DoF gather"));
-
 	_blur		= std::unique_ptr<GaussianBlur>(new GaussianBlur(_settings.bloomRadius, 2));
 	_preferredFormat.push_back(desc);
 	_needsDepth = false;
@@ -41,11 +31,24 @@ void PostProcessStack::process(const Texture * texture, const glm::mat4 & proj,
 	GLUtilities::setBlendState(false);
 	GLUtilities::setCullState(true, Faces::BACK);
 
+	// Intermediate targets are only kept while needed, so that successive effects can share them.
+	FramebufferPool & pool = FramebufferPool::manager();
+	const uint width = texture->width;
+	const uint height = texture->height;
+	const Descriptor & desc = _preferredFormat[0];
+	Framebuffer * result = pool.acquire(width, height, desc, "Postproc. result");
+
 	if(_settings.dof){
 		// --- DoF pass ------
+		Profiler::manager().begin("Depth of field");
+		// Depth of field is performed at half resolution.
+		const Descriptor dofCocDesc = {Layout::RG16F, Filter::NEAREST, Wrap::CLAMP};
+		const Descriptor dofGatherDesc = {Layout::RGBA16F, Filter::LINEAR_NEAREST, Wrap::CLAMP};
+		Framebuffer * dofCocBuffer = pool.acquire(width/2, height/2, {desc, dofCocDesc}, "DoF CoC");
+		Framebuffer * dofGatherBuffer = pool.acquire(width/2, height/2, dofGatherDesc, "DoF gather");
 		// Compute circle of confidence along with the depth and downscaled color.
-		_dofCocBuffer->bind();
-		_dofCocBuffer->setViewport();
+		dofCocBuffer->bind();
+		dofCocBuffer->setViewport();
 		_dofCocProgram->use();
 		_dofCocProgram->uniform("projParams", glm::vec2(proj[2][2], proj[3][2]));
 		_dofCocProgram->uniform("focusDist", _settings.focusDist);
@@ -54,67 +57,79 @@ void PostProcessStack::process(const Texture * texture, const glm::mat4 & proj,
 		GLUtilities::bindTexture(depth, 1);
 		ScreenQuad::draw();
 		// Gather from neighbor samples.
-		_dofGatherBuffer->bind();
-		_dofGatherBuffer->setViewport();
+		dofGatherBuffer->bind();
+		dofGatherBuffer->setViewport();
 		_dofGatherProgram->use();
-		_dofGatherProgram->uniform("invSize", 1.0f/glm::vec2(_dofCocBuffer->width(), _dofCocBuffer->height()));
-		GLUtilities::bindTexture(_dofCocBuffer->texture(0), 0);
-		GLUtilities::bindTexture(_dofCocBuffer->texture(1), 1);
+		_dofGatherProgram->uniform("invSize", 1.0f/glm::vec2(dofCocBuffer->width(), dofCocBuffer->height()));
+		GLUtilities::bindTexture(dofCocBuffer->texture(0), 0);
+		GLUtilities::bindTexture(dofCocBuffer->texture(1), 1);
 		ScreenQuad::draw();
 		// Finally composite back with full res image.
-		_resultFramebuffer->bind();
-		_resultFramebuffer->setViewport();
+		result->bind();
+		result->setViewport();
 		_dofCompositeProgram->use();
 		GLUtilities::bindTexture(texture, 0);
-		GLUtilities::bindTexture(_dofGatherBuffer->texture(), 1);
+		GLUtilities::bindTexture(dofGatherBuffer->texture(), 1);
 		ScreenQuad::draw();
+		pool.release(dofCocBuffer);
+		pool.release(dofGatherBuffer);
+		Profiler::manager().end();
 	} else {
 		// Else just copy the input texture to our internal result.
-		_resultFramebuffer->bind();
-		_resultFramebuffer->setViewport();
+		result->bind();
+		result->setViewport();
 		Resources::manager().getProgram2D("passthrough-pixelperfect")->use();
 		ScreenQuad::draw(texture);
 	}
 
 	if(_settings.bloom) {
 		// --- Bloom selection pass ------
-		_bloomBuffer->bind();
-		_bloomBuffer->setViewport();
+		Profiler::manager().begin("Bloom");
+		Framebuffer * bloomBuffer = pool.acquire(width, height, desc, "Bloom");
+		bloomBuffer->bind();
+		bloomBuffer->setViewport();
 		_bloomProgram->use();
 		_bloomProgram->uniform("luminanceTh", _settings.bloomTh);
-		ScreenQuad::draw(_resultFramebuffer->texture());
+		ScreenQuad::draw(result->texture());
 		
 		// --- Bloom blur pass ------
-		_blur->process(_bloomBuffer->texture(), *_bloomBuffer);
+		_blur->process(bloomBuffer->texture(), *bloomBuffer);
 		
 		// Add back the scene content.
-		_resultFramebuffer->bind();
-		_resultFramebuffer->setViewport();
+		result->bind();
+		result->setViewport();
 		GLUtilities::setBlendState(true, BlendEquation::ADD, BlendFunction::ONE, BlendFunction::ONE);
 		_bloomComposite->use();
 		_bloomComposite->uniform("scale", _settings.bloomMix);
-		ScreenQuad::draw(_bloomBuffer->texture());
+		ScreenQuad::draw(bloomBuffer->texture());
 		GLUtilities::setBlendState(false);
+		pool.release(bloomBuffer);
+		Profiler::manager().end();
 		// Steps below ensures that we will always have an intermediate target.
 	}
 
 	// --- Tonemapping pass ------
-	_toneMapBuffer->bind();
-	_toneMapBuffer->setViewport();
+	Profiler::manager().begin("Tonemapping");
+	Framebuffer * toneMapBuffer = pool.acquire(width, height, desc, "Tonemap");
+	toneMapBuffer->bind();
+	toneMapBuffer->setViewport();
 	_toneMappingProgram->use();
 	_toneMappingProgram->uniform("customExposure", _settings.exposure);
 	_toneMappingProgram->uniform("apply", _settings.tonemap);
-	ScreenQuad::draw(_resultFramebuffer->texture());
+	ScreenQuad::draw(result->texture());
+	pool.release(result);
 
 	if(_settings.fxaa) {
 		framebuffer.bind(layer);
 		framebuffer.setViewport();
 		_fxaaProgram->use();
 		_fxaaProgram->uniform("inverseScreenSize", invRenderSize);
-		ScreenQuad::draw(_toneMapBuffer->texture());
+		ScreenQuad::draw(toneMapBuffer->texture());
 	} else {
-		GLUtilities::blit(*_toneMapBuffer, framebuffer, 0, layer, Filter::LINEAR);
+		GLUtilities::blit(*toneMapBuffer, framebuffer, 0, layer, Filter::LINEAR);
 	}
+	pool.release(toneMapBuffer);
+	Profiler::manager().end();
 
 }
 
@@ -122,14 +137,8 @@ void PostProcessStack::updateBlurPass(){
 	_blur.reset(new GaussianBlur(_settings.bloomRadius, 2));
 }
 
-void PostProcessStack::resize(unsigned int width, unsigned int height) {
-	const glm::ivec2 renderRes(width, height);
-	_toneMapBuffer->resize(renderRes);
-	_bloomBuffer->resize(renderRes);
-	_resultFramebuffer->resize(renderRes);
-	_dofGatherBuffer->resize(renderRes/4);
-	_dofCocBuffer->resize(renderRes/4);
-	checkGLError();
+void PostProcessStack::resize(unsigned int, unsigned int) {
+	// Intermediate targets are acquired at the input resolution when processing.
 }
 
 void PostProcessStack::interface(){
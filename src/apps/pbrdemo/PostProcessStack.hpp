@@ -16,6 +16,7 @@
 	- bloom (thresholding and blurring bright spots)
 	- tonemapping (basic Reinhardt operator)
 	- antialiasing (using FXXA)
+ Intermediate targets are acquired from the framebuffer pool at the input resolution, and released as soon as each effect is done.
  \ingroup PBRDemo
  */
 class PostProcessStack final : public Renderer {
@@ -35,10 +36,8 @@ public:
 		bool fxaa		= true;  ///< Apply screenspace anti-aliasing.
 	};
 	
-	/** Constructor.
-	 \param resolution the initial rendering resolution
-	 */
-	explicit PostProcessStack(const glm::vec2 & resolution);
+	/** Constructor. */
+	PostProcessStack();
 	
 	/** Apply post processing to the scene.
 	 You can assume that there will be at least one operation applied so the same texture can be used as input and output.
@@ -68,11 +67,6 @@ private:
 	/** Update the bloom pass depth based on the current set radius. */
 	void updateBlurPass();
 
-	std::unique_ptr<Framebuffer> _bloomBuffer; 	 ///< Bloom framebuffer
-	std::unique_ptr<Framebuffer> _toneMapBuffer; ///< Tonemapping framebuffer
-	std::unique_ptr<Framebuffer> _dofCocBuffer; 	 ///< DoF CoC framebuffer
-	std::unique_ptr<Framebuffer> _dofGatherBuffer; 	 ///< DoF gathering framebuffer
-	std::unique_ptr<Framebuffer> _resultFramebuffer; ///< In-progress result of the stack.
 	std::unique_ptr<GaussianBlur> _blur;	 ///< Bloom blur processing.
 	
 	const Program * _bloomProgram;			///< Bloom program
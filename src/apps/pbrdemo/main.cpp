@@ -24,7 +24,7 @@
 int main(int argc, char ** argv) {
 
 	// First, init/parse/load configuration.
-	RenderingConfig config(std::vector<std::string>(argv, argv + argc));
+	PBRDemoConfig config(std::vector<std::string>(argv, argv + argc));
 	if(config.showHelp()) {
 		return 0;
 	}
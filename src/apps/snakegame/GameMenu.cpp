@@ -23,12 +23,12 @@ MenuImage::MenuImage(const glm::vec2 & screenPos, float screenScale, const Textu
 }
 
 MenuLabel::MenuLabel(const glm::vec2 & screenPos, float verticalScale, const Font * font, Font::Alignment alignment) :
-	pos(screenPos), tid(font->atlas()), _vScale(verticalScale), _font(font), _align(alignment) {
-	update("0");
+	text("0"), pos(screenPos), vScale(verticalScale), font(font), align(alignment) {
 }
 
-void MenuLabel::update(const std::string & text) {
-	_font->generateLabel(text, _vScale, mesh, _align);
+void MenuLabel::update(const std::string & newText) {
+	// Geometry is generated at render time.
+	text = newText;
 }
 
 void GameMenu::update(const glm::vec2 & screenResolution, float initialRatio) {
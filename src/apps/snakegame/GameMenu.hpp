@@ -100,18 +100,15 @@ public:
 	MenuLabel(const glm::vec2 & screenPos, float verticalScale, const Font * font, Font::Alignment alignment);
 
 	/** Update the string displayed by the label.
-	 \param text the new text to display
+	 \param newText the new text to display
 	 */
-	void update(const std::string & text);
+	void update(const std::string & newText);
 
-	Mesh mesh = Mesh("");				   ///< Label mesh.
-	glm::vec2 pos		= glm::vec2(0.0f); ///< Label position.
-	const Texture * tid = nullptr;		   ///< Font texture shortcut.
-
-private:
-	float _vScale		   = 1.0f;					///< Vertical size on screen.
-	const Font * _font	 = nullptr;				///< Font atlas.
-	Font::Alignment _align = Font::Alignment::LEFT; ///< Text alignement.
+	std::string text;						///< Label text.
+	glm::vec2 pos		   = glm::vec2(0.0f); ///< Label position.
+	float vScale		   = 1.0f;			  ///< Vertical size on screen.
+	const Font * font	   = nullptr;		  ///< Font atlas.
+	Font::Alignment align = Font::Alignment::LEFT; ///< Text alignement.
 };
 
 /**
@@ -18,7 +18,7 @@ GameMenuRenderer::GameMenuRenderer() {
 	_quad			   = Resources::manager().getMesh("plane", Storage::GPU);
 }
 
-void GameMenuRenderer::drawMenu(const GameMenu & menu, const glm::vec2 & finalRes, float aspectRatio) const {
+void GameMenuRenderer::drawMenu(const GameMenu & menu, const glm::vec2 & finalRes, float aspectRatio) {
 
 	static const std::map<MenuButton::State, glm::vec4> borderColors = {
 		{MenuButton::State::OFF, glm::vec4(0.8f, 0.8f, 0.8f, 1.0f)},
@@ -30,9 +30,10 @@ void GameMenuRenderer::drawMenu(const GameMenu & menu, const glm::vec2 & finalRe
 		{MenuButton::State::HOVER, glm::vec4(1.0f, 1.0f, 1.0f, 0.5f)},
 		{MenuButton::State::ON, glm::vec4(0.95f, 0.95f, 0.95f, 0.5f)}};
 
-	static const glm::vec4 labelsColor	 = glm::vec4(0.3f, 0.0f, 0.0f, 1.0f);
-	static const glm::vec4 labelsEdgeColor = glm::vec4(1.0f);
-	static const float labelsEdgeWidth	 = 0.25f;
+	TextBatch::Style labelsStyle;
+	labelsStyle.color	  = glm::vec4(0.3f, 0.0f, 0.0f, 1.0f);
+	labelsStyle.edgeColor = glm::vec4(1.0f);
+	labelsStyle.edgeWidth = 0.25f;
 
 	// Make sure we are rendering directly in the window.
 	Framebuffer::backbuffer()->bind();
@@ -108,17 +109,14 @@ void GameMenuRenderer::drawMenu(const GameMenu & menu, const glm::vec2 & finalRe
 	}
 	GLUtilities::setDepthState(false);
 
-	// Labels
-	_fontProgram->use();
+	// Labels, all drawn at once.
+	_labels.clear();
 	for(const auto & label : menu.labels) {
-		GLUtilities::bindTexture(label.tid, 0);
-		_fontProgram->uniform("ratio", aspectRatio);
-		_fontProgram->uniform("position", label.pos);
-		_fontProgram->uniform("color", labelsColor);
-		_fontProgram->uniform("edgeColor", labelsEdgeColor);
-		_fontProgram->uniform("edgeWidth", labelsEdgeWidth);
-		GLUtilities::drawMesh(label.mesh);
+		_labels.add(*label.font, label.text, label.pos, label.vScale, label.align, labelsStyle);
 	}
+	_fontProgram->use();
+	_fontProgram->uniform("ratio", aspectRatio);
+	_labels.draw(*_fontProgram);
 	GLUtilities::setBlendState(false);
 	checkGLError();
 }
@@ -2,6 +2,8 @@
 
 #include "renderers/Renderer.hpp"
 #include "graphics/Program.hpp"
+#include "graphics/TextBatch.hpp"
+#include "resources/Mesh.hpp"
 #include "GameMenu.hpp"
 
 /**
@@ -19,7 +21,7 @@ public:
 	 \param finalRes the final viewport dimensions
 	 \param aspectRatio the target aspect ratio
 	 */
-	void drawMenu(const GameMenu & menu, const glm::vec2 & finalRes, float aspectRatio) const;
+	void drawMenu(const GameMenu & menu, const glm::vec2 & finalRes, float aspectRatio);
 
 	/** Return the absolute unit size of the button mesh.
 	 \return the dimensions of the button mesh
@@ -36,4 +38,5 @@ private:
 	const Mesh * _toggle;				///< Toggle main mesh (with border).
 	const Mesh * _toggleIn;				///< Toggle interior mesh.
 	const Mesh * _quad;					///< Quad mesh for images.
+	TextBatch _labels;					///< Labels glyphs.
 };
@@ -1,7 +1,7 @@
 #include "Application.hpp"
 #include "input/Input.hpp"
-#include "graphics/GLUtilities.hpp"
 #include "graphics/Framebuffer.hpp"
+#include "graphics/AsyncReadback.hpp"
 #include "resources/ResourcesManager.hpp"
 #include "system/System.hpp"
 
@@ -34,7 +34,7 @@ void Application::update() {
 	// Perform screenshot capture in the current working directory.
 	if(Input::manager().triggered(Input::Key::O) || (Input::manager().controllerAvailable() && Input::manager().controller()->triggered(Controller::ButtonView))) {
 		const std::string filename = System::timestamp();
-		GLUtilities::saveFramebuffer(*Framebuffer::backbuffer(), "./" + filename, true, true);
+		AsyncReadback::manager().saveFramebuffer(*Framebuffer::backbuffer(), "./" + filename, true, true);
 	}
 	// Reload resources.
 	if(Input::manager().triggered(Input::Key::P)) {
@@ -75,11 +75,19 @@ double Application::frameRate(){
 
 CameraApp::CameraApp(RenderingConfig & config) : Application(config) {
 	_userCamera.ratio(config.screenResolution[0] / config.screenResolution[1]);
+	if(config.benchmarkFrames > 0){
+		_benchmark.reset(new Benchmark(config));
+	}
 }
 
 void CameraApp::update(){
 	Application::update();
-	_userCamera.update();
+	// In benchmark mode, the camera follows a fixed path.
+	if(_benchmark){
+		_benchmark->update(_userCamera);
+	} else {
+		_userCamera.update();
+	}
 	
 	// We separate punctual events from the main physics/movement update loop.
 	// Physics simulation
@@ -90,7 +98,7 @@ void CameraApp::update(){
 	// Instead of bounding at dt, we lower our requirement (1 order of magnitude).
 	while(_remainingTime > 0.2 * _dt) {
 		const double deltaTime = std::min(_remainingTime, _dt);
-		if(!_freezeCamera){
+		if(!_freezeCamera && !_benchmark){
 			_userCamera.physics(deltaTime);
 		}
 		// Update physics.
@@ -2,6 +2,7 @@
 #include "system/Config.hpp"
 #include "input/ControllableCamera.hpp"
 #include "renderers/DebugViewer.hpp"
+#include "system/Benchmark.hpp"
 
 /**
  \brief Base structure of an application.
@@ -103,6 +104,8 @@ protected:
 	ControllableCamera _userCamera; ///< The interactive camera.
 
 private:
+
+	std::unique_ptr<Benchmark> _benchmark; ///< Camera path and measurements in benchmark mode.
 	
 	bool _freezeCamera    = false; 	///< Should the camera be frozen.
 	double _fullTime	  = 0.0; 	///< Time elapsed since the app launch.
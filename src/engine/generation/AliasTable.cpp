@@ -0,0 +1,55 @@
+#include "generation/AliasTable.hpp"
+
+AliasTable::AliasTable(const std::vector<float> & weights) {
+	const size_t count = weights.size();
+	_bins.resize(count);
+	if(count == 0) {
+		return;
+	}
+	_total = 0.0f;
+	for(const float weight : weights) {
+		_total += std::max(weight, 0.0f);
+	}
+	const bool uniform = _total <= 0.0f;
+	for(size_t i = 0; i < count; ++i) {
+		_bins[i].pdf = uniform ? (1.0f / float(count)) : (std::max(weights[i], 0.0f) / _total);
+	}
+
+	// Split events between under-full and over-full bins, with weights scaled so that the average is 1.
+	std::vector<double> scaled(count);
+	std::vector<size_t> small;
+	std::vector<size_t> large;
+	for(size_t i = 0; i < count; ++i) {
+		scaled[i] = double(_bins[i].pdf) * double(count);
+		(scaled[i] < 1.0 ? small : large).push_back(i);
+	}
+	// Fill each under-full bin with an over-full event.
+	while(!small.empty() && !large.empty()) {
+		const size_t s = small.back();
+		small.pop_back();
+		const size_t l = large.back();
+		_bins[s].threshold = float(scaled[s]);
+		_bins[s].alias = l;
+		scaled[l] -= (1.0 - scaled[s]);
+		if(scaled[l] < 1.0) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	// Remaining bins are full, up to numerical errors.
+	for(const size_t i : small) {
+		_bins[i].threshold = 1.0f;
+		_bins[i].alias = i;
+	}
+	for(const size_t i : large) {
+		_bins[i].threshold = 1.0f;
+		_bins[i].alias = i;
+	}
+}
+
+size_t AliasTable::sample(float u) const {
+	const float scaled = u * float(_bins.size());
+	const size_t id = std::min(size_t(scaled), _bins.size() - 1);
+	const float remainder = scaled - float(id);
+	return remainder < _bins[id].threshold ? id : _bins[id].alias;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Common.hpp"
+
+/**
+ \brief Sample discrete events in constant time, with probabilities proportional to given weights (Vose alias method).
+ \ingroup Generation
+ */
+class AliasTable {
+
+public:
+	/** Default constructor (empty table). */
+	AliasTable() = default;
+
+	/** Constructor.
+	 \param weights the non-negative weight of each event
+	 \note If all weights are null, events are sampled uniformly.
+	 */
+	explicit AliasTable(const std::vector<float> & weights);
+
+	/** Sample an event.
+	 \param u a uniform random number in [0,1)
+	 \return the index of the sampled event
+	 */
+	size_t sample(float u) const;
+
+	/** Query the probability of an event.
+	 \param id the event index
+	 \return the probability of sampling the event
+	 */
+	float pdf(size_t id) const { return _bins[id].pdf; }
+
+	/** \return the number of events */
+	size_t size() const { return _bins.size(); }
+
+	/** \return the sum of all events weights */
+	float total() const { return _total; }
+
+private:
+
+	/** \brief A table entry. */
+	struct Bin {
+		float threshold = 1.0f; ///< Probability of keeping the entry event instead of its alias.
+		size_t alias = 0; ///< The alternative event.
+		float pdf = 0.0f; ///< The probability of the entry event.
+	};
+
+	std::vector<Bin> _bins; ///< Table entries.
+	float _total = 0.0f; ///< Sum of all weights.
+};
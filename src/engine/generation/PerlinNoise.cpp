@@ -34,6 +34,17 @@ void PerlinNoise::generateLayers(Image & image, int octaves, float gain, float l
 	}
 }
 
+float PerlinNoise::sampleLayers(const glm::vec3 & p, int octaves, float gain, float lacunarity, float scale) const {
+	float value = 0.0f;
+	float weight = 1.0f;
+	for(int i = 0; i < octaves; ++i){
+		value += weight * perlin(scale * p);
+		scale *= lacunarity;
+		weight *= gain;
+	}
+	return value;
+}
+
 void PerlinNoise::reseed(){
 	// Generate a permutation of 0-255 indices.
 	std::vector<int> halfHashes(256);
@@ -56,13 +67,13 @@ void PerlinNoise::reseed(){
 	}
 }
 
-float PerlinNoise::dotGrad(const glm::ivec3 & ip, const glm::vec3 & dp){
+float PerlinNoise::dotGrad(const glm::ivec3 & ip, const glm::vec3 & dp) const {
 	const int id = _hashes[_hashes[_hashes[ip.x] + ip.y] + ip.z];
 	const glm::vec3 & grad = _directions.rgb(id/64, id%64);
 	return glm::dot(grad, dp);
 }
 
-float PerlinNoise::perlin(const glm::vec3 & p){
+float PerlinNoise::perlin(const glm::vec3 & p) const {
 	const glm::vec3 x = p;
 	glm::ivec3 ix = glm::ivec3(glm::floor(x));
 	const glm::vec3 dx = x - glm::vec3(ix);
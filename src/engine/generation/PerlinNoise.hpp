@@ -34,6 +34,18 @@ public:
 	*/
 	void generateLayers(Image & image, int octaves, float gain, float lacunarity, float scale, const glm::vec3 & offset = glm::vec3(0.0f));
 
+	/**
+	 Evaluate multi-layered Perlin noise (FBM) at a given location, consistently with generateLayers.
+	 \param p the location, in pixels
+	 \param octaves number of layers
+	 \param gain the amplitude ratio between a layer and the previous one
+	 \param lacunarity the frequency ratio between a layer and the previous one
+	 \param scale the base frequency, in pixels
+	 \return the noise value
+	 \note This can be called from multiple threads at once.
+	 */
+	float sampleLayers(const glm::vec3 & p, int octaves, float gain, float lacunarity, float scale) const;
+
 	/** Regenerate the randomness table with new values. */
 	void reseed();
 
@@ -44,13 +56,13 @@ private:
 	 \param dp the direction vector
 	 \return the dot product
 	 */
-	float dotGrad(const glm::ivec3 & ip, const glm::vec3 & dp);
+	float dotGrad(const glm::ivec3 & ip, const glm::vec3 & dp) const;
 
 	/** Evaluate Perlin noise for a given location in noise space.
 	 \param p location
 	 \return the noise value in [-1, 1]
 	 */
-	float perlin(const glm::vec3 & p);
+	float perlin(const glm::vec3 & p) const;
 
 	std::array<int, 512> _hashes; ///< Permutation table.
 	Image _directions; ///< random unit sphere directions.
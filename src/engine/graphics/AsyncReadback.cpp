@@ -0,0 +1,281 @@
+#include "graphics/AsyncReadback.hpp"
+#include "graphics/GLUtilities.hpp"
+#include "graphics/Framebuffer.hpp"
+#include "resources/Texture.hpp"
+
+#include <cstring>
+
+AsyncReadback & AsyncReadback::manager() {
+	static AsyncReadback readback;
+	return readback;
+}
+
+AsyncReadback::~AsyncReadback() {
+	// GPU buffers should have been released by clean(), only stop workers.
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wakeup.notify_all();
+	for(std::thread & worker : _workers) {
+		worker.join();
+	}
+}
+
+void AsyncReadback::download(const Texture & texture, uint level, const Callback & process, const Completion & complete) {
+	if(!texture.gpu) {
+		Log::Error() << Log::OpenGL << "Uninitialized GPU texture." << std::endl;
+		return;
+	}
+	if(texture.shape != TextureShape::D2 && texture.shape != TextureShape::Cube) {
+		Log::Error() << Log::OpenGL << "Unsupported download format." << std::endl;
+		return;
+	}
+	if(level >= texture.levels) {
+		Log::Error() << Log::OpenGL << "Invalid mip level." << std::endl;
+		return;
+	}
+	const GPUTexture & gpu = *texture.gpu;
+	const uint w = std::max<uint>(1, texture.width / (1 << level));
+	const uint h = std::max<uint>(1, texture.height / (1 << level));
+	const uint layers = texture.shape == TextureShape::Cube ? 6 : 1;
+
+	Request request;
+	request.process = process;
+	request.complete = complete;
+	for(uint lid = 0; lid < layers; ++lid) {
+		Region region;
+		region.width = w;
+		region.height = h;
+		region.channels = gpu.channels;
+		region.offset = size_t(lid) * w * h * gpu.channels * sizeof(float);
+		request.regions.push_back(region);
+	}
+	begin(request);
+
+	glBindTexture(gpu.target, gpu.id);
+	GLUtilities::_metrics.textureBindings += 1;
+	for(uint lid = 0; lid < layers; ++lid) {
+		const GLenum target = texture.shape == TextureShape::Cube ? GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + lid) : GL_TEXTURE_2D;
+		// With a pack buffer bound, the pointer is an offset in the buffer.
+		glGetTexImage(target, GLint(level), gpu.format, GL_FLOAT, reinterpret_cast<void *>(request.regions[lid].offset));
+		GLUtilities::_metrics.downloads += 1;
+	}
+	GLUtilities::restoreTexture(texture.shape);
+
+	end(request);
+}
+
+void AsyncReadback::download(const Framebuffer & framebuffer, const Callback & process, const Completion & complete) {
+	const GPUTexture & gpu = *framebuffer.texture()->gpu;
+	Request request;
+	request.process = process;
+	request.complete = complete;
+	// 8-bit targets are read as is, halving the transfer size, and converted by workers.
+	request.normalized = gpu.type == GL_UNSIGNED_BYTE;
+	Region region;
+	region.width = framebuffer.width();
+	region.height = framebuffer.height();
+	region.channels = gpu.channels;
+	request.regions.push_back(region);
+	begin(request);
+
+	framebuffer.bind(Framebuffer::Mode::READ);
+	glReadPixels(0, 0, GLsizei(region.width), GLsizei(region.height), gpu.format, request.normalized ? GL_UNSIGNED_BYTE : GL_FLOAT, nullptr);
+	GLUtilities::_metrics.downloads += 1;
+
+	end(request);
+}
+
+void AsyncReadback::saveFramebuffer(const Framebuffer & framebuffer, const std::string & path, bool flip, bool ignoreAlpha) {
+	const bool hdr = framebuffer.texture()->gpu->type == GL_FLOAT;
+	const std::string fullPath = path + (hdr ? ".exr" : ".png");
+	download(framebuffer, [fullPath, flip, ignoreAlpha](std::vector<Image> & images) {
+		if(images[0].save(fullPath, flip, ignoreAlpha) != 0) {
+			Log::Error() << Log::OpenGL << "Unable to save framebuffer to file " << fullPath << "." << std::endl;
+		} else {
+			Log::Info() << Log::OpenGL << "Saved framebuffer to file " << fullPath << "." << std::endl;
+		}
+	});
+}
+
+void AsyncReadback::begin(Request & request) {
+	const size_t component = request.normalized ? sizeof(GLubyte) : sizeof(float);
+	for(const Region & region : request.regions) {
+		request.size = std::max(request.size, region.offset + size_t(region.width) * region.height * region.channels * component);
+	}
+
+	// Reuse the smallest free buffer that is large enough.
+	size_t best = _buffers.size();
+	for(size_t bid = 0; bid < _buffers.size(); ++bid) {
+		if(_buffers[bid].second >= request.size && (best == _buffers.size() || _buffers[bid].second < _buffers[best].second)) {
+			best = bid;
+		}
+	}
+	if(best < _buffers.size()) {
+		request.buffer = _buffers[best].first;
+		request.size = _buffers[best].second;
+		_buffers.erase(_buffers.begin() + best);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, request.buffer);
+	} else {
+		glGenBuffers(1, &request.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, request.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(request.size), nullptr, GL_STREAM_READ);
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	GLUtilities::_metrics.stateChanges += 1;
+}
+
+void AsyncReadback::end(Request & request) {
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	GLUtilities::_metrics.stateChanges += 1;
+	request.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	// Make sure the fence will be reached even if no other command is submitted.
+	glFlush();
+	_requests.push_back(request);
+}
+
+void AsyncReadback::dispatch(Request & request) {
+	Job job;
+	job.regions = std::move(request.regions);
+	job.process = std::move(request.process);
+	job.complete = std::move(request.complete);
+	job.normalized = request.normalized;
+	job.data.resize(request.size);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, request.buffer);
+	const void * data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(request.size), GL_MAP_READ_BIT);
+	if(data) {
+		std::memcpy(job.data.data(), data, request.size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	} else {
+		Log::Error() << Log::OpenGL << "Unable to map readback buffer." << std::endl;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteSync(request.fence);
+	_buffers.emplace_back(request.buffer, request.size);
+
+	// Start workers on first use.
+	if(_workers.empty()) {
+		const size_t count = size_t(std::max(std::min(int(std::thread::hardware_concurrency()) - 1, 2), 1));
+		for(size_t wid = 0; wid < count; ++wid) {
+			_workers.emplace_back(&AsyncReadback::work, this);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::move(job));
+		++_processing;
+	}
+	_wakeup.notify_one();
+}
+
+void AsyncReadback::work() {
+	while(true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wakeup.wait(lock, [this] { return _stop || !_jobs.empty(); });
+			if(_jobs.empty()) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		// Convert to floating point images.
+		std::vector<Image> images;
+		images.reserve(job.regions.size());
+		for(const Region & region : job.regions) {
+			images.emplace_back(region.width, region.height, region.channels);
+			Image & image = images.back();
+			const size_t count = image.pixels.size();
+			if(job.normalized) {
+				const unsigned char * src = job.data.data() + region.offset;
+				for(size_t pid = 0; pid < count; ++pid) {
+					image.pixels[pid] = float(src[pid]) / 255.0f;
+				}
+			} else {
+				std::memcpy(image.pixels.data(), job.data.data() + region.offset, count * sizeof(float));
+			}
+		}
+		job.data.clear();
+		job.data.shrink_to_fit();
+
+		if(job.process) {
+			job.process(images);
+		}
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if(job.complete) {
+				_completions.push_back(job.complete);
+			}
+			--_processing;
+		}
+		_done.notify_all();
+	}
+}
+
+void AsyncReadback::update() {
+	// Dispatch requests whose copy is done, without waiting.
+	for(size_t rid = 0; rid < _requests.size();) {
+		const GLenum status = glClientWaitSync(_requests[rid].fence, 0, 0);
+		if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			dispatch(_requests[rid]);
+			_requests.erase(_requests.begin() + rid);
+		} else {
+			++rid;
+		}
+	}
+	complete();
+}
+
+void AsyncReadback::complete() {
+	std::vector<Completion> completions;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(completions, _completions);
+	}
+	for(const Completion & completion : completions) {
+		completion();
+	}
+}
+
+void AsyncReadback::flush() {
+	for(Request & request : _requests) {
+		// Wait for one second at most per iteration.
+		while(glClientWaitSync(request.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+		}
+		dispatch(request);
+	}
+	_requests.clear();
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [this] { return _processing == 0; });
+	}
+	complete();
+}
+
+size_t AsyncReadback::pending() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _requests.size() + _processing + _completions.size();
+}
+
+void AsyncReadback::clean() {
+	flush();
+	for(const auto & buffer : _buffers) {
+		glDeleteBuffers(1, &buffer.first);
+	}
+	_buffers.clear();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wakeup.notify_all();
+	for(std::thread & worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+	_stop = false;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include "resources/Image.hpp"
+#include "Common.hpp"
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+class Texture;
+class Framebuffer;
+
+/**
+ \brief Download GPU textures and framebuffers without stalling the pipeline, and process the result on worker threads.
+ \details Each request copies data into a pixel pack buffer and inserts a fence. Fences are polled once per frame. When a copy is complete, its data is mapped and handed to a worker thread. The worker converts it to images and runs the processing callback. An optional completion callback then runs on the rendering thread during the next poll, for instance to upload results to the GPU. Pack buffers are recycled between requests.
+ \ingroup Graphics
+ */
+class AsyncReadback {
+public:
+
+	/** Processing callback, executed on a worker thread.
+	 \param images the downloaded images: one per cubemap face, or a single one
+	 */
+	using Callback = std::function<void(std::vector<Image> & images)>;
+
+	/** Completion callback, executed on the rendering thread after processing. */
+	using Completion = std::function<void()>;
+
+	/** Request the download of a texture mip level.
+	 \param texture the 2D or cubemap texture to download
+	 \param level the mip level to download
+	 \param process the processing callback
+	 \param complete the optional completion callback
+	 */
+	void download(const Texture & texture, uint level, const Callback & process, const Completion & complete = nullptr);
+
+	/** Request the download of the first color attachment of a framebuffer (first layer, first mip level).
+	 \param framebuffer the framebuffer to read
+	 \param process the processing callback
+	 \param complete the optional completion callback
+	 */
+	void download(const Framebuffer & framebuffer, const Callback & process, const Completion & complete = nullptr);
+
+	/** Save the content of a framebuffer to disk once downloaded. Encoding happens on a worker thread.
+	 \param framebuffer the framebuffer to save
+	 \param path the output path, the extension will be added (.exr for float framebuffers, .png otherwise)
+	 \param flip should the image be vertically flipped
+	 \param ignoreAlpha should the alpha channel be ignored
+	 */
+	void saveFramebuffer(const Framebuffer & framebuffer, const std::string & path, bool flip = true, bool ignoreAlpha = false);
+
+	/** Dispatch completed downloads to workers, and run completion callbacks of processed requests.
+	 \note This is called by the window at the end of each frame.
+	 */
+	void update();
+
+	/** Wait for all pending requests to be downloaded, processed and completed. */
+	void flush();
+
+	/** \return the number of requests not completed yet */
+	size_t pending() const;
+
+	/** Complete all requests, stop workers and release GPU buffers. */
+	void clean();
+
+	/** \return the shared readback manager */
+	static AsyncReadback & manager();
+
+	/** Copy constructor.*/
+	AsyncReadback(const AsyncReadback &) = delete;
+
+	/** Copy assignment.
+	 \return a reference to the object assigned to
+	 */
+	AsyncReadback & operator=(const AsyncReadback &) = delete;
+
+	/** Move constructor.*/
+	AsyncReadback(AsyncReadback &&) = delete;
+
+	/** Move assignment.
+	 \return a reference to the object assigned to
+	 */
+	AsyncReadback & operator=(AsyncReadback &&) = delete;
+
+private:
+
+	/** Constructor. */
+	AsyncReadback() = default;
+
+	/** Destructor. */
+	~AsyncReadback();
+
+	/** \brief Image stored in a pack buffer. */
+	struct Region {
+		uint width = 0; ///< Image width.
+		uint height = 0; ///< Image height.
+		uint channels = 0; ///< Number of channels.
+		size_t offset = 0; ///< Position of the first pixel in the buffer, in bytes.
+	};
+
+	/** \brief A download waiting for the GPU. */
+	struct Request {
+		std::vector<Region> regions; ///< Images to extract.
+		Callback process; ///< Processing callback.
+		Completion complete; ///< Completion callback.
+		GLuint buffer = 0; ///< Pack buffer.
+		size_t size = 0; ///< Buffer size in bytes.
+		GLsync fence = nullptr; ///< Signaled when the copy is done.
+		bool normalized = false; ///< Is the data stored as 8-bit normalized values instead of floats.
+	};
+
+	/** \brief A downloaded request waiting for a worker. */
+	struct Job {
+		std::vector<unsigned char> data; ///< Downloaded data.
+		std::vector<Region> regions; ///< Images to extract.
+		Callback process; ///< Processing callback.
+		Completion complete; ///< Completion callback.
+		bool normalized = false; ///< Is the data stored as 8-bit normalized values instead of floats.
+	};
+
+	/** Prepare a request, binding a pack buffer large enough for all its regions.
+	 \param request the request, with its regions set
+	 */
+	void begin(Request & request);
+
+	/** Insert the fence of a request and queue it.
+	 \param request the request
+	 */
+	void end(Request & request);
+
+	/** Map the data of a completed request and send it to workers.
+	 \param request the request
+	 */
+	void dispatch(Request & request);
+
+	/** Run completion callbacks of processed jobs. */
+	void complete();
+
+	/** Process jobs until the manager is cleaned. */
+	void work();
+
+	std::vector<Request> _requests; ///< Requests waiting for the GPU.
+	std::vector<std::pair<GLuint, size_t>> _buffers; ///< Free pack buffers and their sizes.
+	std::vector<std::thread> _workers; ///< Worker threads.
+	std::deque<Job> _jobs; ///< Jobs waiting for a worker.
+	std::vector<Completion> _completions; ///< Completion callbacks of processed jobs.
+	mutable std::mutex _mutex; ///< Protects jobs, completions and the counters.
+	std::condition_variable _wakeup; ///< Signals new jobs or stop requests to workers.
+	std::condition_variable _done; ///< Signals processed jobs.
+	size_t _processing = 0; ///< Number of jobs queued or being processed.
+	bool _stop = false; ///< Should workers stop.
+};
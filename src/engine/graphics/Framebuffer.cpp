@@ -114,6 +114,7 @@ Framebuffer::Framebuffer(TextureShape shape, uint width, uint height, uint depth
 	GLUtilities::bindFramebuffer(*Framebuffer::backbuffer(), Mode::WRITE);
 	GLUtilities::bindFramebuffer(*Framebuffer::backbuffer(), Mode::READ);
 
+	updateMemory();
 	DebugViewer::trackDefault(this);
 }
 
@@ -184,6 +185,7 @@ void Framebuffer::resize(uint width, uint height) {
 		idColor.height = _height;
 		GLUtilities::allocateTexture(idColor);
 	}
+	updateMemory();
 }
 
 void Framebuffer::resize(const glm::ivec2 & size) {
@@ -222,8 +224,25 @@ uint Framebuffer::attachments() const {
 	return uint(_idColors.size());
 }
 
+void Framebuffer::updateMemory() {
+	_allocatedMemory -= _memory;
+	_memory = 0;
+	for(const Texture & idColor : _idColors) {
+		_memory += idColor.gpuMemory();
+	}
+	if(_depthUse == Depth::TEXTURE) {
+		_memory += _idDepth.gpuMemory();
+	} else if(_depthUse == Depth::RENDERBUFFER) {
+		// Renderbuffers are always 32-bit float depth.
+		_memory += size_t(_width) * size_t(_height) * sizeof(GLfloat);
+	}
+	_allocatedMemory += _memory;
+	_peakMemory = std::max(_peakMemory, _allocatedMemory);
+}
+
 Framebuffer::~Framebuffer() {
 	DebugViewer::untrackDefault(this);
+	_allocatedMemory -= _memory;
 
 	if(_depthUse == Depth::RENDERBUFFER) {
 		glDeleteRenderbuffers(1, &_idDepth.gpu->id);
@@ -240,6 +259,8 @@ Framebuffer::~Framebuffer() {
 }
 
 Framebuffer * Framebuffer::_backbuffer = nullptr;
+size_t Framebuffer::_allocatedMemory = 0;
+size_t Framebuffer::_peakMemory = 0;
 
 const Framebuffer * Framebuffer::backbuffer() {
 	// Initialize a dummy framebuffer representing the backbuffer.
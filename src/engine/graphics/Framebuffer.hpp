@@ -167,6 +167,24 @@ public:
 	 */
 	uint attachments() const;
 
+	/**
+	 Query the GPU memory used by the framebuffer attachments.
+	 \return the size in bytes
+	 */
+	size_t memory() const { return _memory; }
+
+	/**
+	 Query the GPU memory currently used by all framebuffers.
+	 \return the size in bytes
+	 */
+	static size_t allocatedMemory() { return _allocatedMemory; }
+
+	/**
+	 Query the maximum GPU memory used by all framebuffers since the start of the application.
+	 \return the size in bytes
+	 */
+	static size_t peakMemory() { return _peakMemory; }
+
 	/**
 	 Query the window backbuffer infos.
 	 \return a reference to a placeholder representing the backbuffer
@@ -205,6 +223,9 @@ private:
 	/** Default constructor. */
 	Framebuffer() = default;
 
+	/** Update the GPU memory used by the attachments, and the global counters. */
+	void updateMemory();
+
 	std::string _name; ///< Framebuffer debug name.
 	unsigned int _width  = 0; ///< The framebuffer width.
 	unsigned int _height = 0; ///< The framebuffer height.
@@ -224,8 +245,11 @@ private:
 		TEXTURE
 	};
 	Depth _depthUse = Depth::NONE; ///< The type of depth backing the framebuffer.
+	size_t _memory = 0; ///< GPU memory used by the attachments, in bytes.
 
 	static Framebuffer * _backbuffer; ///< Dummy backbuffer framebuffer.
+	static size_t _allocatedMemory; ///< GPU memory used by all framebuffers, in bytes.
+	static size_t _peakMemory; ///< Maximum GPU memory used by all framebuffers, in bytes.
 	
 	friend class GLUtilities; ///< Utilities will need to access GPU handle.
 	
@@ -0,0 +1,68 @@
+#include "graphics/FramebufferPool.hpp"
+
+FramebufferPool & FramebufferPool::manager() {
+	static FramebufferPool pool;
+	return pool;
+}
+
+Framebuffer * FramebufferPool::acquire(uint width, uint height, const Descriptor & descriptor, const std::string & name) {
+	return acquire(width, height, std::vector<Descriptor>(1, descriptor), name);
+}
+
+Framebuffer * FramebufferPool::acquire(uint width, uint height, const std::vector<Descriptor> & descriptors, const std::string & name) {
+	// Avoid empty targets, for instance when downscaling small resolutions.
+	width = std::max(width, 1u);
+	height = std::max(height, 1u);
+	for(Entry & entry : _entries) {
+		const Framebuffer & framebuffer = *entry.framebuffer;
+		if(entry.used || framebuffer.width() != width || framebuffer.height() != height || framebuffer.attachments() != descriptors.size()) {
+			continue;
+		}
+		bool match = true;
+		for(uint cid = 0; cid < descriptors.size() && match; ++cid) {
+			match = framebuffer.descriptor(cid) == descriptors[cid];
+		}
+		if(match) {
+			entry.used = true;
+			entry.lastFrame = _frame;
+			return entry.framebuffer.get();
+		}
+	}
+	// No compatible framebuffer available, create a new one.
+	_entries.emplace_back();
+	Entry & entry = _entries.back();
+	entry.framebuffer.reset(new Framebuffer(width, height, descriptors, false, name));
+	entry.used = true;
+	entry.lastFrame = _frame;
+	return entry.framebuffer.get();
+}
+
+void FramebufferPool::release(const Framebuffer * framebuffer) {
+	for(Entry & entry : _entries) {
+		if(entry.framebuffer.get() == framebuffer) {
+			entry.used = false;
+			return;
+		}
+	}
+	Log::Warning() << Log::OpenGL << "Framebuffer \"" << (framebuffer ? framebuffer->name() : "") << "\" does not belong to the pool." << std::endl;
+}
+
+void FramebufferPool::update() {
+	auto end = std::remove_if(_entries.begin(), _entries.end(), [this](const Entry & entry) {
+		return !entry.used && _frame - entry.lastFrame > _maxUnusedFrames;
+	});
+	_entries.erase(end, _entries.end());
+	++_frame;
+}
+
+void FramebufferPool::clean() {
+	_entries.clear();
+}
+
+size_t FramebufferPool::memory() const {
+	size_t total = 0;
+	for(const Entry & entry : _entries) {
+		total += entry.framebuffer->memory();
+	}
+	return total;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "graphics/Framebuffer.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Provide transient intermediate framebuffers to processing passes, sharing them between passes that do not run at the same time.
+ \details A pass acquires its intermediate targets when it starts and releases them once it is done, declaring their lifetime. Targets are identified by their size and color attachments descriptors: a released target is handed to the next pass requesting the same configuration, instead of each pass keeping its own resident copy. Targets that have not been used for a few frames are deleted, for instance after a resize.
+ \warning The content of a target is undefined when it is acquired.
+ \ingroup Graphics
+ */
+class FramebufferPool {
+public:
+
+	/** Acquire a 2D framebuffer with a single color attachment and no depth buffer.
+	 \param width the framebuffer width
+	 \param height the framebuffer height
+	 \param descriptor the color attachment descriptor
+	 \param name the debug name used if a new framebuffer has to be created
+	 \return the framebuffer, reserved until released
+	 */
+	Framebuffer * acquire(uint width, uint height, const Descriptor & descriptor, const std::string & name);
+
+	/** Acquire a 2D framebuffer with no depth buffer.
+	 \param width the framebuffer width
+	 \param height the framebuffer height
+	 \param descriptors the color attachments descriptors
+	 \param name the debug name used if a new framebuffer has to be created
+	 \return the framebuffer, reserved until released
+	 */
+	Framebuffer * acquire(uint width, uint height, const std::vector<Descriptor> & descriptors, const std::string & name);
+
+	/** Release a framebuffer, making it available to other passes.
+	 \param framebuffer the framebuffer to release
+	 */
+	void release(const Framebuffer * framebuffer);
+
+	/** Delete framebuffers that have not been used for a few frames.
+	 \note This is called by the window at the end of each frame.
+	 */
+	void update();
+
+	/** Delete all framebuffers. */
+	void clean();
+
+	/** \return the number of framebuffers in the pool */
+	size_t count() const { return _entries.size(); }
+
+	/** \return the GPU memory used by the framebuffers in the pool, in bytes */
+	size_t memory() const;
+
+	/** \return the shared framebuffer pool */
+	static FramebufferPool & manager();
+
+	/** Copy constructor.*/
+	FramebufferPool(const FramebufferPool &) = delete;
+
+	/** Copy assignment.
+	 \return a reference to the object assigned to
+	 */
+	FramebufferPool & operator=(const FramebufferPool &) = delete;
+
+	/** Move constructor.*/
+	FramebufferPool(FramebufferPool &&) = delete;
+
+	/** Move assignment.
+	 \return a reference to the object assigned to
+	 */
+	FramebufferPool & operator=(FramebufferPool &&) = delete;
+
+private:
+
+	/** Constructor. */
+	FramebufferPool() = default;
+
+	/** Destructor. */
+	~FramebufferPool() = default;
+
+	/** \brief A pooled framebuffer. */
+	struct Entry {
+		std::unique_ptr<Framebuffer> framebuffer; ///< The framebuffer.
+		size_t lastFrame = 0; ///< Last frame the framebuffer was acquired.
+		bool used = false; ///< Is the framebuffer currently acquired.
+	};
+
+	std::vector<Entry> _entries; ///< Pooled framebuffers.
+	size_t _frame = 0; ///< Current frame.
+	const size_t _maxUnusedFrames = 30; ///< Number of frames after which an unused framebuffer is deleted.
+};
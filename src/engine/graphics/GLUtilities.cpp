@@ -2,9 +2,13 @@
 #include "graphics/Framebuffer.hpp"
 #include "resources/Texture.hpp"
 #include "resources/Image.hpp"
+#include "resources/ResourcesManager.hpp"
 #include "system/TextUtilities.hpp"
+#include "system/System.hpp"
 
+#include <GLFW/glfw3.h>
 #include <sstream>
+#include <cstring>
 
 /** Converts a GLenum error number into a human-readable string.
  \param error the OpenGl error value
@@ -63,6 +67,22 @@ void GLUtilities::setup() {
 	glBindVertexArray(_vao);
 	glBindVertexArray(0);
 	_state.vertexArray = 0;
+
+	// Let the driver compile shaders on as many threads as it wants, if supported.
+	const std::vector<std::string> extensions = deviceExtensions();
+	for(const std::string & ext : extensions) {
+		if(ext != "GL_KHR_parallel_shader_compile" && ext != "GL_ARB_parallel_shader_compile") {
+			continue;
+		}
+		const bool isKHR = ext == "GL_KHR_parallel_shader_compile";
+		// Query through GLFW, as gl3w can only resolve functions for native contexts.
+		const auto setMaxThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress(isKHR ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+		if(setMaxThreads) {
+			setMaxThreads(0xFFFFFFFF);
+			Log::Verbose() << Log::OpenGL << "Parallel shader compilation enabled." << std::endl;
+			break;
+		}
+	}
 }
 
 int GLUtilities::checkError(const char * file, int line, const std::string & infos) {
@@ -120,7 +140,7 @@ int GLUtilities::checkFramebufferStatus() {
 	return 0;
 }
 
-GLuint GLUtilities::loadShader(const std::string & prog, ShaderType type, Bindings & bindings, std::string & finalLog) {
+std::string GLUtilities::preprocessShader(const std::string & prog, Bindings & bindings) {
 	// We need to detect texture slots and store them, to avoid having to register them in
 	// the rest of the code (object, renderer), while not having support for 'layout(binding=n)' in OpenGL <4.2.
 	std::stringstream inputLines(prog);
@@ -222,7 +242,10 @@ GLuint GLUtilities::loadShader(const std::string & prog, ShaderType type, Bindin
 	for(const auto & outputLine : outputLines) {
 		outputProg.append(outputLine + "\n");
 	}
+	return outputProg;
+}
 
+GLuint GLUtilities::compileShader(const std::string & source, ShaderType type) {
 	// Create shader object.
 	static const std::map<ShaderType, GLenum> types = {
 		{ShaderType::VERTEX, GL_VERTEX_SHADER},
@@ -235,140 +258,226 @@ GLuint GLUtilities::loadShader(const std::string & prog, ShaderType type, Bindin
 	GLuint id = glCreateShader(types.at(type));
 	checkGLError();
 	// Setup string as source.
-	const char * shaderProg = outputProg.c_str();
+	const char * shaderProg = source.c_str();
 	glShaderSource(id, 1, &shaderProg, static_cast<const GLint *>(nullptr));
-	// Compile the shader on the GPU.
+	// Request compilation, the result will be queried later.
 	glCompileShader(id);
 	checkGLError();
+	return id;
+}
 
+std::string GLUtilities::shaderLog(GLuint id) {
 	GLint success;
 	glGetShaderiv(id, GL_COMPILE_STATUS, &success);
-	finalLog = "";
 	// If compilation failed, get information and display it.
-	if(success != GL_TRUE) {
-		// Get the log string length for allocation.
-		GLint infoLogLength;
-		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &infoLogLength);
-		// Get the log string.
-		std::vector<char> infoLog(size_t(std::max(infoLogLength, int(1))));
-		glGetShaderInfoLog(id, infoLogLength, nullptr, &infoLog[0]);
-		// Indent and clean.
-		std::string infoLogString(infoLog.data(), infoLogLength);
+	if(success == GL_TRUE) {
+		return "";
+	}
+	// Get the log string length for allocation.
+	GLint infoLogLength;
+	glGetShaderiv(id, GL_INFO_LOG_LENGTH, &infoLogLength);
+	// Get the log string.
+	std::vector<char> infoLog(size_t(std::max(infoLogLength, int(1))));
+	glGetShaderInfoLog(id, infoLogLength, nullptr, &infoLog[0]);
+	// Indent and clean.
+	std::string infoLogString(infoLog.data(), infoLogLength);
+
+	TextUtilities::replace(infoLogString, "\n", "\n\t");
+	infoLogString.insert(0, "\t");
+	return infoLogString;
+}
 
-		TextUtilities::replace(infoLogString, "\n", "\n\t");
-		infoLogString.insert(0, "\t");
-		finalLog = infoLogString;
-	}
+GLuint GLUtilities::loadShader(const std::string & prog, ShaderType type, Bindings & bindings, std::string & finalLog) {
+	const GLuint id = compileShader(preprocessShader(prog, bindings), type);
+	finalLog = shaderLog(id);
 	// Return the id to the successfuly compiled shader program.
 	return id;
 }
 
-GLuint GLUtilities::createProgram(const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent, const std::string & tessControlContent, const std::string & tessEvalContent, Bindings & bindings, const std::string & debugInfos) {
-	GLuint vp(0), fp(0), gp(0), tcp(0), tep(0);
-	const GLuint id = glCreateProgram();
-	checkGLError();
+/** Hash a string using 64-bits FNV-1a.
+ \param str the string to hash
+ \param hash the initial hash value
+ \return the updated hash
+ */
+static uint64_t hashString(const std::string & str, uint64_t hash = 0xcbf29ce484222325ull) {
+	for(const char c : str) {
+		hash ^= uint64_t(static_cast<unsigned char>(c));
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
 
-	Log::Verbose() << Log::OpenGL << "Compiling " << debugInfos << "." << std::endl;
+void GLUtilities::startProgram(const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent, const std::string & tessControlContent, const std::string & tessEvalContent, Bindings & bindings, const std::string & debugInfos, ProgramBuild & build) {
+	build		 = ProgramBuild();
+	build.name	 = debugInfos;
+	build.id	 = glCreateProgram();
+	checkGLError();
 
-	std::string compilationLog;
-	// If vertex program code is given, compile it.
-	if(!vertexContent.empty()) {
-		vp = loadShader(vertexContent, ShaderType::VERTEX, bindings, compilationLog);
-		glAttachShader(id, vp);
-		if(!compilationLog.empty()) {
-			Log::Error() << Log::OpenGL << "Vertex shader failed to compile:" << std::endl
-						 << compilationLog << std::endl;
+	// Preprocess all stages, bindings are extracted even when the program is cached.
+	const std::array<std::pair<ShaderType, const std::string *>, 5> stages = {{
+		{ShaderType::VERTEX, &vertexContent},
+		{ShaderType::FRAGMENT, &fragmentContent},
+		{ShaderType::GEOMETRY, &geometryContent},
+		{ShaderType::TESSCONTROL, &tessControlContent},
+		{ShaderType::TESSEVAL, &tessEvalContent}
+	}};
+	std::array<std::string, 5> sources;
+	uint64_t hash = hashString(_programCacheDevice);
+	for(size_t sid = 0; sid < stages.size(); ++sid) {
+		if(stages[sid].second->empty()) {
+			continue;
 		}
-	}
-	// If fragment program code is given, compile it.
-	if(!fragmentContent.empty()) {
-		fp = loadShader(fragmentContent, ShaderType::FRAGMENT, bindings, compilationLog);
-		glAttachShader(id, fp);
-		if(!compilationLog.empty()) {
-			Log::Error() << Log::OpenGL << "Fragment shader failed to compile:" << std::endl
-						 << compilationLog << std::endl;
+		sources[sid] = preprocessShader(*stages[sid].second, bindings);
+		// Separate stages so that moving code from one to the other changes the key.
+		hash = hashString(sources[sid], hashString(std::to_string(sid), hash));
+	}
+
+	// Try to load the program from the cache.
+	if(!_programCache.empty()) {
+		std::stringstream key;
+		key << std::hex << hash;
+		build.cacheKey = key.str();
+		const std::string path = _programCache + "/" + build.cacheKey + ".bin";
+		if(Resources::externalFileExists(path)) {
+			size_t size = 0;
+			char * data = Resources::loadRawDataFromExternalFile(path, size);
+			if(data != nullptr && size > sizeof(GLenum)) {
+				GLenum format = 0;
+				std::memcpy(&format, data, sizeof(GLenum));
+				glProgramBinary(build.id, format, data + sizeof(GLenum), GLsizei(size - sizeof(GLenum)));
+				// Ignore errors, the driver might have been updated.
+				glGetError();
+				GLint success = GL_FALSE;
+				glGetProgramiv(build.id, GL_LINK_STATUS, &success);
+				build.cached = success == GL_TRUE;
+			}
+			delete[] data;
+			if(build.cached) {
+				Log::Verbose() << Log::OpenGL << "Loaded " << debugInfos << " from cache." << std::endl;
+				++_cachedPrograms;
+				return;
+			}
+			Log::Verbose() << Log::OpenGL << "Outdated cache entry for " << debugInfos << "." << std::endl;
 		}
+		glProgramParameteri(build.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
-	// If geometry program code is given, compile it.
-	if(!geometryContent.empty()) {
-		gp = loadShader(geometryContent, ShaderType::GEOMETRY, bindings, compilationLog);
-		glAttachShader(id, gp);
-		if(!compilationLog.empty()) {
-			Log::Error() << Log::OpenGL << "Geometry shader failed to compile:" << std::endl
-						 << compilationLog << std::endl;
+
+	Log::Verbose() << Log::OpenGL << "Compiling " << debugInfos << "." << std::endl;
+	for(size_t sid = 0; sid < stages.size(); ++sid) {
+		if(sources[sid].empty()) {
+			continue;
 		}
+		const GLuint shader = compileShader(sources[sid], stages[sid].first);
+		glAttachShader(build.id, shader);
+		build.shaders.emplace_back(stages[sid].first, shader);
 	}
-	// If tesselation control program code is given, compile it.
-	if(!tessControlContent.empty()) {
-		tcp = loadShader(tessControlContent, ShaderType::TESSCONTROL, bindings, compilationLog);
-		glAttachShader(id, tcp);
-		if(!compilationLog.empty()) {
-			Log::Error() << Log::OpenGL << "Tessellation control shader failed to compile:" << std::endl
-						 << compilationLog << std::endl;
-		}
+	// Link everything, without waiting for the result.
+	glLinkProgram(build.id);
+	checkGLError();
+	++_compiledPrograms;
+}
+
+GLuint GLUtilities::finishProgram(ProgramBuild & build) {
+	if(build.cached) {
+		return build.id;
 	}
-	// If tessellation evaluation program code is given, compile it.
-	if(!tessEvalContent.empty()) {
-		tep = loadShader(tessEvalContent, ShaderType::TESSEVAL, bindings, compilationLog);
-		glAttachShader(id, tep);
+	static const std::map<ShaderType, std::string> names = {
+		{ShaderType::VERTEX, "Vertex"},
+		{ShaderType::FRAGMENT, "Fragment"},
+		{ShaderType::GEOMETRY, "Geometry"},
+		{ShaderType::TESSCONTROL, "Tessellation control"},
+		{ShaderType::TESSEVAL, "Tessellation evaluation"}
+	};
+	for(const auto & shader : build.shaders) {
+		const std::string compilationLog = shaderLog(shader.second);
 		if(!compilationLog.empty()) {
-			Log::Error() << Log::OpenGL << "Tessellation evaluation shader failed to compile:" << std::endl
+			Log::Error() << Log::OpenGL << names.at(shader.first) << " shader failed to compile:" << std::endl
 						 << compilationLog << std::endl;
 		}
 	}
 
-	// Link everything
-	glLinkProgram(id);
-	checkGLError();
 	//Check linking status.
 	GLint success = GL_FALSE;
-	glGetProgramiv(id, GL_LINK_STATUS, &success);
+	glGetProgramiv(build.id, GL_LINK_STATUS, &success);
+
+	// We can now clean the shaders objects, by first detaching them and then deleting them.
+	for(const auto & shader : build.shaders) {
+		glDetachShader(build.id, shader.second);
+		glDeleteShader(shader.second);
+	}
+	build.shaders.clear();
+	checkGLError();
 
 	// If linking failed, query info and display it.
 	if(!success) {
 		// Get the log string length for allocation.
 		GLint infoLogLength;
-		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &infoLogLength);
+		glGetProgramiv(build.id, GL_INFO_LOG_LENGTH, &infoLogLength);
 		// Get the log string.
 		std::vector<char> infoLog(size_t(std::max(infoLogLength, int(1))));
-		glGetProgramInfoLog(id, infoLogLength, nullptr, &infoLog[0]);
+		glGetProgramInfoLog(build.id, infoLogLength, nullptr, &infoLog[0]);
 		// Indent and clean.
 		std::string infoLogString(infoLog.data(), infoLogLength);
 		TextUtilities::replace(infoLogString, "\n", "\n\t");
 		infoLogString.insert(0, "\t");
 		// Output.
 		Log::Error() << Log::OpenGL
-					 << "Failed linking program " << debugInfos << ": " << std::endl
+					 << "Failed linking program " << build.name << ": " << std::endl
 					 << infoLogString << std::endl;
+		glDeleteProgram(build.id);
+		build.id = 0;
 		return 0;
 	}
-	// We can now clean the shaders objects, by first detaching them
-	if(vp != 0) {
-		glDetachShader(id, vp);
-	}
-	if(fp != 0) {
-		glDetachShader(id, fp);
-	}
-	if(gp != 0) {
-		glDetachShader(id, gp);
+
+	// Store the program binary for the next runs.
+	if(!build.cacheKey.empty()) {
+		GLint length = 0;
+		glGetProgramiv(build.id, GL_PROGRAM_BINARY_LENGTH, &length);
+		if(length > 0) {
+			std::vector<char> data(sizeof(GLenum) + size_t(length));
+			GLenum format = 0;
+			GLsizei written = 0;
+			glGetProgramBinary(build.id, length, &written, &format, data.data() + sizeof(GLenum));
+			if(glGetError() == GL_NO_ERROR && written > 0) {
+				std::memcpy(data.data(), &format, sizeof(GLenum));
+				Resources::saveRawDataToExternalFile(_programCache + "/" + build.cacheKey + ".bin", data.data(), sizeof(GLenum) + size_t(written));
+			}
+		}
 	}
-	if(tcp != 0) {
-		glDetachShader(id, tcp);
+	// Return the id to the successfuly linked GLProgram.
+	return build.id;
+}
+
+GLuint GLUtilities::createProgram(const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent, const std::string & tessControlContent, const std::string & tessEvalContent, Bindings & bindings, const std::string & debugInfos) {
+	ProgramBuild build;
+	startProgram(vertexContent, fragmentContent, geometryContent, tessControlContent, tessEvalContent, bindings, debugInfos, build);
+	return finishProgram(build);
+}
+
+void GLUtilities::setupProgramCache(const std::string & directory) {
+	_programCache.clear();
+	if(directory.empty()) {
+		return;
 	}
-	if(tep != 0) {
-		glDetachShader(id, tep);
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if(formatCount <= 0) {
+		Log::Info() << Log::OpenGL << "Program binaries are not supported by the driver, the program cache is disabled." << std::endl;
+		return;
 	}
-	checkGLError();
-	//And deleting them
-	glDeleteShader(vp);
-	glDeleteShader(fp);
-	glDeleteShader(gp);
-	glDeleteShader(tcp);
-	glDeleteShader(tep);
+	// Ensure the directory exists.
+	System::createDirectory(directory);
+	_programCache = directory;
+	// Binaries are only valid for a given driver.
+	std::string vendor, renderer, version, shaderVersion;
+	deviceInfos(vendor, renderer, version, shaderVersion);
+	_programCacheDevice = vendor + "|" + renderer + "|" + version + "|" + shaderVersion;
+	Log::Info() << Log::OpenGL << "Program cache stored in \"" << directory << "\"." << std::endl;
+}
 
-	checkGLError();
-	// Return the id to the successfuly linked GLProgram.
-	return id;
+void GLUtilities::programStatistics(size_t & compiled, size_t & cached) {
+	compiled = _compiledPrograms;
+	cached	 = _cachedPrograms;
 }
 
 void GLUtilities::bindProgram(const Program & program){
@@ -412,7 +521,36 @@ void GLUtilities::saveFramebuffer(const Framebuffer & framebuffer, const std::st
 	_metrics.framebufferBindings += 2;
 }
 
+/** Ensure that a texture has GPU data, restoring it if it was evicted by the resources manager, and record its use.
+ \param texture the texture to check
+ \param frame the current frame index
+ \return true if the texture can be bound
+ */
+static bool makeResident(const Texture & texture, size_t frame) {
+	if(!texture.gpu && !Resources::manager().restore(texture)) {
+		return false;
+	}
+	texture.gpu->lastUse = frame;
+	return true;
+}
+
+/** Ensure that a mesh has GPU data, restoring it if it was evicted by the resources manager, and record its use.
+ \param mesh the mesh to check
+ \param frame the current frame index
+ \return true if the mesh can be drawn
+ */
+static bool makeResident(const Mesh & mesh, size_t frame) {
+	if(!mesh.gpu && !Resources::manager().restore(mesh)) {
+		return false;
+	}
+	mesh.gpu->lastUse = frame;
+	return true;
+}
+
 void GLUtilities::bindTexture(const Texture * texture, size_t slot) {
+	if(!makeResident(*texture, _frameIndex)) {
+		return;
+	}
 	auto & currId = _state.textures[slot][texture->gpu->target];
 	if(currId != texture->gpu->id){
 		currId = texture->gpu->id;
@@ -424,6 +562,9 @@ void GLUtilities::bindTexture(const Texture * texture, size_t slot) {
 }
 
 void GLUtilities::bindTexture(const Texture & texture, size_t slot) {
+	if(!makeResident(texture, _frameIndex)) {
+		return;
+	}
 	auto & currId = _state.textures[slot][texture.gpu->target];
 	if(currId != texture.gpu->id){
 		currId = texture.gpu->id;
@@ -437,6 +578,9 @@ void GLUtilities::bindTexture(const Texture & texture, size_t slot) {
 void GLUtilities::bindTextures(const std::vector<const Texture *> & textures, size_t startingSlot) {
 	for(size_t i = 0; i < textures.size(); ++i) {
 		const Texture * infos = textures[i];
+		if(!makeResident(*infos, _frameIndex)) {
+			continue;
+		}
 		const int slot = startingSlot + i;
 		auto & currId = _state.textures[slot][infos->gpu->target];
 
@@ -624,6 +768,52 @@ void GLUtilities::uploadTexture(const Texture & texture) {
 	_metrics.stateChanges += 1;
 }
 
+void GLUtilities::uploadTextureRegion(const Texture & texture, const Image & image, uint layer, uint level, uint x, uint y) {
+	if(!texture.gpu) {
+		Log::Error() << Log::OpenGL << "Uninitialized GPU texture." << std::endl;
+		return;
+	}
+	const GLenum target		= texture.gpu->target;
+	const GLenum destFormat = texture.gpu->format;
+	if(texture.gpu->channels != image.components) {
+		Log::Error() << Log::OpenGL << "Not enough values in source data for texture upload." << std::endl;
+		return;
+	}
+	// Data is always uploaded as floats.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	_metrics.stateChanges += 1;
+	glBindTexture(target, texture.gpu->id);
+	_metrics.textureBindings += 1;
+
+	const GLubyte * finalDataPtr = reinterpret_cast<const GLubyte *>(image.pixels.data());
+	const GLint mip = GLint(level);
+	const GLint lev = GLint(layer);
+	const GLint ox	= GLint(x);
+	const GLint oy	= GLint(y);
+	const GLsizei w = GLsizei(image.width);
+	const GLsizei h = GLsizei(image.height);
+	if(target == GL_TEXTURE_1D) {
+		glTexSubImage1D(target, mip, ox, w, destFormat, GL_FLOAT, finalDataPtr);
+
+	} else if(target == GL_TEXTURE_2D) {
+		glTexSubImage2D(target, mip, ox, oy, w, h, destFormat, GL_FLOAT, finalDataPtr);
+
+	} else if(target == GL_TEXTURE_CUBE_MAP) {
+		glTexSubImage2D(GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + lev), mip, ox, oy, w, h, destFormat, GL_FLOAT, finalDataPtr);
+
+	} else if(target == GL_TEXTURE_2D_ARRAY || target == GL_TEXTURE_CUBE_MAP_ARRAY || target == GL_TEXTURE_3D) {
+		glTexSubImage3D(target, mip, ox, oy, lev, w, h, 1, destFormat, GL_FLOAT, finalDataPtr);
+
+	} else if(target == GL_TEXTURE_1D_ARRAY) {
+		glTexSubImage2D(target, mip, ox, lev, w, 1, destFormat, GL_FLOAT, finalDataPtr);
+
+	} else {
+		Log::Error() << Log::OpenGL << "Unsupported texture upload destination." << std::endl;
+	}
+	_metrics.uploads += 1;
+	GLUtilities::restoreTexture(texture.shape);
+}
+
 void GLUtilities::downloadTexture(Texture & texture) {
 	downloadTexture(texture, -1);
 }
@@ -714,6 +904,31 @@ void GLUtilities::bindBuffer(const BufferBase & buffer, size_t slot) {
 	_metrics.uniforms += 1;
 }
 
+void GLUtilities::bindBuffer(const BufferBase & buffer, Layout format, size_t slot) {
+	if(!buffer.gpu || buffer.gpu->target != GL_TEXTURE_BUFFER) {
+		Log::Error() << Log::OpenGL << "Buffer can't be bound as a texture." << std::endl;
+		return;
+	}
+	GPUBuffer & gpu = *buffer.gpu;
+	GLenum typedFormat, type, texFormat;
+	Descriptor(format, Filter::NEAREST, Wrap::CLAMP).getGPULayout(typedFormat, type, texFormat);
+
+	auto & currId = _state.textures[slot][GL_TEXTURE_BUFFER];
+	const bool newFormat = gpu.textureFormat != typedFormat;
+	if(currId != gpu.textureId || newFormat){
+		currId = gpu.textureId;
+		_state.activeTexture = GLenum(GL_TEXTURE0 + slot);
+		glActiveTexture(_state.activeTexture);
+		glBindTexture(GL_TEXTURE_BUFFER, gpu.textureId);
+		_metrics.textureBindings += 1;
+		// Attach the buffer storage to the texture with the requested format.
+		if(newFormat){
+			glTexBuffer(GL_TEXTURE_BUFFER, typedFormat, gpu.id);
+			gpu.textureFormat = typedFormat;
+		}
+	}
+}
+
 void GLUtilities::setupBuffer(BufferBase & buffer) {
 	if(buffer.gpu) {
 		buffer.gpu->clean();
@@ -723,6 +938,12 @@ void GLUtilities::setupBuffer(BufferBase & buffer) {
 	GLuint bufferId;
 	glGenBuffers(1, &bufferId);
 	buffer.gpu->id = bufferId;
+	// Texture buffers are read through a texture.
+	if(buffer.type == BufferType::TEXTURE){
+		GLuint textureId;
+		glGenTextures(1, &textureId);
+		buffer.gpu->textureId = textureId;
+	}
 	// Allocate.
 	GLUtilities::allocateBuffer(buffer);
 }
@@ -780,7 +1001,37 @@ void GLUtilities::downloadBuffer(const BufferBase & buffer, size_t size, unsigne
 	_metrics.bufferBindings += 2;
 }
 
-void GLUtilities::setupMesh(Mesh & mesh) {
+/** Encode a unit vector with an octahedral mapping (see A Survey of Efficient Representations for Independent Unit Vectors, Cigolle et al., JCGT 2014).
+ \param v the vector to encode
+ \return the 2D encoding, in [-1,1]
+ */
+static glm::vec2 encodeOctahedral(const glm::vec3 & v) {
+	const float norm = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+	if(norm == 0.0f) {
+		return glm::vec2(0.0f);
+	}
+	glm::vec2 e = glm::vec2(v) / norm;
+	// Fold the lower hemisphere over the diagonals.
+	if(v.z < 0.0f) {
+		const glm::vec2 signs(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+		e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * signs;
+	}
+	return e;
+}
+
+/** Pack an octahedral-encoded tangent and the binormal orientation in the GL_INT_2_10_10_10_REV format.
+ \param e the encoded tangent
+ \param sign the sign of the binormal with respect to cross(normal, tangent)
+ \return the packed tangent
+ */
+static uint32_t packTangent(const glm::vec2 & e, float sign) {
+	const int x = int(std::round(glm::clamp(e.x, -1.0f, 1.0f) * 511.0f));
+	const int y = int(std::round(glm::clamp(e.y, -1.0f, 1.0f) * 511.0f));
+	const int w = sign < 0.0f ? -1 : 1;
+	return (uint32_t(x) & 0x3FFu) | ((uint32_t(y) & 0x3FFu) << 10) | ((uint32_t(w) & 0x3u) << 30);
+}
+
+void GLUtilities::setupMesh(Mesh & mesh, const Mesh::Format & format) {
 	if(mesh.gpu) {
 		mesh.gpu->clean();
 	}
@@ -799,71 +1050,187 @@ void GLUtilities::setupMesh(Mesh & mesh) {
 	totalSize += 3 * mesh.tangents.size();
 	totalSize += 3 * mesh.binormals.size();
 	totalSize += 3 * mesh.colors.size();
+	const size_t fullSize = sizeof(GLfloat) * totalSize;
+
+	std::unique_ptr<GPUBuffer> vertexGPU;
+	size_t vertexBytes = fullSize;
+	if(format.packed) {
+		const size_t count = mesh.positions.size();
+		const bool hasNormals = mesh.normals.size() == count;
+		const bool hasTangents = hasNormals && mesh.tangents.size() == count && mesh.binormals.size() == count;
+		const bool hasTexcoords = mesh.texcoords.size() == count;
+		const bool hasColors = mesh.colors.size() == count;
+		// Texture coordinates in [0,1] are stored as unorm16, others (tiling) are kept as floats to avoid precision loss.
+		GLenum uvType = GL_UNSIGNED_SHORT;
+		for(const glm::vec2 & uv : mesh.texcoords) {
+			if(glm::any(glm::lessThan(uv, glm::vec2(0.0f))) || glm::any(glm::greaterThan(uv, glm::vec2(1.0f)))) {
+				uvType = GL_FLOAT;
+				break;
+			}
+		}
+		// Interleaved layout.
+		size_t stride = 3 * sizeof(GLfloat);
+		const size_t normalOffset = stride;
+		stride += hasNormals ? sizeof(uint32_t) : 0;
+		const size_t uvOffset = stride;
+		stride += hasTexcoords ? (uvType == GL_FLOAT ? 2 * sizeof(GLfloat) : sizeof(uint32_t)) : 0;
+		const size_t tangentOffset = stride;
+		stride += hasTangents ? sizeof(uint32_t) : 0;
+		const size_t colorOffset = stride;
+		stride += hasColors ? sizeof(uint32_t) : 0;
+
+		std::vector<unsigned char> data(stride * count);
+		for(size_t vid = 0; vid < count; ++vid) {
+			unsigned char * vertex = &data[vid * stride];
+			std::memcpy(vertex, &mesh.positions[vid][0], 3 * sizeof(GLfloat));
+			if(hasNormals) {
+				const uint32_t normal = glm::packSnorm2x16(encodeOctahedral(mesh.normals[vid]));
+				std::memcpy(vertex + normalOffset, &normal, sizeof(uint32_t));
+			}
+			if(hasTexcoords) {
+				const glm::vec2 & uv = mesh.texcoords[vid];
+				if(uvType == GL_FLOAT) {
+					std::memcpy(vertex + uvOffset, &uv[0], 2 * sizeof(GLfloat));
+				} else {
+					const uint32_t packedUV = glm::packUnorm2x16(uv);
+					std::memcpy(vertex + uvOffset, &packedUV, sizeof(uint32_t));
+				}
+			}
+			if(hasTangents) {
+				const glm::vec3 & n = mesh.normals[vid];
+				const glm::vec3 & t = mesh.tangents[vid];
+				const float sign = glm::dot(glm::cross(n, t), mesh.binormals[vid]);
+				const uint32_t tangent = packTangent(encodeOctahedral(t), sign);
+				std::memcpy(vertex + tangentOffset, &tangent, sizeof(uint32_t));
+			}
+			if(hasColors) {
+				const uint32_t color = glm::packUnorm4x8(glm::vec4(mesh.colors[vid], 1.0f));
+				std::memcpy(vertex + colorOffset, &color, sizeof(uint32_t));
+			}
+		}
 
-	// Create an array buffer to host the geometry data.
-	BufferBase vertexBuffer(sizeof(GLfloat) * totalSize, BufferType::VERTEX, DataUse::STATIC);
-	GLUtilities::setupBuffer(vertexBuffer);
-	// Fill in subregions.
-	size_t offset = 0;
-	if(!mesh.positions.empty()) {
-		const size_t size = sizeof(GLfloat) * 3 * mesh.positions.size();
-		GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.positions.data()), offset);
+		BufferBase vertexBuffer(data.size(), BufferType::VERTEX, DataUse::STATIC);
+		GLUtilities::setupBuffer(vertexBuffer);
+		GLUtilities::uploadBuffer(vertexBuffer, data.size(), data.data());
 		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
 		_metrics.bufferBindings += 1;
+		const GLsizei vStride = GLsizei(stride);
 		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-		offset += size;
-	}
-	if(!mesh.normals.empty()) {
-		const size_t size = sizeof(GLfloat) * 3 * mesh.normals.size();
-		GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.normals.data()), offset);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
-		_metrics.bufferBindings += 1;
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-		offset += size;
-	}
-	if(!mesh.texcoords.empty()) {
-		const size_t size = sizeof(GLfloat) * 2 * mesh.texcoords.size();
-		GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.texcoords.data()), offset);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
-		_metrics.bufferBindings += 1;
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-		offset += size;
-	}
-	if(!mesh.tangents.empty()) {
-		const size_t size = sizeof(GLfloat) * 3 * mesh.tangents.size();
-		GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.tangents.data()), offset);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
-		_metrics.bufferBindings += 1;
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-		offset += size;
-	}
-	if(!mesh.binormals.empty()) {
-		const size_t size = sizeof(GLfloat) * 3 * mesh.binormals.size();
-		GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.binormals.data()), offset);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
-		_metrics.bufferBindings += 1;
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-		offset += size;
-	}
-	if(!mesh.colors.empty()) {
-		const size_t size = sizeof(GLfloat) * 3 * mesh.colors.size();
-		GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.colors.data()), offset);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
-		_metrics.bufferBindings += 1;
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vStride, nullptr);
+		if(hasNormals) {
+			glEnableVertexAttribArray(6);
+			glVertexAttribPointer(6, 2, GL_SHORT, GL_TRUE, vStride, reinterpret_cast<void *>(normalOffset));
+		}
+		if(hasTexcoords) {
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, uvType, uvType == GL_UNSIGNED_SHORT ? GL_TRUE : GL_FALSE, vStride, reinterpret_cast<void *>(uvOffset));
+		}
+		if(hasTangents) {
+			glEnableVertexAttribArray(7);
+			glVertexAttribPointer(7, 4, GL_INT_2_10_10_10_REV, GL_TRUE, vStride, reinterpret_cast<void *>(tangentOffset));
+		}
+		if(hasColors) {
+			glEnableVertexAttribArray(5);
+			glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, vStride, reinterpret_cast<void *>(colorOffset));
+		}
+		vertexBytes = data.size();
+		vertexGPU = std::move(vertexBuffer.gpu);
+
+	} else {
+		// Create an array buffer to host the geometry data.
+		BufferBase vertexBuffer(fullSize, BufferType::VERTEX, DataUse::STATIC);
+		GLUtilities::setupBuffer(vertexBuffer);
+		// Fill in subregions.
+		size_t offset = 0;
+		if(!mesh.positions.empty()) {
+			const size_t size = sizeof(GLfloat) * 3 * mesh.positions.size();
+			GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.positions.data()), offset);
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
+			_metrics.bufferBindings += 1;
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+			offset += size;
+		}
+		if(!mesh.normals.empty()) {
+			const size_t size = sizeof(GLfloat) * 3 * mesh.normals.size();
+			GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.normals.data()), offset);
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
+			_metrics.bufferBindings += 1;
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+			offset += size;
+		}
+		if(!mesh.texcoords.empty()) {
+			const size_t size = sizeof(GLfloat) * 2 * mesh.texcoords.size();
+			GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.texcoords.data()), offset);
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
+			_metrics.bufferBindings += 1;
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+			offset += size;
+		}
+		if(!mesh.tangents.empty()) {
+			const size_t size = sizeof(GLfloat) * 3 * mesh.tangents.size();
+			GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.tangents.data()), offset);
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
+			_metrics.bufferBindings += 1;
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+			offset += size;
+		}
+		if(!mesh.binormals.empty()) {
+			const size_t size = sizeof(GLfloat) * 3 * mesh.binormals.size();
+			GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.binormals.data()), offset);
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
+			_metrics.bufferBindings += 1;
+			glEnableVertexAttribArray(4);
+			glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+			offset += size;
+		}
+		if(!mesh.colors.empty()) {
+			const size_t size = sizeof(GLfloat) * 3 * mesh.colors.size();
+			GLUtilities::uploadBuffer(vertexBuffer, size, reinterpret_cast<unsigned char *>(mesh.colors.data()), offset);
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.gpu->id);
+			_metrics.bufferBindings += 1;
+			glEnableVertexAttribArray(5);
+			glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+		}
+		vertexGPU = std::move(vertexBuffer.gpu);
 	}
 
-	// We load the indices data
-	const size_t inSize = sizeof(unsigned int) * mesh.indices.size();
+	// We load the indices data, followed by the indices of each level of detail.
+	const bool shortIndices = format.shortIndices && mesh.positions.size() <= 65536;
+	const size_t indexSize = shortIndices ? sizeof(GLushort) : sizeof(GLuint);
+	std::vector<GPUMesh::Level> levels(1);
+	levels[0].count = GLsizei(mesh.indices.size());
+	size_t inSize = indexSize * mesh.indices.size();
+	for(const auto & level : mesh.levels) {
+		levels.emplace_back();
+		levels.back().offset = inSize;
+		levels.back().count	 = GLsizei(level.size());
+		inSize += indexSize * level.size();
+	}
 	BufferBase indexBuffer(inSize, BufferType::INDEX, DataUse::STATIC);
 	GLUtilities::setupBuffer(indexBuffer);
-	GLUtilities::uploadBuffer(indexBuffer, inSize, reinterpret_cast<unsigned char *>(mesh.indices.data()));
+	if(shortIndices) {
+		std::vector<GLushort> indices;
+		indices.reserve(inSize / indexSize);
+		for(const unsigned int vid : mesh.indices) {
+			indices.push_back(GLushort(vid));
+		}
+		for(const auto & level : mesh.levels) {
+			for(const unsigned int vid : level) {
+				indices.push_back(GLushort(vid));
+			}
+		}
+		GLUtilities::uploadBuffer(indexBuffer, inSize, reinterpret_cast<unsigned char *>(indices.data()));
+	} else {
+		GLUtilities::uploadBuffer(indexBuffer, sizeof(unsigned int) * mesh.indices.size(), reinterpret_cast<unsigned char *>(mesh.indices.data()));
+		for(size_t lid = 0; lid < mesh.levels.size(); ++lid) {
+			const size_t size = sizeof(unsigned int) * mesh.levels[lid].size();
+			GLUtilities::uploadBuffer(indexBuffer, size, reinterpret_cast<unsigned char *>(mesh.levels[lid].data()), levels[lid + 1].offset);
+		}
+	}
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.gpu->id);
 	// Restore previously bound vertex array.
@@ -874,30 +1241,63 @@ void GLUtilities::setupMesh(Mesh & mesh) {
 	_metrics.vertexBindings += 2;
 	_metrics.bufferBindings += 2;
 
+	if(format.packed || shortIndices) {
+		const size_t fullInSize = inSize / indexSize * sizeof(GLuint);
+		Log::Verbose() << Log::OpenGL << "Mesh " << mesh.name() << ": vertex data " << fullSize << " -> " << vertexBytes << " bytes, index data " << fullInSize << " -> " << inSize << " bytes (" << (100 * (fullSize + fullInSize - vertexBytes - inSize) / std::max(fullSize + fullInSize, size_t(1))) << "% saved)." << std::endl;
+	}
+
 	mesh.gpu->id		   = vao;
 	mesh.gpu->count		   = GLsizei(mesh.indices.size());
+	mesh.gpu->levels	   = levels;
+	mesh.gpu->indexType	   = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	mesh.gpu->vertexBytes  = vertexBytes;
+	mesh.gpu->indexBytes   = inSize;
 	mesh.gpu->indexBuffer  = std::move(indexBuffer.gpu);
-	mesh.gpu->vertexBuffer = std::move(vertexBuffer.gpu);
+	mesh.gpu->vertexBuffer = std::move(vertexGPU);
+}
+
+void GLUtilities::drawMesh(const Mesh & mesh, uint level) {
+	if(!makeResident(mesh, _frameIndex)) {
+		return;
+	}
+	if(_state.vertexArray != mesh.gpu->id){
+		_state.vertexArray = mesh.gpu->id;
+		glBindVertexArray(mesh.gpu->id);
+		_metrics.vertexBindings += 1;
+	}
+	// Fall back to the coarsest available level.
+	const auto & levels = mesh.gpu->levels;
+	const GPUMesh::Level & range = levels[std::min(size_t(level), levels.size() - 1)];
+	glDrawElements(GL_TRIANGLES, range.count, mesh.gpu->indexType, reinterpret_cast<void *>(range.offset));
+	_metrics.drawCalls += 1;
+	_metrics.triangles += (unsigned long)(range.count / 3);
 }
 
-void GLUtilities::drawMesh(const Mesh & mesh) {
+void GLUtilities::drawInstancedMesh(const Mesh & mesh, uint instanceCount) {
+	if(!makeResident(mesh, _frameIndex)) {
+		return;
+	}
 	if(_state.vertexArray != mesh.gpu->id){
 		_state.vertexArray = mesh.gpu->id;
 		glBindVertexArray(mesh.gpu->id);
 		_metrics.vertexBindings += 1;
 	}
-	glDrawElements(GL_TRIANGLES, mesh.gpu->count, GL_UNSIGNED_INT, static_cast<void *>(nullptr));
+	glDrawElementsInstanced(GL_TRIANGLES, mesh.gpu->count, mesh.gpu->indexType, static_cast<void *>(nullptr), GLsizei(instanceCount));
 	_metrics.drawCalls += 1;
+	_metrics.triangles += (unsigned long)(mesh.gpu->count / 3) * instanceCount;
 }
 
 void GLUtilities::drawTesselatedMesh(const Mesh & mesh, uint patchSize){
+	if(!makeResident(mesh, _frameIndex)) {
+		return;
+	}
 	glPatchParameteri(GL_PATCH_VERTICES, GLint(patchSize));
 	if(_state.vertexArray != mesh.gpu->id){
 		_state.vertexArray = mesh.gpu->id;
 		glBindVertexArray(mesh.gpu->id);
 		_metrics.vertexBindings += 1;
 	}
-	glDrawElements(GL_PATCHES, mesh.gpu->count, GL_UNSIGNED_INT, static_cast<void *>(nullptr));
+	glDrawElements(GL_PATCHES, mesh.gpu->count, mesh.gpu->indexType, static_cast<void *>(nullptr));
 	_metrics.drawCalls += 1;
 
 }
@@ -912,6 +1312,16 @@ void GLUtilities::drawQuad(){
 	_metrics.quadCalls += 1;
 }
 
+void GLUtilities::drawVertices(uint first, uint count){
+	if(_state.vertexArray != _vao){
+		_state.vertexArray = _vao;
+		glBindVertexArray(_vao);
+		_metrics.vertexBindings += 1;
+	}
+	glDrawArrays(GL_TRIANGLES, GLint(first), GLsizei(count));
+	_metrics.drawCalls += 1;
+}
+
 void GLUtilities::sync(){
 	glFlush();
 	glFinish();
@@ -921,6 +1331,11 @@ void GLUtilities::nextFrame(){
 	// Save and reset stats.
 	_metricsPrevious = _metrics;
 	_metrics = Metrics();
+	++_frameIndex;
+}
+
+size_t GLUtilities::frameIndex(){
+	return _frameIndex;
 }
 
 void GLUtilities::deviceInfos(std::string & vendor, std::string & renderer, std::string & version, std::string & shaderVersion) {
@@ -1621,7 +2036,21 @@ void GLUtilities::deleted(GPUMesh & mesh){
 	}
 }
 
+void GLUtilities::deleted(GPUBuffer & buffer){
+	// If any active slot is using its texture, set it to 0.
+	for(auto& bind : _state.textures){
+		if(bind[GL_TEXTURE_BUFFER] == buffer.textureId){
+			bind[GL_TEXTURE_BUFFER] = 0;
+		}
+	}
+}
+
 GPUState GLUtilities::_state;
 GLUtilities::Metrics GLUtilities::_metrics;
 GLUtilities::Metrics GLUtilities::_metricsPrevious;
+size_t GLUtilities::_frameIndex = 0;
 GLuint GLUtilities::_vao = 0;
+std::string GLUtilities::_programCache;
+std::string GLUtilities::_programCacheDevice;
+size_t GLUtilities::_compiledPrograms = 0;
+size_t GLUtilities::_cachedPrograms = 0;
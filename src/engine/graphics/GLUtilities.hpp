@@ -36,6 +36,7 @@ class GLUtilities {
 	friend class GPUMesh; ///< Access to deletion notifier for cached state update.
 	friend class Framebuffer; ///< Access to deletion notifier for cached state update.
 	friend class Program; ///< Access to metrics.
+	friend class AsyncReadback; ///< Access to cached state and metrics.
 
 public:
 
@@ -53,9 +54,19 @@ public:
 	/** Bindings list */
 	using Bindings = std::map<std::string, Binding>;
 
+	/** \brief A program whose creation has been started, see startProgram and finishProgram. */
+	struct ProgramBuild {
+		GLuint id = 0; ///< The program ID.
+		std::vector<std::pair<ShaderType, GLuint>> shaders; ///< Shaders being compiled.
+		std::string cacheKey; ///< Name of the entry in the binary cache, empty if the cache is disabled.
+		std::string name; ///< Program debug name.
+		bool cached = false; ///< Was the program loaded from the binary cache.
+	};
+
 	/** Internal operation metrics. */
 	struct Metrics {
 		unsigned long drawCalls = 0; ///< Mesh draw call.
+		unsigned long triangles = 0; ///< Triangles submitted by mesh draw calls.
 		unsigned long quadCalls = 0; ///< Full screen quad.
 		unsigned long stateChanges = 0; ///< State changes.
 		unsigned long textureBindings = 0; ///< Number of texture bindings.
@@ -107,6 +118,35 @@ public:
 	 */
 	static GLuint createProgram(const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent, const std::string & tessControlContent, const std::string & tessEvalContent, Bindings & bindings, const std::string & debugInfos);
 
+	/** Start creating a GLProgram using the shader code contained in the given strings. If the binary cache contains the program, it is directly loaded, else compilation and linking are requested but their results are not queried, letting the driver work in the background.
+	 \param vertexContent the vertex shader string
+	 \param fragmentContent the fragment shader string
+	 \param geometryContent the optional geometry shader string
+	 \param tessControlContent the optional tesselation control shader string
+	 \param tessEvalContent the optional tesselation evaluation shader string
+	 \param bindings will be filled with the samplers present in the shaders and their user-defined locations
+	 \param debugInfos the name of the program, or any custom debug infos that will be logged.
+	 \param build will contain the program being created
+	 */
+	static void startProgram(const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent, const std::string & tessControlContent, const std::string & tessEvalContent, Bindings & bindings, const std::string & debugInfos, ProgramBuild & build);
+
+	/** Wait for a program creation to complete, log errors and store the program in the binary cache if needed.
+	 \param build the program being created
+	 \return the OpenGL ID of the program, or 0 if it failed
+	 */
+	static GLuint finishProgram(ProgramBuild & build);
+
+	/** Enable the program binary cache, if supported by the driver.
+	 \param directory the directory storing cached programs
+	 */
+	static void setupProgramCache(const std::string & directory);
+
+	/** Obtain statistics on the programs created since launch.
+	 \param compiled will contain the number of programs compiled from source
+	 \param cached will contain the number of programs loaded from the binary cache
+	 */
+	static void programStatistics(size_t & compiled, size_t & cached);
+
 	/** Bind a program to use for rendering
 	 \param program the program to use
 	 */
@@ -168,6 +208,17 @@ public:
 	 */
 	static void uploadTexture(const Texture & texture);
 
+	/** Upload an image to a region of an existing texture on the GPU.
+	 \param texture the texture to update
+	 \param image the image to upload
+	 \param layer the destination layer (or face)
+	 \param level the destination mip level
+	 \param x the horizontal offset of the region, in pixels
+	 \param y the vertical offset of the region, in pixels
+	 \note The image should have the same number of channels as the texture.
+	 */
+	static void uploadTextureRegion(const Texture & texture, const Image & image, uint layer, uint level, uint x, uint y);
+
 	/** Download a texture images data from the GPU.
 	 \param texture the texture to download
 	 \warning The CPU images of the texture will be overwritten.
@@ -200,6 +251,14 @@ public:
 	 */
 	static void bindBuffer(const BufferBase & buffer, size_t slot);
 
+	/** Bind a texture buffer to a texture slot.
+	 \param buffer the infos of the buffer to bind
+	 \param format the layout to use when reading the buffer content in shaders
+	 \param slot the texture slot
+	 \note The buffer should have been created with the BufferType::TEXTURE type.
+	 */
+	static void bindBuffer(const BufferBase & buffer, Layout format, size_t slot);
+
 	/** Create and allocate a GPU buffer.
 	 \param buffer the buffer to setup on the GPU
 	 */
@@ -228,14 +287,22 @@ public:
 
 	/** Mesh loading: send a mesh data to the GPU and set the input mesh GPU infos accordingly.
 	 \param mesh the mesh to upload
-	 \note The order of attribute locations is: position, normal, uvs, tangents, binormals.
+	 \param format the vertex attributes layout
+	 \note The order of attribute locations is: position, normal, uvs, tangents, binormals, colors. With the packed layout, the normal and tangent are instead stored octahedral-encoded at locations 6 and 7, the tangent fourth component being the binormal sign.
 	 */
-	static void setupMesh(Mesh & mesh);
+	static void setupMesh(Mesh & mesh, const Mesh::Format & format);
 
 	/** Draw indexed geometry.
 	 \param mesh the mesh to draw
+	 \param level the level of detail to draw, clamped to the ones available
 	 */
-	static void drawMesh(const Mesh & mesh);
+	static void drawMesh(const Mesh & mesh, uint level = 0);
+
+	/** Draw multiple instances of indexed geometry. The shader can use gl_InstanceID to differentiate them.
+	 \param mesh the mesh to draw
+	 \param instanceCount the number of instances
+	 */
+	static void drawInstancedMesh(const Mesh & mesh, uint instanceCount);
 
 	/** Draw tessellated geometry.
 	 \param mesh the mesh to tessellate and render
@@ -246,6 +313,12 @@ public:
 	/** Draw a fullscreen quad.*/
 	static void drawQuad();
 
+	/** Draw triangles without any vertex attribute, the shader generates vertices based on gl_VertexID.
+	 \param first the index of the first vertex
+	 \param count the number of vertices to draw
+	 */
+	static void drawVertices(uint first, uint count);
+
 	/** Flush the GPU command pipelines and wait for all processing to be done.
 	 */
 	static void sync();
@@ -254,6 +327,9 @@ public:
 	 */
 	static void nextFrame();
 
+	/** \return the index of the current frame */
+	static size_t frameIndex();
+
 	/** Query the GPU driver and API infos.
 	 \param vendor will contain the vendor name
 	 \param renderer will contain the renderer name
@@ -453,6 +529,26 @@ private:
 	 */
 	static void restoreTexture(TextureShape shape);
 
+	/** Extract bindings from a shader, strip the corresponding layout qualifiers and add the GLSL version.
+	 \param prog the content of the shader
+	 \param bindings will be filled with the samplers/buffers present in the shader and their user-defined locations
+	 \return the final shader source
+	 */
+	static std::string preprocessShader(const std::string & prog, Bindings & bindings);
+
+	/** Request the compilation of a shader, without waiting for the result.
+	 \param source the final shader source
+	 \param type the type of shader
+	 \return the OpenGL ID of the shader object
+	 */
+	static GLuint compileShader(const std::string & source, ShaderType type);
+
+	/** Retrieve the compilation log of a shader.
+	 \param id the OpenGL ID of the shader object
+	 \return the indented log, empty if the compilation succeeded
+	 */
+	static std::string shaderLog(GLuint id);
+
 	/** Update the cache to remove input object if it was used.
 	 \param tex the texture that was deleted
 	 \note See the OpenGL specification for update of bindings when named object is deleted.
@@ -471,8 +567,19 @@ private:
 	 */
 	static void deleted(GPUMesh & mesh);
 
+	/** Update the cache to remove input object if it was used.
+	 \param buffer the buffer that was deleted
+	 \note See the OpenGL specification for update of bindings when named object is deleted.
+	 */
+	static void deleted(GPUBuffer & buffer);
+
 	static GPUState _state; ///< Current GPU state for caching.
 	static Metrics _metrics; ///< Internal metrics (draw count, state changes,...).
 	static Metrics _metricsPrevious; ///< Internal metrics for the last completed frame.
+	static size_t _frameIndex; ///< Index of the current frame.
 	static GLuint _vao; ///< The unique empty screenquad VAO.
+	static std::string _programCache; ///< Program binary cache directory, empty if disabled.
+	static std::string _programCacheDevice; ///< Driver identification, part of the cache keys.
+	static size_t _compiledPrograms; ///< Number of programs compiled from source.
+	static size_t _cachedPrograms; ///< Number of programs loaded from the binary cache.
 };
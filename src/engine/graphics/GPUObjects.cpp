@@ -40,7 +40,8 @@ GPUBuffer::GPUBuffer(BufferType type, DataUse use){
 	static const std::map<BufferType, GLenum> types = {
 	{BufferType::VERTEX, GL_ARRAY_BUFFER},
 	{BufferType::INDEX, GL_ELEMENT_ARRAY_BUFFER},
-	{BufferType::UNIFORM, GL_UNIFORM_BUFFER}};
+	{BufferType::UNIFORM, GL_UNIFORM_BUFFER},
+	{BufferType::TEXTURE, GL_TEXTURE_BUFFER}};
 	target = types.at(type);
 
 	static const std::map<DataUse, GLenum> usages = {
@@ -50,6 +51,11 @@ GPUBuffer::GPUBuffer(BufferType type, DataUse use){
 }
 
 void GPUBuffer::clean(){
+	if(textureId != 0){
+		glDeleteTextures(1, &textureId);
+		GLUtilities::deleted(*this);
+		textureId = 0;
+	}
 	glDeleteBuffers(1, &id);
 	id = 0;
 }
@@ -230,6 +236,32 @@ unsigned int Descriptor::getChannelsCount() const {
 	return getGPULayout(typeFormat, type, format);
 }
 
+unsigned int Descriptor::getPixelSize() const {
+	GLenum typedFormat, type, format;
+	getGPULayout(typedFormat, type, format);
+	// Packed types store all channels in a single value.
+	if(type == GL_UNSIGNED_SHORT_5_5_5_1) {
+		return 2;
+	}
+	if(type == GL_UNSIGNED_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_10F_11F_11F_REV || type == GL_UNSIGNED_INT_24_8) {
+		return 4;
+	}
+	if(type == GL_FLOAT_32_UNSIGNED_INT_24_8_REV) {
+		return 8;
+	}
+	unsigned int channels = 4;
+	if(format == GL_RED || format == GL_RED_INTEGER || format == GL_DEPTH_COMPONENT) {
+		channels = 1;
+	} else if(format == GL_RG || format == GL_RG_INTEGER) {
+		channels = 2;
+	} else if(format == GL_RGB || format == GL_RGB_INTEGER) {
+		channels = 3;
+	}
+	const bool byteType = type == GL_UNSIGNED_BYTE || type == GL_BYTE;
+	const bool shortType = type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT;
+	return channels * (byteType ? 1 : (shortType ? 2 : 4));
+}
+
 GLenum Descriptor::getGPUMinificationFilter() const {
 	return getGPUFilter(_filtering);
 }
@@ -23,7 +23,8 @@ enum class ShaderType : uint {
 enum class BufferType : uint {
 	VERTEX, ///< Vertex data.
 	INDEX, ///< Element indices.
-	UNIFORM ///< Uniform data.
+	UNIFORM, ///< Uniform data.
+	TEXTURE ///< Texture buffer data, read in shaders through a buffer sampler.
 };
 
 /**
@@ -264,6 +265,11 @@ public:
 	 */
 	unsigned int getChannelsCount() const;
 
+	/** Query the size of a pixel on the GPU, assuming tightly packed channels.
+	 \return the size in bytes
+	 */
+	unsigned int getPixelSize() const;
+
 	/** Query the data layout.
 	 \return the layout
 	 */
@@ -393,6 +399,7 @@ public:
 	GLenum format;				 ///< General format.
 	GLenum type;				 ///< Data type.
 	GLuint id = 0; ///< The OpenGL texture ID.
+	size_t lastUse = 0; ///< Index of the last frame the texture was bound, for residency management.
 	
 private:
 	Descriptor _descriptor; ///< Layout used.
@@ -410,6 +417,8 @@ public:
 	GLuint id = 0; ///< The buffer OpenGL ID.
 	GLenum target; ///< The buffer type.
 	GLenum usage; ///< The buffer usage.
+	GLuint textureId = 0; ///< The texture OpenGL ID (texture buffers only).
+	GLenum textureFormat = GL_NONE; ///< The current texture format (texture buffers only).
 
 	/** Constructor.
 	 \param type the type of buffer
@@ -450,6 +459,17 @@ public:
 
 	GLsizei count = 0; ///< The number of vertices (cached).
 	GLuint id	= 0; ///< The vertex buffer objects OpenGL ID.
+	GLenum indexType = GL_UNSIGNED_INT; ///< The type of the indices.
+	size_t vertexBytes = 0; ///< Size of the vertex data, in bytes (cached).
+	size_t indexBytes = 0; ///< Size of the index data, in bytes (cached).
+	size_t lastUse = 0; ///< Index of the last frame the mesh was drawn, for residency management.
+
+	/** \brief Range of the index buffer used by a level of detail. */
+	struct Level {
+		size_t offset = 0; ///< Offset in the index buffer, in bytes.
+		GLsizei count = 0; ///< Number of indices.
+	};
+	std::vector<Level> levels; ///< Index ranges of each level of detail, the first one being the full mesh (cached).
 	
 	/** Clean internal GPU buffers. */
 	void clean();
@@ -0,0 +1,329 @@
+#include "graphics/Profiler.hpp"
+#include "system/System.hpp"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <functional>
+
+Profiler::Profiler() {
+	_start = std::chrono::steady_clock::now();
+	_frames[_current].frame.cpuStart = 0;
+	_frames[_current].pending = _enabled;
+}
+
+Profiler & Profiler::manager() {
+	static Profiler profiler;
+	return profiler;
+}
+
+int64_t Profiler::now() const {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void Profiler::begin(const std::string & name) {
+	if(!_enabled) {
+		return;
+	}
+	PendingFrame & current = _frames[_current];
+	const size_t id = current.frame.scopes.size();
+	// Allocate additional queries if needed, they are kept for the following frames.
+	if(current.queries.size() < 2 * (id + 1)) {
+		const size_t first = current.queries.size();
+		const size_t count = std::max(size_t(16), first);
+		current.queries.resize(first + count);
+		glGenQueries(GLsizei(count), &current.queries[first]);
+	}
+
+	current.frame.scopes.emplace_back();
+	Timing & timing = current.frame.scopes.back();
+	timing.name		= name;
+	timing.depth	= uint(_stack.size());
+	timing.cpuStart = now() - current.frame.cpuStart;
+	glQueryCounter(current.queries[2 * id], GL_TIMESTAMP);
+	_stack.push_back(id);
+}
+
+void Profiler::end() {
+	if(!_enabled) {
+		return;
+	}
+	if(_stack.empty()) {
+		Log::Warning() << "[Profiler] No scope currently open. Ignoring the end." << std::endl;
+		return;
+	}
+	PendingFrame & current = _frames[_current];
+	const size_t id = _stack.back();
+	_stack.pop_back();
+	current.frame.scopes[id].cpuEnd = now() - current.frame.cpuStart;
+	glQueryCounter(current.queries[2 * id + 1], GL_TIMESTAMP);
+}
+
+void Profiler::closeScopes() {
+	if(_stack.empty()) {
+		return;
+	}
+	const Frame & frame = _frames[_current].frame;
+	Log::Warning() << "[Profiler] Scope \"" << frame.scopes[_stack.back()].name << "\" was not closed before the end of the frame." << std::endl;
+	while(!_stack.empty()) {
+		end();
+	}
+}
+
+void Profiler::nextFrame() {
+	if(_enabled) {
+		closeScopes();
+		// Estimate the offset between the GPU and CPU clocks once.
+		if(!_calibrated) {
+			GLint64 gpuTime = 0;
+			glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+			_gpuOffset  = int64_t(gpuTime) - now();
+			_calibrated = true;
+		}
+	}
+	PendingFrame & finished	   = _frames[_current];
+	finished.frame.cpuDuration = now() - finished.frame.cpuStart;
+	if(finished.timed) {
+		glQueryCounter(finished.frameQueries[1], GL_TIMESTAMP);
+	}
+
+	// Move to the oldest buffered frame, its timestamps have had the time to be written.
+	_current = (_current + 1) % _bufferCount;
+	PendingFrame & oldest = _frames[_current];
+	if(oldest.pending) {
+		resolve(oldest.frame, oldest.queries, oldest.timed ? &oldest.frameQueries[0] : nullptr);
+		_lastFrame = oldest.frame;
+		if(_capturing) {
+			_captured.push_back(oldest.frame);
+		}
+	}
+
+	// Reuse it for the frame about to start.
+	_enabled = _nextEnabled;
+	++_frameId;
+	oldest.frame.scopes.clear();
+	oldest.frame.id		  = _frameId;
+	oldest.frame.cpuStart	  = now();
+	oldest.frame.cpuDuration = 0;
+	oldest.frame.gpuDuration = 0;
+	oldest.frame.gpuValid	  = false;
+	oldest.pending		  = _enabled;
+	oldest.timed		  = _enabled;
+	if(_enabled) {
+		if(oldest.frameQueries[0] == 0) {
+			glGenQueries(2, &oldest.frameQueries[0]);
+		}
+		glQueryCounter(oldest.frameQueries[0], GL_TIMESTAMP);
+	}
+}
+
+void Profiler::resolve(Frame & frame, const std::vector<GLuint> & queries, const GLuint * frameQueries) const {
+	frame.gpuValid = false;
+	const size_t count = 2 * frame.scopes.size();
+	// Never stall: if a result is still missing, the GPU timings of this frame are dropped.
+	for(size_t qid = 0; qid < count + (frameQueries ? 2 : 0); ++qid) {
+		GLint available = 0;
+		glGetQueryObjectiv(qid < count ? queries[qid] : frameQueries[qid - count], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(available == GL_FALSE) {
+			return;
+		}
+	}
+	if(frameQueries) {
+		GLuint64 start = 0;
+		GLuint64 end   = 0;
+		glGetQueryObjectui64v(frameQueries[0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frameQueries[1], GL_QUERY_RESULT, &end);
+		frame.gpuDuration = int64_t(end) - int64_t(start);
+	}
+	// Express GPU timestamps in the CPU frame timeline.
+	const int64_t origin = _gpuOffset + frame.cpuStart;
+	for(size_t sid = 0; sid < frame.scopes.size(); ++sid) {
+		GLuint64 start = 0;
+		GLuint64 end   = 0;
+		glGetQueryObjectui64v(queries[2 * sid], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(queries[2 * sid + 1], GL_QUERY_RESULT, &end);
+		frame.scopes[sid].gpuStart = int64_t(start) - origin;
+		frame.scopes[sid].gpuEnd   = int64_t(end) - origin;
+	}
+	frame.gpuValid = true;
+}
+
+void Profiler::setEnabled(bool enabled) {
+	_nextEnabled = enabled;
+}
+
+void Profiler::startCapture() {
+	_captured.clear();
+	_capturing = true;
+}
+
+void Profiler::stopCapture() {
+	_capturing = false;
+}
+
+/** Escape a string for insertion in a JSON document.
+ \param str the string to escape
+ \return the escaped string
+ */
+static std::string escapeJSON(const std::string & str) {
+	std::string res;
+	res.reserve(str.size());
+	for(const char c : str) {
+		if(c == '"' || c == '\\') {
+			res.push_back('\\');
+			res.push_back(c);
+		} else if(uchar(c) < 0x20) {
+			res.push_back(' ');
+		} else {
+			res.push_back(c);
+		}
+	}
+	return res;
+}
+
+bool Profiler::exportTrace(const std::string & path) const {
+	if(_captured.empty()) {
+		Log::Warning() << "[Profiler] No captured frame to export." << std::endl;
+		return false;
+	}
+	std::ofstream file(System::widen(path));
+	if(!file.is_open()) {
+		Log::Error() << "[Profiler] Unable to save trace at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	// Timestamps are expressed in microseconds.
+	std::stringstream str;
+	str.precision(3);
+	str << std::fixed;
+	const auto writeEvent = [&str](const std::string & name, const std::string & category, int64_t start, int64_t end, int thread) {
+		str << ",\n{\"name\":\"" << escapeJSON(name) << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",";
+		str << "\"ts\":" << (double(start) * 1e-3) << ",\"dur\":" << (double(std::max(end - start, int64_t(0))) * 1e-3) << ",";
+		str << "\"pid\":0,\"tid\":" << thread << "}";
+	};
+
+	str << "{\"traceEvents\":[\n";
+	str << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}}";
+	str << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+	for(const Frame & frame : _captured) {
+		writeEvent("Frame " + std::to_string(frame.id), "frame", frame.cpuStart, frame.cpuStart + frame.cpuDuration, 0);
+		for(const Timing & timing : frame.scopes) {
+			writeEvent(timing.name, "cpu", frame.cpuStart + timing.cpuStart, frame.cpuStart + timing.cpuEnd, 0);
+			if(frame.gpuValid) {
+				writeEvent(timing.name, "gpu", frame.cpuStart + timing.gpuStart, frame.cpuStart + timing.gpuEnd, 1);
+			}
+		}
+	}
+	str << "\n],\n\"displayTimeUnit\":\"ms\"}\n";
+	file << str.str();
+	file.close();
+	Log::Info() << "[Profiler] Exported " << _captured.size() << " frames to \"" << path << "\"." << std::endl;
+	return true;
+}
+
+void Profiler::interface() {
+	bool enabled = _nextEnabled;
+	if(ImGui::Checkbox("Enabled", &enabled)) {
+		setEnabled(enabled);
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("GPU timings", &_showGPU);
+	ImGui::SameLine();
+	if(ImGui::Button(_capturing ? "Stop capture" : "Start capture")) {
+		if(_capturing) {
+			stopCapture();
+		} else {
+			startCapture();
+		}
+	}
+	ImGui::SameLine();
+	if(ImGui::Button("Export")) {
+		exportTrace("./" + System::timestamp() + "_trace.json");
+	}
+	ImGui::SameLine();
+	ImGui::Text("%lu frames captured", (unsigned long)(_captured.size()));
+
+	const Frame & frame = _lastFrame;
+	ImGui::Text("Frame %lu: %05.2fms (CPU)", (unsigned long)(frame.id), double(frame.cpuDuration) * 1e-6);
+	if(frame.gpuValid) {
+		ImGui::SameLine();
+		ImGui::Text(", %05.2fms (GPU)", double(frame.gpuDuration) * 1e-6);
+	} else if(_showGPU) {
+		ImGui::SameLine();
+		ImGui::TextDisabled("GPU timings unavailable");
+	}
+	displayFlame(frame, _showGPU && frame.gpuValid);
+}
+
+void Profiler::displayFlame(const Frame & frame, bool gpu) const {
+	if(frame.scopes.empty()) {
+		ImGui::TextDisabled("No scope recorded.");
+		return;
+	}
+
+	// Time range covered by the scopes.
+	int64_t minTime = std::numeric_limits<int64_t>::max();
+	int64_t maxTime = std::numeric_limits<int64_t>::min();
+	uint maxDepth	= 0;
+	for(const Timing & timing : frame.scopes) {
+		minTime	 = std::min(minTime, gpu ? timing.gpuStart : timing.cpuStart);
+		maxTime	 = std::max(maxTime, gpu ? timing.gpuEnd : timing.cpuEnd);
+		maxDepth = std::max(maxDepth, timing.depth);
+	}
+	// On the CPU, the frame itself is a meaningful reference.
+	if(!gpu) {
+		minTime = 0;
+		maxTime = std::max(maxTime, frame.cpuDuration);
+	}
+	const double range = double(std::max(maxTime - minTime, int64_t(1)));
+
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const float width	  = std::max(ImGui::GetContentRegionAvail().x, 50.0f);
+	const ImVec2 origin	  = ImGui::GetCursorScreenPos();
+	ImDrawList * drawList = ImGui::GetWindowDrawList();
+	const std::hash<std::string> hasher;
+
+	for(const Timing & timing : frame.scopes) {
+		const int64_t start = (gpu ? timing.gpuStart : timing.cpuStart) - minTime;
+		const int64_t end	= (gpu ? timing.gpuEnd : timing.cpuEnd) - minTime;
+		const float x0		= origin.x + float(double(start) / range) * width;
+		const float x1		= std::max(origin.x + float(double(end) / range) * width, x0 + 1.0f);
+		const float y0		= origin.y + float(timing.depth) * rowHeight;
+		const ImVec2 minCorner(x0, y0);
+		const ImVec2 maxCorner(x1, y0 + rowHeight - 1.0f);
+
+		// Stable color per scope name.
+		const float hue = float(hasher(timing.name) % 360) / 360.0f;
+		drawList->AddRectFilled(minCorner, maxCorner, ImColor::HSV(hue, 0.6f, 0.7f));
+		drawList->PushClipRect(minCorner, maxCorner, true);
+		drawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32_WHITE, timing.name.c_str());
+		drawList->PopClipRect();
+
+		if(ImGui::IsMouseHoveringRect(minCorner, maxCorner)) {
+			const double duration = double(end - start) * 1e-6;
+			ImGui::SetTooltip("%s\n%s: %.3fms\nStart: %.3fms", timing.name.c_str(), gpu ? "GPU" : "CPU", duration, double(start) * 1e-6);
+		}
+	}
+	// Reserve the space used by the graph.
+	ImGui::Dummy(ImVec2(width, float(maxDepth + 1) * rowHeight));
+}
+
+void Profiler::clean() {
+	for(PendingFrame & pending : _frames) {
+		if(!pending.queries.empty()) {
+			glDeleteQueries(GLsizei(pending.queries.size()), &pending.queries[0]);
+		}
+		pending.queries.clear();
+		if(pending.frameQueries[0] != 0) {
+			glDeleteQueries(2, &pending.frameQueries[0]);
+		}
+		pending.frameQueries = {{0, 0}};
+		pending.frame.scopes.clear();
+		pending.timed	= false;
+		pending.pending = false;
+	}
+	_stack.clear();
+	_calibrated = false;
+	// Measurements require a GPU context.
+	_enabled	 = false;
+	_nextEnabled = false;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Common.hpp"
+#include <chrono>
+#include <array>
+
+/**
+ \brief Record the CPU and GPU durations of nested named scopes at each frame.
+ \details GPU durations are measured using timestamp queries, that are retrieved a few frames later to avoid stalling the pipeline. The last completed frame can be displayed as a flame graph, and a series of frames can be captured and exported as a Chrome trace (to load in chrome://tracing or similar tools).
+ \ingroup Graphics
+ */
+class Profiler {
+
+public:
+
+	/** \brief Timings of a scope, in nanoseconds relative to the beginning of the frame on the CPU. */
+	struct Timing {
+		std::string name; ///< Scope name.
+		uint depth = 0; ///< Nesting level of the scope.
+		int64_t cpuStart = 0; ///< CPU start time.
+		int64_t cpuEnd = 0; ///< CPU end time.
+		int64_t gpuStart = 0; ///< GPU start time.
+		int64_t gpuEnd = 0; ///< GPU end time.
+	};
+
+	/** \brief Timings of all scopes of a frame. */
+	struct Frame {
+		std::vector<Timing> scopes; ///< Scopes, in opening order.
+		uint64_t id = 0; ///< Frame number.
+		int64_t cpuStart = 0; ///< Frame start time, relative to the creation of the profiler.
+		int64_t cpuDuration = 0; ///< Frame duration on the CPU.
+		int64_t gpuDuration = 0; ///< Frame duration on the GPU.
+		bool gpuValid = false; ///< Are the GPU timings available.
+	};
+
+	/** Start measuring a scope. Scopes can be nested.
+	 \param name the scope name
+	 */
+	void begin(const std::string & name);
+
+	/** End the most recently started scope. */
+	void end();
+
+	/** Finish the current frame and retrieve the results of the oldest buffered frame.
+	 \note This is called by the window at the end of each frame.
+	 */
+	void nextFrame();
+
+	/** \return the timings of the last completed frame */
+	const Frame & lastFrame() const { return _lastFrame; }
+
+	/** \return the number of the frame currently measured */
+	uint64_t frameId() const { return _frameId; }
+
+	/** Enable or disable measurements, starting at the next frame.
+	 \param enabled the new state
+	 */
+	void setEnabled(bool enabled);
+
+	/** \return true if measurements are enabled */
+	bool enabled() const { return _nextEnabled; }
+
+	/** Start recording all completed frames, for export. */
+	void startCapture();
+
+	/** Stop recording completed frames. */
+	void stopCapture();
+
+	/** \return the number of captured frames */
+	size_t capturedFrames() const { return _captured.size(); }
+
+	/** Save captured frames as a JSON file in the Chrome trace event format.
+	 \param path the output file path
+	 \return true if the export succeeded
+	 */
+	bool exportTrace(const std::string & path) const;
+
+	/** Display the profiler options and a flame graph of the last completed frame.
+	 \note The profiler can assume that a GUI window is currently open.
+	 */
+	void interface();
+
+	/** Release GPU queries. */
+	void clean();
+
+	/** \return the shared profiler */
+	static Profiler & manager();
+
+	/** Copy constructor.*/
+	Profiler(const Profiler &) = delete;
+
+	/** Copy assignment.
+	 \return a reference to the object assigned to
+	 */
+	Profiler & operator=(const Profiler &) = delete;
+
+	/** Move constructor.*/
+	Profiler(Profiler &&) = delete;
+
+	/** Move assignment.
+	 \return a reference to the object assigned to
+	 */
+	Profiler & operator=(Profiler &&) = delete;
+
+private:
+
+	/** Constructor. */
+	Profiler();
+
+	/** Destructor. */
+	~Profiler() = default;
+
+	/** \return the CPU time elapsed since the creation of the profiler, in nanoseconds */
+	int64_t now() const;
+
+	/** Retrieve the GPU timings of a frame, if they are available.
+	 \param frame the frame whose timings should be retrieved
+	 \param queries the scopes timestamp queries
+	 \param frameQueries the frame start and end timestamp queries, if timed
+	 */
+	void resolve(Frame & frame, const std::vector<GLuint> & queries, const GLuint * frameQueries) const;
+
+	/** Close all open scopes of the current frame. */
+	void closeScopes();
+
+	/** Display a flame graph of the timings of a frame.
+	 \param frame the frame to display
+	 \param gpu display the GPU timings instead of the CPU ones
+	 */
+	void displayFlame(const Frame & frame, bool gpu) const;
+
+	/** \brief A frame being measured or waiting for its GPU results. */
+	struct PendingFrame {
+		Frame frame; ///< The frame timings.
+		std::vector<GLuint> queries; ///< Two timestamp queries per scope.
+		std::array<GLuint, 2> frameQueries = {{0, 0}}; ///< Frame start and end timestamp queries.
+		bool timed = false; ///< Has the frame start timestamp been queried.
+		bool pending = false; ///< Is the frame waiting to be retrieved.
+	};
+
+	static const size_t _bufferCount = 4; ///< Number of buffered frames.
+	std::array<PendingFrame, _bufferCount> _frames; ///< Buffered frames.
+	size_t _current = 0; ///< Frame being measured.
+	std::vector<size_t> _stack; ///< Currently open scopes.
+
+	Frame _lastFrame; ///< Last completed frame.
+	std::vector<Frame> _captured; ///< Captured frames for export.
+
+	std::chrono::time_point<std::chrono::steady_clock> _start; ///< Profiler creation time.
+	int64_t _gpuOffset = 0; ///< Difference between the GPU and the CPU clocks.
+	uint64_t _frameId = 0; ///< Current frame number.
+	bool _calibrated = false; ///< Has the GPU clock offset been estimated.
+	bool _enabled = true; ///< Are measurements performed.
+	bool _nextEnabled = true; ///< Should measurements be performed starting at the next frame.
+	bool _capturing = false; ///< Are completed frames recorded.
+	bool _showGPU = true; ///< Display GPU timings in the flame graph.
+};
@@ -3,6 +3,11 @@
 #include "resources/ResourcesManager.hpp"
 
 
+struct Program::PendingBuild {
+	GLUtilities::ProgramBuild build; ///< The program being created.
+	GLUtilities::Bindings bindings; ///< Bindings to register once the program is linked.
+};
+
 Program::Uniform::Uniform(const std::string & uname, Program::Uniform::Type utype) :
 	name(uname), type(utype) {
 }
@@ -11,14 +16,33 @@ Program::Program(const std::string & name, const std::string & vertexContent, co
 	reload(vertexContent, fragmentContent, geometryContent, tessControlContent, tessEvalContent);
 }
 
-void Program::reload(const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent, const std::string & tessControlContent, const std::string & tessEvalContent) {
-	GLUtilities::Bindings bindings;
+Program::Program(Program &&) = default;
+
+Program & Program::operator=(Program &&) = default;
 
-	const std::string debugName = _name;
+Program::~Program() = default;
 
-	_id = GLUtilities::createProgram(vertexContent, fragmentContent, geometryContent, tessControlContent, tessEvalContent, bindings, debugName);
+void Program::reload(const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent, const std::string & tessControlContent, const std::string & tessEvalContent) {
+	// Release the shaders of a previous compilation that was never used.
+	if(_pending) {
+		GLUtilities::finishProgram(_pending->build);
+	}
+	_pending.reset(new PendingBuild());
+	GLUtilities::startProgram(vertexContent, fragmentContent, geometryContent, tessControlContent, tessEvalContent, _pending->bindings, _name, _pending->build);
+	_id = _pending->build.id;
 	_uniforms.clear();
 	_uniformInfos.clear();
+}
+
+void Program::finalize() const {
+	const std::unique_ptr<PendingBuild> pending = std::move(_pending);
+	const std::string & debugName = _name;
+	GLUtilities::Bindings & bindings = pending->bindings;
+	// The ID is unchanged, unless linking failed.
+	_id = GLUtilities::finishProgram(pending->build);
+	if(_id == 0) {
+		return;
+	}
 
 	// Get the number of active uniforms and their maximum length.
 	// Note: this will also capture each attribute of each element of a uniform block.
@@ -121,7 +145,13 @@ void Program::reload(const std::string & vertexContent, const std::string & frag
 	checkGLError();
 }
 
+const std::vector<Program::Uniform> & Program::uniforms() const {
+	ready();
+	return _uniformInfos;
+}
+
 void Program::validate() const {
+	ready();
 	glValidateProgram(_id);
 	int status = -2;
 	glGetProgramiv(_id, GL_VALIDATE_STATUS, &status);
@@ -138,6 +168,7 @@ void Program::validate() const {
 }
 
 void Program::saveBinary(const std::string & outputPath) const {
+	ready();
 	int count = 0;
 	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
 	if(count <= 0) {
@@ -158,10 +189,16 @@ void Program::saveBinary(const std::string & outputPath) const {
 }
 
 void Program::use() const {
+	ready();
 	GLUtilities::bindProgram(*this);
 }
 
 void Program::clean() const {
+	// Release shaders without querying uniforms.
+	if(_pending) {
+		GLUtilities::finishProgram(_pending->build);
+		_pending.reset();
+	}
 	glDeleteProgram(_id);
 }
 
@@ -257,6 +294,7 @@ void Program::uniform(const std::string & name, const glm::mat4 & t) const {
 }
 
 void Program::uniformBuffer(const std::string & name, size_t slot) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glUniformBlockBinding(_id, _uniforms.at(name), GLuint(slot));
 		updateUniformMetric();
@@ -264,6 +302,7 @@ void Program::uniformBuffer(const std::string & name, size_t slot) const {
 }
 
 void Program::uniformTexture(const std::string & name, size_t slot) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glUniform1i(_uniforms.at(name), int(slot));
 		updateUniformMetric();
@@ -271,6 +310,7 @@ void Program::uniformTexture(const std::string & name, size_t slot) const {
 }
 
 void Program::getUniform(const std::string & name, bool & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		int val = int(t);
 		glGetUniformiv(_id, _uniforms.at(name), &val);
@@ -279,66 +319,77 @@ void Program::getUniform(const std::string & name, bool & t) const {
 }
 
 void Program::getUniform(const std::string & name, int & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformiv(_id, _uniforms.at(name), &t);
 	}
 }
 
 void Program::getUniform(const std::string & name, uint & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformuiv(_id, _uniforms.at(name), &t);
 	}
 }
 
 void Program::getUniform(const std::string & name, float & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformfv(_id, _uniforms.at(name), &t);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::vec2 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformfv(_id, _uniforms.at(name), &t[0]);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::vec3 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformfv(_id, _uniforms.at(name), &t[0]);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::vec4 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformfv(_id, _uniforms.at(name), &t[0]);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::ivec2 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformiv(_id, _uniforms.at(name), &t[0]);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::ivec3 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformiv(_id, _uniforms.at(name), &t[0]);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::ivec4 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformiv(_id, _uniforms.at(name), &t[0]);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::mat3 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformfv(_id, _uniforms.at(name), &t[0][0]);
 	}
 }
 
 void Program::getUniform(const std::string & name, glm::mat4 & t) const {
+	ready();
 	if(_uniforms.count(name) != 0) {
 		glGetUniformfv(_id, _uniforms.at(name), &t[0][0]);
 	}
@@ -6,7 +6,7 @@
 
 /**
  \brief Represents a group of shaders used for rendering.
- \details Internally responsible for handling uniforms locations, shaders reloading and values caching.
+ \details Internally responsible for handling uniforms locations, shaders reloading and values caching. Compilation and linking results are only queried when the program is first used, so that the driver can process multiple programs concurrently.
  \ingroup Graphics
  */
 class Program {
@@ -50,7 +50,7 @@ public:
 	Program(const std::string & name, const std::string & vertexContent, const std::string & fragmentContent, const std::string & geometryContent = "", const std::string & tessControlContent = "", const std::string & tessEvalContent = "");
 
 	/**
-	 Load the program, compiling the shader and updating all uniform locations.
+	 Load the program, starting the shaders compilation. Uniform locations will be updated when the program is first used.
 	 \param vertexContent the content of the vertex shader
 	 \param fragmentContent the content of the fragment shader
 	 \param geometryContent the content of the geometry shader (can be empty)
@@ -244,9 +244,7 @@ public:
 
 	/** \return the list of registered basic uniforms.
 	 */
-	const std::vector<Uniform> & uniforms() const {
-		return _uniformInfos;
-	}
+	const std::vector<Uniform> & uniforms() const;
 
 	/** \return the program name */
 	const std::string & name() const {
@@ -264,19 +262,36 @@ public:
 	/** Move assignment operator.
 	 \return a reference to the object assigned to
 	 */
-	Program & operator=(Program &&) = default;
+	Program & operator=(Program &&);
 	
 	/** Move constructor. */
-	Program(Program &&) = default;
+	Program(Program &&);
+
+	/** Destructor. */
+	~Program();
 	
 private:
 
+	/** Wait for the program compilation if needed, and update all uniform locations. */
+	void finalize() const;
+
+	/** Finalize the program if its compilation has not been checked yet. */
+	void ready() const {
+		if(_pending) {
+			finalize();
+		}
+	}
+
 	void updateUniformMetric() const; ///< Update internal metrics.
+
+	/** \brief A program whose compilation has been requested but not checked yet. */
+	struct PendingBuild;
 	
-	GLuint _id;								 ///< The OpenGL program ID.
+	mutable GLuint _id;						 ///< The OpenGL program ID.
 	std::string _name;				 		 ///< The shader name
-	std::map<std::string, GLint> _uniforms;  ///< Internal list of automatically registered uniforms and their locations. We keep this separate to avoid exposing GL internal types.
-	std::vector<Uniform> _uniformInfos;  ///< Additional uniforms info.
+	mutable std::map<std::string, GLint> _uniforms;  ///< Internal list of automatically registered uniforms and their locations. We keep this separate to avoid exposing GL internal types.
+	mutable std::vector<Uniform> _uniformInfos;  ///< Additional uniforms info.
+	mutable std::unique_ptr<PendingBuild> _pending; ///< Program being compiled, if not finalized yet.
 
 	friend class GLUtilities; ///< Utilities will need to access GPU handle.
 };
@@ -0,0 +1,91 @@
+#include "graphics/TextBatch.hpp"
+#include "graphics/GLUtilities.hpp"
+
+TextBatch::TextBatch(size_t capacity) {
+	_stream.reset(new Buffer<GPUGlyph>(std::max(capacity, size_t(1)), BufferType::TEXTURE, DataUse::DYNAMIC));
+}
+
+void TextBatch::clear() {
+	for(AtlasBatch & batch : _batches) {
+		batch.glyphs.clear();
+	}
+}
+
+void TextBatch::add(const Font & font, const std::string & text, const glm::vec2 & position, float scale, Font::Alignment align, const Style & style) {
+	// Find the batch associated to the font atlas.
+	AtlasBatch * batch = nullptr;
+	for(AtlasBatch & other : _batches) {
+		if(other.atlas == font.atlas()) {
+			batch = &other;
+			break;
+		}
+	}
+	if(!batch) {
+		_batches.emplace_back();
+		batch		 = &_batches.back();
+		batch->atlas = font.atlas();
+	}
+
+	_quads.clear();
+	font.layoutLabel(text, scale, align, _quads);
+	for(const Font::GlyphQuad & quad : _quads) {
+		GPUGlyph glyph;
+		glyph.corners		= glm::vec4(quad.min, quad.max);
+		glyph.uvs			= glm::vec4(quad.uvMin, quad.uvMax);
+		glyph.color			= style.color;
+		glyph.edgeColor		= style.edgeColor;
+		glyph.anchorAndEdge = glm::vec4(position, style.edgeWidth, 0.0f);
+		batch->glyphs.push_back(glyph);
+	}
+}
+
+void TextBatch::draw(const Program & program) {
+	const size_t count = size();
+	if(count == 0) {
+		return;
+	}
+	// Grow the GPU buffer if needed.
+	if(count > _stream->size()) {
+		size_t newSize = _stream->size();
+		while(newSize < count) {
+			newSize *= 2;
+		}
+		_stream.reset(new Buffer<GPUGlyph>(newSize, BufferType::TEXTURE, DataUse::DYNAMIC));
+	}
+	// Gather all glyphs, contiguous per atlas.
+	auto & glyphs = _stream->data;
+	size_t offset = 0;
+	for(const AtlasBatch & batch : _batches) {
+		std::copy(batch.glyphs.begin(), batch.glyphs.end(), glyphs.begin() + offset);
+		offset += batch.glyphs.size();
+	}
+	// Upload the whole buffer to orphan the previous content.
+	_stream->upload();
+
+	program.use();
+	GLUtilities::bindBuffer(*_stream, Layout::RGBA32F, 1);
+	// Each glyph is made of two triangles.
+	offset = 0;
+	for(const AtlasBatch & batch : _batches) {
+		if(batch.glyphs.empty()) {
+			continue;
+		}
+		GLUtilities::bindTexture(batch.atlas, 0);
+		GLUtilities::drawVertices(uint(6 * offset), uint(6 * batch.glyphs.size()));
+		offset += batch.glyphs.size();
+	}
+}
+
+size_t TextBatch::size() const {
+	size_t count = 0;
+	for(const AtlasBatch & batch : _batches) {
+		count += batch.glyphs.size();
+	}
+	return count;
+}
+
+void TextBatch::clean() {
+	_batches.clear();
+	_quads.clear();
+	_stream->clean();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "resources/Font.hpp"
+#include "resources/Buffer.hpp"
+#include "graphics/Program.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Collect the glyphs of all text labels displayed in a frame and render them with one draw call per font atlas.
+ \details Glyphs are appended to a CPU list each frame and sent at once in a persistent GPU buffer, read by the vertex shader (see font_sdf.vert) which generates two triangles per glyph. The buffer is only reallocated when more glyphs than ever before are displayed, so changing text every frame doesn't create any GPU object.
+ \ingroup Graphics
+ */
+class TextBatch {
+public:
+
+	/** \brief Label appearance. */
+	struct Style {
+		glm::vec4 color = glm::vec4(1.0f); ///< The inner glyph color.
+		glm::vec4 edgeColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); ///< The outer glyph color.
+		float edgeWidth = 0.0f; ///< The outer edge width.
+	};
+
+	/** Constructor.
+	 \param capacity the initial number of glyphs that can be displayed
+	 */
+	explicit TextBatch(size_t capacity = 256);
+
+	/** Remove all labels, keeping the allocated memory. */
+	void clear();
+
+	/** Add a label to the batch.
+	 \param font the font to use
+	 \param text the text to display
+	 \param position the position of the label anchor on screen
+	 \param scale the vertical height of the characters, in absolute units
+	 \param align the text alignment relative to the anchor
+	 \param style the label colors
+	 */
+	void add(const Font & font, const std::string & text, const glm::vec2 & position, float scale, Font::Alignment align, const Style & style);
+
+	/** Upload all glyphs and draw them, one call per font atlas.
+	 \param program the program to use (see font_sdf), other uniforms should already be set
+	 \note The atlas is bound at slot 0, the glyphs buffer at slot 1.
+	 */
+	void draw(const Program & program);
+
+	/** \return the number of glyphs currently in the batch */
+	size_t size() const;
+
+	/** Clean internal resources. */
+	void clean();
+
+	/** Copy constructor.*/
+	TextBatch(const TextBatch &) = delete;
+
+	/** Copy assignment.
+	 \return a reference to the object assigned to
+	 */
+	TextBatch & operator=(const TextBatch &) = delete;
+
+	/** Move constructor.*/
+	TextBatch(TextBatch &&) = delete;
+
+	/** Move assignment.
+	 \return a reference to the object assigned to
+	 */
+	TextBatch & operator=(TextBatch &&) = delete;
+
+	/** Destructor. */
+	~TextBatch() = default;
+
+private:
+
+	/** \brief Represent a glyph on the GPU. */
+	struct GPUGlyph {
+		glm::vec4 corners; ///< Bottom left and top right corners, relative to the anchor.
+		glm::vec4 uvs; ///< Bottom left and top right corners in the atlas.
+		glm::vec4 color; ///< Inner color.
+		glm::vec4 edgeColor; ///< Outer color.
+		glm::vec4 anchorAndEdge; ///< Anchor position, edge width.
+	};
+
+	/** \brief Glyphs sharing the same font atlas. */
+	struct AtlasBatch {
+		const Texture * atlas = nullptr; ///< The font atlas.
+		std::vector<GPUGlyph> glyphs; ///< The glyphs to display.
+	};
+
+	std::vector<AtlasBatch> _batches; ///< Glyphs grouped by atlas.
+	std::vector<Font::GlyphQuad> _quads; ///< Temporary glyph placement storage.
+	std::unique_ptr<Buffer<GPUGlyph>> _stream; ///< Glyphs GPU buffer.
+};
@@ -2,6 +2,7 @@
 #include "graphics/GPUObjects.hpp"
 #include "graphics/GLUtilities.hpp"
 #include "graphics/ScreenQuad.hpp"
+#include "graphics/FramebufferPool.hpp"
 #include "resources/ResourcesManager.hpp"
 
 BilateralBlur::BilateralBlur() {
@@ -17,13 +18,8 @@ void BilateralBlur::process(const glm::mat4 & projection, const Texture * textur
 	GLUtilities::setBlendState(false);
 	GLUtilities::setCullState(true, Faces::BACK);
 
-	if(!_intermediate || _intermediate->descriptor() != framebuffer.descriptor()){
-		_intermediate.reset(new Framebuffer(framebuffer.width(), framebuffer.height(), framebuffer.descriptor(), false, "Bilateral blur"));
-	}
-
-	if(framebuffer.width() != _intermediate->width() || framebuffer.height() != _intermediate->height()){
-		resize(framebuffer.width(), framebuffer.height());
-	}
+	// The intermediate target is only needed during processing.
+	Framebuffer * intermediate = FramebufferPool::manager().acquire(framebuffer.width(), framebuffer.height(), framebuffer.descriptor(), "Bilateral blur");
 	_filter->use();
 	GLUtilities::bindTexture(depthTex, 1);
 	GLUtilities::bindTexture(normalTex, 2);
@@ -31,17 +27,14 @@ void BilateralBlur::process(const glm::mat4 & projection, const Texture * textur
 	_filter->uniform("projParams", glm::vec2( projection[2][2], projection[3][2]));
 	framebuffer.setViewport();
 
-	_intermediate->bind();
+	intermediate->bind();
 	_filter->uniform("axis", 0);
 	GLUtilities::bindTexture(texture, 0);
 	ScreenQuad::draw();
 
 	framebuffer.bind();
 	_filter->uniform("axis", 1);
-	GLUtilities::bindTexture(_intermediate->texture(), 0);
+	GLUtilities::bindTexture(intermediate->texture(), 0);
 	ScreenQuad::draw();
-}
-
-void BilateralBlur::resize(unsigned int width, unsigned int height) const {
-	_intermediate->resize(width, height);
+	FramebufferPool::manager().release(intermediate);
 }
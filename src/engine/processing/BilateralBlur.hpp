@@ -31,12 +31,5 @@ public:
 
 private:
 
-	/** Resize the internal intermediate buffers.
-	 \param width the new resolution width
-	 \param height the new resolution height
-	 */
-	void resize(unsigned int width, unsigned int height) const;
-
-	std::unique_ptr<Framebuffer> _intermediate; ///< Intermediate framebuffer.
 	const Program * _filter; ///< Bialteral hader.
 };
@@ -1,6 +1,7 @@
 #include "processing/BoxBlur.hpp"
 #include "graphics/GLUtilities.hpp"
 #include "graphics/ScreenQuad.hpp"
+#include "graphics/FramebufferPool.hpp"
 #include "resources/Library.hpp"
 #include "resources/ResourcesManager.hpp"
 
@@ -17,67 +18,67 @@ BoxBlur::BoxBlur(bool approximate) {
 
 // Draw function
 void BoxBlur::process(const Texture * texture, Framebuffer & framebuffer) {
+	// Process all layers.
+	std::vector<size_t> layers(framebuffer.depth());
+	for(size_t lid = 0; lid < layers.size(); ++lid){
+		layers[lid] = lid;
+	}
+	process(texture, framebuffer, layers);
+}
 
+void BoxBlur::process(const Texture * texture, Framebuffer & framebuffer, const std::vector<size_t> & layers) {
+	if(layers.empty()){
+		return;
+	}
 	GLUtilities::setDepthState(false);
 	GLUtilities::setBlendState(false);
 	GLUtilities::setCullState(true, Faces::BACK);
-	
-	// Detect changes of descriptor.
-	if(!_intermediate || _intermediate->descriptor() != framebuffer.descriptor()){
-		_intermediate.reset(new Framebuffer(framebuffer.width(), framebuffer.height(), framebuffer.descriptor(), false, "Box blur"));
-	}
-	// Detect changes of size.
-	if(_intermediate->width() != framebuffer.width() || _intermediate->height() != framebuffer.height()){
-		resize(framebuffer.width() , framebuffer.height());
-	}
 
-	_intermediate->setViewport();
+	// The intermediate target is only needed during processing.
+	Framebuffer * intermediate = FramebufferPool::manager().acquire(framebuffer.width(), framebuffer.height(), framebuffer.descriptor(), "Box blur");
+	intermediate->setViewport();
+
 	const TextureShape & tgtShape = framebuffer.shape();
 	if(tgtShape == TextureShape::D2){
 		_blur2D->use();
-		_intermediate->bind();
+		intermediate->bind();
 		ScreenQuad::draw(texture);
-		GLUtilities::blit(*_intermediate, framebuffer, Filter::NEAREST);
+		GLUtilities::blit(*intermediate, framebuffer, Filter::NEAREST);
 
 	} else if(tgtShape == TextureShape::Array2D){
 		_blurArray->use();
-		for(size_t lid = 0; lid < framebuffer.depth(); ++lid){
-			_intermediate->bind();
+		for(const size_t lid : layers){
+			intermediate->bind();
 			_blurArray->uniform("layer", int(lid));
 			ScreenQuad::draw(texture);
-			GLUtilities::blit(*_intermediate, framebuffer, 0, lid, Filter::NEAREST);
+			GLUtilities::blit(*intermediate, framebuffer, 0, lid, Filter::NEAREST);
 		}
 	} else if(tgtShape == TextureShape::Cube){
 		_blurCube->use();
 		_blurCube->uniform("invHalfSize", 2.0f/float(texture->width));
-		for(size_t fid = 0; fid < 6; ++fid){
-			_intermediate->bind();
+		for(const size_t fid : layers){
+			intermediate->bind();
 			_blurCube->uniform("up", Library::boxUps[fid]);
 			_blurCube->uniform("right", Library::boxRights[fid]);
 			_blurCube->uniform("center", Library::boxCenters[fid]);
 			ScreenQuad::draw(texture);
-			GLUtilities::blit(*_intermediate, framebuffer, 0, fid, Filter::NEAREST);
+			GLUtilities::blit(*intermediate, framebuffer, 0, fid, Filter::NEAREST);
 		}
 	} else if(tgtShape == TextureShape::ArrayCube){
 		_blurCubeArray->use();
 		_blurCubeArray->uniform("invHalfSize", 2.0f/float(texture->width));
-		for(size_t lid = 0; lid < texture->depth; ++lid){
+		for(const size_t lid : layers){
 			const int fid = int(lid)%6;
-			_intermediate->bind();
+			intermediate->bind();
 			_blurCubeArray->uniform("layer", int(lid)/6);
 			_blurCubeArray->uniform("up", Library::boxUps[fid]);
 			_blurCubeArray->uniform("right", Library::boxRights[fid]);
 			_blurCubeArray->uniform("center", Library::boxCenters[fid]);
 			ScreenQuad::draw(texture);
-			GLUtilities::blit(*_intermediate, framebuffer, 0, lid, Filter::NEAREST);
+			GLUtilities::blit(*intermediate, framebuffer, 0, lid, Filter::NEAREST);
 		}
 	} else {
 		Log::Error() << "Unsupported shape." << std::endl;
 	}
-
-}
-
-// Handle screen resizing
-void BoxBlur::resize(unsigned int width, unsigned int height) const {
-	_intermediate->resize(width, height);
+	FramebufferPool::manager().release(intermediate);
 }
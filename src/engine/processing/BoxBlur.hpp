@@ -6,7 +6,7 @@
 
 /**
  \brief Applies a box blur of fixed radius 2. Correspond to uniformly averaging values over a 5x5 square window.
- \details An approximate (checkboard pattern) version doing half as many fetches is available. his blur can be applied to 2D, cubemap, 2D arrays and cubemap arrays textures.
+ \details An approximate (checkboard pattern) version doing half as many fetches is available. his blur can be applied to 2D, cubemap, 2D arrays and cubemap arrays textures. The intermediate target is acquired from the framebuffer pool for the duration of the processing.
  \ingroup Processing
  */
 class BoxBlur {
@@ -26,18 +26,19 @@ public:
 	 */
 	void process(const Texture * texture, Framebuffer & framebuffer);
 
-private:
-
 	/**
-	  Handle screen resizing if needed.
-	 \param width the new width to use
-	 \param height the new height to use
+	 Apply the blurring process to some layers of a texture, other layers are left untouched.
+	 \note It is possible to use the same texture as input and output.
+	 \param texture the ID of the texture to process
+	 \param framebuffer the destination framebuffer
+	 \param layers the indices of the layers to process (for cubemap arrays, each face is a layer)
 	 */
-	void resize(unsigned int width, unsigned int height) const;
+	void process(const Texture * texture, Framebuffer & framebuffer, const std::vector<size_t> & layers);
+
+private:
 
 	const Program * _blur2D;					///< Box blur program
 	const Program * _blurArray;					///< Box blur program
 	const Program * _blurCube;					///< Box blur program
 	const Program * _blurCubeArray;					///< Box blur program
-	std::unique_ptr<Framebuffer> _intermediate; ///< Intermediate target.
 };
@@ -1,6 +1,7 @@
 #include "processing/ConvolutionPyramid.hpp"
 #include "graphics/ScreenQuad.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "graphics/FramebufferPool.hpp"
 
 ConvolutionPyramid::ConvolutionPyramid(unsigned int width, unsigned int height, unsigned int inoutPadding) :
 	_padding(int(inoutPadding)) {
@@ -11,42 +12,40 @@ ConvolutionPyramid::ConvolutionPyramid(unsigned int width, unsigned int height,
 	_filter	= Resources::manager().getProgram2D("filter");
 	_padder	= Resources::manager().getProgram2D("passthrough-shift");
 
-	// Pre and post process framebuffers.
-	const Descriptor desc = {Layout::RGBA32F, Filter::NEAREST_NEAREST, Wrap::CLAMP};
-	const Descriptor descSrc = {Layout::RGBA32F, Filter::LINEAR_NEAREST, Wrap::CLAMP};
 	// Output is as the basic required size.
+	const Descriptor descSrc = {Layout::RGBA32F, Filter::LINEAR_NEAREST, Wrap::CLAMP};
 	_shifted = std::unique_ptr<Framebuffer>(new Framebuffer(width, height, descSrc, false, "Conv. pyramid shift"));
 	// Resolution of the pyramid takes into account the filter padding.
 	_resolution = glm::ivec2(width + 2 * _padding, height + 2 * _padding);
+}
+
+void ConvolutionPyramid::process(const Texture * texture) {
+	GLUtilities::setDepthState(false);
+	GLUtilities::setBlendState(false);
+	GLUtilities::setCullState(true, Faces::BACK);
 
-	// Create a series of framebuffers smaller and smaller.
-	const int depth = int(std::ceil(std::log2(std::min(_resolution[0], _resolution[1]))));
-	_levelsIn		= std::vector<std::unique_ptr<Framebuffer>>(depth);
-	_levelsOut		= std::vector<std::unique_ptr<Framebuffer>>(depth);
+	// Acquire a series of framebuffers smaller and smaller, only needed during processing.
+	const Descriptor desc = {Layout::RGBA32F, Filter::NEAREST_NEAREST, Wrap::CLAMP};
+	const int depth = std::max(int(std::ceil(std::log2(std::min(_resolution[0], _resolution[1])))), 1);
+	std::vector<Framebuffer *> levelsIn(depth);
+	std::vector<Framebuffer *> levelsOut(depth);
 	// Initial padded size.
 	int levelWidth  = _resolution[0] + 2 * _size;
 	int levelHeight = _resolution[1] + 2 * _size;
-	// Generate framebuffer pyramids.
 	for(size_t i = 0; i < size_t(depth); ++i) {
-		_levelsIn[i]  = std::unique_ptr<Framebuffer>(new Framebuffer(levelWidth, levelHeight, desc, false, "Conv. pyramid in " + std::to_string(i)));
-		_levelsOut[i] = std::unique_ptr<Framebuffer>(new Framebuffer(levelWidth, levelHeight, desc, false, "Conv. pyramid out " + std::to_string(i)));
+		levelsIn[i]  = FramebufferPool::manager().acquire(uint(levelWidth), uint(levelHeight), desc, "Conv. pyramid in " + std::to_string(i));
+		levelsOut[i] = FramebufferPool::manager().acquire(uint(levelWidth), uint(levelHeight), desc, "Conv. pyramid out " + std::to_string(i));
 		// Downscaling and padding.
 		levelWidth /= 2;
 		levelHeight /= 2;
 		levelWidth += 2 * _size;
 		levelHeight += 2 * _size;
 	}
-}
 
-void ConvolutionPyramid::process(const Texture * texture) {
-	GLUtilities::setDepthState(false);
-	GLUtilities::setBlendState(false);
-	GLUtilities::setCullState(true, Faces::BACK);
-	
 	// Pad by the size of the filter.
-	_levelsIn[0]->bind();
+	levelsIn[0]->bind();
 	// Shift the viewport and fill the padded region with 0s.
-	GLUtilities::setViewport(_size, _size, int(_levelsIn[0]->width()) - 2 * _size, int(_levelsIn[0]->height()) - 2 * _size);
+	GLUtilities::setViewport(_size, _size, int(levelsIn[0]->width()) - 2 * _size, int(levelsIn[0]->height()) - 2 * _size);
 	GLUtilities::clearColor(glm::vec4(0.0f));
 	// Transfer the boundary content.
 	_padder->use();
@@ -60,13 +59,13 @@ void ConvolutionPyramid::process(const Texture * texture) {
 	_downscale->uniform("h1[0]", 5, &_h1[0]);
 
 	// Do: l[i] = downscale(filter(l[i-1], h1))
-	for(size_t i = 1; i < _levelsIn.size(); ++i) {
-		_levelsIn[i]->bind();
+	for(size_t i = 1; i < levelsIn.size(); ++i) {
+		levelsIn[i]->bind();
 		// Shift the viewport and fill the padded region with 0s.
 		GLUtilities::clearColor(glm::vec4(0.0f));
-		GLUtilities::setViewport(_size, _size, int(_levelsIn[i]->width()) - 2 * _size, int(_levelsIn[i]->height()) - 2 * _size);
+		GLUtilities::setViewport(_size, _size, int(levelsIn[i]->width()) - 2 * _size, int(levelsIn[i]->height()) - 2 * _size);
 		// Filter and downscale.
-		ScreenQuad::draw(_levelsIn[i - 1]->texture());
+		ScreenQuad::draw(levelsIn[i - 1]->texture());
 	}
 
 	// Filter the last level with g.
@@ -74,10 +73,10 @@ void ConvolutionPyramid::process(const Texture * texture) {
 	_filter->use();
 	_filter->uniform("g[0]", 3, &_g[0]);
 	// Do:  f[end] = filter(l[end], g)
-	const auto & lastLevel = _levelsOut.back();
+	const auto & lastLevel = levelsOut.back();
 	lastLevel->bind();
 	lastLevel->setViewport();
-	ScreenQuad::draw(_levelsIn.back()->texture());
+	ScreenQuad::draw(levelsIn.back()->texture());
 
 	// Flatten the pyramid from the bottom, combining the filtered current result and the next level.
 	_upscale->use();
@@ -86,11 +85,11 @@ void ConvolutionPyramid::process(const Texture * texture) {
 	_upscale->uniform("h2", _h2);
 
 	// Do: f[i] = filter(l[i], g) + filter(upscale(f[i+1], h2)
-	for(int i = int(_levelsOut.size() - 2); i >= 0; --i) {
-		_levelsOut[i]->bind();
-		_levelsOut[i]->setViewport();
+	for(int i = int(levelsOut.size() - 2); i >= 0; --i) {
+		levelsOut[i]->bind();
+		levelsOut[i]->setViewport();
 		// Upscale with zeros, filter and combine.
-		ScreenQuad::draw({_levelsIn[i]->texture(), _levelsOut[i + 1]->texture()});
+		ScreenQuad::draw({levelsIn[i]->texture(), levelsOut[i + 1]->texture()});
 	}
 
 	// Compensate the initial padding.
@@ -99,7 +98,12 @@ void ConvolutionPyramid::process(const Texture * texture) {
 	_padder->use();
 	// Need to also compensate for the potential extra padding.
 	_padder->uniform("padding", -_size - _padding);
-	ScreenQuad::draw(_levelsOut[0]->texture());
+	ScreenQuad::draw(levelsOut[0]->texture());
+
+	for(size_t i = 0; i < size_t(depth); ++i) {
+		FramebufferPool::manager().release(levelsIn[i]);
+		FramebufferPool::manager().release(levelsOut[i]);
+	}
 }
 
 void ConvolutionPyramid::setFilters(const float h1[5], float h2, const float g[3]) {
@@ -117,32 +121,6 @@ void ConvolutionPyramid::setFilters(const float h1[5], float h2, const float g[3
 void ConvolutionPyramid::resize(unsigned int width, unsigned int height) {
 	_shifted->resize(width, height);
 	// Resolution of the pyramid takes into account the filter padding.
+	// The pyramid levels will be acquired at the new size.
 	_resolution = glm::ivec2(width + 2 * _padding, height + 2 * _padding);
-
-	const int currentDepth = int(_levelsIn.size());
-
-	const int newDepth = std::max(int(std::ceil(std::log2(std::min(_resolution[0], _resolution[1])))), 1);
-	// Create a series of framebuffers smaller and smaller.
-	const Descriptor desc = {Layout::RGBA32F, Filter::NEAREST_NEAREST, Wrap::CLAMP};
-	_levelsIn.resize(newDepth);
-	_levelsOut.resize(newDepth);
-	// Initial padded size.
-	int levelWidth  = _resolution[0] + 2 * _size;
-	int levelHeight = _resolution[1] + 2 * _size;
-
-	// Generate framebuffer pyramids.
-	for(int i = 0; i < newDepth; ++i) {
-		if(i < currentDepth) {
-			_levelsIn[i]->resize(levelWidth, levelHeight);
-			_levelsOut[i]->resize(levelWidth, levelHeight);
-		} else {
-			_levelsIn[i]  = std::unique_ptr<Framebuffer>(new Framebuffer(levelWidth, levelHeight, desc, false, "Conv. pyramid in " + std::to_string(i)));
-			_levelsOut[i] = std::unique_ptr<Framebuffer>(new Framebuffer(levelWidth, levelHeight, desc, false, "Conv. pyramid out " + std::to_string(i)));
-		}
-		// Downscaling and padding.
-		levelWidth /= 2;
-		levelHeight /= 2;
-		levelWidth += 2 * _size;
-		levelHeight += 2 * _size;
-	}
 }
@@ -8,6 +8,7 @@
  This is the basis of the technique described in Convolution Pyramids, Farbman et al., 2011.
  A set of filter parameters can be estimated through an offline optimization for each desired task:
  gradient field integration, seamless image cloning, background filling, or scattered data interpolation.
+ The pyramid levels are acquired from the framebuffer pool for the duration of the processing.
  \ingroup Processing
  */
 class ConvolutionPyramid {
@@ -62,8 +63,6 @@ private:
 	const Program * _padder;	///< Padding helper shader.
 
 	std::unique_ptr<Framebuffer> _shifted;				  ///< Contains the input data padded to the right size.
-	std::vector<std::unique_ptr<Framebuffer>> _levelsIn;  ///< The initial levels of the pyramid.
-	std::vector<std::unique_ptr<Framebuffer>> _levelsOut; ///< The filtered levels of the pyramid.
 
 	float _h1[5] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f}; ///< h1 filter coefficients.
 	float _h2	= 0.0f;						   ///< h2 filter multiplier.
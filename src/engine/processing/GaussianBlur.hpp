@@ -9,7 +9,7 @@
  \details Use a downscaled pyramid approach to approximate a gaussian blur with a large radius. 
  The input texture is downscaled a number of times, using a custom filter as described by Marius Bjørge in the 'Bandwidth-Efficient Rendering' presentation, Siggraph 2015
  (https://community.arm.com/cfs-file/__key/communityserver-blogs-components-weblogfiles/00-00-00-20-66/siggraph2015_2D00_mmg_2D00_marius_2D00_slides.pdf).
- The image is then upscaled again with a second custom filter.
+ The image is then upscaled again with a second custom filter. The pyramid levels are acquired from the framebuffer pool for the duration of the processing.
  
  \see GPU::Frag::Blur-dual-filter-down, GPU::Frag::Blur-dual-filter-up
  \ingroup Processing
@@ -34,16 +34,9 @@ public:
 
 private:
 
-	/**
-	  Handle screen resizing if needed.
-	 \param width the new width to use
-	 \param height the new height to use
-	 */
-	void resize(unsigned int width, unsigned int height);
-
 	const Program * _blurProgramDown;						 ///< The downscaling filter.
 	const Program * _blurProgramUp;							 ///< The upscaling filter.
 	const Program * _passthrough;							 ///< The copy program.
-	std::vector<std::unique_ptr<Framebuffer>> _frameBuffers; ///< Downscaled pyramid framebuffers.
+	uint _levels = 0;										 ///< Number of levels in the downscaled pyramid.
 	uint _downscale = 1;									 ///< Initial downscaling factor.
 };
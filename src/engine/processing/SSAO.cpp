@@ -3,13 +3,13 @@
 #include "graphics/GPUObjects.hpp"
 #include "graphics/GLUtilities.hpp"
 #include "graphics/ScreenQuad.hpp"
+#include "graphics/FramebufferPool.hpp"
 #include "resources/ResourcesManager.hpp"
 
 SSAO::SSAO(uint width, uint height, uint downscale, float radius) : _mediumBlur(true),
 	_samples(16, BufferType::UNIFORM, DataUse::STATIC), _radius(radius), _downscale(downscale) {
 
 	const Descriptor desc = Descriptor(Layout::R8, Filter::LINEAR_NEAREST, Wrap::CLAMP);
-	_ssaoFramebuffer.reset(new Framebuffer(width/_downscale, height/_downscale, desc, false, "SSAO"));
 	_finalFramebuffer.reset(new Framebuffer(width, height, desc, false, "SSAO final"));
 	_programSSAO = Resources::manager().getProgram2D("ssao");
 
@@ -66,8 +66,12 @@ void SSAO::process(const glm::mat4 & projection, const Texture * depthTex, const
 	GLUtilities::setBlendState(false);
 	GLUtilities::setCullState(true, Faces::BACK);
 
-	_ssaoFramebuffer->bind();
-	_ssaoFramebuffer->setViewport();
+	// The raw result is only needed until blurred.
+	const uint width = _finalFramebuffer->width() / _downscale;
+	const uint height = _finalFramebuffer->height() / _downscale;
+	Framebuffer * ssaoFramebuffer = FramebufferPool::manager().acquire(width, height, _finalFramebuffer->descriptor(), "SSAO");
+	ssaoFramebuffer->bind();
+	ssaoFramebuffer->setViewport();
 	_programSSAO->use();
 	_programSSAO->uniform("projectionMatrix", projection);
 	_programSSAO->uniform("radius", _radius);
@@ -76,14 +80,15 @@ void SSAO::process(const glm::mat4 & projection, const Texture * depthTex, const
 
 	// Blurring pass
 	if(_quality == Quality::HIGH){
-		_highBlur.process(projection, _ssaoFramebuffer->texture(), depthTex, normalTex, *_finalFramebuffer);
+		_highBlur.process(projection, ssaoFramebuffer->texture(), depthTex, normalTex, *_finalFramebuffer);
 	} else if(_quality == Quality::MEDIUM){
 		// Render at potentially low res.
-		_mediumBlur.process(_ssaoFramebuffer->texture(), *_ssaoFramebuffer);
-		GLUtilities::blit(*_ssaoFramebuffer, *_finalFramebuffer, Filter::LINEAR);
+		_mediumBlur.process(ssaoFramebuffer->texture(), *ssaoFramebuffer);
+		GLUtilities::blit(*ssaoFramebuffer, *_finalFramebuffer, Filter::LINEAR);
 	} else {
-		GLUtilities::blit(*_ssaoFramebuffer, *_finalFramebuffer, Filter::LINEAR);
+		GLUtilities::blit(*ssaoFramebuffer, *_finalFramebuffer, Filter::LINEAR);
 	}
+	FramebufferPool::manager().release(ssaoFramebuffer);
 }
 
 void SSAO::clear() const {
@@ -92,9 +97,8 @@ void SSAO::clear() const {
 
 // Handle screen resizing
 void SSAO::resize(uint width, uint height) const {
-	_ssaoFramebuffer->resize(width/_downscale, height/_downscale);
 	_finalFramebuffer->resize(width, height);
-	// The blurs resize automatically.
+	// The intermediate targets and the blurs adapt automatically.
 }
 
 const Texture * SSAO::texture() const {
@@ -71,7 +71,6 @@ public:
 	Quality & quality();
 
 private:
-	std::unique_ptr<Framebuffer> _ssaoFramebuffer;  ///< SSAO framebuffer
 	std::unique_ptr<Framebuffer> _finalFramebuffer; ///< SSAO framebuffer
 	BilateralBlur _highBlur;	  					///< High quality blur.
 	BoxBlur _mediumBlur;							///< Medium quality blur.
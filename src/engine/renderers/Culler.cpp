@@ -1,10 +1,10 @@
 #include "renderers/Culler.hpp"
 #include "resources/Bounds.hpp"
 
-Culler::Culler(const std::vector<Object> & objects) : _objects(objects), _frustum(glm::mat4(1.0f)) {
-	_order.resize(objects.size(), -1);
-	_distances.resize(objects.size());
-	_maxCount = (unsigned long)(objects.size());
+Culler::Culler(const Scene & scene) : _objects(scene.objectsData()), _frustum(glm::mat4(1.0f)) {
+	_order.resize(_objects.size(), -1);
+	_distances.resize(_objects.size());
+	_maxCount = (unsigned long)(_objects.size());
 }
 
 const Culler::List & Culler::cull(const glm::mat4 & view, const glm::mat4 & proj){
@@ -25,7 +25,7 @@ const Culler::List & Culler::cull(const glm::mat4 & view, const glm::mat4 & proj
 	const size_t allowedCount = std::min(objCount, size_t(_maxCount));
 	for(size_t oid = 0; oid < allowedCount; ++oid){
 		// If the object falls inside the frustum, store its index in the result list.
-		if(_frustum.intersects(_objects[oid].boundingBox())){
+		if(_frustum.intersects(_objects.boxes[oid])){
 			_order[cid] = long(oid);
 			++cid;
 		}
@@ -68,23 +68,38 @@ const Culler::List & Culler::cullAndSort(const glm::mat4 & view, const glm::mat4
 		{ Object::Transparent, 	2 },
 	};
 
-	// Culling and distance computation.
+	// Frustum culling.
 	size_t cid = 0;
 	for(size_t oid = 0; oid < objCount; ++oid){
-		// If the object falls inside the frustum, compute its distance.
-		const BoundingBox & bbox = _objects[oid].boundingBox();
-		if(_frustum.intersects(bbox)){
-			_distances[cid].id = long(oid);
+		if(_frustum.intersects(_objects.boxes[oid])){
+			_order[cid] = long(oid);
+			++cid;
+		}
+	}
+	if(cid < objCount){
+		_order[cid] = -1;
+	}
+
+	// Occlusion culling, using the frustum visible objects as potential occluders.
+	if(_occlusionCulling){
+		if(!_freezeFrustum){
+			_occlusion.render(_objects, _order, cid, proj * view, pos);
+		}
+		cid = _occlusion.filter(_objects, _order, cid);
+	}
 
-			const Object::Type & type = _objects[oid].type();
-			const double sign = orders.at(type) == Ordering::FRONT_TO_BACK ? 1.0 : -1.0;
-			const glm::vec3 dist = pos - bbox.getCentroid();
+	// Distance computation.
+	for(size_t ocid = 0; ocid < cid; ++ocid){
+		const long oid = _order[ocid];
+		const BoundingBox & bbox = _objects.boxes[oid];
+		_distances[ocid].id = oid;
 
-			_distances[cid].distance = sign * double(glm::dot(dist, dist));
-			_distances[cid].material = sets.at(type);
+		const Object::Type & type = _objects.types[oid];
+		const double sign = orders.at(type) == Ordering::FRONT_TO_BACK ? 1.0 : -1.0;
+		const glm::vec3 dist = pos - bbox.getCentroid();
 
-			++cid;
-		}
+		_distances[ocid].distance = sign * double(glm::dot(dist, dist));
+		_distances[ocid].material = sets.at(type);
 	}
 	// Sort wrt distances.
 	std::sort(_distances.begin(), _distances.begin() + cid, [](const DistPair & a, const DistPair & b){
@@ -119,4 +134,11 @@ void Culler::interface(){
 	const unsigned long step = 1, stepFast = 100;
 	ImGui::InputScalar("Max objects", ImGuiDataType_U64, (void*)&_maxCount, (void*)(&step), (void*)(&stepFast), "%u", 0);
 
+	ImGui::Checkbox("Occlusion culling", &_occlusionCulling);
+	if(_occlusionCulling){
+		const OcclusionCuller::Statistics & stats = _occlusion.statistics();
+		ImGui::Text("Occluders: %lu (%lu triangles), culled: %lu/%lu", stats.occluders, stats.triangles, stats.culled, stats.tested);
+		ImGui::Text("Raster: %.3fms, tests: %.3fms", stats.rasterTime, stats.testTime);
+	}
+
 }
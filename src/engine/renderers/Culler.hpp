@@ -1,11 +1,12 @@
 #pragma once
 
 #include "Common.hpp"
-#include "scene/Object.hpp"
+#include "scene/Scene.hpp"
+#include "renderers/OcclusionCuller.hpp"
 
 /**
  \brief Select and sort objects based on visibility and distance criteria.
- \details This can be used to limit the number of objects drawn based on if they fall inside a camera frustum. Their ordering can also be optimized, for instance to maximize depth rejection or ensure transparent objects are rendered back to front.
+ \details This can be used to limit the number of objects drawn based on if they fall inside a camera frustum, and optionally if they are hidden behind large occluders (see OcclusionCuller). Their ordering can also be optimized, for instance to maximize depth rejection or ensure transparent objects are rendered back to front. Only the scene contiguous objects data is traversed.
  \ingroup Renderers
  */
 class Culler {
@@ -15,9 +16,9 @@ public:
 	using List = std::vector<long>; ///< Indices of selected objects.
 
 	/** Constructor
-	 \param objects the list of objects to process
+	 \param scene the scene containing the objects to process
 	 */
-	Culler(const std::vector<Object> & objects);
+	Culler(const Scene & scene);
 
 	/** Detect objects that are inside the view frustum. This returns the indices of the objects that are visible in a list padded to the objects count with -1s.
 	 \param view the view matrix
@@ -27,7 +28,7 @@ public:
 	 */
 	const List & cull(const glm::mat4 & view, const glm::mat4 & proj);
 
-	/** Detect objects that are inside the view frustum and sort them based on their type. This returns the object indices in a list padded to the objects count with -1s.
+	/** Detect objects that are inside the view frustum and not occluded, and sort them based on their type. This returns the object indices in a list padded to the objects count with -1s.
 	 \param view the view matrix
 	 \param proj the projection matrix
 	 \param pos the camera position in world space
@@ -63,7 +64,7 @@ private:
 		BACK_TO_FRONT  ///< Furthest first.
 	};
 
-	const std::vector<Object> & _objects; ///< Reference to the objects to process.
+	const Scene::ObjectsData & _objects; ///< Reference to the objects data to process.
 	List _order; ///< Will contain the indices of the objects selected.
 
 	/** Information for object sorting. */
@@ -78,4 +79,7 @@ private:
 	unsigned long _maxCount; ///< Maximum number of objects to select
 	bool _freezeFrustum = false; ///< Should the frustum not be updated.
 
+	OcclusionCuller _occlusion; ///< CPU occlusion culling.
+	bool _occlusionCulling = false; ///< Should occluded objects be removed when sorting.
+
 };
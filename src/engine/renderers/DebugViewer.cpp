@@ -1,6 +1,8 @@
 #include "DebugViewer.hpp"
 #include "graphics/GLUtilities.hpp"
 #include "graphics/Framebuffer.hpp"
+#include "graphics/FramebufferPool.hpp"
+#include "graphics/Profiler.hpp"
 #include "resources/Texture.hpp"
 #include "resources/Mesh.hpp"
 #include "graphics/ScreenQuad.hpp"
@@ -27,6 +29,13 @@ DebugViewer::DebugViewer(bool silent) : _silent(silent) {
 	}
 }
 
+DebugViewer::~DebugViewer() {
+	// Objects released later (pooled framebuffers for instance) shouldn't reach a deleted viewer.
+	if(_shared == this) {
+		_shared = nullptr;
+	}
+}
+
 void DebugViewer::track(const Texture * tex) {
 	if(_silent || tex->name() == debugSkipName) {
 		return;
@@ -236,6 +245,8 @@ void DebugViewer::interface() {
 			}
 			ImGui::EndMenu();
 		}
+		ImGui::MenuItem("Profiler", nullptr, &_showProfiler);
+		ImGui::MenuItem("Resources", nullptr, &_showResources);
 		ImGui::EndMainMenuBar();
 	}
 
@@ -267,6 +278,16 @@ void DebugViewer::interface() {
 		displayState(infos.first, infos.second);
 	}
 
+	if(_showProfiler){
+		if(ImGui::Begin("Profiler##DEBUGVIEWER", &_showProfiler)){
+			Profiler::manager().interface();
+		}
+		ImGui::End();
+	}
+	if(_showResources){
+		displayResources();
+	}
+
 	// Display raw metrics.
 	displayMetrics();
 }
@@ -278,6 +299,7 @@ void DebugViewer::displayMetrics(){
 		ImGui::Text("Clear & blits: %lu", metrics.clearAndBlits);
 		ImGui::Text("Screen quads: %lu", metrics.quadCalls);
 		ImGui::Text("Draw calls: %lu", metrics.drawCalls);
+		ImGui::Text("Triangles: %lu", metrics.triangles);
 		ImGui::Text("VAO bindings: %lu", metrics.textureBindings);
 		ImGui::Text("Texture bindings: %lu", metrics.textureBindings);
 		ImGui::Text("Framebuffer bindings: %lu", metrics.framebufferBindings);
@@ -286,6 +308,72 @@ void DebugViewer::displayMetrics(){
 		ImGui::Text("Uniforms: %lu", metrics.uniforms);
 		ImGui::Text("Uploads: %lu", metrics.uploads);
 		ImGui::Text("Downloads: %lu", metrics.downloads);
+		const FramebufferPool & pool = FramebufferPool::manager();
+		const float mb = 1.0f / 1048576.0f;
+		ImGui::Text("Framebuffers: %.1fMB (peak %.1fMB)", float(Framebuffer::allocatedMemory()) * mb, float(Framebuffer::peakMemory()) * mb);
+		ImGui::Text("Transient: %.1fMB in %lu", float(pool.memory()) * mb, (unsigned long)(pool.count()));
+	}
+	ImGui::End();
+}
+
+void DebugViewer::displayResources(){
+	Resources & resources = Resources::manager();
+	std::vector<Resources::MemoryInfos> meshes;
+	std::vector<Resources::MemoryInfos> textures;
+	resources.memoryUsage(meshes, textures);
+
+	const float mb = 1.0f / 1048576.0f;
+	ImGui::SetNextWindowSize(ImVec2(420, 400), ImGuiCond_Once);
+	if(ImGui::Begin("Resources##DEBUGVIEWER", &_showResources)){
+		size_t cpu = 0;
+		size_t gpu = 0;
+		for(const auto & infos : meshes) {
+			cpu += infos.cpu;
+			gpu += infos.gpu;
+		}
+		for(const auto & infos : textures) {
+			cpu += infos.cpu;
+			gpu += infos.gpu;
+		}
+		ImGui::Text("CPU: %.1fMB, GPU: %.1fMB", float(cpu) * mb, float(gpu) * mb);
+		ImGui::Text("Evictions: %lu, restorations: %lu", (unsigned long)(resources.evictions()), (unsigned long)(resources.restorations()));
+		int budget = int(resources.budget() / 1048576);
+		ImGui::PushItemWidth(120);
+		if(ImGui::InputInt("GPU budget (MB)", &budget, 16, 128, ImGuiInputTextFlags_EnterReturnsTrue)) {
+			resources.setBudget(size_t(std::max(budget, 0)) * 1048576);
+		}
+		ImGui::PopItemWidth();
+
+		const std::vector<std::pair<std::string, const std::vector<Resources::MemoryInfos> *>> lists = {{"Meshes", &meshes}, {"Textures", &textures}};
+		for(const auto & list : lists) {
+			if(!ImGui::CollapsingHeader(list.first.c_str())) {
+				continue;
+			}
+			ImGui::Columns(4);
+			ImGui::Text("Name");
+			ImGui::NextColumn();
+			ImGui::Text("Refs");
+			ImGui::NextColumn();
+			ImGui::Text("CPU (kB)");
+			ImGui::NextColumn();
+			ImGui::Text("GPU (kB)");
+			ImGui::NextColumn();
+			for(const auto & infos : *list.second) {
+				ImGui::Text("%s", infos.name.c_str());
+				ImGui::NextColumn();
+				ImGui::Text("%u", infos.references);
+				ImGui::NextColumn();
+				ImGui::Text("%lu", (unsigned long)(infos.cpu / 1024));
+				ImGui::NextColumn();
+				if(infos.evicted) {
+					ImGui::TextDisabled("evicted");
+				} else {
+					ImGui::Text("%lu", (unsigned long)(infos.gpu / 1024));
+				}
+				ImGui::NextColumn();
+			}
+			ImGui::Columns(1);
+		}
 	}
 	ImGui::End();
 }
@@ -401,7 +489,7 @@ void DebugViewer::displayState(const std::string & name, StateInfos & infos){
 
 void DebugViewer::displayMesh(MeshInfos & mesh) {
 
-	ImGui::SetNextWindowSize(ImVec2(280, 130), ImGuiCond_Once);
+	ImGui::SetNextWindowSize(ImVec2(280, 150), ImGuiCond_Once);
 	const std::string finalWinName = "Mesh - " + mesh.name;
 
 	if(ImGui::Begin(finalWinName.c_str(), &mesh.visible)) {
@@ -420,6 +508,12 @@ void DebugViewer::displayMesh(MeshInfos & mesh) {
 		ImGui::NextColumn();
 		ImGui::Text("Indices: %lu", mesh.mesh->indices.size());
 		ImGui::Columns(0);
+		// The GPU data might have been evicted since the mesh was tracked.
+		if(mesh.mesh->gpu){
+			ImGui::Text("GPU: vertices %lu B, indices %lu B", (unsigned long)(mesh.mesh->gpu->vertexBytes), (unsigned long)(mesh.mesh->gpu->indexBytes));
+		} else {
+			ImGui::Text("GPU: evicted");
+		}
 		const auto & bbox = mesh.mesh->bbox;
 		if(!bbox.empty()){
 			ImGui::Text("Bbox: min: %.3f, %.3f, %.3f", bbox.minis[0], bbox.minis[1], bbox.minis[2]);
@@ -58,8 +58,8 @@ public:
 	/** Display interface and monitored data. */
 	void interface();
 
-	/** Destructor */
-	~DebugViewer() = default;
+	/** Destructor, unregisters the viewer if it is the default one. */
+	~DebugViewer();
 
 	/** Copy constructor.*/
 	DebugViewer(const DebugViewer &) = delete;
@@ -164,6 +164,10 @@ private:
 	 */
 	void displayMetrics();
 
+	/** Display the memory usage and GPU residency of loaded meshes and textures in a panel.
+	 */
+	void displayResources();
+
 	/** Display GPU state in a panel.
 	 \param name name of the state
 	 \param infos the state to display
@@ -200,6 +204,8 @@ private:
 
 	const Program * _texDisplay; ///< Texture display shader.
 	const bool _silent; ///< Don't register or display anything.
+	bool _showProfiler = false; ///< Is the profiler window visible.
+	bool _showResources = false; ///< Is the resources window visible.
 	uint _textureId = 0; ///< Default texture name counter.
 	uint _bufferId	= 0; ///< Default framebuffer name counter.
 	uint _meshId    = 0; ///< Default mesh name counter.
@@ -0,0 +1,38 @@
+#include "renderers/LodSelector.hpp"
+
+void LodSelector::setView(const glm::mat4 & viewProj, float height) {
+	_depthRow = glm::vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+	// Vertical scaling from world space to clip space.
+	const glm::vec3 verticalRow(viewProj[0][1], viewProj[1][1], viewProj[2][1]);
+	_pixelScale = 0.5f * height * glm::length(verticalRow);
+}
+
+uint LodSelector::select(const Mesh & mesh, const glm::mat4 & model) const {
+	if(!enabled || mesh.levelCount() == 1) {
+		return 0;
+	}
+	// World space size of the mesh, assuming a uniform scaling.
+	const float scale = std::max(std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1]))), glm::length(glm::vec3(model[2])));
+	const float extent = scale * glm::length(mesh.bbox.getSize());
+	const glm::vec3 center = glm::vec3(model * glm::vec4(mesh.bbox.getCentroid(), 1.0f));
+	// Clip space w of the closest point of the bounding sphere.
+	const float w = glm::dot(_depthRow, glm::vec4(center, 1.0f)) - 0.5f * extent * glm::length(glm::vec3(_depthRow));
+	if(w <= 1e-4f || extent <= 0.0f) {
+		return 0;
+	}
+	// Maximum relative error so that the projected error stays below the threshold.
+	const float pixelsPerUnit = _pixelScale / w;
+	return mesh.selectLevel(threshold * bias / (pixelsPerUnit * extent));
+}
+
+void LodSelector::interface(const std::string & name) {
+	ImGui::PushID(this);
+	ImGui::Checkbox(name.c_str(), &enabled);
+	if(enabled) {
+		ImGui::SameLine();
+		ImGui::PushItemWidth(100);
+		ImGui::SliderFloat("Max error (px)", &threshold, 0.1f, 16.0f, "%.1f", 2.0f);
+		ImGui::PopItemWidth();
+	}
+	ImGui::PopID();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "resources/Mesh.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Select the level of detail of meshes based on the size of their error once projected on screen.
+ \details The projected size is estimated at the point of the mesh bounding sphere closest to the viewer, so that large objects close to the camera always use the full resolution mesh. Both perspective and orthographic projections are supported.
+ \ingroup Renderers
+ */
+class LodSelector {
+
+public:
+
+	/** Set the current view.
+	 \param viewProj the view projection matrix
+	 \param height the viewport height in pixels
+	 */
+	void setView(const glm::mat4 & viewProj, float height);
+
+	/** Select the level of detail of a mesh for the current view.
+	 \param mesh the mesh to draw
+	 \param model the mesh model matrix
+	 \return the level to draw
+	 */
+	uint select(const Mesh & mesh, const glm::mat4 & model) const;
+
+	/** Display options GUI.
+	 \param name the name displayed for the options
+	 */
+	void interface(const std::string & name);
+
+	bool enabled = true; ///< Should simplified levels be used.
+	float threshold = 1.0f; ///< Maximum error on screen, in pixels.
+	float bias = 1.0f; ///< Scaling applied to the threshold, larger values select coarser levels.
+
+private:
+
+	glm::vec4 _depthRow = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); ///< Row of the view projection matrix giving the clip space w.
+	float _pixelScale = 1.0f; ///< Size in pixels of a unit length at unit w.
+};
@@ -0,0 +1,318 @@
+#include "renderers/OcclusionCuller.hpp"
+#include "resources/Mesh.hpp"
+#include "system/System.hpp"
+#include "system/Query.hpp"
+
+OcclusionCuller::OcclusionCuller(const glm::uvec2 & resolution) : _resolution(glm::max(resolution, glm::uvec2(1))) {
+	// Allocate the depth buffer and all pyramid levels down to a single texel.
+	glm::uvec2 size = _resolution;
+	while(true) {
+		_sizes.push_back(size);
+		_levels.emplace_back(size_t(size.x) * size.y, 1.0f);
+		if(size.x == 1 && size.y == 1) {
+			break;
+		}
+		size = glm::max((size + 1u) / 2u, glm::uvec2(1));
+	}
+	_bins.resize((_resolution.y + bandHeight - 1) / bandHeight);
+}
+
+void OcclusionCuller::render(const Scene::ObjectsData & objects, const std::vector<long> & candidates, size_t count, const glm::mat4 & viewProj, const glm::vec3 & pos) {
+	Query timer;
+	timer.begin();
+	_stats = Statistics();
+	_viewProj = viewProj;
+	std::fill(_levels[0].begin(), _levels[0].end(), 1.0f);
+
+	// Select large opaque objects close to the viewer, with geometry available.
+	_occluders.clear();
+	for(size_t cid = 0; cid < count; ++cid) {
+		const long oid = candidates[cid];
+		if(oid < 0) {
+			break;
+		}
+		const Object::Type type = objects.types[oid];
+		if(type == Object::Transparent || type == Object::None || (objects.flags[oid] & Scene::ObjectsData::MASKED)) {
+			continue;
+		}
+		const Mesh * mesh = objects.meshes[oid];
+		if(!mesh || mesh->positions.empty() || mesh->indices.empty()) {
+			continue;
+		}
+		const BoundingBox & box = objects.boxes[oid];
+		const float radius = 0.5f * glm::length(box.getSize());
+		const float distance = std::max(glm::distance(box.getCentroid(), pos), 1e-4f);
+		const float size = radius / distance;
+		if(size >= minOccluderSize) {
+			_occluders.emplace_back(size, size_t(oid));
+		}
+	}
+	std::sort(_occluders.begin(), _occluders.end(), [](const std::pair<float, size_t> & a, const std::pair<float, size_t> & b) {
+		return a.first > b.first;
+	});
+
+	// Keep the largest ones that fit in the triangle budget.
+	size_t budget = maxTriangles;
+	size_t selected = 0;
+	for(size_t id = 0; id < _occluders.size() && selected < maxOccluders; ++id) {
+		const size_t triCount = objects.meshes[_occluders[id].second]->indices.size() / 3;
+		if(triCount > budget) {
+			continue;
+		}
+		budget -= triCount;
+		_occluders[selected++] = _occluders[id];
+	}
+	_occluders.resize(selected);
+
+	// Transform occluders in parallel.
+	if(_triangles.size() < selected) {
+		_triangles.resize(selected);
+	}
+	System::forParallel(0, selected, [this, &objects, &viewProj](size_t id) {
+		_triangles[id].clear();
+		setupTriangles(objects, _occluders[id].second, viewProj, _triangles[id]);
+	});
+
+	// Bin triangles in horizontal bands.
+	for(auto & bin : _bins) {
+		bin.clear();
+	}
+	for(size_t id = 0; id < selected; ++id) {
+		for(const Triangle & tri : _triangles[id]) {
+			for(int band = tri.bounds.y / int(bandHeight); band <= tri.bounds.w / int(bandHeight); ++band) {
+				_bins[band].push_back(&tri);
+			}
+		}
+		_stats.triangles += (unsigned long)(_triangles[id].size());
+	}
+	_stats.occluders = (unsigned long)(selected);
+
+	// Rasterize each band independently.
+	if(_stats.triangles != 0) {
+		System::forParallel(0, _bins.size(), [this](size_t band) {
+			rasterizeBand(band);
+		});
+	}
+	buildHierarchy();
+
+	timer.end();
+	_stats.rasterTime = double(timer.value()) / 1000000.0;
+}
+
+size_t OcclusionCuller::filter(const Scene::ObjectsData & objects, std::vector<long> & ids, size_t count) {
+	if(!active()) {
+		return count;
+	}
+	Query timer;
+	timer.begin();
+	size_t kept = 0;
+	for(size_t cid = 0; cid < count; ++cid) {
+		const long oid = ids[cid];
+		if(visible(objects.boxes[oid])) {
+			ids[kept] = oid;
+			++kept;
+		}
+	}
+	timer.end();
+	_stats.tested = (unsigned long)(count);
+	_stats.culled = (unsigned long)(count - kept);
+	_stats.testTime = double(timer.value()) / 1000000.0;
+	return kept;
+}
+
+bool OcclusionCuller::visible(const BoundingBox & box) const {
+	const glm::vec2 res(_resolution);
+	glm::vec2 minScreen(std::numeric_limits<float>::max());
+	glm::vec2 maxScreen(std::numeric_limits<float>::lowest());
+	float minDepth = std::numeric_limits<float>::max();
+	for(uint cid = 0; cid < 8; ++cid) {
+		const glm::vec3 corner((cid & 1) ? box.maxis.x : box.minis.x, (cid & 2) ? box.maxis.y : box.minis.y, (cid & 4) ? box.maxis.z : box.minis.z);
+		const glm::vec4 clip = _viewProj * glm::vec4(corner, 1.0f);
+		// Boxes crossing the near plane are always visible.
+		if(clip.w <= 0.0f || clip.z < -clip.w) {
+			return true;
+		}
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		const glm::vec2 screen = (0.5f * glm::vec2(ndc) + 0.5f) * res;
+		minScreen = glm::min(minScreen, screen);
+		maxScreen = glm::max(maxScreen, screen);
+		minDepth = std::min(minDepth, 0.5f * ndc.z + 0.5f);
+	}
+
+	// Pixels touched by the screen space rectangle.
+	const glm::ivec2 minPix = glm::max(glm::ivec2(glm::floor(minScreen)), glm::ivec2(0));
+	const glm::ivec2 maxPix = glm::min(glm::ivec2(glm::floor(maxScreen)), glm::ivec2(_resolution) - 1);
+	if(minPix.x > maxPix.x || minPix.y > maxPix.y) {
+		return true;
+	}
+	// Pick the level where the rectangle covers a few texels.
+	size_t level = 0;
+	while(level + 1 < _levels.size() && std::max((maxPix.x >> level) - (minPix.x >> level), (maxPix.y >> level) - (minPix.y >> level)) >= 3) {
+		++level;
+	}
+	// Visible if the box is in front of the farthest occluder in any texel.
+	const std::vector<float> & depths = _levels[level];
+	const size_t width = _sizes[level].x;
+	for(int y = minPix.y >> level; y <= (maxPix.y >> level); ++y) {
+		for(int x = minPix.x >> level; x <= (maxPix.x >> level); ++x) {
+			if(minDepth <= depths[size_t(y) * width + size_t(x)]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void OcclusionCuller::setupTriangles(const Scene::ObjectsData & objects, size_t oid, const glm::mat4 & viewProj, std::vector<Triangle> & triangles) const {
+	const Mesh & mesh = *objects.meshes[oid];
+	const bool twoSided = objects.flags[oid] & Scene::ObjectsData::TWO_SIDED;
+	const glm::mat4 mvp = viewProj * objects.models[oid];
+
+	std::vector<glm::vec4> clips(mesh.positions.size());
+	for(size_t vid = 0; vid < mesh.positions.size(); ++vid) {
+		clips[vid] = mvp * glm::vec4(mesh.positions[vid], 1.0f);
+	}
+
+	const size_t triCount = mesh.indices.size() / 3;
+	for(size_t tid = 0; tid < triCount; ++tid) {
+		const glm::vec4 * verts[3] = {&clips[mesh.indices[3 * tid]], &clips[mesh.indices[3 * tid + 1]], &clips[mesh.indices[3 * tid + 2]]};
+		// Reject triangles fully outside one of the side planes.
+		bool outside = false;
+		for(int axis = 0; axis < 2 && !outside; ++axis) {
+			outside = ((*verts[0])[axis] > verts[0]->w && (*verts[1])[axis] > verts[1]->w && (*verts[2])[axis] > verts[2]->w)
+				|| ((*verts[0])[axis] < -verts[0]->w && (*verts[1])[axis] < -verts[1]->w && (*verts[2])[axis] < -verts[2]->w);
+		}
+		if(outside) {
+			continue;
+		}
+		// Distances to the near plane.
+		const float dists[3] = {verts[0]->z + verts[0]->w, verts[1]->z + verts[1]->w, verts[2]->z + verts[2]->w};
+		if(dists[0] >= 0.0f && dists[1] >= 0.0f && dists[2] >= 0.0f) {
+			setupTriangle(*verts[0], *verts[1], *verts[2], twoSided, triangles);
+			continue;
+		}
+		if(dists[0] < 0.0f && dists[1] < 0.0f && dists[2] < 0.0f) {
+			continue;
+		}
+		// Clip against the near plane, producing at most four vertices.
+		glm::vec4 polygon[4];
+		uint vertCount = 0;
+		for(uint vid = 0; vid < 3; ++vid) {
+			const uint nid = (vid + 1) % 3;
+			if(dists[vid] >= 0.0f) {
+				polygon[vertCount++] = *verts[vid];
+			}
+			if((dists[vid] >= 0.0f) != (dists[nid] >= 0.0f)) {
+				const float t = dists[vid] / (dists[vid] - dists[nid]);
+				polygon[vertCount++] = glm::mix(*verts[vid], *verts[nid], t);
+			}
+		}
+		for(uint vid = 2; vid < vertCount; ++vid) {
+			setupTriangle(polygon[0], polygon[vid - 1], polygon[vid], twoSided, triangles);
+		}
+	}
+}
+
+void OcclusionCuller::setupTriangle(const glm::vec4 & a, const glm::vec4 & b, const glm::vec4 & c, bool twoSided, std::vector<Triangle> & triangles) const {
+	const glm::vec2 res(_resolution);
+	const glm::vec4 clips[3] = {a, b, c};
+	Triangle tri;
+	float depths[3];
+	for(uint vid = 0; vid < 3; ++vid) {
+		const float invW = 1.0f / std::max(clips[vid].w, 1e-6f);
+		tri.vertices[vid] = (0.5f * glm::vec2(clips[vid]) * invW + 0.5f) * res;
+		depths[vid] = 0.5f * clips[vid].z * invW + 0.5f;
+	}
+	glm::vec2 e1 = tri.vertices[1] - tri.vertices[0];
+	glm::vec2 e2 = tri.vertices[2] - tri.vertices[0];
+	float area = e1.x * e2.y - e1.y * e2.x;
+	if(area == 0.0f || (area < 0.0f && !twoSided)) {
+		return;
+	}
+	// Ensure counter-clockwise ordering.
+	if(area < 0.0f) {
+		std::swap(tri.vertices[1], tri.vertices[2]);
+		std::swap(depths[1], depths[2]);
+		std::swap(e1, e2);
+		area = -area;
+	}
+	// Pixel centers covered by the bounding rectangle.
+	const glm::vec2 minPos = glm::min(glm::min(tri.vertices[0], tri.vertices[1]), tri.vertices[2]);
+	const glm::vec2 maxPos = glm::max(glm::max(tri.vertices[0], tri.vertices[1]), tri.vertices[2]);
+	tri.bounds.x = std::max(int(std::ceil(minPos.x - 0.5f)), 0);
+	tri.bounds.y = std::max(int(std::ceil(minPos.y - 0.5f)), 0);
+	tri.bounds.z = std::min(int(std::floor(maxPos.x - 0.5f)), int(_resolution.x) - 1);
+	tri.bounds.w = std::min(int(std::floor(maxPos.y - 0.5f)), int(_resolution.y) - 1);
+	if(tri.bounds.x > tri.bounds.z || tri.bounds.y > tri.bounds.w) {
+		return;
+	}
+	// Depth plane equation.
+	const float d1 = depths[1] - depths[0];
+	const float d2 = depths[2] - depths[0];
+	tri.depthPlane.x = (d1 * e2.y - d2 * e1.y) / area;
+	tri.depthPlane.y = (d2 * e1.x - d1 * e2.x) / area;
+	tri.depthPlane.z = depths[0] - tri.depthPlane.x * tri.vertices[0].x - tri.depthPlane.y * tri.vertices[0].y;
+	triangles.push_back(tri);
+}
+
+void OcclusionCuller::rasterizeBand(size_t band) {
+	const int bandMin = int(band * bandHeight);
+	const int bandMax = std::min(bandMin + int(bandHeight), int(_resolution.y)) - 1;
+	std::vector<float> & depths = _levels[0];
+
+	for(const Triangle * tri : _bins[band]) {
+		// Edge functions, positive inside.
+		glm::vec3 edges[3];
+		for(uint vid = 0; vid < 3; ++vid) {
+			const glm::vec2 & v0 = tri->vertices[vid];
+			const glm::vec2 & v1 = tri->vertices[(vid + 1) % 3];
+			edges[vid].x = v0.y - v1.y;
+			edges[vid].y = v1.x - v0.x;
+			edges[vid].z = -edges[vid].x * v0.x - edges[vid].y * v0.y;
+		}
+		const int minY = std::max(tri->bounds.y, bandMin);
+		const int maxY = std::min(tri->bounds.w, bandMax);
+		const int minX = tri->bounds.x;
+		const int maxX = tri->bounds.z;
+		const glm::vec3 & plane = tri->depthPlane;
+
+		for(int y = minY; y <= maxY; ++y) {
+			// Evaluate at the center of the first pixel of the row, then step along x.
+			const glm::vec3 start(float(minX) + 0.5f, float(y) + 0.5f, 1.0f);
+			float e0 = glm::dot(edges[0], start);
+			float e1 = glm::dot(edges[1], start);
+			float e2 = glm::dot(edges[2], start);
+			float depth = glm::dot(plane, start);
+			float * row = &depths[size_t(y) * _resolution.x];
+			for(int x = minX; x <= maxX; ++x) {
+				const bool inside = e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f;
+				row[x] = inside ? std::min(row[x], depth) : row[x];
+				e0 += edges[0].x;
+				e1 += edges[1].x;
+				e2 += edges[2].x;
+				depth += plane.x;
+			}
+		}
+	}
+}
+
+void OcclusionCuller::buildHierarchy() {
+	for(size_t level = 1; level < _levels.size(); ++level) {
+		const glm::uvec2 & size = _sizes[level];
+		const glm::uvec2 & prevSize = _sizes[level - 1];
+		const std::vector<float> & prev = _levels[level - 1];
+		std::vector<float> & curr = _levels[level];
+		for(uint y = 0; y < size.y; ++y) {
+			// Clamp to the previous level for odd sizes.
+			const uint y0 = std::min(2 * y, prevSize.y - 1);
+			const uint y1 = std::min(2 * y + 1, prevSize.y - 1);
+			for(uint x = 0; x < size.x; ++x) {
+				const uint x0 = std::min(2 * x, prevSize.x - 1);
+				const uint x1 = std::min(2 * x + 1, prevSize.x - 1);
+				const float depth0 = std::max(prev[y0 * prevSize.x + x0], prev[y0 * prevSize.x + x1]);
+				const float depth1 = std::max(prev[y1 * prevSize.x + x0], prev[y1 * prevSize.x + x1]);
+				curr[y * size.x + x] = std::max(depth0, depth1);
+			}
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "scene/Scene.hpp"
+#include "resources/Bounds.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Determine objects hidden behind large occluders, using a low resolution depth buffer rasterized on the CPU.
+ \details Each frame, the largest opaque objects on screen are selected as occluders, up to a triangle budget. Their triangles are transformed, clipped against the near plane and binned in horizontal bands of the depth buffer, which are then rasterized in parallel. A hierarchy of maximum depths is built from the result. Objects bounding boxes can then be tested conservatively against a few texels of this pyramid. Occluders need their mesh geometry to be available on the CPU.
+ \ingroup Renderers
+ */
+class OcclusionCuller {
+
+public:
+
+	/** \brief Statistics of the last frame. */
+	struct Statistics {
+		unsigned long occluders = 0; ///< Number of objects rasterized.
+		unsigned long triangles = 0; ///< Number of triangles rasterized.
+		unsigned long tested = 0; ///< Number of bounding boxes tested.
+		unsigned long culled = 0; ///< Number of bounding boxes hidden.
+		double rasterTime = 0.0; ///< Time spent preparing the depth buffer, in milliseconds.
+		double testTime = 0.0; ///< Time spent testing bounding boxes, in milliseconds.
+	};
+
+	/** Constructor
+	 \param resolution the depth buffer resolution
+	 */
+	explicit OcclusionCuller(const glm::uvec2 & resolution = glm::uvec2(320, 180));
+
+	/** Select occluders among candidate objects and rasterize them in the depth buffer.
+	 \param objects the scene objects data
+	 \param candidates indices of the objects that can be selected, for instance the ones in the view frustum
+	 \param count number of candidates in the list
+	 \param viewProj the view projection matrix
+	 \param pos the camera position in world space
+	 */
+	void render(const Scene::ObjectsData & objects, const std::vector<long> & candidates, size_t count, const glm::mat4 & viewProj, const glm::vec3 & pos);
+
+	/** Remove hidden objects from a list, preserving the order of the others.
+	 \param objects the scene objects data
+	 \param ids indices of the objects to test, updated in place
+	 \param count number of objects in the list
+	 \return the number of objects that can be visible, now at the beginning of the list
+	 */
+	size_t filter(const Scene::ObjectsData & objects, std::vector<long> & ids, size_t count);
+
+	/** \return true if the depth buffer contains at least one occluder */
+	bool active() const { return _stats.triangles != 0; }
+
+	/** \return the last frame statistics */
+	const Statistics & statistics() const { return _stats; }
+
+	/** \return the depth buffer resolution */
+	const glm::uvec2 & resolution() const { return _resolution; }
+
+	/** \return the rasterized depth buffer, row by row */
+	const std::vector<float> & depth() const { return _levels[0]; }
+
+	size_t maxOccluders = 24; ///< Maximum number of occluders rasterized each frame.
+	size_t maxTriangles = 65536; ///< Maximum number of triangles rasterized each frame.
+	float minOccluderSize = 0.05f; ///< Minimum ratio of the object radius over its distance for it to be an occluder.
+
+private:
+
+	/** \brief Screen space triangle ready for rasterization. */
+	struct Triangle {
+		glm::vec2 vertices[3]; ///< Screen space positions, counter-clockwise.
+		glm::vec3 depthPlane; ///< Depth as a linear function of screen position.
+		glm::ivec4 bounds; ///< Pixels bounding rectangle (min x, min y, max x, max y), inclusive.
+	};
+
+	/** Test if a bounding box can be visible, conservatively.
+	 \param box the world space bounding box
+	 \return false if the box is fully hidden by the occluders
+	 */
+	bool visible(const BoundingBox & box) const;
+
+	/** Transform, clip and setup the triangles of an occluder.
+	 \param objects the scene objects data
+	 \param oid the object index
+	 \param viewProj the view projection matrix
+	 \param triangles will receive the screen space triangles
+	 */
+	void setupTriangles(const Scene::ObjectsData & objects, size_t oid, const glm::mat4 & viewProj, std::vector<Triangle> & triangles) const;
+
+	/** Setup a clip space triangle for rasterization, if front facing and covering pixel centers.
+	 \param a first vertex in clip space
+	 \param b second vertex in clip space
+	 \param c third vertex in clip space
+	 \param twoSided should back facing triangles be kept
+	 \param triangles will receive the screen space triangle
+	 */
+	void setupTriangle(const glm::vec4 & a, const glm::vec4 & b, const glm::vec4 & c, bool twoSided, std::vector<Triangle> & triangles) const;
+
+	/** Rasterize the triangles overlapping a band of the depth buffer.
+	 \param band the band index
+	 */
+	void rasterizeBand(size_t band);
+
+	/** Build the maximum depth pyramid from the depth buffer. */
+	void buildHierarchy();
+
+	std::vector<std::vector<float>> _levels; ///< Depth buffer and max depth pyramid, row by row.
+	std::vector<glm::uvec2> _sizes; ///< Size of each pyramid level.
+	std::vector<std::vector<Triangle>> _triangles; ///< Triangles of each occluder.
+	std::vector<std::vector<const Triangle *>> _bins; ///< Triangles overlapping each band.
+	std::vector<std::pair<float, size_t>> _occluders; ///< Selected occluders and their priorities.
+	glm::mat4 _viewProj = glm::mat4(1.0f); ///< Current view projection matrix.
+	glm::uvec2 _resolution; ///< Depth buffer resolution.
+	Statistics _stats; ///< Last frame statistics.
+
+	static const uint bandHeight = 16; ///< Number of rows in a band.
+};
@@ -1,6 +1,7 @@
 #include "Probe.hpp"
 #include "graphics/GPUObjects.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "graphics/AsyncReadback.hpp"
 #include "resources/Library.hpp"
 
 Probe::Probe(const glm::vec3 & position, std::shared_ptr<Renderer> renderer, uint size, uint mips, const glm::vec2 & clippingPlanes) {
@@ -19,6 +20,7 @@ Probe::Probe(const glm::vec3 & position, std::shared_ptr<Renderer> renderer, uin
 	}
 	_shCoeffs->setup();
 	_shCoeffs->upload();
+	_shPending = std::make_shared<bool>(false);
 
 	// Compute the camera for each face.
 	for(uint i = 0; i < 6; ++i) {
@@ -71,23 +73,37 @@ void Probe::prepareIrradiance() {
 }
 
 void Probe::estimateIrradiance(float clamp) {
-	// Download the texture to the CPU.
-	Texture & tex = *_copy->texture();
-	GLUtilities::downloadTexture(tex, 0);
-	// Compute SH coeffs.
-	std::vector<glm::vec3> coeffs(9);
-	extractIrradianceSHCoeffs(tex, clamp, coeffs);
-	for(int i = 0; i < 9; ++i) {
-		_shCoeffs->at(i)[0] = coeffs[i][0];
-		_shCoeffs->at(i)[1] = coeffs[i][1];
-		_shCoeffs->at(i)[2] = coeffs[i][2];
-		_shCoeffs->at(i)[3] = 1.0f;
+	if(*_shPending) {
+		return;
 	}
-	_shCoeffs->upload();
+	*_shPending = true;
+	// The callbacks only share data that outlive the probe if needed.
+	std::shared_ptr<std::vector<glm::vec3>> coeffs = std::make_shared<std::vector<glm::vec3>>(9);
+	std::shared_ptr<Buffer<glm::vec4>> shCoeffs = _shCoeffs;
+	std::shared_ptr<bool> pending = _shPending;
+	// Download the texture to the CPU and compute SH coeffs on a worker thread.
+	AsyncReadback::manager().download(*_copy->texture(), 0, [coeffs, clamp](std::vector<Image> & faces) {
+		extractIrradianceSHCoeffs(faces, clamp, *coeffs);
+	}, [coeffs, shCoeffs, pending]() {
+		// Upload on the rendering thread.
+		for(int i = 0; i < 9; ++i) {
+			shCoeffs->at(i) = glm::vec4((*coeffs)[i], 1.0f);
+		}
+		shCoeffs->upload();
+		*pending = false;
+	});
 }
 
 void Probe::extractIrradianceSHCoeffs(const Texture & cubemap, float clamp, std::vector<glm::vec3> & shCoeffs) {
+	extractIrradianceSHCoeffs(cubemap.images, clamp, shCoeffs);
+}
+
+void Probe::extractIrradianceSHCoeffs(const std::vector<Image> & faces, float clamp, std::vector<glm::vec3> & shCoeffs) {
 	shCoeffs.resize(9);
+	if(faces.size() < 6) {
+		Log::Error() << "Missing cubemap faces for SH extraction." << std::endl;
+		return;
+	}
 
 	// Indices conversions from cubemap UVs to direction.
 	static const std::vector<int> axisIndices  = {0, 0, 1, 1, 2, 2};
@@ -107,9 +123,9 @@ void Probe::extractIrradianceSHCoeffs(const Texture & cubemap, float clamp, std:
 	const float y4 = 0.546274f;
 
 	float denom		= 0.0f;
-	const uint side = cubemap.width;
+	const uint side = faces[0].width;
 	for(uint i = 0; i < 6; ++i) {
-		const auto & currentSide = cubemap.images[i];
+		const auto & currentSide = faces[i];
 		for(uint y = 0; y < side; ++y) {
 			for(uint x = 0; x < side; ++x) {
 
@@ -44,11 +44,12 @@ public:
 	void prepareIrradiance();
 
 	/** Estimate the SH representation of the cubemap irradiance. The estimation is done on the CPU,
-	 and relies on downlaoding a (downscaled) copy of the cubemap content. For synchronization reasons,
-	 it is recommended to only update irradiance every other frame, and to trigger the copy
-	 (performed by prepareIrradiance) after the coeffs update. This will introduce a latency but
-	 will avoid any stalls.
+	 and relies on downloading a (downscaled) copy of the cubemap content. The download and estimation
+	 are asynchronous: the coefficients are updated a few frames later, without stalling the pipeline.
+	 Call prepareIrradiance before to update the copy. If the previous estimation is not complete yet,
+	 this call is ignored.
 	 \param clamp maximum intensity value, useful to avoid temporal instabilities
+	 \note Use AsyncReadback::flush to wait for the coefficients.
 	 */
 	void estimateIrradiance(float clamp);
 
@@ -98,6 +99,13 @@ public:
 	\param shCoeffs will contain the irradiance SH representation
 	 */
 	static void extractIrradianceSHCoeffs(const Texture & cubemap, float clamp, std::vector<glm::vec3> & shCoeffs);
+
+	/** Decompose a cubemap irradiance onto the nine first elements of the spherical harmonic basis.
+	\param faces the six cubemap faces, square and with the same size
+	\param clamp maximum intensity value, useful to avoid temporal instabilities
+	\param shCoeffs will contain the irradiance SH representation
+	 */
+	static void extractIrradianceSHCoeffs(const std::vector<Image> & faces, float clamp, std::vector<glm::vec3> & shCoeffs);
 	
 private:
 
@@ -105,6 +113,7 @@ private:
 	std::shared_ptr<Renderer> _renderer; ///< The renderer to use.
 	std::unique_ptr<Framebuffer> _copy; ///< Downscaled copy of the cubemap content.
 	std::shared_ptr<Buffer<glm::vec4>> _shCoeffs; ///< SH representation of the cubemap irradiance.
+	std::shared_ptr<bool> _shPending; ///< Is an irradiance estimation in progress, shared with the readback callbacks.
 
 	std::array<Camera, 6> _cameras; ///< Camera for each face.
 	glm::vec3 _position; ///< The probe location.
@@ -0,0 +1,91 @@
+#include "renderers/shadowmaps/ShadowMap.hpp"
+#include "scene/Scene.hpp"
+
+void ShadowMap::setCaching(bool cache, bool splitStatic){
+	if(cache != _useCache || splitStatic != _splitStatic){
+		_forceUpdate = true;
+	}
+	_useCache = cache;
+	_splitStatic = splitStatic;
+}
+
+const std::vector<size_t> & ShadowMap::gatherCasters(const Scene & scene, const Frustum & frustum, Casters casters){
+	const Scene::ObjectsData & data = scene.objectsData();
+	// Flags that have to be set, and their expected values.
+	uint8_t mask = Scene::ObjectsData::CASTER;
+	uint8_t expected = Scene::ObjectsData::CASTER;
+	if(casters != Casters::ALL){
+		mask |= Scene::ObjectsData::ANIMATED;
+		expected |= (casters == Casters::DYNAMIC ? Scene::ObjectsData::ANIMATED : 0);
+	}
+	_visibleCasters.clear();
+	const size_t objCount = data.size();
+	for(size_t oid = 0; oid < objCount; ++oid){
+		if((data.flags[oid] & mask) != expected){
+			continue;
+		}
+		// Frustum culling.
+		if(frustum.intersects(data.boxes[oid])){
+			_visibleCasters.push_back(oid);
+		}
+	}
+	return _visibleCasters;
+}
+
+void ShadowMap::detectChanges(const Scene & scene){
+	_changedStatic.clear();
+	_changedDynamic.clear();
+
+	// Handle scene changes.
+	const size_t objCount = scene.objects.size();
+	if(_casters.size() != objCount || _scene != &scene || _sceneVersion == 0){
+		_casters.clear();
+		_casters.resize(objCount);
+		_forceUpdate = true;
+		// Register all casters.
+		for(size_t oid = 0; oid < objCount; ++oid){
+			updateCaster(scene.objects[oid], _casters[oid]);
+		}
+	} else {
+		// Only visit the objects that moved since the last draw.
+		Scene::Changes changes;
+		scene.changes(_sceneVersion, changes);
+		for(const size_t oid : changes.objects){
+			updateCaster(scene.objects[oid], _casters[oid]);
+		}
+	}
+	_scene = &scene;
+	_sceneVersion = scene.version();
+}
+
+void ShadowMap::updateCaster(const Object & object, CasterState & state){
+	const bool caster = object.castsShadow();
+	// Skip objects that are not casting shadows, or that have not moved.
+	if(!caster && !state.caster){
+		return;
+	}
+	if(caster == state.caster && object.model() == state.model){
+		return;
+	}
+	// Both the previous and the new regions covered by the caster have to be updated.
+	std::vector<BoundingBox> & changes = object.animated() ? _changedDynamic : _changedStatic;
+	if(state.caster){
+		changes.push_back(state.box);
+	}
+	if(caster){
+		changes.push_back(object.boundingBox());
+	}
+	state.model = object.model();
+	state.box = object.boundingBox();
+	state.caster = caster;
+}
+
+bool ShadowMap::changed(const Frustum & frustum, bool dynamic) const {
+	const std::vector<BoundingBox> & changes = dynamic ? _changedDynamic : _changedStatic;
+	for(const BoundingBox & box : changes){
+		if(frustum.intersects(box)){
+			return true;
+		}
+	}
+	return false;
+}
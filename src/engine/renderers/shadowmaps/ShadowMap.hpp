@@ -2,10 +2,13 @@
 
 #include "graphics/Framebuffer.hpp"
 #include "processing/BoxBlur.hpp"
+#include "resources/Bounds.hpp"
+#include "renderers/LodSelector.hpp"
 
 #include "Common.hpp"
 
 class Scene;
+class Object;
 
 /**
 \brief Available shadow mapping techniques.
@@ -28,8 +31,27 @@ public:
 	
 	/** Update the shadow map.
 	 \param scene the objcts to draw in the map.
+	 \note If caching is enabled, only the maps affected by a moving light or caster are re-rendered.
 	 */
-	virtual void draw(const Scene & scene) const = 0;
+	virtual void draw(const Scene & scene) = 0;
+
+	/** Set the shadow map update policy. Changing the policy forces a full update at the next draw.
+	 \param cache only re-render a light map when the light or one of the casters it sees has moved
+	 \param splitStatic keep the static casters in a separate cached map, and only composite dynamic casters on top of it
+	 \note Implementations that do not support caching will always re-render their maps.
+	 */
+	void setCaching(bool cache, bool splitStatic);
+
+	/** Force a full update at the next draw. */
+	void invalidate(){ _forceUpdate = true; }
+
+	/** \return the number of map layers that were re-rendered during the last draw */
+	size_t updatedLayers() const { return _updatedLayers; }
+
+	/** \return the levels of detail selection settings, the projected error being measured in shadow map texels
+	 \note Cached maps should be invalidated after changing these settings.
+	 */
+	LodSelector & lods() { return _lods; }
 	
 	/** Destructor. */
 	virtual ~ShadowMap() = default;
@@ -58,4 +80,61 @@ public:
 		size_t layer = 0; ///< The layer containing the shadow map.
 	};
 
+protected:
+
+	/// \brief Subset of the scene casters to render.
+	enum class Casters {
+		ALL, ///< All casters.
+		STATIC, ///< Casters without animations.
+		DYNAMIC ///< Animated casters.
+	};
+
+	/** Collect the casters from a subset that are visible in a light frustum, traversing the scene contiguous objects data.
+	 \param scene the scene to inspect
+	 \param frustum the light frustum
+	 \param casters the subset of casters
+	 \return the indices of the visible casters, valid until the next call
+	 */
+	const std::vector<size_t> & gatherCasters(const Scene & scene, const Frustum & frustum, Casters casters);
+
+	/** Compare the scene shadow casters with their state at the previous draw, and collect the world space regions that changed.
+	 \param scene the scene to inspect
+	 \note Static casters are the objects without animations. Only the objects moved since the previous draw are visited, using the scene change set.
+	 */
+	void detectChanges(const Scene & scene);
+
+	/** Check if a light frustum overlaps a region changed since the previous draw.
+	 \param frustum the light frustum
+	 \param dynamic check the regions affected by dynamic casters instead of static ones
+	 \return true if the light map content has to be updated
+	 */
+	bool changed(const Frustum & frustum, bool dynamic) const;
+
+	bool _useCache = true; ///< Should maps be re-rendered only when needed.
+	bool _splitStatic = false; ///< Should static casters be cached in a separate map.
+	bool _forceUpdate = true; ///< Should all maps be re-rendered at the next draw.
+	size_t _updatedLayers = 0; ///< Number of layers re-rendered during the last draw.
+	LodSelector _lods; ///< Levels of detail selection for casters.
+
+private:
+
+	/** State of a caster at the previous draw. */
+	struct CasterState {
+		glm::mat4 model = glm::mat4(1.0f); ///< Caster transformation.
+		BoundingBox box; ///< Caster world space bounding box.
+		bool caster = false; ///< Was the object casting shadows.
+	};
+
+	/** Update the state of a caster, registering the regions it covered and covers now if it moved.
+	 \param object the caster
+	 \param state the caster state at the previous draw
+	 */
+	void updateCaster(const Object & object, CasterState & state);
+
+	std::vector<CasterState> _casters; ///< Casters state at the previous draw.
+	std::vector<size_t> _visibleCasters; ///< Casters visible in the last gathered frustum.
+	const Scene * _scene = nullptr; ///< The scene inspected at the previous draw.
+	uint64_t _sceneVersion = 0; ///< The scene version at the previous draw.
+	std::vector<BoundingBox> _changedStatic; ///< Regions changed by static casters since the previous draw.
+	std::vector<BoundingBox> _changedDynamic; ///< Regions changed by dynamic casters since the previous draw.
 };
@@ -11,7 +11,8 @@ VarianceShadowMap2D::VarianceShadowMap2D(const std::shared_ptr<Light> & light, c
 	_light->registerShadowMap(_map->texture());
 }
 
-void VarianceShadowMap2D::draw(const Scene & scene) const {
+void VarianceShadowMap2D::draw(const Scene & scene) {
+	_updatedLayers = 0;
 	if(!_light->castsShadow()){
 		return;
 	}
@@ -27,15 +28,10 @@ void VarianceShadowMap2D::draw(const Scene & scene) const {
 	_program->use();
 
 	const Frustum lightFrustum(_light->vp());
+	_lods.setView(_light->vp(), float(_map->height()));
 
-	for(auto & object : scene.objects) {
-		if(!object.castsShadow()) {
-			continue;
-		}
-		// Frustum culling.
-		if(!lightFrustum.intersects(object.boundingBox())){
-			continue;
-		}
+	for(const size_t oid : gatherCasters(scene, lightFrustum, Casters::ALL)) {
+		const Object & object = scene.objects[oid];
 		GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
 		_program->uniform("hasMask", object.masked());
 		if(object.masked()) {
@@ -43,11 +39,12 @@ void VarianceShadowMap2D::draw(const Scene & scene) const {
 		}
 		const glm::mat4 lightMVP = _light->vp() * object.model();
 		_program->uniform("mvp", lightMVP);
-		GLUtilities::drawMesh(*(object.mesh()));
+		GLUtilities::drawMesh(*(object.mesh()), _lods.select(*(object.mesh()), object.model()));
 	}
 	
 	// Blur pass.
 	_blur->process(_map->texture(), *_map);
+	_updatedLayers = 1;
 }
 
 VarianceShadowMapCube::VarianceShadowMapCube(const std::shared_ptr<PointLight> & light, int side){
@@ -59,7 +56,8 @@ VarianceShadowMapCube::VarianceShadowMapCube(const std::shared_ptr<PointLight> &
 	_light->registerShadowMap(_map->texture());
 }
 
-void VarianceShadowMapCube::draw(const Scene & scene) const {
+void VarianceShadowMapCube::draw(const Scene & scene) {
+	_updatedLayers = 0;
 	if(!_light->castsShadow()){
 		return;
 	}
@@ -81,15 +79,10 @@ void VarianceShadowMapCube::draw(const Scene & scene) const {
 		_map->bind(i);
 		GLUtilities::clearColorAndDepth(glm::vec4(1.0f), 1.0f);
 		const Frustum lightFrustum(faces[i]);
+		_lods.setView(faces[i], float(_map->height()));
 
-		for(auto & object : scene.objects) {
-			if(!object.castsShadow()) {
-				continue;
-			}
-			// Frustum culling.
-			if(!lightFrustum.intersects(object.boundingBox())){
-				continue;
-			}
+		for(const size_t oid : gatherCasters(scene, lightFrustum, Casters::ALL)) {
+			const Object & object = scene.objects[oid];
 			GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
 			const glm::mat4 mvp = faces[i] * object.model();
 			_program->uniform("mvp", mvp);
@@ -98,9 +91,10 @@ void VarianceShadowMapCube::draw(const Scene & scene) const {
 			if(object.masked()) {
 				GLUtilities::bindTexture(object.textures()[0], 0);
 			}
-			GLUtilities::drawMesh(*(object.mesh()));
+			GLUtilities::drawMesh(*(object.mesh()), _lods.select(*(object.mesh()), object.model()));
 		}
 	}
 	// Blur pass.
 	_blur->process(_map->texture(), *_map);
+	_updatedLayers = 6;
 }
@@ -18,7 +18,7 @@ public:
 	explicit VarianceShadowMap2D(const std::shared_ptr<Light> & light, const glm::vec2 & resolution);
 	
 	/** \copydoc ShadowMap::draw  */
-	void draw(const Scene & scene) const override;
+	void draw(const Scene & scene) override;
 
 private:
 	
@@ -42,7 +42,7 @@ public:
 	explicit VarianceShadowMapCube(const std::shared_ptr<PointLight> & light, int side);
 	
 	/** \copydoc ShadowMap::draw  */
-	void draw(const Scene & scene) const override;
+	void draw(const Scene & scene) override;
 	
 private:
 	
@@ -4,6 +4,7 @@
 
 VarianceShadowMap2DArray::VarianceShadowMap2DArray(const std::vector<std::shared_ptr<Light>> & lights, const glm::vec2 & resolution){
 	_lights = lights;
+	_states.resize(_lights.size());
 	const Descriptor descriptor = {Layout::RG32F, Filter::LINEAR, Wrap::CLAMP};
 	_map = std::unique_ptr<Framebuffer>(new Framebuffer(TextureShape::Array2D, uint(resolution.x), uint(resolution.y), uint(lights.size()), 1, {descriptor}, true, "Shadow map 2D array"));
 	_blur = std::unique_ptr<BoxBlur>(new BoxBlur(false));
@@ -13,7 +14,18 @@ VarianceShadowMap2DArray::VarianceShadowMap2DArray(const std::vector<std::shared
 	}
 }
 
-void VarianceShadowMap2DArray::draw(const Scene & scene) const {
+void VarianceShadowMap2DArray::draw(const Scene & scene) {
+
+	detectChanges(scene);
+	_dirtyLayers.clear();
+
+	// Allocate or release the static casters map.
+	const bool split = _useCache && _splitStatic;
+	if(split && !_staticMap){
+		_staticMap.reset(new Framebuffer(TextureShape::Array2D, _map->width(), _map->height(), _map->depth(), 1, {_map->descriptor()}, true, "Shadow map 2D array static"));
+	} else if(!split && _staticMap){
+		_staticMap.reset();
+	}
 
 	GLUtilities::setDepthState(true, TestFunction::LESS, true);
 	GLUtilities::setBlendState(false);
@@ -24,40 +36,76 @@ void VarianceShadowMap2DArray::draw(const Scene & scene) const {
 
 	for(size_t lid = 0; lid < _lights.size(); ++lid){
 		const auto & light = _lights[lid];
+		LightState & state = _states[lid];
 		if(!light->castsShadow()){
+			state.valid = false;
 			continue;
 		}
-		_map->bind(lid);
-		GLUtilities::clearColorAndDepth(glm::vec4(1.0f), 1.0f);
 
-		const Frustum lightFrustum(light->vp());
+		// Check if the light or the casters it sees have moved.
+		const glm::mat4 & vp = light->vp();
+		const Frustum lightFrustum(vp);
+		const bool lightChanged = !_useCache || _forceUpdate || !state.valid || state.vp != vp;
+		const bool staticChanged = lightChanged || changed(lightFrustum, false);
+		const bool dynamicChanged = changed(lightFrustum, true);
+		if(!staticChanged && !dynamicChanged){
+			continue;
+		}
+		state.vp = vp;
+		state.valid = true;
+		_dirtyLayers.push_back(lid);
 
-		for(auto & object : scene.objects) {
-			if(!object.castsShadow()) {
-				continue;
-			}
-			// Frustum culling.
-			if(!lightFrustum.intersects(object.boundingBox())){
-				continue;
-			}
-			GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
+		if(!split){
+			_map->bind(lid);
+			GLUtilities::clearColorAndDepth(glm::vec4(1.0f), 1.0f);
+			drawCasters(scene, vp, Casters::ALL);
+			continue;
+		}
 
-			_program->uniform("hasMask", object.masked());
-			if(object.masked()) {
-				GLUtilities::bindTexture(object.textures()[0], 0);
-			}
-			const glm::mat4 lightMVP = light->vp() * object.model();
-			_program->uniform("mvp", lightMVP);
-			GLUtilities::drawMesh(*(object.mesh()));
+		// Update the static casters map if needed, and copy it.
+		if(staticChanged){
+			_staticMap->bind(lid);
+			GLUtilities::clearColorAndDepth(glm::vec4(1.0f), 1.0f);
+			drawCasters(scene, vp, Casters::STATIC);
 		}
+		GLUtilities::blit(*_staticMap, *_map, lid, lid, Filter::NEAREST);
+
+		// Both moments increase with the depth, we can composite dynamic casters by keeping the minimum.
+		_map->bind(lid);
+		GLUtilities::setDepthState(false);
+		GLUtilities::setBlendState(true, BlendEquation::MIN, BlendFunction::ONE, BlendFunction::ONE);
+		drawCasters(scene, vp, Casters::DYNAMIC);
+		GLUtilities::setDepthState(true, TestFunction::LESS, true);
+		GLUtilities::setBlendState(false);
 	}
-	
+	_forceUpdate = false;
+	_updatedLayers = _dirtyLayers.size();
+
 	// Apply box blur.
-	_blur->process(_map->texture(), *_map);
+	_blur->process(_map->texture(), *_map, _dirtyLayers);
+}
+
+void VarianceShadowMap2DArray::drawCasters(const Scene & scene, const glm::mat4 & vp, Casters casters) {
+	const Frustum lightFrustum(vp);
+	_lods.setView(vp, float(_map->height()));
+
+	for(const size_t oid : gatherCasters(scene, lightFrustum, casters)) {
+		const Object & object = scene.objects[oid];
+		GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
+
+		_program->uniform("hasMask", object.masked());
+		if(object.masked()) {
+			GLUtilities::bindTexture(object.textures()[0], 0);
+		}
+		const glm::mat4 lightMVP = vp * object.model();
+		_program->uniform("mvp", lightMVP);
+		GLUtilities::drawMesh(*(object.mesh()), _lods.select(*(object.mesh()), object.model()));
+	}
 }
 
 VarianceShadowMapCubeArray::VarianceShadowMapCubeArray(const std::vector<std::shared_ptr<PointLight>> & lights, int side){
 	_lights = lights;
+	_states.resize(_lights.size());
 	const Descriptor descriptor = {Layout::RG16F, Filter::LINEAR, Wrap::CLAMP};
 	_map = std::unique_ptr<Framebuffer>(new Framebuffer( TextureShape::ArrayCube, side, side, uint(lights.size()), 1,  {descriptor}, true, "Shadow map cube array"));
 	_blur = std::unique_ptr<BoxBlur>(new BoxBlur(true));
@@ -67,7 +115,18 @@ VarianceShadowMapCubeArray::VarianceShadowMapCubeArray(const std::vector<std::sh
 	}
 }
 
-void VarianceShadowMapCubeArray::draw(const Scene & scene) const {
+void VarianceShadowMapCubeArray::draw(const Scene & scene) {
+
+	detectChanges(scene);
+	_dirtyLayers.clear();
+
+	// Allocate or release the static casters map.
+	const bool split = _useCache && _splitStatic;
+	if(split && !_staticMap){
+		_staticMap.reset(new Framebuffer(TextureShape::ArrayCube, _map->width(), _map->height(), uint(_lights.size()), 1, {_map->descriptor()}, true, "Shadow map cube array static"));
+	} else if(!split && _staticMap){
+		_staticMap.reset();
+	}
 
 	GLUtilities::setDepthState(true, TestFunction::LESS, true);
 	GLUtilities::setCullState(true, Faces::BACK);
@@ -77,42 +136,78 @@ void VarianceShadowMapCubeArray::draw(const Scene & scene) const {
 
 	for(size_t lid = 0; lid < _lights.size(); ++lid){
 		const auto & light = _lights[lid];
+		LightState & state = _states[lid];
 		if(!light->castsShadow()){
+			state.valid = false;
 			continue;
 		}
 		// Udpate the light vp matrices.
 		const auto & faces = light->vpFaces();
+		const bool lightChanged = !_useCache || _forceUpdate || !state.valid || state.position != light->position() || state.farPlane != light->farPlane();
+		state.position = light->position();
+		state.farPlane = light->farPlane();
+		state.valid = true;
 
 		// Pass the world space light position, and the projection matrix far plane.
 		_program->uniform("lightPositionWorld", light->position());
 		_program->uniform("lightFarPlane", light->farPlane());
 		for(int i = 0; i < 6; ++i){
-			// We render each face sequentially, culling objects that are not visible.
-			_map->bind(lid * 6 + i);
-			GLUtilities::clearColorAndDepth(glm::vec4(1.0f), 1.0f);
+			// Check if the light or the casters visible in this face have moved.
 			const Frustum lightFrustum(faces[i]);
+			const bool staticChanged = lightChanged || changed(lightFrustum, false);
+			const bool dynamicChanged = changed(lightFrustum, true);
+			if(!staticChanged && !dynamicChanged){
+				continue;
+			}
+			const size_t layer = lid * 6 + i;
+			_dirtyLayers.push_back(layer);
 
-			for(auto & object : scene.objects) {
-				if(!object.castsShadow()) {
-					continue;
-				}
-				// Frustum culling.
-				if(!lightFrustum.intersects(object.boundingBox())){
-					continue;
-				}
-
-				GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
-				const glm::mat4 mvp = faces[i] * object.model();
-				_program->uniform("mvp", mvp);
-				_program->uniform("m", object.model());
-				_program->uniform("hasMask", object.masked());
-				if(object.masked()) {
-					GLUtilities::bindTexture(object.textures()[0], 0);
-				}
-				GLUtilities::drawMesh(*(object.mesh()));
+			// We render each face sequentially, culling objects that are not visible.
+			if(!split){
+				_map->bind(layer);
+				GLUtilities::clearColorAndDepth(glm::vec4(1.0f), 1.0f);
+				drawCasters(scene, faces[i], Casters::ALL);
+				continue;
+			}
+
+			// Update the static casters map if needed, and copy it.
+			if(staticChanged){
+				_staticMap->bind(layer);
+				GLUtilities::clearColorAndDepth(glm::vec4(1.0f), 1.0f);
+				drawCasters(scene, faces[i], Casters::STATIC);
 			}
+			GLUtilities::blit(*_staticMap, *_map, layer, layer, Filter::NEAREST);
+
+			// Both moments increase with the distance, we can composite dynamic casters by keeping the minimum.
+			_map->bind(layer);
+			GLUtilities::setDepthState(false);
+			GLUtilities::setBlendState(true, BlendEquation::MIN, BlendFunction::ONE, BlendFunction::ONE);
+			drawCasters(scene, faces[i], Casters::DYNAMIC);
+			GLUtilities::setDepthState(true, TestFunction::LESS, true);
+			GLUtilities::setBlendState(false);
 		}
 	}
+	_forceUpdate = false;
+	_updatedLayers = _dirtyLayers.size();
+
 	// Apply box blur.
-	_blur->process(_map->texture(), *_map);
+	_blur->process(_map->texture(), *_map, _dirtyLayers);
+}
+
+void VarianceShadowMapCubeArray::drawCasters(const Scene & scene, const glm::mat4 & vp, Casters casters) {
+	const Frustum lightFrustum(vp);
+	_lods.setView(vp, float(_map->height()));
+
+	for(const size_t oid : gatherCasters(scene, lightFrustum, casters)) {
+		const Object & object = scene.objects[oid];
+		GLUtilities::setCullState(!object.twoSided(), Faces::BACK);
+		const glm::mat4 mvp = vp * object.model();
+		_program->uniform("mvp", mvp);
+		_program->uniform("m", object.model());
+		_program->uniform("hasMask", object.masked());
+		if(object.masked()) {
+			GLUtilities::bindTexture(object.textures()[0], 0);
+		}
+		GLUtilities::drawMesh(*(object.mesh()), _lods.select(*(object.mesh()), object.model()));
+	}
 }
@@ -7,6 +7,7 @@
 
 /**
  \brief A 2D variance shadow map array, can be used for directional and spot lights. The shadow map will register itself with the associated lights. Implement variance shadow mapping to filter the shadows and get correct smoother edges.
+ \details Each light map is cached and only re-rendered when the light or a caster visible from it moves. Static casters can optionally be cached in a separate map, on top of which dynamic casters are composited.
  \ingroup Renderers
  */
 class VarianceShadowMap2DArray : public ShadowMap {
@@ -18,19 +19,36 @@ public:
 	explicit VarianceShadowMap2DArray(const std::vector<std::shared_ptr<Light>> & lights, const glm::vec2 & resolution);
 	
 	/** \copydoc ShadowMap::draw  */
-	void draw(const Scene & scene) const override;
+	void draw(const Scene & scene) override;
 
 private:
+
+	/** Render a subset of the casters in the currently bound layer.
+	 \param scene the scene containing the casters
+	 \param vp the light view-projection matrix
+	 \param casters the subset of casters to render
+	 */
+	void drawCasters(const Scene & scene, const glm::mat4 & vp, Casters casters);
+
+	/** Light state at the time of the last update of its map. */
+	struct LightState {
+		glm::mat4 vp = glm::mat4(1.0f); ///< Light view-projection matrix.
+		bool valid = false; ///< Is the map up to date.
+	};
 	
 	std::vector<std::shared_ptr<Light>> _lights; ///< The associated light.
+	std::vector<LightState> _states;	///< The lights state when their map was last updated.
+	std::vector<size_t> _dirtyLayers;	///< Layers updated during the current draw.
 	const Program * _program;			///< Shadow program.
 	std::unique_ptr<Framebuffer> _map;	///< Raw shadow map result.
+	std::unique_ptr<Framebuffer> _staticMap;	///< Static casters shadow map, if split.
 	std::unique_ptr<BoxBlur> _blur;		///< Blur filter.
 	
 };
 
 /**
  \brief A cube variance shadow map array, can be used for point lights. Each face of the map is updated sequentially. The shadow map will register itself with the associated lights. Implement variance shadow mapping to filter the shadows and get correct smoother edges.
+ \details Each face is cached and only re-rendered when the light or a caster visible from it moves. Static casters can optionally be cached in a separate map, on top of which dynamic casters are composited.
  \ingroup Renderers
  */
 class VarianceShadowMapCubeArray : public ShadowMap {
@@ -42,13 +60,30 @@ public:
 	explicit VarianceShadowMapCubeArray(const std::vector<std::shared_ptr<PointLight>> & lights, int side);
 	
 	/** \copydoc ShadowMap::draw  */
-	void draw(const Scene & scene) const override;
+	void draw(const Scene & scene) override;
 	
 private:
+
+	/** Render a subset of the casters in the currently bound face.
+	 \param scene the scene containing the casters
+	 \param vp the face view-projection matrix
+	 \param casters the subset of casters to render
+	 */
+	void drawCasters(const Scene & scene, const glm::mat4 & vp, Casters casters);
+
+	/** Light state at the time of the last update of its map. */
+	struct LightState {
+		glm::vec3 position = glm::vec3(0.0f); ///< Light position.
+		float farPlane = 0.0f; ///< Light far plane.
+		bool valid = false; ///< Is the map up to date.
+	};
 	
 	std::vector<std::shared_ptr<PointLight>> _lights; ///< The associated lights.
+	std::vector<LightState> _states;	///< The lights state when their map was last updated.
+	std::vector<size_t> _dirtyLayers;	///< Faces updated during the current draw.
 	const Program * _program;			///< Shadow program.
 	std::unique_ptr<Framebuffer> _map;	///< Raw shadow map result.
+	std::unique_ptr<Framebuffer> _staticMap;	///< Static casters shadow map, if split.
 	std::unique_ptr<BoxBlur> _blur;		///< Blur filter.
 	
 };
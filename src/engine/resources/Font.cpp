@@ -50,54 +50,31 @@ Font::Font(std::istream & in) {
 	}
 }
 
-void Font::generateLabel(const std::string & text, float scale, Mesh & mesh, Alignment align) const {
-	mesh.clean();
-	glm::vec3 currentOrigin(0.0f);
+float Font::layoutLabel(const std::string & text, float scale, Alignment align, std::vector<GlyphQuad> & quads) const {
+	const size_t firstQuad = quads.size();
+	float currentX = 0.0f;
 
-	int idBase = 0;
 	for(const auto & c : text) {
 		if(int(c) < _firstCodepoint || int(c) > _lastCodepoint) {
 			Log::Error() << "Unknown codepoint." << std::endl;
 			continue;
 		}
-		const int glyphIndex = int(c) - _firstCodepoint;
-
-		// Indices are easy.
-		mesh.indices.push_back(idBase);
-		mesh.indices.push_back(idBase + 1);
-		mesh.indices.push_back(idBase + 2);
-		mesh.indices.push_back(idBase);
-		mesh.indices.push_back(idBase + 2);
-		mesh.indices.push_back(idBase + 3);
-		idBase += 4;
-
-		const auto & glyph = _glyphs[glyphIndex];
-		// Uvs also.
-		mesh.texcoords.push_back(glyph.min);
-		mesh.texcoords.emplace_back(glyph.max.x, glyph.min.y);
-		mesh.texcoords.push_back(glyph.max);
-		mesh.texcoords.emplace_back(glyph.min.x, glyph.max.y);
-
-		// Vertices.
+		const auto & glyph = _glyphs[int(c) - _firstCodepoint];
 		// We want the vertical height to be scale, X to follow based on aspect ratio in font atlas.
 		const glm::vec2 uvSize = (glyph.max - glyph.min);
 		const float deltaY	 = scale;
 		const float deltaX	 = deltaY * (uvSize.x / uvSize.y) * (float(_atlas->width) / float(_atlas->height));
-		mesh.positions.push_back(currentOrigin);
-		mesh.positions.push_back(currentOrigin + glm::vec3(deltaX, 0.0f, 0.0f));
-		mesh.positions.push_back(currentOrigin + glm::vec3(deltaX, deltaY, 0.0f));
-		mesh.positions.push_back(currentOrigin + glm::vec3(0.0f, deltaY, 0.0f));
-		currentOrigin.x += deltaX;
+		quads.push_back({glm::vec2(currentX, 0.0f), glm::vec2(currentX + deltaX, deltaY), glyph.min, glyph.max});
+		currentX += deltaX;
 	}
-	// currentOrigin.x now contains the width of the label.
-	// Depending on the alignment mode, we shift all vertices based on it.
+	// currentX now contains the width of the label.
+	// Depending on the alignment mode, we shift all glyphs based on it.
 	if(align != Alignment::LEFT) {
-		const float shiftX = (align == Alignment::CENTER ? 0.5f : 1.0f) * currentOrigin.x;
-		for(auto & vert : mesh.positions) {
-			vert.x -= shiftX;
+		const float shiftX = (align == Alignment::CENTER ? 0.5f : 1.0f) * currentX;
+		for(size_t qid = firstQuad; qid < quads.size(); ++qid) {
+			quads[qid].min.x -= shiftX;
+			quads[qid].max.x -= shiftX;
 		}
 	}
-	mesh.upload();
-	// Remove uneeded CPU geometry.
-	mesh.clearGeometry();
+	return currentX;
 }
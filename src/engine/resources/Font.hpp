@@ -1,7 +1,6 @@
 #pragma once
 
 #include "resources/Texture.hpp"
-#include "resources/Mesh.hpp"
 #include "Common.hpp"
 
 /**
@@ -18,18 +17,27 @@ public:
 		RIGHT
 	};
 
+	/** \brief A glyph placed in a label. */
+	struct GlyphQuad {
+		glm::vec2 min; ///< Bottom left corner, relative to the label origin.
+		glm::vec2 max; ///< Top right corner, relative to the label origin.
+		glm::vec2 uvMin; ///< Bottom left corner in the atlas.
+		glm::vec2 uvMax; ///< Top right corner in the atlas.
+	};
+
 	/** Load font from text stream.
 	 \param in the input stream containing the metadata
 	 */
 	explicit Font(std::istream & in);
 
-	/** Generate the label mesh for a given text and font.
+	/** Place the glyphs of a label, without allocating any GPU object.
 	 \param text the text do display
 	 \param scale the vertical height of the characters, in absolute units
-	 \param mesh the mesh to populate
 	 \param align the text alignment to apply, will influence the origin placement
+	 \param quads will receive the placed glyphs, appended after any existing ones
+	 \return the width of the label
 	 */
-	void generateLabel(const std::string & text, float scale, Mesh & mesh, Alignment align = Alignment::LEFT) const;
+	float layoutLabel(const std::string & text, float scale, Alignment align, std::vector<GlyphQuad> & quads) const;
 	
 	/** Copy assignment operator (disabled).
 	 \return a reference to the object assigned to
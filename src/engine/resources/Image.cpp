@@ -296,7 +296,8 @@ int Image::loadLDR(const std::string & path, unsigned int channels, bool flip, b
 		return 1;
 	}
 
-	stbi_set_flip_vertically_on_load(flip);
+	// Per-thread setting, images can be loaded concurrently.
+	stbi_set_flip_vertically_on_load_thread(flip);
 
 	int localWidth  = 0;
 	int localHeight = 0;
@@ -189,26 +189,42 @@ Mesh::Mesh(std::istream & in, Mesh::Load mode, const std::string & name) {
 }
 
 void Mesh::upload() {
-	GLUtilities::setupMesh(*this);
+	upload(Format());
+}
+
+void Mesh::upload(const Format & format) {
+	GLUtilities::setupMesh(*this, format);
 	DebugViewer::trackDefault(this);
 }
 
-void Mesh::clearGeometry() {
-	positions.clear();
+void Mesh::clearGeometry(bool keepPositions) {
 	normals.clear();
 	tangents.clear();
 	binormals.clear();
 	texcoords.clear();
+	levels.clear();
+	if(keepPositions) {
+		positions.shrink_to_fit();
+		indices.shrink_to_fit();
+		return;
+	}
+	positions.clear();
 	indices.clear();
 }
 
-void Mesh::clean() {
-	clearGeometry();
-	bbox = BoundingBox();
+void Mesh::clearGPU() {
 	if(gpu) {
 		gpu->clean();
 		DebugViewer::untrackDefault(this);
 	}
+	gpu = nullptr;
+}
+
+void Mesh::clean() {
+	clearGeometry();
+	levelErrors.clear();
+	bbox = BoundingBox();
+	clearGPU();
 }
 
 BoundingBox Mesh::computeBoundingBox() {
@@ -422,3 +438,11 @@ bool Mesh::hadTexcoords() const {
 bool Mesh::hadColors() const {
 	return _hasColors;
 }
+
+uint Mesh::selectLevel(float maxError) const {
+	uint level = 0;
+	while(level < levelErrors.size() && levelErrors[level] <= maxError) {
+		++level;
+	}
+	return level;
+}
@@ -19,6 +19,12 @@ public:
 		Indexed   ///< Duplicate only vertices that are shared between faces with attributes with different values.
 	};
 
+	/// \brief Layout of the vertex attributes on the GPU.
+	struct Format {
+		bool packed = false; ///< Interleave and quantize attributes: octahedral normal and tangent with a binormal sign, 16-bit texture coordinates, 8-bit colors.
+		bool shortIndices = false; ///< Use 16-bit indices if the mesh has at most 65536 vertices.
+	};
+
 	/** Default constructor.
 	 \param name the mesh identifier
 	 */
@@ -32,11 +38,21 @@ public:
 	Mesh(std::istream & in, Load mode, const std::string & name);
 
 	
-	/** Send to the GPU. */
+	/** Send to the GPU, using full precision separate vertex attributes. */
 	void upload();
+
+	/** Send to the GPU.
+	 \param format the vertex attributes layout to use
+	 */
+	void upload(const Format & format);
 	
-	/** Clear CPU geometry data. */
-	void clearGeometry();
+	/** Clear CPU geometry data.
+	 \param keepPositions preserve positions and indices, for instance for CPU visibility queries
+	 */
+	void clearGeometry(bool keepPositions = false);
+
+	/** Release GPU data, preserving CPU data. */
+	void clearGPU();
 
 	/** Cleanup all data. */
 	void clean();
@@ -86,6 +102,15 @@ public:
 	 \return true if it did
 	 */
 	bool hadColors() const;
+
+	/** \return the number of levels of detail, including the full resolution mesh */
+	uint levelCount() const { return uint(levelErrors.size()) + 1; }
+
+	/** Select the coarsest level of detail with an acceptable error.
+	 \param maxError the maximum error, relative to the bounding box diagonal
+	 \return the level index, 0 being the full resolution mesh
+	 */
+	uint selectLevel(float maxError) const;
 	
 	/** Copy assignment operator (disabled).
 	 \return a reference to the object assigned to
@@ -110,6 +135,8 @@ public:
 	std::vector<glm::vec3> colors;	 ///< The vertex colors.
 	std::vector<glm::vec2> texcoords;  ///< The texture coordinates.
 	std::vector<unsigned int> indices; ///< The triangular faces indices.
+	std::vector<std::vector<unsigned int>> levels; ///< Triangular faces indices of simplified versions, from finest to coarsest.
+	std::vector<float> levelErrors; ///< Error of each simplified version, relative to the bounding box diagonal (kept after clearing geometry).
 	
 	BoundingBox bbox;			  ///< The mesh bounding box in model space.
 	std::unique_ptr<GPUMesh> gpu; ///< The GPU buffers infos (optional).
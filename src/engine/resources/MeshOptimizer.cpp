@@ -0,0 +1,247 @@
+#include "resources/MeshOptimizer.hpp"
+
+#include <numeric>
+
+MeshOptimizer::Statistics MeshOptimizer::analyze(const std::vector<unsigned int> & indices, size_t vertexCount, uint cacheSize) {
+	Statistics stats;
+	if(indices.empty() || cacheSize == 0) {
+		return stats;
+	}
+	// Each vertex stores the value of the miss counter when it entered the cache.
+	// It is still in the FIFO cache if less than cacheSize misses occurred since.
+	std::vector<size_t> entries(vertexCount, 0);
+	std::vector<uint8_t> used(vertexCount, 0);
+	size_t misses = 0;
+	size_t unique = 0;
+	for(const unsigned int vid : indices) {
+		if(!used[vid] || misses - entries[vid] >= cacheSize) {
+			++misses;
+			entries[vid] = misses;
+		}
+		unique += used[vid] ? 0 : 1;
+		used[vid] = 1;
+	}
+	stats.acmr = float(misses) / float(indices.size() / 3);
+	stats.atvr = float(misses) / float(std::max(unique, size_t(1)));
+	return stats;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int> & indices, size_t vertexCount, uint cacheSize, std::vector<size_t> * clusters) {
+	const size_t triCount = indices.size() / 3;
+	if(clusters) {
+		clusters->assign(1, 0);
+	}
+	if(triCount == 0) {
+		return;
+	}
+
+	// Triangles adjacent to each vertex, and live triangles count.
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for(const unsigned int vid : indices) {
+		++offsets[vid + 1];
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<unsigned int> live(vertexCount);
+	{
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for(size_t id = 0; id < indices.size(); ++id) {
+			adjacency[fill[indices[id]]++] = (unsigned int)(id / 3);
+		}
+		for(size_t vid = 0; vid < vertexCount; ++vid) {
+			live[vid] = offsets[vid + 1] - offsets[vid];
+		}
+	}
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	std::vector<uint8_t> emitted(triCount, 0);
+	// Time at which each vertex entered the cache.
+	std::vector<size_t> timestamps(vertexCount, 0);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+	size_t time = cacheSize + 1;
+	size_t cursor = 0;
+	long fanning = long(indices[0]);
+
+	while(fanning >= 0) {
+		// Emit all remaining triangles around the fanning vertex.
+		candidates.clear();
+		const unsigned int fid = (unsigned int)(fanning);
+		for(unsigned int aid = offsets[fid]; aid < offsets[fid + 1]; ++aid) {
+			const unsigned int tid = adjacency[aid];
+			if(emitted[tid]) {
+				continue;
+			}
+			emitted[tid] = 1;
+			for(size_t k = 0; k < 3; ++k) {
+				const unsigned int vid = indices[3 * tid + k];
+				result.push_back(vid);
+				deadEnds.push_back(vid);
+				candidates.push_back(vid);
+				--live[vid];
+				if(time - timestamps[vid] > cacheSize) {
+					timestamps[vid] = time;
+					++time;
+				}
+			}
+		}
+
+		// Pick the candidate in cache with the most remaining triangles, that will still be in cache after being used.
+		long next = -1;
+		long best = -1;
+		for(const unsigned int vid : candidates) {
+			if(live[vid] == 0) {
+				continue;
+			}
+			long priority = 0;
+			if(time - timestamps[vid] + 2 * live[vid] <= cacheSize) {
+				priority = long(time - timestamps[vid]);
+			}
+			if(priority > best) {
+				best = priority;
+				next = long(vid);
+			}
+		}
+		if(next >= 0) {
+			fanning = next;
+			continue;
+		}
+
+		// Dead end: look for a recently used vertex, or the next vertex with remaining triangles.
+		while(!deadEnds.empty() && next < 0) {
+			const unsigned int vid = deadEnds.back();
+			deadEnds.pop_back();
+			next = live[vid] > 0 ? long(vid) : -1;
+		}
+		while(next < 0 && cursor < vertexCount) {
+			next = live[cursor] > 0 ? long(cursor) : -1;
+			++cursor;
+		}
+		// A new cluster starts if the vertex is not in cache anymore.
+		if(next >= 0 && clusters && time - timestamps[next] > cacheSize) {
+			clusters->push_back(result.size() / 3);
+		}
+		fanning = next;
+	}
+	indices = result;
+}
+
+void MeshOptimizer::optimizeOverdraw(const std::vector<glm::vec3> & positions, std::vector<unsigned int> & indices, const std::vector<size_t> & clusters) {
+	const size_t triCount = indices.size() / 3;
+	if(clusters.size() < 2 || triCount == 0) {
+		return;
+	}
+	// Mesh centroid, weighted by area.
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for(size_t tid = 0; tid < triCount; ++tid) {
+		const glm::vec3 & p0 = positions[indices[3 * tid]];
+		const glm::vec3 & p1 = positions[indices[3 * tid + 1]];
+		const glm::vec3 & p2 = positions[indices[3 * tid + 2]];
+		const float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+		meshCenter += area * (p0 + p1 + p2) / 3.0f;
+		meshArea += area;
+	}
+	meshCenter /= std::max(meshArea, 1e-12f);
+
+	// Clusters facing away from the mesh center are more likely to occlude the others.
+	std::vector<std::pair<float, size_t>> scores(clusters.size());
+	for(size_t cid = 0; cid < clusters.size(); ++cid) {
+		const size_t end = cid + 1 < clusters.size() ? clusters[cid + 1] : triCount;
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for(size_t tid = clusters[cid]; tid < end; ++tid) {
+			const glm::vec3 & p0 = positions[indices[3 * tid]];
+			const glm::vec3 & p1 = positions[indices[3 * tid + 1]];
+			const glm::vec3 & p2 = positions[indices[3 * tid + 2]];
+			const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+			const float triArea = glm::length(cross);
+			center += triArea * (p0 + p1 + p2) / 3.0f;
+			normal += cross;
+			area += triArea;
+		}
+		center /= std::max(area, 1e-12f);
+		const float length = glm::length(normal);
+		scores[cid].first = length > 0.0f ? glm::dot(center - meshCenter, normal / length) : 0.0f;
+		scores[cid].second = cid;
+	}
+	std::stable_sort(scores.begin(), scores.end(), [](const std::pair<float, size_t> & a, const std::pair<float, size_t> & b) {
+		return a.first > b.first;
+	});
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	for(const auto & score : scores) {
+		const size_t cid = score.second;
+		const size_t end = cid + 1 < clusters.size() ? clusters[cid + 1] : triCount;
+		result.insert(result.end(), indices.begin() + 3 * clusters[cid], indices.begin() + 3 * end);
+	}
+	indices = result;
+}
+
+/** Reorder the elements of an attribute array.
+ \param attribute the array to reorder
+ \param remap the new index of each element
+ */
+template<typename T>
+static void remapAttribute(std::vector<T> & attribute, const std::vector<unsigned int> & remap) {
+	if(attribute.size() != remap.size()) {
+		return;
+	}
+	std::vector<T> result(attribute.size());
+	for(size_t vid = 0; vid < remap.size(); ++vid) {
+		result[remap[vid]] = attribute[vid];
+	}
+	attribute = std::move(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(Mesh & mesh) {
+	const size_t vertexCount = mesh.positions.size();
+	const unsigned int unassigned = std::numeric_limits<unsigned int>::max();
+	std::vector<unsigned int> remap(vertexCount, unassigned);
+	unsigned int next = 0;
+	for(const unsigned int vid : mesh.indices) {
+		if(remap[vid] == unassigned) {
+			remap[vid] = next++;
+		}
+	}
+	// Unreferenced vertices are moved to the end.
+	for(unsigned int & id : remap) {
+		if(id == unassigned) {
+			id = next++;
+		}
+	}
+
+	remapAttribute(mesh.positions, remap);
+	remapAttribute(mesh.normals, remap);
+	remapAttribute(mesh.tangents, remap);
+	remapAttribute(mesh.binormals, remap);
+	remapAttribute(mesh.colors, remap);
+	remapAttribute(mesh.texcoords, remap);
+	for(unsigned int & vid : mesh.indices) {
+		vid = remap[vid];
+	}
+	for(auto & level : mesh.levels) {
+		for(unsigned int & vid : level) {
+			vid = remap[vid];
+		}
+	}
+}
+
+std::pair<MeshOptimizer::Statistics, MeshOptimizer::Statistics> MeshOptimizer::optimize(Mesh & mesh, uint cacheSize) {
+	const size_t vertexCount = mesh.positions.size();
+	const Statistics before = analyze(mesh.indices, vertexCount, cacheSize);
+
+	std::vector<size_t> clusters;
+	optimizeVertexCache(mesh.indices, vertexCount, cacheSize, &clusters);
+	optimizeOverdraw(mesh.positions, mesh.indices, clusters);
+	for(auto & level : mesh.levels) {
+		optimizeVertexCache(level, vertexCount, cacheSize, nullptr);
+	}
+	optimizeVertexFetch(mesh);
+
+	const Statistics after = analyze(mesh.indices, vertexCount, cacheSize);
+	return std::make_pair(before, after);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "resources/Mesh.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Reorder the triangles and vertices of a mesh to make better use of the GPU caches, without changing its geometry.
+ \details Three stages are applied:
+ - triangles are reordered to reuse recently transformed vertices, with the Tipsify algorithm (see Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, P. Sander, D. Nehab and J. Barczak, SIGGRAPH 2007);
+ - the clusters of triangles produced at cache flushes are sorted so that outward facing clusters are drawn first, to reduce overdraw;
+ - vertices are reordered in the order of their first use, to improve vertex fetching locality.
+ The efficiency of an ordering is measured by the average number of vertices transformed per triangle (ACMR) and per vertex (ATVR), using a FIFO cache model.
+ \ingroup Resources
+ */
+class MeshOptimizer {
+public:
+
+	/** \brief Vertex cache efficiency of a triangles ordering. */
+	struct Statistics {
+		float acmr = 0.0f; ///< Average cache miss ratio, the number of vertices transformed per triangle (between 0.5 and 3).
+		float atvr = 0.0f; ///< Average transformed vertex ratio, the number of times each vertex is transformed (1 is optimal).
+	};
+
+	/** Simulate a FIFO vertex cache to estimate the efficiency of a triangles ordering.
+	 \param indices the triangles indices
+	 \param vertexCount the number of vertices
+	 \param cacheSize the simulated cache size
+	 \return the cache statistics
+	 */
+	static Statistics analyze(const std::vector<unsigned int> & indices, size_t vertexCount, uint cacheSize = 16);
+
+	/** Reorder triangles to improve vertex cache reuse.
+	 \param indices the triangles indices, updated in place
+	 \param vertexCount the number of vertices
+	 \param cacheSize the target cache size
+	 \param clusters if non null, will receive the index of the first triangle of each cluster delimited by cache flushes
+	 */
+	static void optimizeVertexCache(std::vector<unsigned int> & indices, size_t vertexCount, uint cacheSize, std::vector<size_t> * clusters);
+
+	/** Reorder clusters of triangles to reduce overdraw, drawing outward facing clusters first.
+	 \param positions the vertices positions
+	 \param indices the triangles indices, updated in place
+	 \param clusters the index of the first triangle of each cluster
+	 */
+	static void optimizeOverdraw(const std::vector<glm::vec3> & positions, std::vector<unsigned int> & indices, const std::vector<size_t> & clusters);
+
+	/** Reorder the vertices of a mesh in the order of their first use by the full resolution triangles. Levels of detail indices are updated.
+	 \param mesh the mesh to process
+	 */
+	static void optimizeVertexFetch(Mesh & mesh);
+
+	/** Apply all optimizations to a mesh and its levels of detail.
+	 \param mesh the mesh to process
+	 \param cacheSize the target cache size
+	 \return the full resolution cache statistics before and after optimization
+	 */
+	static std::pair<Statistics, Statistics> optimize(Mesh & mesh, uint cacheSize = 16);
+
+};
@@ -0,0 +1,439 @@
+#include "resources/MeshSimplifier.hpp"
+
+#include <numeric>
+
+/** \brief Symmetric quadric form, accumulating weighted squared distances to planes. */
+struct Quadric {
+	double a00 = 0.0, a11 = 0.0, a22 = 0.0; ///< Diagonal of the matrix.
+	double a01 = 0.0, a02 = 0.0, a12 = 0.0; ///< Off-diagonal terms of the matrix.
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0; ///< Linear terms.
+	double c = 0.0; ///< Constant term.
+	double weight = 0.0; ///< Sum of the planes weights.
+
+	/** Add a plane to the quadric.
+	 \param n the plane unit normal
+	 \param d the plane offset
+	 \param w the plane weight
+	 */
+	void addPlane(const glm::dvec3 & n, double d, double w) {
+		a00 += w * n.x * n.x; a11 += w * n.y * n.y; a22 += w * n.z * n.z;
+		a01 += w * n.x * n.y; a02 += w * n.x * n.z; a12 += w * n.y * n.z;
+		b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+		c += w * d * d;
+		weight += w;
+	}
+
+	/** Accumulate another quadric.
+	 \param q the quadric to add
+	 */
+	void add(const Quadric & q) {
+		a00 += q.a00; a11 += q.a11; a22 += q.a22;
+		a01 += q.a01; a02 += q.a02; a12 += q.a12;
+		b0 += q.b0; b1 += q.b1; b2 += q.b2;
+		c += q.c;
+		weight += q.weight;
+	}
+
+	/** Evaluate the weighted sum of squared distances from a point to the planes.
+	 \param p the point
+	 \return the sum
+	 */
+	double evaluate(const glm::vec3 & p) const {
+		const double x = p.x, y = p.y, z = p.z;
+		const double quad = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z);
+		return std::abs(quad + 2.0 * (b0 * x + b1 * y + b2 * z) + c);
+	}
+};
+
+/// Topological kind of a vertex, determining which collapses are allowed.
+enum class VertexKind : uint8_t {
+	MANIFOLD, ///< Interior vertex, can collapse to any neighbor.
+	BORDER, ///< Vertex on the mesh border, can only collapse along it.
+	SEAM, ///< Vertex duplicated once, can only collapse along the seam with its duplicate.
+	LOCKED ///< Vertex that should not move.
+};
+
+/** Build a 64 bits key for an edge.
+ \param a the first vertex
+ \param b the second vertex
+ \return the key
+ */
+static uint64_t edgeKey(unsigned int a, unsigned int b) {
+	return (uint64_t(a) << 32) | uint64_t(b);
+}
+
+/** Check if a sorted list of edge keys contains an edge.
+ \param edges the sorted keys
+ \param a the first vertex
+ \param b the second vertex
+ \return true if the edge is present
+ */
+static bool hasEdge(const std::vector<uint64_t> & edges, unsigned int a, unsigned int b) {
+	return std::binary_search(edges.begin(), edges.end(), edgeKey(a, b));
+}
+
+/** Count the occurrences of an edge in a sorted list of edge keys.
+ \param edges the sorted keys
+ \param a the first vertex
+ \param b the second vertex
+ \return the number of occurrences
+ */
+static size_t countEdge(const std::vector<uint64_t> & edges, unsigned int a, unsigned int b) {
+	const auto range = std::equal_range(edges.begin(), edges.end(), edgeKey(std::min(a, b), std::max(a, b)));
+	return size_t(range.second - range.first);
+}
+
+float MeshSimplifier::simplify(const Mesh & mesh, const std::vector<unsigned int> & indices, size_t targetCount, float maxError, float attributeWeight, std::vector<unsigned int> & result) {
+	result = indices;
+	const size_t vertexCount = mesh.positions.size();
+	const size_t triCount = indices.size() / 3;
+	if(triCount <= targetCount || vertexCount == 0) {
+		return 0.0f;
+	}
+	const std::vector<glm::vec3> & positions = mesh.positions;
+	const bool hasNormals = mesh.normals.size() == vertexCount;
+	const bool hasTexcoords = mesh.texcoords.size() == vertexCount;
+
+	// Errors are relative to the size of the mesh.
+	BoundingBox bbox;
+	for(const unsigned int vid : indices) {
+		bbox.minis = glm::min(bbox.minis, positions[vid]);
+		bbox.maxis = glm::max(bbox.maxis, positions[vid]);
+	}
+	const double extent = double(glm::length(bbox.getSize()));
+	if(extent == 0.0) {
+		return 0.0f;
+	}
+
+	// Group vertices sharing the same position, the first vertex of the group acting as its identifier.
+	std::vector<unsigned int> sorted(vertexCount);
+	std::iota(sorted.begin(), sorted.end(), 0u);
+	std::sort(sorted.begin(), sorted.end(), [&positions](unsigned int a, unsigned int b) {
+		const glm::vec3 & pa = positions[a];
+		const glm::vec3 & pb = positions[b];
+		return pa.x < pb.x || (pa.x == pb.x && (pa.y < pb.y || (pa.y == pb.y && pa.z < pb.z)));
+	});
+	std::vector<unsigned int> groups(vertexCount);
+	std::vector<unsigned int> wedges(vertexCount, 1);
+	// Each vertex points to the next one in its group, forming a loop.
+	std::vector<unsigned int> siblings(vertexCount);
+	for(size_t sid = 0; sid < vertexCount;) {
+		size_t eid = sid + 1;
+		while(eid < vertexCount && positions[sorted[eid]] == positions[sorted[sid]]) {
+			++eid;
+		}
+		const unsigned int first = *std::min_element(sorted.begin() + sid, sorted.begin() + eid);
+		for(size_t vid = sid; vid < eid; ++vid) {
+			groups[sorted[vid]] = first;
+			wedges[sorted[vid]] = (unsigned int)(eid - sid);
+			siblings[sorted[vid]] = sorted[vid + 1 < eid ? vid + 1 : sid];
+		}
+		sid = eid;
+	}
+
+	// Directed edges between vertices, and undirected edges between positions.
+	std::vector<uint64_t> edges;
+	std::vector<uint64_t> groupEdges;
+	auto buildEdges = [&](const std::vector<unsigned int> & triangles) {
+		edges.clear();
+		groupEdges.clear();
+		for(size_t tid = 0; tid < triangles.size(); tid += 3) {
+			for(size_t k = 0; k < 3; ++k) {
+				const unsigned int a = triangles[tid + k];
+				const unsigned int b = triangles[tid + (k + 1) % 3];
+				edges.push_back(edgeKey(a, b));
+				groupEdges.push_back(edgeKey(std::min(groups[a], groups[b]), std::max(groups[a], groups[b])));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		std::sort(groupEdges.begin(), groupEdges.end());
+	};
+	buildEdges(indices);
+
+	// Classify vertices, based on their open edges (without a reverse edge between the same vertices).
+	std::vector<unsigned int> openCount(vertexCount, 0);
+	std::vector<uint8_t> onBorder(vertexCount, 0);
+	std::vector<uint8_t> complex(vertexCount, 0);
+	for(size_t tid = 0; tid < indices.size(); tid += 3) {
+		for(size_t k = 0; k < 3; ++k) {
+			const unsigned int a = indices[tid + k];
+			const unsigned int b = indices[tid + (k + 1) % 3];
+			const size_t faces = countEdge(groupEdges, groups[a], groups[b]);
+			const auto directed = std::equal_range(edges.begin(), edges.end(), edgeKey(a, b));
+			if(faces > 2 || directed.second - directed.first > 1) {
+				complex[groups[a]] = complex[groups[b]] = 1;
+			}
+			if(faces == 1) {
+				onBorder[groups[a]] = onBorder[groups[b]] = 1;
+			}
+			if(!hasEdge(edges, b, a)) {
+				++openCount[a];
+				++openCount[b];
+			}
+		}
+	}
+	std::vector<VertexKind> kinds(vertexCount, VertexKind::LOCKED);
+	for(size_t vid = 0; vid < vertexCount; ++vid) {
+		const unsigned int group = groups[vid];
+		if(complex[group]) {
+			continue;
+		}
+		if(wedges[vid] == 1) {
+			if(openCount[vid] == 0) {
+				kinds[vid] = VertexKind::MANIFOLD;
+			} else if(openCount[vid] == 2 && onBorder[group]) {
+				kinds[vid] = VertexKind::BORDER;
+			}
+		} else if(wedges[vid] == 2 && !onBorder[group] && openCount[vid] == 2 && openCount[siblings[vid]] == 2) {
+			kinds[vid] = VertexKind::SEAM;
+		}
+	}
+
+	// Plane quadrics of each position, with constraints keeping open edges in place.
+	std::vector<Quadric> quadrics(vertexCount);
+	for(size_t tid = 0; tid < indices.size(); tid += 3) {
+		const glm::dvec3 p0(positions[indices[tid]]);
+		const glm::dvec3 p1(positions[indices[tid + 1]]);
+		const glm::dvec3 p2(positions[indices[tid + 2]]);
+		const glm::dvec3 cross = glm::cross(p1 - p0, p2 - p0);
+		const double area = glm::length(cross);
+		if(area == 0.0) {
+			continue;
+		}
+		const glm::dvec3 n = cross / area;
+		Quadric plane;
+		plane.addPlane(n, -glm::dot(n, p0), area);
+		for(size_t k = 0; k < 3; ++k) {
+			quadrics[groups[indices[tid + k]]].add(plane);
+		}
+		for(size_t k = 0; k < 3; ++k) {
+			const unsigned int a = indices[tid + k];
+			const unsigned int b = indices[tid + (k + 1) % 3];
+			if(hasEdge(edges, b, a)) {
+				continue;
+			}
+			const glm::dvec3 pa(positions[a]);
+			const glm::dvec3 edge = glm::dvec3(positions[b]) - pa;
+			const double length = glm::length(edge);
+			if(length == 0.0) {
+				continue;
+			}
+			const glm::dvec3 en = glm::normalize(glm::cross(edge, n));
+			Quadric constraint;
+			constraint.addPlane(en, -glm::dot(en, pa), 10.0 * length * length);
+			quadrics[groups[a]].add(constraint);
+			quadrics[groups[b]].add(constraint);
+		}
+	}
+
+	/// A collapse of a vertex onto one of its neighbors.
+	struct Collapse {
+		double cost; ///< Geometric and attributes error introduced, used for ordering.
+		double error; ///< Geometric error introduced.
+		unsigned int from; ///< Moved vertex.
+		unsigned int to; ///< Target vertex.
+	};
+
+	const double attributeScale = double(attributeWeight) * extent * extent;
+	auto attributeCost = [&](unsigned int from, unsigned int to) {
+		double cost = 0.0;
+		if(hasNormals) {
+			const glm::vec3 delta = mesh.normals[from] - mesh.normals[to];
+			cost += double(glm::dot(delta, delta));
+		}
+		if(hasTexcoords) {
+			const glm::vec2 delta = mesh.texcoords[from] - mesh.texcoords[to];
+			cost += double(glm::dot(delta, delta));
+		}
+		return attributeScale * cost;
+	};
+	// Find the duplicate of the target on the other side of a seam.
+	auto seamTarget = [&](unsigned int from, unsigned int to) {
+		const unsigned int sibling = siblings[from];
+		unsigned int candidate = to;
+		for(unsigned int wid = 0; wid < wedges[to]; ++wid) {
+			candidate = siblings[candidate];
+			if(candidate != to && (hasEdge(edges, sibling, candidate) != hasEdge(edges, candidate, sibling))) {
+				return candidate;
+			}
+		}
+		return to;
+	};
+	auto allowed = [&](unsigned int from, unsigned int to) {
+		if(groups[from] == groups[to]) {
+			return false;
+		}
+		switch(kinds[from]) {
+			case VertexKind::MANIFOLD:
+				return true;
+			case VertexKind::BORDER:
+				return countEdge(groupEdges, groups[from], groups[to]) == 1;
+			case VertexKind::SEAM:
+				return countEdge(groupEdges, groups[from], groups[to]) == 2 && (hasEdge(edges, from, to) != hasEdge(edges, to, from)) && seamTarget(from, to) != to;
+			default:
+				return false;
+		}
+	};
+
+	const double maxCost = double(maxError) * double(maxError) * extent * extent;
+	double error = 0.0;
+	std::vector<unsigned int> & current = result;
+	std::vector<unsigned int> offsets(vertexCount + 1);
+	std::vector<unsigned int> adjacency;
+	std::vector<unsigned int> collapses(vertexCount);
+	std::vector<uint8_t> locked(vertexCount);
+	std::vector<Collapse> candidates;
+
+	// Check that moving a vertex does not flip any of its triangles.
+	auto flips = [&](unsigned int from, unsigned int to) {
+		const glm::vec3 & target = positions[to];
+		for(unsigned int aid = offsets[from]; aid < offsets[from + 1]; ++aid) {
+			const unsigned int * tri = &current[3 * adjacency[aid]];
+			if(tri[0] == to || tri[1] == to || tri[2] == to) {
+				continue;
+			}
+			const glm::vec3 & p0 = positions[tri[0]];
+			const glm::vec3 & p1 = positions[tri[1]];
+			const glm::vec3 & p2 = positions[tri[2]];
+			const glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+			const glm::vec3 q0 = tri[0] == from ? target : p0;
+			const glm::vec3 q1 = tri[1] == from ? target : p1;
+			const glm::vec3 q2 = tri[2] == from ? target : p2;
+			const glm::vec3 after = glm::cross(q1 - q0, q2 - q0);
+			if(glm::dot(before, after) <= 1e-2f * glm::length(before) * glm::length(after)) {
+				return true;
+			}
+		}
+		return false;
+	};
+	// Number of triangles removed by a collapse, and lock its neighborhood for the current pass.
+	auto apply = [&](unsigned int from, unsigned int to) {
+		size_t removed = 0;
+		collapses[from] = to;
+		for(unsigned int aid = offsets[from]; aid < offsets[from + 1]; ++aid) {
+			const unsigned int * tri = &current[3 * adjacency[aid]];
+			removed += (tri[0] == to || tri[1] == to || tri[2] == to) ? 1 : 0;
+			locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = 1;
+		}
+		return removed;
+	};
+
+	while(current.size() / 3 > targetCount) {
+		// Edges and triangles adjacent to each vertex.
+		buildEdges(current);
+		std::fill(offsets.begin(), offsets.end(), 0u);
+		for(const unsigned int vid : current) {
+			++offsets[vid + 1];
+		}
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		adjacency.resize(current.size());
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for(size_t id = 0; id < current.size(); ++id) {
+			adjacency[fill[current[id]]++] = (unsigned int)(id / 3);
+		}
+
+		// Evaluate the cost of all valid collapses.
+		candidates.clear();
+		for(size_t tid = 0; tid < current.size(); tid += 3) {
+			for(size_t k = 0; k < 6; ++k) {
+				const unsigned int from = current[tid + k % 3];
+				const unsigned int to = current[tid + (k < 3 ? (k + 1) % 3 : (k + 2) % 3)];
+				if(!allowed(from, to)) {
+					continue;
+				}
+				Quadric quadric = quadrics[groups[from]];
+				quadric.add(quadrics[groups[to]]);
+				const double geometric = quadric.evaluate(positions[to]) / std::max(quadric.weight, 1e-12);
+				double cost = geometric + attributeCost(from, to);
+				if(kinds[from] == VertexKind::SEAM) {
+					cost += attributeCost(siblings[from], seamTarget(from, to));
+				}
+				if(geometric <= maxCost) {
+					candidates.push_back({cost, geometric, from, to});
+				}
+			}
+		}
+		if(candidates.empty()) {
+			break;
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse & a, const Collapse & b) {
+			return a.cost < b.cost;
+		});
+
+		// Apply the cheapest collapses that don't overlap.
+		std::iota(collapses.begin(), collapses.end(), 0u);
+		std::fill(locked.begin(), locked.end(), uint8_t(0));
+		const size_t needed = current.size() / 3 - targetCount;
+		size_t removed = 0;
+		size_t applied = 0;
+		for(const Collapse & collapse : candidates) {
+			if(removed >= needed) {
+				break;
+			}
+			const unsigned int from = collapse.from;
+			const unsigned int to = collapse.to;
+			const bool seam = kinds[from] == VertexKind::SEAM;
+			const unsigned int fromSibling = seam ? siblings[from] : from;
+			const unsigned int toSibling = seam ? seamTarget(from, to) : to;
+			if(locked[from] || locked[to] || locked[fromSibling] || locked[toSibling]) {
+				continue;
+			}
+			if(flips(from, to) || (seam && flips(fromSibling, toSibling))) {
+				continue;
+			}
+			removed += apply(from, to);
+			if(seam) {
+				removed += apply(fromSibling, toSibling);
+			}
+			locked[to] = locked[toSibling] = 1;
+			quadrics[groups[to]].add(quadrics[groups[from]]);
+			error = std::max(error, collapse.error);
+			++applied;
+		}
+		if(applied == 0) {
+			break;
+		}
+
+		// Update triangles and remove degenerate ones.
+		size_t kept = 0;
+		for(size_t tid = 0; tid < current.size(); tid += 3) {
+			const unsigned int i0 = collapses[current[tid]];
+			const unsigned int i1 = collapses[current[tid + 1]];
+			const unsigned int i2 = collapses[current[tid + 2]];
+			if(i0 == i1 || i1 == i2 || i2 == i0) {
+				continue;
+			}
+			current[kept++] = i0;
+			current[kept++] = i1;
+			current[kept++] = i2;
+		}
+		current.resize(kept);
+	}
+	return float(std::sqrt(error) / extent);
+}
+
+void MeshSimplifier::generateLevels(Mesh & mesh, const Settings & settings) {
+	mesh.levels.clear();
+	mesh.levelErrors.clear();
+	mesh.levels.reserve(settings.maxLevels);
+	float error = 0.0f;
+	const std::vector<unsigned int> * source = &mesh.indices;
+
+	for(uint lid = 0; lid < settings.maxLevels; ++lid) {
+		const size_t triCount = source->size() / 3;
+		if(triCount < settings.minTriangles || error >= settings.maxError) {
+			break;
+		}
+		const size_t target = size_t(float(triCount) * settings.reduction);
+		std::vector<unsigned int> level;
+		const float levelError = simplify(mesh, *source, target, settings.maxError - error, settings.attributeWeight, level);
+		// Stop if the simplification is stuck.
+		if(level.size() / 3 > size_t(0.9f * float(triCount))) {
+			break;
+		}
+		error += levelError;
+		mesh.levels.push_back(std::move(level));
+		mesh.levelErrors.push_back(error);
+		source = &mesh.levels.back();
+	}
+}
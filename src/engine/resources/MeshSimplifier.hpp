@@ -0,0 +1,40 @@
+#pragma once
+#include "resources/Mesh.hpp"
+#include "Common.hpp"
+
+/**
+ \brief Generate simplified versions of a mesh, using quadric error metrics.
+ \details Edges are collapsed onto one of their vertices, so that simplified versions only need new triangle indices and can share the mesh vertex buffers. The cost of a collapse is the quadric error of the moved vertex (see Surface Simplification Using Quadric Error Metrics, M. Garland and P. Heckbert, SIGGRAPH 1997), with an additional penalty for normals and texture coordinates deviation. Mesh borders are kept in place, and seams (vertices duplicated because of different attributes) can only be collapsed along their length, moving all duplicates together. Vertices with a more complex topology are locked.
+ \ingroup Resources
+ */
+class MeshSimplifier {
+public:
+
+	/** \brief Levels of detail generation settings. */
+	struct Settings {
+		uint maxLevels = 4; ///< Maximum number of simplified versions.
+		float reduction = 0.5f; ///< Ratio of triangles kept between two successive levels.
+		float maxError = 0.05f; ///< Maximum error of the coarsest level, relative to the mesh bounding box diagonal.
+		float attributeWeight = 0.01f; ///< Weight of the squared normals and texture coordinates deviation in the error.
+		size_t minTriangles = 64; ///< Levels with fewer triangles are not simplified further.
+	};
+
+	/** Simplify a mesh.
+	 \param mesh the mesh providing the vertices attributes
+	 \param indices the triangles to simplify
+	 \param targetCount the number of triangles to reach
+	 \param maxError the maximum error allowed, relative to the mesh bounding box diagonal
+	 \param attributeWeight the weight of attributes deviation in the error
+	 \param result will contain the simplified triangles indices
+	 \return the error of the simplified triangles, relative to the mesh bounding box diagonal
+	 \note Simplification stops before reaching the target if the error would exceed the maximum.
+	 */
+	static float simplify(const Mesh & mesh, const std::vector<unsigned int> & indices, size_t targetCount, float maxError, float attributeWeight, std::vector<unsigned int> & result);
+
+	/** Generate a chain of levels of detail for a mesh, each one simplified from the previous one. Existing levels are replaced.
+	 \param mesh the mesh to process
+	 \param settings the generation settings
+	 */
+	static void generateLevels(Mesh & mesh, const Settings & settings);
+
+};
@@ -1,5 +1,8 @@
 #include "resources/ResourcesManager.hpp"
 #include "resources/Mesh.hpp"
+#include "resources/MeshSimplifier.hpp"
+#include "resources/MeshOptimizer.hpp"
+#include "graphics/GLUtilities.hpp"
 #include "system/TextUtilities.hpp"
 #include "system/System.hpp"
 
@@ -8,6 +11,10 @@
 #include <miniz/miniz.h>
 #include <fstream>
 #include <sstream>
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 /** By enabling RESOURCES_PACKAGED, the resources will be loaded from a zip archive
  instead of the resources directory. Basic text files can still be read from disk
@@ -20,6 +27,40 @@ Resources & Resources::manager() {
 	return *res;
 }
 
+/** Estimate the CPU memory used by the geometry of a mesh.
+ \param mesh the mesh
+ \return the size in bytes
+ */
+static size_t cpuMemory(const Mesh & mesh) {
+	size_t bytes = (mesh.positions.size() + mesh.normals.size() + mesh.tangents.size() + mesh.binormals.size() + mesh.colors.size()) * sizeof(glm::vec3);
+	bytes += mesh.texcoords.size() * sizeof(glm::vec2);
+	bytes += mesh.indices.size() * sizeof(unsigned int);
+	for(const auto & level : mesh.levels) {
+		bytes += level.size() * sizeof(unsigned int);
+	}
+	return bytes;
+}
+
+/** Estimate the GPU memory used by the buffers of a mesh.
+ \param mesh the mesh
+ \return the size in bytes, or 0 if the mesh is not on the GPU
+ */
+static size_t gpuMemory(const Mesh & mesh) {
+	return mesh.gpu ? (mesh.gpu->vertexBytes + mesh.gpu->indexBytes) : 0;
+}
+
+/** Estimate the CPU memory used by the images of a texture.
+ \param texture the texture
+ \return the size in bytes
+ */
+static size_t cpuMemory(const Texture & texture) {
+	size_t bytes = 0;
+	for(const Image & image : texture.images) {
+		bytes += image.pixels.size() * sizeof(float);
+	}
+	return bytes;
+}
+
 #ifdef RESOURCES_PACKAGED
 void Resources::addResources(const std::string & path) {
 	Log::Info() << Log::Resources << "Loading resources from archive (" << path + ".zip"
@@ -123,17 +164,17 @@ std::string Resources::getImagePath(const std::string & name) {
 	std::string path;
 	// Check if the file exists with an image extension.
 	if(_files.count(name + ".png") > 0) {
-		path = _files[name + ".png"];
+		path = _files.at(name + ".png");
 	} else if(_files.count(name + ".jpg") > 0) {
-		path = _files[name + ".jpg"];
+		path = _files.at(name + ".jpg");
 	} else if(_files.count(name + ".jpeg") > 0) {
-		path = _files[name + ".jpeg"];
+		path = _files.at(name + ".jpeg");
 	} else if(_files.count(name + ".bmp") > 0) {
-		path = _files[name + ".bmp"];
+		path = _files.at(name + ".bmp");
 	} else if(_files.count(name + ".tga") > 0) {
-		path = _files[name + ".tga"];
+		path = _files.at(name + ".tga");
 	} else if(_files.count(name + ".exr") > 0) {
-		path = _files[name + ".exr"];
+		path = _files.at(name + ".exr");
 	}
 	return path;
 }
@@ -200,12 +241,29 @@ char * Resources::getRawData(const std::string & path, size_t & size) {
 
 #endif
 
+bool Resources::hasFile(const std::string & filename) const {
+	return _files.count(filename) > 0;
+}
+
+uint64_t Resources::modificationTime(const std::string & filename) const {
+	const auto file = _files.find(filename);
+	if(file == _files.end()) {
+		return 0;
+	}
+#ifdef RESOURCES_PACKAGED
+	// Archive entries are stored without timestamps.
+	return 0;
+#else
+	return System::modificationTime(file->second);
+#endif
+}
+
 std::string Resources::getString(const std::string & filename) {
 	std::string path;
 	if(_files.count(filename) > 0) {
-		path = _files[filename];
+		path = _files.at(filename);
 	} else if(_files.count(filename + ".txt") > 0) {
-		path = _files[filename + ".txt"];
+		path = _files.at(filename + ".txt");
 	} else {
 		Log::Error() << Log::Resources << "Unable to find text file named \"" << filename << "\"." << std::endl;
 		return "";
@@ -272,10 +330,56 @@ std::string Resources::getStringWithIncludes(const std::string& filename) {
 // Mesh method.
 
 const Mesh * Resources::getMesh(const std::string & name, Storage options) {
-	if(_meshes.count(name) > 0) {
-		return &_meshes.at(name);
+	const Mesh * mesh = requestMesh(name, options);
+	if(mesh) {
+		std::lock_guard<std::mutex> lock(_meshMutex);
+		++_meshResidency[mesh].references;
 	}
+	return mesh;
+}
 
+const Mesh * Resources::requestMesh(const std::string & name, Storage options) {
+	std::promise<const Mesh *> promise;
+	std::shared_future<const Mesh *> loading;
+	{
+		std::lock_guard<std::mutex> lock(_meshMutex);
+		const auto pending = _meshLoads.find(name);
+		if(pending != _meshLoads.end()) {
+			loading = pending->second;
+		} else {
+			const auto existing = _meshes.find(name);
+			if(existing != _meshes.end()) {
+				return &existing->second;
+			}
+			// Other requests for the same mesh will wait for this one.
+			_meshLoads[name] = promise.get_future().share();
+		}
+	}
+	if(loading.valid()) {
+		return loading.get();
+	}
+
+	// Decode without holding the lock.
+	std::unique_ptr<Mesh> loaded = loadMesh(name, options);
+	Mesh * mesh = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_meshMutex);
+		if(loaded) {
+			mesh = &(_meshes.emplace(std::make_pair(name, std::move(*loaded))).first->second);
+			_meshResidency[mesh].pending = true;
+		}
+		_meshLoads.erase(name);
+	}
+	if(mesh) {
+		runOnContext([this, mesh, options]() {
+			finalizeMesh(*mesh, options);
+		});
+	}
+	promise.set_value(mesh);
+	return mesh;
+}
+
+std::unique_ptr<Mesh> Resources::loadMesh(const std::string & name, Storage options) {
 	const std::string meshText = getString(name + ".obj");
 	if(meshText.empty()) {
 		Log::Error() << Log::Resources << "Unable to load mesh named " << name << "." << std::endl;
@@ -283,35 +387,98 @@ const Mesh * Resources::getMesh(const std::string & name, Storage options) {
 	}
 	// Load geometry. For now we only support OBJs.
 	std::stringstream meshStream(meshText);
-	_meshes.emplace(std::make_pair(name, Mesh(meshStream, Mesh::Load::Indexed, name)));
-	
-	auto & mesh = _meshes.at(name);
+	std::unique_ptr<Mesh> mesh(new Mesh(meshStream, Mesh::Load::Indexed, name));
+
 	const bool forceFrame = options & Storage::FORCE_FRAME;
-	if(forceFrame && mesh.normals.empty()){
-		mesh.computeNormals();
+	if(forceFrame && mesh->normals.empty()){
+		mesh->computeNormals();
 	}
 	// If uv or positions are missing, tangent/binormals won't be computed.
-	mesh.computeTangentsAndBinormals(forceFrame);
+	mesh->computeTangentsAndBinormals(forceFrame);
 	// Compute bounding box.
-	mesh.computeBoundingBox();
+	mesh->computeBoundingBox();
+	// Generate levels of detail, sharing the mesh vertices.
+	if(options & Storage::LODS) {
+		MeshSimplifier::generateLevels(*mesh, MeshSimplifier::Settings());
+	}
+	// Reorder triangles and vertices for the GPU caches.
+	const auto stats = MeshOptimizer::optimize(*mesh);
+	Log::Verbose() << Log::Resources << "Mesh " << name << ": ACMR " << stats.first.acmr << " -> " << stats.second.acmr << ", ATVR " << stats.first.atvr << " -> " << stats.second.atvr << "." << std::endl;
+	return mesh;
+}
 
+const Mesh * Resources::finalizeMesh(Mesh & mesh, Storage options) {
 	if(options & Storage::GPU) {
 		// Setup GL buffers and attributes.
-		mesh.upload();
+		Mesh::Format format;
+		format.packed = format.shortIndices = (options & Storage::PACKED);
+		mesh.upload(format);
+		mesh.gpu->lastUse = GLUtilities::frameIndex();
 	}
 	// If we are not planning on using the CPU data, remove it.
-	if(!(options & Storage::CPU)) {
-		mesh.clearGeometry();
+	// Meshes that are expensive to process are kept if they can be evicted, so that restoring them only uploads them again.
+	const bool keepGeometry = (options & Storage::CPU) || (_budget > 0 && ((options & Storage::LODS) || (options & Storage::POSITIONS)));
+	if(!keepGeometry) {
+		mesh.clearGeometry(options & Storage::POSITIONS);
+	}
+	std::lock_guard<std::mutex> lock(_meshMutex);
+	Residency & residency = _meshResidency[&mesh];
+	residency.source = mesh.name();
+	residency.options = options;
+	residency.evicted = false;
+	residency.pending = false;
+	residency.geometry = keepGeometry;
+	return &mesh;
+}
+
+void Resources::preload(const std::vector<std::string> & meshes, const std::vector<std::pair<std::string, Descriptor>> & textures, Storage options) {
+	const size_t meshCount = meshes.size();
+	const size_t jobCount  = meshCount + textures.size();
+	if(jobCount == 0) {
+		return;
 	}
 
-	return &_meshes.at(name);
+	// Decode all resources concurrently, each worker picking the next job available.
+	// Loaded resources are skipped, and duplicates are only loaded once.
+	std::atomic<size_t> nextJob(0);
+	auto worker = [&]() {
+		for(size_t jid = nextJob++; jid < jobCount; jid = nextJob++) {
+			if(jid < meshCount) {
+				if(!meshes[jid].empty()) {
+					requestMesh(meshes[jid], options);
+				}
+				continue;
+			}
+			const auto & texture = textures[jid - meshCount];
+			if(!texture.first.empty()) {
+				requestTexture(texture.first, texture.first, texture.second, options);
+			}
+		}
+	};
+	// Always leave one thread free.
+	const size_t threadCount = std::min(jobCount, size_t(std::max(int(std::thread::hardware_concurrency()) - 1, 1)));
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount);
+	for(size_t tid = 0; tid < threadCount; ++tid) {
+		threads.emplace_back(worker);
+	}
+	for(std::thread & thread : threads) {
+		thread.join();
+	}
+
+	// Upload on the calling thread if it owns the context, else at the next update.
+	if(std::this_thread::get_id() == _contextThread) {
+		processUploads();
+	}
 }
 
 // Texture methods.
 
 const Texture * Resources::getTexture(const std::string & name) {
-	if(_textures.count(name) > 0) {
-		return &(_textures.at(name));
+	std::lock_guard<std::mutex> lock(_textureMutex);
+	const auto existing = _textures.find(name);
+	if(existing != _textures.end()) {
+		return &existing->second;
 	}
 	Log::Error() << Log::Resources << "Unable to find existing texture \"" << name << "\"" << std::endl;
 	return nullptr;
@@ -319,33 +486,106 @@ const Texture * Resources::getTexture(const std::string & name) {
 
 const Texture * Resources::getTexture(const std::string & name, const Descriptor & descriptor, Storage options, const std::string & refName) {
 	const std::string & keyName = refName.empty() ? name : refName;
+	const Texture * texture = requestTexture(name, keyName, descriptor, options);
+	if(texture) {
+		std::lock_guard<std::mutex> lock(_textureMutex);
+		++_textureResidency[texture].references;
+	}
+	return texture;
+}
 
-	// If texture already loaded, return it.
-	if(_textures.count(keyName) > 0) {
-		auto & texture = _textures.at(keyName);
-		if(options & Storage::GPU) {
-			// If we want to store the texture on the GPU...
-			if(texture.gpu) {
-				// If the texture is already on the GPU, check that the layout is the same, else raise a warning.
-				if(!texture.gpu->hasSameLayoutAs(descriptor)) {
-					Log::Warning() << Log::Resources << "Texture \"" << keyName
-								   << "\" already exist with a different descriptor." << std::endl;
-				}
+const Texture * Resources::requestTexture(const std::string & name, const std::string & keyName, const Descriptor & descriptor, Storage options) {
+	std::promise<const Texture *> promise;
+	std::shared_future<const Texture *> loading;
+	Texture * existingTexture = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_textureMutex);
+		const auto pending = _textureLoads.find(keyName);
+		if(pending != _textureLoads.end()) {
+			loading = pending->second;
+		} else {
+			const auto existing = _textures.find(keyName);
+			if(existing != _textures.end()) {
+				existingTexture = &existing->second;
 			} else {
-				// Else upload to the GPU.
-				texture.upload(descriptor, texture.levels == 1);
+				// Other requests for the same texture will wait for this one.
+				_textureLoads[keyName] = promise.get_future().share();
 			}
 		}
-		// If we require CPU data but the images are empty, the texture CPU data was cleared...
-		// Don't try and reload, just print an error.
-		if((options & Storage::CPU) && texture.images.empty()) {
-			Log::Error() << Log::Resources << "Texture \"" << keyName
-						 << "\" exists but is not CPU available." << std::endl;
+	}
+	if(loading.valid()) {
+		return loading.get();
+	}
+	// If texture already loaded, check that it is compatible with the request.
+	if(existingTexture) {
+		runOnContext([this, existingTexture, descriptor, options]() {
+			updateTexture(*existingTexture, descriptor, options);
+		});
+		return existingTexture;
+	}
+
+	// Else, load the image(s) without holding the lock.
+	Texture loaded(keyName);
+	const bool found = loadTexture(name, descriptor, loaded);
+	Texture * texture = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_textureMutex);
+		if(found) {
+			texture = &(_textures.insert(std::make_pair<>(keyName, std::move(loaded))).first->second);
+			_textureResidency[texture].pending = true;
 		}
-		return &_textures.at(keyName);
+		_textureLoads.erase(keyName);
+	}
+	if(texture) {
+		runOnContext([this, texture, descriptor, options, name]() {
+			finalizeTexture(*texture, descriptor, options, name);
+		});
 	}
+	promise.set_value(texture);
+	return texture;
+}
 
-	// Else, find the corresponding file(s).
+void Resources::updateTexture(Texture & texture, const Descriptor & descriptor, Storage options) {
+	if(options & Storage::GPU) {
+		// If we want to store the texture on the GPU...
+		bool restorable = false;
+		{
+			std::lock_guard<std::mutex> lock(_textureMutex);
+			const Residency & residency = _textureResidency[&texture];
+			restorable = residency.evicted || residency.pending;
+		}
+		if(!texture.gpu && restorable) {
+			// The texture was evicted or is waiting for its upload.
+			restore(texture);
+		}
+		if(texture.gpu) {
+			// If the texture is already on the GPU, check that the layout is the same, else raise a warning.
+			if(!texture.gpu->hasSameLayoutAs(descriptor)) {
+				Log::Warning() << Log::Resources << "Texture \"" << texture.name()
+							   << "\" already exist with a different descriptor." << std::endl;
+			}
+		} else {
+			// Else upload to the GPU.
+			const bool mipmaps = texture.levels == 1;
+			texture.upload(descriptor, mipmaps);
+			texture.gpu->lastUse = GLUtilities::frameIndex();
+			std::lock_guard<std::mutex> lock(_textureMutex);
+			Residency & residency = _textureResidency[&texture];
+			residency.options = residency.options | Storage::GPU;
+			residency.descriptor = descriptor;
+			residency.mipmaps = mipmaps;
+		}
+	}
+	// If we require CPU data but the images are empty, the texture CPU data was cleared...
+	// Don't try and reload, just print an error.
+	if((options & Storage::CPU) && texture.images.empty()) {
+		Log::Error() << Log::Resources << "Texture \"" << texture.name()
+					 << "\" exists but is not CPU available." << std::endl;
+	}
+}
+
+bool Resources::loadTexture(const std::string & name, const Descriptor & descriptor, Texture & texture) {
+	// Find the corresponding file(s).
 	// Supported names:
 	// * "file", "file_0": 2D
 	// * "file_nx", "file_0_nx": cubemap
@@ -445,17 +685,13 @@ const Texture * Resources::getTexture(const std::string & name, const Descriptor
 	if(paths.empty()) {
 		// If couldn't file the image(s), return empty texture infos.
 		Log::Error() << Log::Resources << "Unable to find texture named \"" << name << "\"." << std::endl;
-		return nullptr;
+		return false;
 	}
 
 	// Format and orientation.
 	const uint channels = descriptor.getChannelsCount();
 	// Cubemaps don't need to be flipped.
 	const bool flip	= !(shape & TextureShape::Cube);
-	// We know the texture is not in the list, we insert.
-	_textures.insert(std::make_pair<>(keyName, Texture(keyName)));
-	Texture & texture  = _textures.at(keyName);
-
 	if(isColorString){
 		// For now we assume only one level and a 2D image.
 		const auto toks = TextUtilities::split(name, ",", true);
@@ -495,17 +731,299 @@ const Texture * Resources::getTexture(const std::string & name, const Descriptor
 	texture.height = texture.images[0].height;
 	texture.depth  = uint(paths[0].size());
 	texture.levels = uint(paths.size());
+	return true;
+}
 
+const Texture * Resources::finalizeTexture(Texture & texture, const Descriptor & descriptor, Storage options, const std::string & source) {
+	// A request on the context thread can upload the texture before this task is run, don't upload it twice.
+	// Uploads only happen on the context thread, so the GPU data can be checked without locking.
+	if(texture.gpu) {
+		Storage merged = options;
+		{
+			std::lock_guard<std::mutex> lock(_textureMutex);
+			Residency & residency = _textureResidency[&texture];
+			residency.source = source;
+			residency.evicted = false;
+			residency.pending = false;
+			residency.options = merged = residency.options | options;
+		}
+		if(!(merged & Storage::CPU)) {
+			texture.clearImages();
+		}
+		return &texture;
+	}
+	// If only one level was given, generate the mipmaps.
+	const bool mipmaps = texture.levels == 1;
 	// If GPU mode, send them to the GPU.
 	if(options & Storage::GPU) {
-		// If only one level was given, generate the mipmaps.
-		texture.upload(descriptor, texture.levels == 1);
+		texture.upload(descriptor, mipmaps);
+		texture.gpu->lastUse = GLUtilities::frameIndex();
 	}
 	// If GPU only, clear the CPU data.
 	if(!(options & Storage::CPU)) {
 		texture.clearImages();
 	}
-	return &_textures.at(keyName);
+	std::lock_guard<std::mutex> lock(_textureMutex);
+	Residency & residency = _textureResidency[&texture];
+	residency.source = source;
+	residency.descriptor = descriptor;
+	residency.options = options;
+	residency.mipmaps = mipmaps;
+	residency.evicted = false;
+	residency.pending = false;
+	return &texture;
+}
+
+// Threading methods.
+
+void Resources::runOnContext(const std::function<void()> & task) {
+	if(std::this_thread::get_id() == _contextThread) {
+		task();
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_uploadMutex);
+	_uploads.push_back(task);
+}
+
+void Resources::processUploads() {
+	// Pop tasks one at a time, as a task can restore resources and process the queue itself.
+	while(true) {
+		std::function<void()> task;
+		{
+			std::lock_guard<std::mutex> lock(_uploadMutex);
+			if(_uploads.empty()) {
+				return;
+			}
+			task = std::move(_uploads.front());
+			_uploads.pop_front();
+		}
+		task();
+	}
+}
+
+// Residency methods.
+
+void Resources::setBudget(size_t bytes) {
+	_budget = bytes;
+	if(_budget > 0) {
+		Log::Info() << Log::Resources << "GPU memory budget: " << (_budget / (1024 * 1024)) << "MB." << std::endl;
+	}
+}
+
+void Resources::update() {
+	// Upload resources loaded by other threads.
+	processUploads();
+
+	if(_budget == 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> meshLock(_meshMutex);
+	std::lock_guard<std::mutex> textureLock(_textureMutex);
+
+	/// Resident mesh or texture.
+	struct Candidate {
+		Mesh * mesh;
+		Texture * texture;
+		Residency * residency;
+		size_t bytes;
+		size_t lastUse;
+	};
+	// Gather resident resources, keeping the ones that have not been used recently.
+	const size_t frame = GLUtilities::frameIndex();
+	std::vector<Candidate> candidates;
+	size_t total = 0;
+	for(auto & entry : _meshes) {
+		Mesh & mesh = entry.second;
+		if(!mesh.gpu) {
+			continue;
+		}
+		const size_t bytes = gpuMemory(mesh);
+		total += bytes;
+		if(mesh.gpu->lastUse + _minUnusedFrames < frame) {
+			candidates.push_back({&mesh, nullptr, &_meshResidency[&mesh], bytes, mesh.gpu->lastUse});
+		}
+	}
+	for(auto & entry : _textures) {
+		Texture & texture = entry.second;
+		if(!texture.gpu) {
+			continue;
+		}
+		const size_t bytes = texture.gpuMemory();
+		total += bytes;
+		if(texture.gpu->lastUse + _minUnusedFrames < frame) {
+			candidates.push_back({nullptr, &texture, &_textureResidency[&texture], bytes, texture.gpu->lastUse});
+		}
+	}
+	if(total <= _budget) {
+		return;
+	}
+
+	// Evict unreferenced resources first, then the least recently used ones.
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate & a, const Candidate & b) {
+		const bool aReferenced = a.residency->references > 0;
+		const bool bReferenced = b.residency->references > 0;
+		if(aReferenced != bReferenced) {
+			return bReferenced;
+		}
+		return a.lastUse < b.lastUse;
+	});
+	size_t count = 0;
+	size_t freed = 0;
+	for(const Candidate & candidate : candidates) {
+		if(total <= _budget) {
+			break;
+		}
+		if(candidate.mesh) {
+			candidate.mesh->clearGPU();
+		} else {
+			candidate.texture->clearGPU();
+		}
+		candidate.residency->evicted = true;
+		total -= candidate.bytes;
+		freed += candidate.bytes;
+		++count;
+	}
+	_evictions += count;
+	if(count > 0) {
+		Log::Verbose() << Log::Resources << "Evicted " << count << " resource(s), " << (freed / 1024) << "kB released." << std::endl;
+	}
+}
+
+bool Resources::restore(const Mesh & mesh) {
+	Residency infos;
+	Mesh * target = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_meshMutex);
+		const auto residency = _meshResidency.find(&mesh);
+		if(residency != _meshResidency.end()) {
+			infos = residency->second;
+			target = &_meshes.at(mesh.name());
+		}
+	}
+	// The mesh was loaded by another thread, upload it now.
+	if(infos.pending) {
+		processUploads();
+		return mesh.gpu != nullptr;
+	}
+	if(!target || !infos.evicted) {
+		Log::Error() << Log::Resources << "Mesh \"" << mesh.name() << "\" is not available on the GPU." << std::endl;
+		return false;
+	}
+	// Reload from disk if the full geometry was not kept on the CPU.
+	// This is done on another thread to avoid stalling the frame, and the mesh is skipped until then.
+	if(!infos.geometry) {
+		std::lock_guard<std::mutex> lock(_meshMutex);
+		_meshResidency[target].pending = true;
+		_meshRestores[target->name()] = std::async(std::launch::async, [this, target, infos]() {
+			std::shared_ptr<Mesh> loaded(loadMesh(infos.source, infos.options));
+			runOnContext([this, target, infos, loaded]() {
+				if(!loaded) {
+					std::lock_guard<std::mutex> lock(_meshMutex);
+					_meshResidency[target].pending = false;
+					return;
+				}
+				*target = std::move(*loaded);
+				finalizeMesh(*target, infos.options);
+				++_restorations;
+				Log::Verbose() << Log::Resources << "Restored mesh \"" << target->name() << "\"." << std::endl;
+			});
+		});
+		return false;
+	}
+	finalizeMesh(*target, infos.options);
+	++_restorations;
+	Log::Verbose() << Log::Resources << "Restored mesh \"" << mesh.name() << "\"." << std::endl;
+	return target->gpu != nullptr;
+}
+
+bool Resources::restore(const Texture & texture) {
+	Residency infos;
+	Texture * target = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_textureMutex);
+		const auto residency = _textureResidency.find(&texture);
+		if(residency != _textureResidency.end()) {
+			infos = residency->second;
+			target = &_textures.at(texture.name());
+		}
+	}
+	// The texture was loaded by another thread, upload it now.
+	if(infos.pending) {
+		processUploads();
+		return texture.gpu != nullptr;
+	}
+	if(!target || !infos.evicted) {
+		Log::Error() << Log::Resources << "Texture \"" << texture.name() << "\" is not available on the GPU." << std::endl;
+		return false;
+	}
+	if(target->images.empty()) {
+		// Reload from disk if the images were not kept on the CPU.
+		Texture loaded(target->name());
+		if(!loadTexture(infos.source, infos.descriptor, loaded)) {
+			return false;
+		}
+		*target = std::move(loaded);
+	} else if(infos.mipmaps) {
+		// Only the first level is stored on the CPU, mipmaps will be generated again.
+		target->levels = 1;
+	}
+	finalizeTexture(*target, infos.descriptor, infos.options, infos.source);
+	++_restorations;
+	Log::Verbose() << Log::Resources << "Restored texture \"" << texture.name() << "\"." << std::endl;
+	return target->gpu != nullptr;
+}
+
+void Resources::release(const Mesh * mesh) {
+	std::lock_guard<std::mutex> lock(_meshMutex);
+	const auto residency = _meshResidency.find(mesh);
+	if(residency != _meshResidency.end() && residency->second.references > 0) {
+		--residency->second.references;
+	}
+}
+
+void Resources::release(const Texture * texture) {
+	std::lock_guard<std::mutex> lock(_textureMutex);
+	const auto residency = _textureResidency.find(texture);
+	if(residency != _textureResidency.end() && residency->second.references > 0) {
+		--residency->second.references;
+	}
+}
+
+void Resources::memoryUsage(std::vector<MemoryInfos> & meshes, std::vector<MemoryInfos> & textures) const {
+	std::lock_guard<std::mutex> meshLock(_meshMutex);
+	std::lock_guard<std::mutex> textureLock(_textureMutex);
+	meshes.clear();
+	textures.clear();
+	meshes.reserve(_meshes.size());
+	textures.reserve(_textures.size());
+	for(const auto & entry : _meshes) {
+		const Mesh & mesh = entry.second;
+		meshes.emplace_back();
+		MemoryInfos & infos = meshes.back();
+		infos.name = entry.first;
+		infos.cpu = cpuMemory(mesh);
+		infos.gpu = gpuMemory(mesh);
+		infos.lastUse = mesh.gpu ? mesh.gpu->lastUse : 0;
+		const auto residency = _meshResidency.find(&mesh);
+		if(residency != _meshResidency.end()) {
+			infos.references = residency->second.references;
+			infos.evicted = residency->second.evicted;
+		}
+	}
+	for(const auto & entry : _textures) {
+		const Texture & texture = entry.second;
+		textures.emplace_back();
+		MemoryInfos & infos = textures.back();
+		infos.name = entry.first;
+		infos.cpu = cpuMemory(texture);
+		infos.gpu = texture.gpuMemory();
+		infos.lastUse = texture.gpu ? texture.gpu->lastUse : 0;
+		const auto residency = _textureResidency.find(&texture);
+		if(residency != _textureResidency.end()) {
+			infos.references = residency->second.references;
+			infos.evicted = residency->second.evicted;
+		}
+	}
 }
 
 // Program/shaders methods.
@@ -527,18 +1045,12 @@ Program * Resources::getProgram(const std::string & name, const std::string & ve
 	const std::string vName = vertexName.empty() ? name : vertexName;
 	const std::string fName = fragmentName.empty() ? name : fragmentName;
 	// For the other stage names, we don't replace by the default name because empty means "disabled".
-	const std::string gName = geometryName;
-	const std::string tcName = tessControlName;
-	const std::string teName = tessEvalName;
-
-	const std::string vContent = getStringWithIncludes(vName + ".vert");
-	const std::string fContent = getStringWithIncludes(fName + ".frag");
-	const std::string gContent = gName.empty() ? "" : getStringWithIncludes(gName + ".geom");
-	const std::string tcContent = tcName.empty() ? "" : getStringWithIncludes(tcName + ".tessc");
-	const std::string teContent = teName.empty() ? "" : getStringWithIncludes(teName + ".tesse");
-
-	_programs.emplace(std::make_pair(name, Program(name, vContent, fContent, gContent, tcContent, teContent)));
-	_progInfos.emplace(std::make_pair(name, ProgramInfos(vName, fName, gName, tcName, teName)));
+	ProgramInfos infos(vName, fName, geometryName, tessControlName, tessEvalName);
+	std::array<std::string, 5> contents;
+	loadProgramStages(infos, contents);
+
+	_programs.emplace(std::make_pair(name, Program(name, contents[0], contents[1], contents[2], contents[3], contents[4])));
+	_progInfos.emplace(std::make_pair(name, infos));
 	return &_programs.at(name);
 }
 
@@ -546,17 +1058,56 @@ Program * Resources::getProgram2D(const std::string & name) {
 	return getProgram(name, "passthrough", name);
 }
 
+void Resources::loadProgramStages(ProgramInfos & infos, std::array<std::string, 5> & contents) {
+	const std::array<std::string, 5> names = {{
+		infos.vertexName.empty() ? "" : infos.vertexName + ".vert",
+		infos.fragmentName.empty() ? "" : infos.fragmentName + ".frag",
+		infos.geomName.empty() ? "" : infos.geomName + ".geom",
+		infos.tessContName.empty() ? "" : infos.tessContName + ".tessc",
+		infos.tessEvalName.empty() ? "" : infos.tessEvalName + ".tesse"
+	}};
+	infos.files.clear();
+	for(size_t sid = 0; sid < names.size(); ++sid) {
+		contents[sid].clear();
+		if(names[sid].empty()) {
+			continue;
+		}
+		std::vector<std::string> files;
+		contents[sid] = getStringWithIncludes(names[sid], files);
+		infos.files.insert(infos.files.end(), files.begin(), files.end());
+	}
+	// Remove duplicates and store the current state of each file.
+	std::sort(infos.files.begin(), infos.files.end());
+	infos.files.erase(std::unique(infos.files.begin(), infos.files.end()), infos.files.end());
+	for(const std::string & file : infos.files) {
+		_shaderHashes[file] = std::hash<std::string>()(getString(file));
+	}
+}
+
 void Resources::reload() {
+	// Find which shader files have been modified since they were last loaded.
+	std::set<std::string> modified;
+	for(const auto & file : _shaderHashes) {
+		if(std::hash<std::string>()(getString(file.first)) != file.second) {
+			modified.insert(file.first);
+		}
+	}
+	// Only reload programs using one of these files.
+	size_t count = 0;
 	for(auto & prog : _programs) {
-		const ProgramInfos & infos = _progInfos.at(prog.first);
-		const std::string vContent = getStringWithIncludes(infos.vertexName + ".vert");
-		const std::string fContent = getStringWithIncludes(infos.fragmentName + ".frag");
-		const std::string gContent = infos.geomName.empty() ? "" : getStringWithIncludes(infos.geomName + ".geom");
-		const std::string tcContent = infos.tessContName.empty() ? "" : getStringWithIncludes(infos.tessContName + ".tessc");
-		const std::string teContent = infos.tessEvalName.empty() ? "" : getStringWithIncludes(infos.tessEvalName + ".tesse");
-		prog.second.reload(vContent, fContent, gContent, tcContent, teContent);
+		ProgramInfos & infos = _progInfos.at(prog.first);
+		const bool outdated = std::any_of(infos.files.begin(), infos.files.end(), [&modified](const std::string & file) {
+			return modified.count(file) > 0;
+		});
+		if(!outdated) {
+			continue;
+		}
+		std::array<std::string, 5> contents;
+		loadProgramStages(infos, contents);
+		prog.second.reload(contents[0], contents[1], contents[2], contents[3], contents[4]);
+		++count;
 	}
-	Log::Info() << Log::Resources << "Shader programs reloaded." << std::endl;
+	Log::Info() << Log::Resources << count << " shader program(s) reloaded, " << modified.size() << " file(s) modified." << std::endl;
 }
 
 Font * Resources::getFont(const std::string & name) {
@@ -660,6 +1211,11 @@ bool Resources::externalFileExists(const std::string & path) {
 
 void Resources::clean() {
 	Log::Info() << Log::Resources << "Cleaning up." << std::endl;
+	// Finish background reloads and the uploads requested by other threads before releasing everything.
+	_meshRestores.clear();
+	processUploads();
+	std::lock_guard<std::mutex> meshLock(_meshMutex);
+	std::lock_guard<std::mutex> textureLock(_textureMutex);
 
 	for(auto & tex : _textures) {
 		tex.second.clean();
@@ -672,7 +1228,13 @@ void Resources::clean() {
 	}
 	_textures.clear();
 	_meshes.clear();
+	_meshResidency.clear();
+	_textureResidency.clear();
+	_meshLoads.clear();
+	_textureLoads.clear();
 	_fonts.clear();
 	_programs.clear();
+	_progInfos.clear();
+	_shaderHashes.clear();
 	_files.clear();
 }
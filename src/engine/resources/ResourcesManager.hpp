@@ -6,6 +6,12 @@
 #include "resources/Mesh.hpp"
 #include "Common.hpp"
 #include <map>
+#include <array>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
 
 
 /**
@@ -17,7 +23,10 @@ enum class Storage : uint {
 	GPU  = 1,		   ///< Store on the GPU
 	CPU  = 2,		   ///< Store on the CPU
 	BOTH = (GPU | CPU), ///< Store on both the CPU and GPU
-	FORCE_FRAME = 4 ///< For meshes, force computation of a local frame
+	FORCE_FRAME = 4, ///< For meshes, force computation of a local frame
+	POSITIONS = 8, ///< For meshes stored on the GPU only, keep positions and indices on the CPU
+	LODS = 16, ///< For meshes, generate simplified levels of detail
+	PACKED = 32 ///< For meshes, upload interleaved quantized vertices and 16-bit indices when possible
 };
 
 /** Combining operator for Storage.
@@ -41,6 +50,7 @@ inline bool operator&(Storage t0, Storage t1) {
 /**
  \brief The Resources manager is responsible for all resources loading and setup.
  \details It provides an abstraction over the file system: resources can be loaded directly from files on disk, or from a zip archive.
+ Meshes and textures can be requested from any thread. Each one is decoded only once: concurrent requests for the same resource wait for the first one to complete. GPU uploads are performed immediately on the thread owning the GL context (the first thread to access the manager), and queued by other threads until the next update. Programs and fonts should only be requested on the context thread, and resources directories should all be added before concurrent requests.
  \ingroup Resources
  */
 class Resources {
@@ -59,13 +69,30 @@ public:
 	 */
 	void addResources(const std::string & path);
 
-	/** Reload all shader programs.
+	/** Reload shader programs using a shader file (or an included file) that was modified since the program was loaded.
 	 */
 	void reload();
 
 	/** Clean all loaded resources, both CPU and GPU side. */
 	void clean();
 
+	/** Upload meshes and textures loaded by other threads, then evict the GPU data of resources that have not been used recently if the memory budget is exceeded. Should be called once per frame on the context thread. */
+	void update();
+
+	/** Set the GPU memory budget for meshes and textures. When it is exceeded, the GPU data of resources unused for a few frames is released, unreferenced and least recently used first. It is transparently restored the next time the resource is bound, reloading it from disk if its CPU data was not kept. Meshes with generated levels of detail or kept positions keep their full geometry on the CPU while a budget is set, other meshes are reloaded in the background.
+	 \param bytes the budget in bytes, or 0 for no limit
+	 */
+	void setBudget(size_t bytes);
+
+	/** \return the GPU memory budget in bytes, 0 if unlimited */
+	size_t budget() const { return _budget; }
+
+	/** \return the number of resources evicted since startup */
+	size_t evictions() const { return _evictions; }
+
+	/** \return the number of resources restored since startup */
+	size_t restorations() const { return _restorations; }
+
 	/** Copy assignment operator (disabled).
 	 \return a reference to the object assigned to
 	 */
@@ -116,6 +143,73 @@ private:
 	 */
 	std::vector<std::string> getLayeredPaths(const std::string & name, const std::string & suffix);
 
+	/** Load a mesh once and register it, whatever the number of concurrent requests. Its GPU upload is performed on the context thread.
+	 \param name the mesh file name
+	 \param options data loading and storage options
+	 \return the mesh, or null if loading failed
+	 */
+	const Mesh * requestMesh(const std::string & name, Storage options);
+
+	/** Load and prepare a mesh on the CPU, without registering it.
+	 \param name the mesh file name
+	 \param options data loading and storage options
+	 \return the mesh, or null if loading failed
+	 \note This can be called from any thread.
+	 */
+	std::unique_ptr<Mesh> loadMesh(const std::string & name, Storage options);
+
+	/** Upload a loaded mesh and release its CPU data, depending on the options.
+	 \param mesh the mesh to finalize
+	 \param options data loading and storage options
+	 \return the finalized mesh
+	 \note This must be called on the context thread.
+	 */
+	const Mesh * finalizeMesh(Mesh & mesh, Storage options);
+
+	/** Load a texture once and register it, whatever the number of concurrent requests. Its GPU upload is performed on the context thread.
+	 \param name the texture base name
+	 \param keyName the name identifying the texture
+	 \param descriptor the texture layout to use
+	 \param options data loading and storage options
+	 \return the texture, or null if loading failed
+	 */
+	const Texture * requestTexture(const std::string & name, const std::string & keyName, const Descriptor & descriptor, Storage options);
+
+	/** Update an existing texture for a new request, uploading it to the GPU if needed.
+	 \param texture the texture to update
+	 \param descriptor the texture layout requested
+	 \param options data loading and storage options requested
+	 \note This must be called on the context thread.
+	 */
+	void updateTexture(Texture & texture, const Descriptor & descriptor, Storage options);
+
+	/** Load the images of a texture on the CPU, without registering it.
+	 \param name the texture base name
+	 \param descriptor the texture layout to use
+	 \param texture will contain the texture images and information
+	 \return true if the texture images were found
+	 \note This can be called from any thread.
+	 */
+	bool loadTexture(const std::string & name, const Descriptor & descriptor, Texture & texture);
+
+	/** Upload a loaded texture and release its CPU data, depending on the options.
+	 \param texture the texture to finalize
+	 \param descriptor the texture layout to use
+	 \param options data loading and storage options
+	 \param source the name used to load the texture data
+	 \return the finalized texture
+	 \note This must be called on the context thread.
+	 */
+	const Texture * finalizeTexture(Texture & texture, const Descriptor & descriptor, Storage options, const std::string & source);
+
+	/** Run GPU work immediately on the context thread, or queue it until the next update.
+	 \param task the work to perform
+	 */
+	void runOnContext(const std::function<void()> & task);
+
+	/** Run the GPU work queued by other threads. Must be called on the context thread. */
+	void processUploads();
+
 	/** Load raw binary data from a resource file
 	 \param path the path to the file
 	 \param size will contain the number of bytes loaded from the file
@@ -124,6 +218,18 @@ private:
 	char * getRawData(const std::string & path, size_t & size);
 
 public:
+	/** Check if a file is available in the resources.
+	 \param filename the file name
+	 \return true if the file exists
+	 */
+	bool hasFile(const std::string & filename) const;
+
+	/** Query the last modification time of a file available in the resources.
+	 \param filename the file name
+	 \return the modification time in seconds since the epoch, or 0 if it is unknown (for instance for archived files)
+	 */
+	uint64_t modificationTime(const std::string & filename) const;
+
 	/** Get a text file resource.
 	 \param filename the file name
 	 \return the string content of the file
@@ -147,6 +253,7 @@ public:
 	 \param name the mesh file name
 	 \param options data loading and storage options
 	 \return the mesh informations
+	 \note When called from another thread than the context one, the GPU upload is deferred to the next update, or to the first time the mesh is drawn.
 	 */
 	const Mesh * getMesh(const std::string & name, Storage options);
 
@@ -156,18 +263,68 @@ public:
 	 \param options data loading and storage options
 	 \param refName the name to use for the texture in future calls
 	 \return the texture informations
+	 \note When called from another thread than the context one, the GPU upload is deferred to the next update, or to the first time the texture is bound.
 	 \note If the name is the string representation of an RGB(A) color ("1.0,0.0,1.0" for instance), a constant color 2D texture will be allocated using the passed descriptor.
 	 \note Cubemaps will be automatically detected using suffixes _nx, _ny, _nz, _px, _py, _pz.
 	 \note 2D arrays will be automatically detected using suffix _sX where X=0,1..., 3D textures using suffix _zX where X=0,1...
 	 */
 	const Texture * getTexture(const std::string & name, const Descriptor & descriptor, Storage options, const std::string & refName = "");
 
+	/** Load a set of meshes and textures, decoding them from disk concurrently. Resources already loaded are skipped, and later calls to getMesh and getTexture with the same names will return the loaded data.
+	 \param meshes the mesh file names
+	 \param textures the texture base names and layouts
+	 \param options data loading and storage options
+	 \note GPU uploads are performed on the calling thread once all data has been decoded if it owns the context, else at the next update.
+	 */
+	void preload(const std::vector<std::string> & meshes, const std::vector<std::pair<std::string, Descriptor>> & textures, Storage options);
+
 	/** Get an existing texture resource.
 	 \param name the texture base name
 	 \return the texture informations
 	 */
 	const Texture * getTexture(const std::string & name);
 
+	/** Release a reference to a mesh obtained with getMesh. Unreferenced meshes are evicted first when over budget.
+	 \param mesh the mesh to release
+	 \note The mesh stays valid until the resources are cleaned.
+	 */
+	void release(const Mesh * mesh);
+
+	/** Release a reference to a texture obtained with getTexture. Unreferenced textures are evicted first when over budget.
+	 \param texture the texture to release
+	 \note The texture stays valid until the resources are cleaned.
+	 */
+	void release(const Texture * texture);
+
+	/** Restore the GPU data of a mesh evicted to respect the memory budget.
+	 \param mesh the mesh to restore
+	 \return true if the mesh is available on the GPU
+	 \note If the mesh has to be reloaded from disk, this is done on another thread and the mesh is unavailable until its upload.
+	 */
+	bool restore(const Mesh & mesh);
+
+	/** Restore the GPU data of a texture evicted to respect the memory budget.
+	 \param texture the texture to restore
+	 \return true if the texture is available on the GPU
+	 */
+	bool restore(const Texture & texture);
+
+	/** \brief Memory usage of a loaded mesh or texture. */
+	struct MemoryInfos {
+		std::string name; ///< Resource name.
+		size_t cpu = 0; ///< Estimated CPU memory, in bytes.
+		size_t gpu = 0; ///< Estimated GPU memory, in bytes.
+		size_t lastUse = 0; ///< Index of the last frame the resource was used on the GPU.
+		uint references = 0; ///< Number of requests not released yet.
+		bool evicted = false; ///< Is the GPU data currently released.
+	};
+
+	/** Query the memory usage of all loaded meshes and textures.
+	 \param meshes will contain the meshes usage
+	 \param textures will contain the textures usage
+	 */
+	void memoryUsage(std::vector<MemoryInfos> & meshes, std::vector<MemoryInfos> & textures) const;
+
 	/** Get an OpenGL program resource.
 	 \param name the name to represent the program
 	 \param vertexName the name of the vertex shader
@@ -252,12 +409,46 @@ private:
 		std::string geomName; ///< Geometry shader filename.
 		std::string tessContName; ///< Tessellation control shader filename.
 		std::string tessEvalName; ///< Tessellation evaluation shader filename.
+		std::vector<std::string> files; ///< All files used by the program, including included files.
 	};
 
+	/** Load the content of all stages of a program, resolving includes. Update the list and hashes of files used by the program.
+	 \param infos the program information, will be updated
+	 \param contents will contain the vertex, fragment, geometry, tessellation control and evaluation shaders content
+	 */
+	void loadProgramStages(ProgramInfos & infos, std::array<std::string, 5> & contents);
+
 	std::map<std::string, std::string> _files; ///< Listing of available files and their paths.
 	std::map<std::string, Texture> _textures;  ///< Loaded textures, identified by name.
 	std::map<std::string, Mesh> _meshes;	   ///< Loaded meshes, identified by name.
 	std::map<std::string, Font> _fonts;		   ///< Loaded font infos, identified by name.
 	std::map<std::string, Program> _programs;  ///< Loaded shader programs, identified by name.
 	std::map<std::string, ProgramInfos> _progInfos;  ///< Additional info to support shader reloading.
+	/** \brief Loading options and usage of a mesh or texture, to manage its GPU residency. */
+	struct Residency {
+		std::string source; ///< Name used to load the resource data.
+		Descriptor descriptor; ///< Texture layout.
+		Storage options = Storage::NONE; ///< Loading and storage options.
+		bool mipmaps = false; ///< Should the texture mipmaps be generated after upload.
+		bool evicted = false; ///< Has the GPU data been released to respect the budget.
+		bool pending = false; ///< Is the GPU upload waiting for the context thread.
+		bool geometry = false; ///< Is the full mesh geometry kept on the CPU.
+		uint references = 0; ///< Number of requests not released yet.
+	};
+
+	std::map<std::string, size_t> _shaderHashes;  ///< Hash of the content of each shader file when it was last loaded.
+	std::map<const Mesh *, Residency> _meshResidency; ///< Residency of loaded meshes.
+	std::map<const Texture *, Residency> _textureResidency; ///< Residency of loaded textures.
+	size_t _budget = 0; ///< GPU memory budget for meshes and textures, in bytes (unlimited if 0).
+	size_t _evictions = 0; ///< Number of evictions since startup.
+	size_t _restorations = 0; ///< Number of restorations since startup.
+	const size_t _minUnusedFrames = 3; ///< Resources used during the last frames are never evicted.
+	std::map<std::string, std::shared_future<const Mesh *>> _meshLoads; ///< Meshes being loaded, identified by name.
+	std::map<std::string, std::shared_future<const Texture *>> _textureLoads; ///< Textures being loaded, identified by name.
+	std::map<std::string, std::future<void>> _meshRestores; ///< Evicted meshes being reloaded, identified by name.
+	std::deque<std::function<void()>> _uploads; ///< GPU work queued by other threads for the context thread.
+	mutable std::mutex _meshMutex; ///< Protects meshes, their residency and loads.
+	mutable std::mutex _textureMutex; ///< Protects textures, their residency and loads.
+	std::mutex _uploadMutex; ///< Protects the queued GPU work.
+	const std::thread::id _contextThread = std::this_thread::get_id(); ///< Thread owning the GL context, the first one to access the manager.
 };
@@ -1,6 +1,7 @@
 #include "resources/Texture.hpp"
 #include "graphics/GPUObjects.hpp"
 #include "graphics/GLUtilities.hpp"
+#include "resources/ResourcesManager.hpp"
 #include "renderers/DebugViewer.hpp"
 
 Texture::Texture(const std::string & name) : _name(name) {
@@ -9,6 +10,7 @@ Texture::Texture(const std::string & name) : _name(name) {
 void Texture::upload(const Descriptor & layout, bool updateMipmaps) {
 
 	// Create texture.
+	_descriptor = layout;
 	GLUtilities::setupTexture(*this, layout);
 	GLUtilities::uploadTexture(*this);
 
@@ -35,12 +37,27 @@ uint Texture::getMaxMipLevel() const {
 	return uint(std::floor(std::log2(minDimension)));
 }
 
+size_t Texture::gpuMemory() const {
+	if(!gpu) {
+		return 0;
+	}
+	// Only 3D textures are downscaled along the depth.
+	const bool volume = shape & TextureShape::D3;
+	size_t pixels = 0;
+	for(uint mid = 0; mid < levels; ++mid) {
+		const size_t w = std::max(width >> mid, 1u);
+		const size_t h = std::max(height >> mid, 1u);
+		const size_t d = volume ? std::max(depth >> mid, 1u) : depth;
+		pixels += w * h * d;
+	}
+	return pixels * gpu->descriptor().getPixelSize();
+}
+
 void Texture::clearImages() {
 	images.clear();
 }
 
-void Texture::clean() {
-	clearImages();
+void Texture::clearGPU() {
 	if(gpu) {
 		DebugViewer::untrackDefault(this);
 		gpu->clean();
@@ -48,6 +65,11 @@ void Texture::clean() {
 	gpu = nullptr;
 }
 
+void Texture::clean() {
+	clearImages();
+	clearGPU();
+}
+
 glm::vec3 Texture::sampleCubemap(const glm::vec3 & dir) const {
 	// Images are stored in the following order:
 	// px, nx, py, ny, pz, nz
@@ -105,9 +127,17 @@ const std::string & Texture::name() const {
 }
 
 void ImGui::Image(const Texture & texture, const ImVec2& size, const ImVec2& uv0, const ImVec2& uv1, const ImVec4& tint_col, const ImVec4& border_col){
+	if(!texture.gpu && !Resources::manager().restore(texture)) {
+		return;
+	}
+	texture.gpu->lastUse = GLUtilities::frameIndex();
 	ImGui::Image(reinterpret_cast<void *>(static_cast<uintptr_t>(texture.gpu->id)), size, uv0, uv1, tint_col, border_col);
 }
 
 bool ImGui::ImageButton(const Texture & texture, const ImVec2& size, const ImVec2& uv0,  const ImVec2& uv1, int frame_padding, const ImVec4& bg_col, const ImVec4& tint_col){
+	if(!texture.gpu && !Resources::manager().restore(texture)) {
+		return false;
+	}
+	texture.gpu->lastUse = GLUtilities::frameIndex();
 	return ImGui::ImageButton(reinterpret_cast<void *>(static_cast<uintptr_t>(texture.gpu->id)), size, uv0, uv1, frame_padding, bg_col, tint_col);
 }
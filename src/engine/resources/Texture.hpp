@@ -23,6 +23,9 @@ public:
 
 	/** Clear CPU images data. */
 	void clearImages();
+
+	/** Release GPU data, preserving the CPU images and dimensions. */
+	void clearGPU();
 	
 	/** Cleanup all data.
 	 \note The dimensions and shape of the texture are preserved.
@@ -45,6 +48,16 @@ public:
 	 */
 	uint getMaxMipLevel() const;
 
+	/** Estimate the GPU memory used by the texture, assuming tightly packed pixels.
+	 \return the size in bytes, or 0 if the texture is not on the GPU
+	 */
+	size_t gpuMemory() const;
+
+	/** Get the layout used for the last upload to the GPU, preserved when the GPU data is released.
+	 \return the texture descriptor
+	 */
+	const Descriptor & descriptor() const { return _descriptor; }
+
 	/** Copy assignment operator (disabled).
 	 \return a reference to the object assigned to
 	 */
@@ -74,6 +87,7 @@ public:
 private:
 		
 	std::string _name; ///< Resource name.
+	Descriptor _descriptor; ///< Layout of the last GPU upload.
 	
 };
 
@@ -131,10 +131,12 @@ void Object::update(double fullTime, double frameTime) {
 	for(auto & anim : _animations) {
 		model = anim->apply(model, fullTime, frameTime);
 	}
+	_model = model;
+	// Refresh the bounding box right away, so that renderers only read it.
 	if(!_animations.empty()){
-		_dirtyBbox = true;
+		_bbox = _mesh->bbox.transformed(model);
+		_dirtyBbox = false;
 	}
-	_model = model;
 }
 
 const BoundingBox & Object::boundingBox() const {
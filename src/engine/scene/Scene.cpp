@@ -5,6 +5,7 @@
 
 #include <map>
 #include <sstream>
+#include <algorithm>
 
 Scene::Scene(const std::string & name) {
 	// Append the extension if needed.
@@ -15,6 +16,24 @@ Scene::Scene(const std::string & name) {
 	_name = fullName;
 }
 
+Scene::~Scene() {
+	// The resources stay loaded, but can be evicted first if over budget.
+	Resources & resources = Resources::manager();
+	for(const Object & object : objects) {
+		resources.release(object.mesh());
+		for(const Texture * texture : object.textures()) {
+			resources.release(texture);
+		}
+	}
+	if(background) {
+		resources.release(background->mesh());
+		for(const Texture * texture : background->textures()) {
+			resources.release(texture);
+		}
+	}
+	resources.release(environment.map());
+}
+
 void printToken(const KeyValues & tk, const std::string & shift) {
 	Log::Info() << shift << tk.key << ": " << std::endl;
 	if(!tk.values.empty()) {
@@ -36,19 +55,54 @@ bool Scene::init(Storage options) {
 
 	Query timer;
 	timer.begin();
+	Query phaseTimer;
+	phaseTimer.begin();
 	
 	// Define loaders for each keyword.
 	std::map<std::string, void (Scene::*)(const KeyValues &, Storage)> loaders = {
 		{"scene", &Scene::loadScene}, {"object", &Scene::loadObject}, {"point", &Scene::loadLight}, {"directional", &Scene::loadLight}, {"spot", &Scene::loadLight}, {"camera", &Scene::loadCamera}, {"background", &Scene::loadBackground}, {"probe", &Scene::loadProbe}};
 
-	// Parse the file.
-	const std::string sceneFile			   = Resources::manager().getString(_name);
-	if(sceneFile.empty()) {
-		return false;
+	// Parse the file, preferring the compiled version if it exists and is not older than the text version.
+	std::vector<KeyValues> allParams;
+	const std::string compiledName = _name + "bin";
+	bool useCompiled = Resources::manager().hasFile(compiledName);
+	if(useCompiled && Resources::manager().hasFile(_name)) {
+		if(Resources::manager().modificationTime(_name) > Resources::manager().modificationTime(compiledName)) {
+			useCompiled = false;
+			Log::Warning() << Log::Resources << "Compiled scene \"" << compiledName << "\" is outdated, loading \"" << _name << "\" instead." << std::endl;
+		} else {
+			Log::Info() << Log::Resources << "Loading compiled scene \"" << compiledName << "\"." << std::endl;
+		}
+	}
+	if(useCompiled) {
+		const std::string sceneData = Resources::manager().getString(compiledName);
+		if(!Codable::decodeBinary(sceneData, allParams)) {
+			return false;
+		}
+	} else {
+		const std::string sceneFile = Resources::manager().getString(_name);
+		if(sceneFile.empty()) {
+			return false;
+		}
+		allParams = Codable::decode(sceneFile);
 	}
-	const std::vector<KeyValues> allParams = Codable::decode(sceneFile);
+	phaseTimer.end();
+	const uint64_t parseTime = phaseTimer.value();
+
+	// Load all meshes and textures at once.
+	phaseTimer.begin();
+	std::vector<std::string> meshes;
+	std::vector<std::pair<std::string, Descriptor>> textures;
+	gatherDependencies(allParams, meshes, textures);
+	Resources::manager().preload(meshes, textures, options);
+	phaseTimer.end();
+	const uint64_t resourcesTime = phaseTimer.value();
 
 	// Process each group of keyvalues.
+	phaseTimer.begin();
+	objects.reserve(std::count_if(allParams.begin(), allParams.end(), [](const KeyValues & element){
+		return element.key == "object";
+	}));
 	for(const auto & element : allParams) {
 		const std::string key = element.key;
 		// By construction (see above), all keys should have a loader.
@@ -80,28 +134,71 @@ bool Scene::init(Storage options) {
 		return int(a.type()) < int(b.type());
 	});
 
-	// Check if the scene is static.
-	for(const auto & obj : objects){
+	// Gather per-object data in contiguous arrays.
+	const size_t objCount = objects.size();
+	_objectsData.models.resize(objCount);
+	_objectsData.boxes.resize(objCount);
+	_objectsData.meshes.resize(objCount);
+	_objectsData.types.resize(objCount);
+	_objectsData.flags.resize(objCount);
+	for(size_t oid = 0; oid < objCount; ++oid){
+		const Object & obj = objects[oid];
+		_objectsData.models[oid] = obj.model();
+		_objectsData.boxes[oid] = obj.boundingBox();
+		_objectsData.meshes[oid] = obj.mesh();
+		_objectsData.types[oid] = obj.type();
+		uint8_t flags = 0;
+		flags |= obj.castsShadow() ? ObjectsData::CASTER : 0;
+		flags |= obj.animated() ? ObjectsData::ANIMATED : 0;
+		flags |= obj.twoSided() ? ObjectsData::TWO_SIDED : 0;
+		flags |= obj.masked() ? ObjectsData::MASKED : 0;
+		_objectsData.flags[oid] = flags;
+	}
+
+	// Split the scene into static and animated elements.
+	for(size_t oid = 0; oid < objCount; ++oid){
+		const Object & obj = objects[oid];
 		if(obj.animated()){
-			_animated = true;
+			_dynamicObjects.ids.push_back(oid);
 		}
 		if(obj.type() == Object::Transparent){
 			_transparent = true;
 		}
-
 	}
-	for(const auto & light : lights){
-		if(light->animated()){
-			_animated = true;
-			break;
+	for(size_t lid = 0; lid < lights.size(); ++lid){
+		if(lights[lid]->animated()){
+			_dynamicLights.ids.push_back(lid);
 		}
 	}
+	_dynamicObjects.versions.resize(_dynamicObjects.ids.size(), 0);
+	_dynamicLights.versions.resize(_dynamicLights.ids.size(), 0);
+	_animated = !_dynamicObjects.ids.empty() || !_dynamicLights.ids.empty();
+	_version = 1;
+
+	phaseTimer.end();
+	const uint64_t setupTime = phaseTimer.value();
 
 	timer.end();
-	Log::Info() << Log::Resources << "Loading took " << (float(timer.value())/1000000.0f) << "ms." << std::endl;
+	Log::Info() << Log::Resources << "Loading took " << (float(timer.value())/1000000.0f) << "ms (parsing: " << (float(parseTime)/1000000.0f) << "ms, resources: " << (float(resourcesTime)/1000000.0f) << "ms, setup: " << (float(setupTime)/1000000.0f) << "ms)." << std::endl;
 	return true;
 }
 
+void Scene::gatherDependencies(const std::vector<KeyValues> & params, std::vector<std::string> & meshes, std::vector<std::pair<std::string, Descriptor>> & textures) {
+	for(const KeyValues & param : params) {
+		if(param.key == "mesh" && !param.values.empty()) {
+			meshes.push_back(param.values[0]);
+			continue;
+		}
+		// Texture keys are only used for textures.
+		const auto texture = Codable::decodeTexture(param);
+		if(!texture.first.empty()) {
+			textures.push_back(texture);
+			continue;
+		}
+		gatherDependencies(param.elements, meshes, textures);
+	}
+}
+
 void Scene::loadObject(const KeyValues & params, Storage options) {
 	objects.emplace_back();
 	objects.back().decode(params, options);
@@ -136,7 +233,8 @@ void Scene::loadBackground(const KeyValues & params, Storage options) {
 
 		} else if(param.key == "cube" && !param.elements.empty()) {
 			backgroundMode = Background::SKYBOX;
-			// Object is a textured skybox.
+			// Object is a textured skybox, the plane is not used anymore.
+			Resources::manager().release(background->mesh());
 			background = std::unique_ptr<Object>(new Object(Object::Type::None, Resources::manager().getMesh("skybox", options), false));
 			background->decode(params, options);
 			// Load cubemap described as subelement.
@@ -147,6 +245,7 @@ void Scene::loadBackground(const KeyValues & params, Storage options) {
 		} else if(param.key == "sun") {
 			// In that case the background is a sky object.
 			backgroundMode = Background::ATMOSPHERE;
+			Resources::manager().release(background->mesh());
 			background	 = std::unique_ptr<Sky>(new Sky(options));
 			background->decode(params, options);
 			// Load the scattering table.
@@ -234,11 +333,39 @@ BoundingBox Scene::computeBoundingBox(bool onlyShadowCasters) {
 }
 
 void Scene::update(double fullTime, double frameTime) {
-	for(auto & light : lights) {
-		light->update(fullTime, frameTime);
+	++_version;
+	// Static lights and objects are left untouched.
+	for(size_t did = 0; did < _dynamicLights.ids.size(); ++did) {
+		lights[_dynamicLights.ids[did]]->update(fullTime, frameTime);
+		_dynamicLights.versions[did] = _version;
 	}
-	for(auto & object : objects) {
+	for(size_t did = 0; did < _dynamicObjects.ids.size(); ++did) {
+		const size_t oid = _dynamicObjects.ids[did];
+		Object & object = objects[oid];
 		object.update(fullTime, frameTime);
+		// Only record objects that really moved.
+		if(object.model() != _objectsData.models[oid]) {
+			_objectsData.models[oid] = object.model();
+			_objectsData.boxes[oid] = object.boundingBox();
+			_dynamicObjects.versions[did] = _version;
+		}
+	}
+	if(background->animated()) {
+		background->update(fullTime, frameTime);
+	}
+}
+
+void Scene::changes(uint64_t since, Changes & changes) const {
+	changes.objects.clear();
+	changes.lights.clear();
+	for(size_t did = 0; did < _dynamicObjects.ids.size(); ++did) {
+		if(_dynamicObjects.versions[did] > since) {
+			changes.objects.push_back(_dynamicObjects.ids[did]);
+		}
+	}
+	for(size_t did = 0; did < _dynamicLights.ids.size(); ++did) {
+		if(_dynamicLights.versions[did] > since) {
+			changes.lights.push_back(_dynamicLights.ids[did]);
+		}
 	}
-	background->update(fullTime, frameTime);
 }
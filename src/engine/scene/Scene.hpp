@@ -26,15 +26,35 @@ public:
 	/** Performs initialization against the graphics API, loading data.
 	 \param options data loading and storage options.
 	 \return the initialization success
+	 \note If a compiled version of the scene file exists (same name with the .scenebin extension, see Codable::encodeBinary) and is not older than the text file, it is used instead. All meshes and textures are loaded concurrently before the scene is populated.
 	 */
 	bool init(Storage options);
 
-	/** Update the animations in the scene.
+	/** Update the animations in the scene. Only animated objects and lights are visited, and the ones that moved are recorded.
 	 \param fullTime the time elapsed since the beginning of the render loop
 	 \param frameTime the duration of the last frame
 	 */
 	void update(double fullTime, double frameTime);
 
+	/** \brief Objects and lights that moved during a range of updates. */
+	struct Changes {
+		std::vector<size_t> objects; ///< Indices of the objects that moved.
+		std::vector<size_t> lights; ///< Indices of the lights that moved.
+	};
+
+	/** Query the scene version, incremented at each update. Consumers can store it to later retrieve the changes that happened in between.
+	 \return the current version
+	 \note The version is 0 until the scene is loaded.
+	 */
+	uint64_t version() const { return _version; }
+
+	/** Collect the objects and lights that moved after a given scene version.
+	 \param since the version at which the caller last synchronized with the scene
+	 \param changes will contain the moved objects and lights indices, without duplicates
+	 \note If since is 0, the caller is expected to process the whole scene instead.
+	 */
+	void changes(uint64_t since, Changes & changes) const;
+
 	/** Convert a scene to a Codable-compliant list of key-values tuples. Can be used for serialization.
 	 \return a list of tuples
 	 */
@@ -61,6 +81,33 @@ public:
 	/** \return true if the scene contains transparent objects */
 	bool transparent() const { return _transparent; }
 
+	/** \brief Per-object data read by most rendering passes, stored in contiguous arrays indexed like the objects list. */
+	struct ObjectsData {
+
+		/// Object properties.
+		enum Flag : uint8_t {
+			CASTER = 1 << 0, ///< The object casts shadows.
+			ANIMATED = 1 << 1, ///< The object is animated.
+			TWO_SIDED = 1 << 2, ///< The object faces are visible from both sides.
+			MASKED = 1 << 3 ///< The object uses alpha masking.
+		};
+
+		std::vector<glm::mat4> models; ///< World transformations.
+		std::vector<BoundingBox> boxes; ///< World space bounding boxes.
+		std::vector<const Mesh *> meshes; ///< Object meshes.
+		std::vector<Object::Type> types; ///< Object material types.
+		std::vector<uint8_t> flags; ///< Object properties, see Flag.
+
+		/** \return the number of objects */
+		size_t size() const { return models.size(); }
+	};
+
+	/** Get the objects data, kept in sync with the objects by update.
+	 \return the objects data arrays
+	 \note The objects list should not be modified after initialization.
+	 */
+	const ObjectsData & objectsData() const { return _objectsData; }
+
 	std::vector<Object> objects;				///< The objects in the scene.
 	std::vector<std::shared_ptr<Light>> lights; ///< Lights present in the scene.
 
@@ -76,6 +123,9 @@ public:
 	std::unique_ptr<Object> background;			   ///< Background object, containing the geometry and optional textures to use.
 	LightProbe environment;						   ///< Reflection probe.
 	
+	/** Destructor. Release the references to the objects and background resources. */
+	~Scene();
+	
 	/** Copy constructor.*/
 	Scene(const Scene &) = delete;
 	
@@ -129,12 +179,30 @@ private:
 	 */
 	void loadScene(const KeyValues & params, Storage options);
 
+	/** List the meshes and textures referenced in the scene representation, recursively.
+	 \param params the scene parameters
+	 \param meshes will be extended with the mesh names
+	 \param textures will be extended with the texture names and layouts
+	 */
+	static void gatherDependencies(const std::vector<KeyValues> & params, std::vector<std::string> & meshes, std::vector<std::pair<std::string, Descriptor>> & textures);
+
 	/** Compute the bounding box of the scene, optionaly excluding objects that do not cast shadows.
 	 \param onlyShadowCasters denote if only objects that are allowed to cast shadows should be taken into account
 	 \return the scene bounding box
 	 */
 	BoundingBox computeBoundingBox(bool onlyShadowCasters = false);
 
+	/** \brief Animated elements of one kind, stored as parallel arrays. */
+	struct DynamicSet {
+		std::vector<size_t> ids; ///< Indices of the animated elements.
+		std::vector<uint64_t> versions; ///< Scene version at which each element last moved.
+	};
+
+	ObjectsData _objectsData;				 ///< Per-object data arrays.
+	DynamicSet _dynamicObjects;				 ///< Animated objects.
+	DynamicSet _dynamicLights;				 ///< Animated lights.
+	uint64_t _version = 0;					 ///< Scene version, incremented at each update.
+
 	Camera _camera;							 ///< The initial viewpoint on the scene.
 	BoundingBox _bbox;						 ///< The scene bounding box.
 	glm::mat4 _sceneModel = glm::mat4(1.0f); ///< The scene global transformation.
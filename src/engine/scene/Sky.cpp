@@ -27,3 +27,50 @@ void Sky::update(double fullTime, double frameTime) {
 	}
 	_sunDirection = glm::normalize(glm::vec3(dir));
 }
+
+float Sky::rayleighPhase(float cosAngle) {
+	const float k = 1.0f / (4.0f * glm::pi<float>());
+	return k * 3.0f / 4.0f * (1.0f + cosAngle * cosAngle);
+}
+
+float Sky::miePhase(float cosAngle, float g) {
+	const float k = 1.0f / (4.0f * glm::pi<float>());
+	const float g2 = g * g;
+	return k * 3.0f * (1.0f - g2) / (2.0f * (2.0f + g2)) * (1.0f + cosAngle * cosAngle) / std::pow(1.0f + g2 - 2.0f * g * cosAngle, 3.0f / 2.0f);
+}
+
+float Sky::horizonZenith(const AtmosphereParameters & params, float radius) {
+	return glm::pi<float>() - std::asin(glm::clamp(params.groundRadius / radius, 0.0f, 1.0f));
+}
+
+float Sky::zenithToCoordinate(float zenith, float horizon) {
+	// Square root mappings on each side of the horizon.
+	if(zenith < horizon) {
+		const float coord = zenith / horizon;
+		return 0.5f * (1.0f - std::sqrt(std::max(1.0f - coord, 0.0f)));
+	}
+	const float coord = (zenith - horizon) / (glm::pi<float>() - horizon);
+	return 0.5f + 0.5f * std::sqrt(std::max(coord, 0.0f));
+}
+
+float Sky::coordinateToZenith(float coordinate, float horizon) {
+	// Inverse of zenithToCoordinate.
+	if(coordinate < 0.5f) {
+		const float coord = 1.0f - 2.0f * coordinate;
+		return (1.0f - coord * coord) * horizon;
+	}
+	const float coord = 2.0f * coordinate - 1.0f;
+	return horizon + coord * coord * (glm::pi<float>() - horizon);
+}
+
+glm::vec2 Sky::transmittanceCoordinates(const AtmosphereParameters & params, float radius, float cosZenith) {
+	const float relativeHeight = (radius - params.groundRadius) / (params.topRadius - params.groundRadius);
+	return glm::clamp(glm::vec2(relativeHeight, 0.5f - 0.5f * cosZenith), 0.0f, 1.0f);
+}
+
+glm::vec3 Sky::sampleTable(const Image & table, const glm::vec2 & uv) {
+	// Shift so that texel centers are at integer positions in the bilinear lookup.
+	const glm::vec2 size(table.width, table.height);
+	const glm::vec2 coords = glm::clamp(uv, 0.0f, 1.0f) * (size - 1.0f) / size;
+	return table.rgbl(coords.x, coords.y);
+}
@@ -2,6 +2,7 @@
 
 #include "scene/Object.hpp"
 #include "resources/ResourcesManager.hpp"
+#include "resources/Image.hpp"
 #include "system/Codable.hpp"
 #include "Common.hpp"
 
@@ -63,6 +64,55 @@ public:
 		float sunRadiusCos = 0.998f; ///< Cosine of the sun angular radius.
 	};
 
+	/** Compute the Rayleigh phase.
+	 \param cosAngle Cosine of the angle between the ray and the light directions
+	 \return the phase
+	 */
+	static float rayleighPhase(float cosAngle);
+
+	/** Compute the Mie phase.
+	 \param cosAngle Cosine of the angle between the ray and the light directions
+	 \param g the Mie asymmetry parameter
+	 \return the phase
+	 */
+	static float miePhase(float cosAngle, float g);
+
+	/** Compute the view zenith angle of the horizon.
+	 \param params the atmosphere parameters
+	 \param radius the viewer distance to the planet center
+	 \return the zenith angle at which view rays start hitting the ground
+	 */
+	static float horizonZenith(const AtmosphereParameters & params, float radius);
+
+	/** Convert a view zenith angle to a sky-view table coordinate, with more precision around the horizon.
+	 \param zenith the view zenith angle
+	 \param horizon the view zenith angle of the horizon
+	 \return the normalized vertical coordinate
+	 */
+	static float zenithToCoordinate(float zenith, float horizon);
+
+	/** Convert a sky-view table coordinate to a view zenith angle.
+	 \param coordinate the normalized vertical coordinate
+	 \param horizon the view zenith angle of the horizon
+	 \return the view zenith angle
+	 */
+	static float coordinateToZenith(float coordinate, float horizon);
+
+	/** Convert a position and a zenith cosine to transmittance table coordinates. The table stores the altitude along X and the zenith cosine along Y, from 1 to -1 (this is the layout expected by atmosphere.glsl).
+	 \param params the atmosphere parameters
+	 \param radius the distance to the planet center
+	 \param cosZenith the cosine of the angle with the vertical
+	 \return the normalized coordinates, clamped to [0,1]
+	 */
+	static glm::vec2 transmittanceCoordinates(const AtmosphereParameters & params, float radius, float cosZenith);
+
+	/** Bilinearly sample a table, with the first and last texels centers at 0 and 1.
+	 \param table the table to sample
+	 \param uv the normalized coordinates, clamped to [0,1]
+	 \return the filtered value
+	 */
+	static glm::vec3 sampleTable(const Image & table, const glm::vec2 & uv);
+
 private:
 	Animated<glm::vec3> _sunDirection { glm::vec3(0.0f, 1.0f, 0.0f) }; ///< The sun direction.
 };
@@ -0,0 +1,188 @@
+#include "system/Benchmark.hpp"
+#include "system/Codable.hpp"
+#include "input/Camera.hpp"
+#include "graphics/GLUtilities.hpp"
+#include "graphics/Framebuffer.hpp"
+#include "graphics/Profiler.hpp"
+#include "resources/ResourcesManager.hpp"
+
+#include <sstream>
+
+/// Statistics measured at each frame, in this order.
+enum BenchmarkStat : uint {
+	CPU_TIME = 0, GPU_TIME, DRAW_CALLS, TRIANGLES, QUAD_CALLS, STATE_CHANGES, TEXTURE_BINDINGS, FRAMEBUFFER_BINDINGS,
+	BUFFER_BINDINGS, VERTEX_BINDINGS, PROGRAM_BINDINGS, CLEAR_AND_BLITS, UPLOADS, DOWNLOADS, UNIFORMS, FRAMEBUFFER_MEMORY, COUNT
+};
+
+Benchmark::Benchmark(RenderingConfig & config) : _config(config) {
+	const std::vector<std::string> names = {
+		"cpu_ms", "gpu_ms", "draw_calls", "triangles", "quad_calls", "state_changes", "texture_bindings", "framebuffer_bindings",
+		"buffer_bindings", "vertex_bindings", "program_bindings", "clear_and_blits", "uploads", "downloads", "uniforms", "framebuffers_mb"};
+	_stats.resize(BenchmarkStat::COUNT);
+	for(uint sid = 0; sid < BenchmarkStat::COUNT; ++sid) {
+		_stats[sid].name = names[sid];
+		_stats[sid].values.reserve(_config.benchmarkFrames);
+	}
+	// Frame timings are provided by the profiler.
+	Profiler::manager().setEnabled(true);
+	Log::Info() << "[Benchmark] Measuring " << _config.benchmarkFrames << " frames after " << _config.benchmarkWarmup << " warmup frames." << std::endl;
+}
+
+void Benchmark::update(Camera & camera) {
+	if(_finished) {
+		return;
+	}
+	if(_frame == 0) {
+		setupPath(camera);
+	}
+	const size_t warmup = _config.benchmarkWarmup;
+	const size_t count	= std::max(_config.benchmarkFrames, size_t(1));
+
+	// GPU metrics are available for the previous frame.
+	if(_frame > warmup && _frame <= warmup + count) {
+		const GLUtilities::Metrics & metrics = GLUtilities::getMetrics();
+		_stats[DRAW_CALLS].values.push_back(double(metrics.drawCalls));
+		_stats[TRIANGLES].values.push_back(double(metrics.triangles));
+		_stats[QUAD_CALLS].values.push_back(double(metrics.quadCalls));
+		_stats[STATE_CHANGES].values.push_back(double(metrics.stateChanges));
+		_stats[TEXTURE_BINDINGS].values.push_back(double(metrics.textureBindings));
+		_stats[FRAMEBUFFER_BINDINGS].values.push_back(double(metrics.framebufferBindings));
+		_stats[BUFFER_BINDINGS].values.push_back(double(metrics.bufferBindings));
+		_stats[VERTEX_BINDINGS].values.push_back(double(metrics.vertexBindings));
+		_stats[PROGRAM_BINDINGS].values.push_back(double(metrics.programBindings));
+		_stats[CLEAR_AND_BLITS].values.push_back(double(metrics.clearAndBlits));
+		_stats[UPLOADS].values.push_back(double(metrics.uploads));
+		_stats[DOWNLOADS].values.push_back(double(metrics.downloads));
+		_stats[UNIFORMS].values.push_back(double(metrics.uniforms));
+		_stats[FRAMEBUFFER_MEMORY].values.push_back(double(Framebuffer::allocatedMemory()) / 1048576.0);
+	}
+
+	// Timings are retrieved by the profiler a few frames later.
+	const Profiler & profiler = Profiler::manager();
+	if(_frame == warmup) {
+		_firstId   = profiler.frameId();
+		_measuring = true;
+	}
+	const Profiler::Frame & last = profiler.lastFrame();
+	if(_measuring && last.id != _lastId && last.id >= _firstId && _measured < count) {
+		_lastId = last.id;
+		++_measured;
+		_stats[CPU_TIME].values.push_back(double(last.cpuDuration) * 1e-6);
+		if(last.gpuValid) {
+			_stats[GPU_TIME].values.push_back(double(last.gpuDuration) * 1e-6);
+		}
+	}
+
+	// Stop once all measurements are retrieved, or if the profiler doesn't provide them in time.
+	if(_frame > warmup + count && (_measured == count || _frame > warmup + 2 * count + 16)) {
+		if(_measured < count) {
+			Log::Warning() << "[Benchmark] Only " << _measured << " frame timings could be retrieved." << std::endl;
+		}
+		save();
+		_finished	 = true;
+		_config.quit = true;
+		return;
+	}
+
+	// Pose the camera, staying at the start of the path during warmup.
+	const float t = count > 1 ? float(std::min(_frame - std::min(_frame, warmup), count - 1)) / float(count - 1) : 0.0f;
+	const Keyframe pose = evaluate(t);
+	camera.pose(pose.position, pose.center, pose.up);
+	++_frame;
+}
+
+void Benchmark::setupPath(const Camera & camera) {
+	_path.clear();
+	if(!_config.benchmarkPath.empty()) {
+		const std::string content = Resources::loadStringFromExternalFile(_config.benchmarkPath);
+		const std::vector<KeyValues> params = Codable::decode(content);
+		for(const KeyValues & param : params) {
+			if(param.key != "keyframe") {
+				continue;
+			}
+			Keyframe key = {camera.position(), camera.center(), camera.up()};
+			for(const KeyValues & elem : param.elements) {
+				if(elem.key == "position") {
+					key.position = Codable::decodeVec3(elem);
+				} else if(elem.key == "center") {
+					key.center = Codable::decodeVec3(elem);
+				} else if(elem.key == "up") {
+					key.up = Codable::decodeVec3(elem);
+				}
+			}
+			_path.push_back(key);
+		}
+		if(_path.empty()) {
+			Log::Warning() << "[Benchmark] No keyframe found in \"" << _config.benchmarkPath << "\", orbiting instead." << std::endl;
+		}
+	}
+	if(!_path.empty()) {
+		return;
+	}
+	// Orbit once around the initial view center.
+	const uint steps		= 32;
+	const glm::vec3 up		= camera.up();
+	const glm::vec3 center	= camera.center();
+	const glm::vec3 offset	= camera.position() - center;
+	for(uint sid = 0; sid <= steps; ++sid) {
+		const float angle = float(sid) / float(steps) * glm::two_pi<float>();
+		const glm::vec3 rotated = glm::vec3(glm::rotate(glm::mat4(1.0f), angle, up) * glm::vec4(offset, 0.0f));
+		_path.push_back({center + rotated, center, up});
+	}
+}
+
+Benchmark::Keyframe Benchmark::evaluate(float t) const {
+	if(_path.size() == 1) {
+		return _path[0];
+	}
+	const float x	 = glm::clamp(t, 0.0f, 1.0f) * float(_path.size() - 1);
+	const size_t id	 = std::min(size_t(x), _path.size() - 2);
+	const float a	 = x - float(id);
+	const Keyframe & k0 = _path[id];
+	const Keyframe & k1 = _path[id + 1];
+	Keyframe res;
+	res.position = glm::mix(k0.position, k1.position, a);
+	res.center	 = glm::mix(k0.center, k1.center, a);
+	res.up		 = glm::normalize(glm::mix(k0.up, k1.up, a));
+	return res;
+}
+
+void Benchmark::save() const {
+	std::stringstream csv;
+	std::stringstream json;
+	csv << "statistic,samples,mean,min,p50,p95,p99,max\n";
+	json << "{\n\t\"frames\": " << _config.benchmarkFrames << ",\n\t\"warmup\": " << _config.benchmarkWarmup << ",\n\t\"statistics\": {";
+
+	bool first = true;
+	for(const Statistic & stat : _stats) {
+		if(stat.values.empty()) {
+			continue;
+		}
+		std::vector<double> sorted = stat.values;
+		std::sort(sorted.begin(), sorted.end());
+		double mean = 0.0;
+		for(const double value : sorted) {
+			mean += value;
+		}
+		mean /= double(sorted.size());
+		// Nearest-rank percentiles.
+		const auto percentile = [&sorted](double p) {
+			const size_t rank = size_t(std::ceil(p * double(sorted.size())));
+			return sorted[std::min(std::max(rank, size_t(1)), sorted.size()) - 1];
+		};
+		const double p50 = percentile(0.50);
+		const double p95 = percentile(0.95);
+		const double p99 = percentile(0.99);
+
+		csv << stat.name << "," << sorted.size() << "," << mean << "," << sorted.front() << "," << p50 << "," << p95 << "," << p99 << "," << sorted.back() << "\n";
+		json << (first ? "" : ",") << "\n\t\t\"" << stat.name << "\": {";
+		json << "\"samples\": " << sorted.size() << ", \"mean\": " << mean << ", \"min\": " << sorted.front();
+		json << ", \"p50\": " << p50 << ", \"p95\": " << p95 << ", \"p99\": " << p99 << ", \"max\": " << sorted.back() << "}";
+		first = false;
+	}
+	json << "\n\t}\n}\n";
+
+	Resources::saveStringToExternalFile(_config.benchmarkOutput + ".csv", csv.str());
+	Resources::saveStringToExternalFile(_config.benchmarkOutput + ".json", json.str());
+	Log::Info() << "[Benchmark] Results saved to \"" << _config.benchmarkOutput << ".csv/.json\"." << std::endl;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "system/Config.hpp"
+#include "Common.hpp"
+
+class Camera;
+
+/**
+ \brief Drive a camera along a fixed path for a given number of frames, while collecting frame timings and GPU metrics.
+ \details After a warmup period, the camera is moved along the path so that the same views are rendered at the same frames for each run. Once all measured frames have been retrieved, percentiles for each statistic are saved as CSV and JSON, and the application is asked to quit.
+ The camera path is a Codable file containing a list of keyframes, linearly interpolated:
+ \verbatim
+ * keyframe:
+	position: X,Y,Z
+	center: X,Y,Z
+	up: X,Y,Z
+ ...
+ \endverbatim
+ If no path is provided, the camera orbits once around the center of its initial view.
+ \ingroup System
+ */
+class Benchmark {
+public:
+
+	/** Constructor.
+	 \param config the configuration containing the benchmark settings, will be notified when the benchmark ends
+	 */
+	explicit Benchmark(RenderingConfig & config);
+
+	/** Record the statistics of completed frames and pose the camera for the current frame.
+	 \param camera the camera to move along the path
+	 */
+	void update(Camera & camera);
+
+	/** \return true if all measurements have been performed */
+	bool finished() const { return _finished; }
+
+	/** Copy constructor.*/
+	Benchmark(const Benchmark &) = delete;
+
+	/** Copy assignment.
+	 \return a reference to the object assigned to
+	 */
+	Benchmark & operator=(const Benchmark &) = delete;
+
+	/** Move constructor.*/
+	Benchmark(Benchmark &&) = delete;
+
+	/** Move assignment.
+	 \return a reference to the object assigned to
+	 */
+	Benchmark & operator=(Benchmark &&) = delete;
+
+	/** Destructor. */
+	~Benchmark() = default;
+
+private:
+
+	/** \brief A camera pose along the path. */
+	struct Keyframe {
+		glm::vec3 position; ///< Camera position.
+		glm::vec3 center; ///< Camera target.
+		glm::vec3 up; ///< Camera up vector.
+	};
+
+	/** \brief A series of per-frame measurements. */
+	struct Statistic {
+		std::string name; ///< Statistic name.
+		std::vector<double> values; ///< Per-frame values.
+	};
+
+	/** Load the camera path, or generate an orbit around the camera initial view.
+	 \param camera the camera in its initial pose
+	 */
+	void setupPath(const Camera & camera);
+
+	/** Evaluate the camera pose along the path.
+	 \param t the position along the path, in [0,1]
+	 \return the interpolated pose
+	 */
+	Keyframe evaluate(float t) const;
+
+	/** Save percentiles of all statistics to disk. */
+	void save() const;
+
+	RenderingConfig & _config; ///< The application configuration.
+	std::vector<Keyframe> _path; ///< Camera keyframes.
+	std::vector<Statistic> _stats; ///< Measured statistics.
+	size_t _frame = 0; ///< Number of frames started.
+	uint64_t _firstId = 0; ///< Profiler identifier of the first measured frame.
+	uint64_t _lastId = 0; ///< Profiler identifier of the last retrieved frame.
+	size_t _measured = 0; ///< Number of measured frames retrieved.
+	bool _measuring = false; ///< Has the measurement period begun.
+	bool _finished = false; ///< Have all measurements been retrieved.
+};
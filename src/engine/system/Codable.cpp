@@ -4,6 +4,7 @@
 
 #include <map>
 #include <sstream>
+#include <cstring>
 
 bool Codable::decodeBool(const KeyValues & param, unsigned int position) {
 	if(param.values.size() < position + 1) {
@@ -160,87 +161,141 @@ KeyValues Codable::encode(const Texture * texture){
 		{"rgb32cube", {Layout::RGB32F, Filter::LINEAR_LINEAR, Wrap::CLAMP}},
 	};
 	KeyValues token("rgb");
-	if(texture->gpu){
-		for(const auto & desc : descriptors){
-			if(texture->gpu->descriptor() == desc.second){
-				token.key = desc.first;
-				break;
-			}
+	// Use the layout stored on the texture, as its GPU data might have been evicted.
+	for(const auto & desc : descriptors){
+		if(texture->descriptor() == desc.second){
+			token.key = desc.first;
+			break;
 		}
 	}
 	token.values = {texture->name()};
 	return token;
 }
 
+/** \brief A range of characters in a string, used to tokenize text without copies. */
+struct CharRange {
+	const char * begin; ///< First character.
+	const char * end; ///< Past-the-end character.
+
+	/** \return true if the range is empty */
+	bool empty() const { return begin >= end; }
+
+	/** \return a string copy of the range */
+	std::string str() const { return std::string(begin, end); }
+};
+
+/** Check if a character belongs to a list of characters.
+ \param c the character to test
+ \param chars the null-terminated list of characters
+ \return true if the character is in the list
+ */
+static bool isAnyOf(char c, const char * chars) {
+	for(; *chars != '\0'; ++chars) {
+		if(c == *chars) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Remove characters at the beginning and the end of a range.
+ \param range the range to trim
+ \param chars the null-terminated list of characters to remove
+ \return the trimmed range
+ */
+static CharRange trimRange(CharRange range, const char * chars) {
+	while(range.begin < range.end && isAnyOf(*range.begin, chars)) {
+		++range.begin;
+	}
+	while(range.end > range.begin && isAnyOf(*(range.end - 1), chars)) {
+		--range.end;
+	}
+	return range;
+}
+
 std::vector<KeyValues> Codable::decode(const std::string & codableFile) {
-	std::vector<KeyValues> rawTokens;
-	std::stringstream sstr(codableFile);
-	std::string line;
+	/** Token with its optional prefix ('*' or '-'). */
+	struct RawToken {
+		KeyValues token; ///< The token.
+		char prefix; ///< The prefix character, or '\0'.
+	};
+	std::vector<RawToken> rawTokens;
+
+	const char * const fileEnd = codableFile.data() + codableFile.size();
+	const char * lineStart = codableFile.data();
 
 	// First, get a list of flat tokens, cleaned up, splitting them when there are multiple on the same line.
-	while(std::getline(sstr, line)) {
-		// Check if the line contains a comment, remove everything after.
-		const std::string::size_type hashPos = line.find('#');
-		if(hashPos != std::string::npos) {
-			line = line.substr(0, hashPos);
-		}
+	while(lineStart < fileEnd) {
+		const char * lineEnd = std::find(lineStart, fileEnd, '\n');
+		const char * nextLine = (lineEnd == fileEnd) ? fileEnd : (lineEnd + 1);
+		// Check if the line contains a comment, ignore everything after.
+		lineEnd = std::find(lineStart, lineEnd, '#');
 		// Cleanup.
-		line = TextUtilities::trim(line, " \t\r");
+		const CharRange line = trimRange({lineStart, lineEnd}, " \t\r");
+		lineStart = nextLine;
 		if(line.empty()) {
 			continue;
 		}
 
 		// Find the first colon.
-		const std::string::size_type firstColon = line.find(':');
+		const char * firstColon = std::find(line.begin, line.end, ':');
 		// If no colon, ignore the line.
-		if(firstColon == std::string::npos) {
+		if(firstColon == line.end) {
 			Log::Warning() << "Line with no colon encountered while parsing file. Skipping line." << std::endl;
 			continue;
 		}
 
+		// Create the base token, extracting its prefix if any.
+		CharRange key = trimRange({line.begin, firstColon}, " \t");
+		char prefix = '\0';
+		if(!key.empty() && (*key.begin == '*' || *key.begin == '-')) {
+			prefix = *key.begin;
+			key = trimRange({key.begin + 1, key.end}, " \t");
+		}
+		rawTokens.push_back({KeyValues(key.str()), prefix});
+		KeyValues * tok = &rawTokens.back().token;
+
 		// We can have multiple colons on the same line, when nesting (a texture for a specific attribute for instance). In that case, store the next element as a child of the current one, recursively.
-		// Create the base token.
-		std::string key = line.substr(0, firstColon);
-		key				= TextUtilities::trim(key, " \t");
-		rawTokens.emplace_back(key);
-		KeyValues * tok = &rawTokens.back();
-
-		// Then iterate while we are find sub-tokens, denoted by colons.
-		std::string::size_type previousColon = firstColon + 1;
-		std::string::size_type nextColon	 = line.find(':', previousColon);
-		while(nextColon != std::string::npos) {
-			std::string keySub = line.substr(previousColon, nextColon - previousColon);
-			keySub			   = TextUtilities::trim(keySub, " \t");
+		const char * previousColon = firstColon + 1;
+		const char * nextColon = std::find(previousColon, line.end, ':');
+		while(nextColon != line.end) {
+			const CharRange keySub = trimRange({previousColon, nextColon}, " \t");
 			// Store the token as a child of the previous one, and recurse.
 			if(!keySub.empty()) {
-				tok->elements.emplace_back(keySub);
+				tok->elements.emplace_back(keySub.str());
 				tok = &(tok->elements.back());
 			}
 			previousColon = nextColon + 1;
-			nextColon	 = line.find(':', previousColon);
+			nextColon = std::find(previousColon, line.end, ':');
 		}
 
 		// Everything after the last colon are values, separated by either spaces or commas.
 		// Those values belong to the last token created.
-		std::string values = line.substr(previousColon);
-		TextUtilities::replace(values, ",", " ");
-		values = TextUtilities::trim(values, " \t");
-		// Split in value tokens.
-		tok->values = TextUtilities::split(values, " ", true);
-		
+		const char * valueStart = previousColon;
+		while(valueStart < line.end) {
+			// Skip separators.
+			while(valueStart < line.end && isAnyOf(*valueStart, " ,\t")) {
+				++valueStart;
+			}
+			const char * valueEnd = valueStart;
+			while(valueEnd < line.end && !isAnyOf(*valueEnd, " ,\t")) {
+				++valueEnd;
+			}
+			if(valueEnd > valueStart) {
+				tok->values.emplace_back(valueStart, valueEnd);
+			}
+			valueStart = valueEnd;
+		}
 	}
 
 	// Parse the raw tokens and recreate the hierarchy, looking at objets (*) and array elements (-).
 	std::vector<KeyValues> tokens;
 	for(size_t tid = 0; tid < rawTokens.size(); ++tid) {
-		const auto & token = rawTokens[tid];
-		// Tokens here are guaranteed to be non-empty.
+		RawToken & token = rawTokens[tid];
 		// If the token start with a '*' it is a root object.
-		if(token.key[0] == '*') {
-			std::string name = token.key.substr(1);
-			name			 = TextUtilities::trim(name, "\t ");
-			tokens.emplace_back(name);
-			tokens.back().values = token.values;
+		if(token.prefix == '*') {
+			tokens.emplace_back(std::move(token.token.key));
+			tokens.back().values = std::move(token.token.values);
 			continue;
 		}
 		// Can't add tokens if there are no objects.
@@ -249,18 +304,14 @@ std::vector<KeyValues> Codable::decode(const std::string & codableFile) {
 		}
 		// Else, we append to the current object elements list.
 		auto & object = tokens.back();
-		object.elements.push_back(token);
+		object.elements.push_back(std::move(token.token));
 
 		// Array handling: search for tokens with a '-' following the current one.
 		auto & array = object.elements.back();
 		++tid;
-		while(tid < rawTokens.size() && rawTokens[tid].key[0] == '-') {
+		while(tid < rawTokens.size() && rawTokens[tid].prefix == '-') {
 			// Store the element in the array.
-			array.elements.push_back(rawTokens[tid]);
-			// Update the name.
-			std::string name		  = array.elements.back().key;
-			name					  = TextUtilities::trim(name.substr(1), "\t ");
-			array.elements.back().key = name;
+			array.elements.push_back(std::move(rawTokens[tid].token));
 			++tid;
 		}
 		--tid;
@@ -268,6 +319,132 @@ std::vector<KeyValues> Codable::decode(const std::string & codableFile) {
 	return tokens;
 }
 
+/** Magic number identifying compiled binary Codable files. */
+static const char binaryMagic[4] = {'C', 'O', 'D', 'B'};
+
+/** Version of the compiled binary Codable format. */
+static const uint32_t binaryVersion = 1;
+
+/** Append an integer to a binary representation.
+ \param value the integer to append
+ \param data the binary representation
+ */
+static void appendUInt(uint32_t value, std::string & data) {
+	data.append(reinterpret_cast<const char *>(&value), sizeof(uint32_t));
+}
+
+/** Append a length-prefixed string to a binary representation.
+ \param str the string to append
+ \param data the binary representation
+ */
+static void appendString(const std::string & str, std::string & data) {
+	appendUInt(uint32_t(str.size()), data);
+	data.append(str);
+}
+
+/** Read an integer from a binary representation.
+ \param data the current position, will be advanced
+ \param end the end of the binary representation
+ \param value will contain the integer
+ \return true if the integer was read
+ */
+static bool readUInt(const char * & data, const char * end, uint32_t & value) {
+	if(end - data < std::ptrdiff_t(sizeof(uint32_t))) {
+		return false;
+	}
+	std::memcpy(&value, data, sizeof(uint32_t));
+	data += sizeof(uint32_t);
+	return true;
+}
+
+/** Read a length-prefixed string from a binary representation.
+ \param data the current position, will be advanced
+ \param end the end of the binary representation
+ \param str will contain the string
+ \return true if the string was read
+ */
+static bool readString(const char * & data, const char * end, std::string & str) {
+	uint32_t size = 0;
+	if(!readUInt(data, end, size) || (end - data) < std::ptrdiff_t(size)) {
+		return false;
+	}
+	str.assign(data, size);
+	data += size;
+	return true;
+}
+
+std::string Codable::encodeBinary(const std::vector<KeyValues> & params) {
+	std::string data(binaryMagic, sizeof(binaryMagic));
+	appendUInt(binaryVersion, data);
+	encodeBinary(params, data);
+	return data;
+}
+
+void Codable::encodeBinary(const std::vector<KeyValues> & params, std::string & data) {
+	appendUInt(uint32_t(params.size()), data);
+	for(const KeyValues & param : params) {
+		appendString(param.key, data);
+		appendUInt(uint32_t(param.values.size()), data);
+		for(const std::string & value : param.values) {
+			appendString(value, data);
+		}
+		encodeBinary(param.elements, data);
+	}
+}
+
+bool Codable::decodeBinary(const std::string & data, std::vector<KeyValues> & tokens) {
+	tokens.clear();
+	const char * current = data.data();
+	const char * end = current + data.size();
+	uint32_t version = 0;
+	if(data.size() < sizeof(binaryMagic) || std::memcmp(current, binaryMagic, sizeof(binaryMagic)) != 0) {
+		Log::Error() << "Unrecognized binary Codable content." << std::endl;
+		return false;
+	}
+	current += sizeof(binaryMagic);
+	if(!readUInt(current, end, version) || version != binaryVersion) {
+		Log::Error() << "Unsupported binary Codable version " << version << "." << std::endl;
+		return false;
+	}
+	if(!decodeBinary(current, end, tokens)) {
+		Log::Error() << "Truncated binary Codable content." << std::endl;
+		tokens.clear();
+		return false;
+	}
+	return true;
+}
+
+bool Codable::decodeBinary(const char * & data, const char * end, std::vector<KeyValues> & params) {
+	uint32_t count = 0;
+	// Each tuple takes at least three sizes.
+	if(!readUInt(data, end, count) || (end - data) < std::ptrdiff_t(count) * std::ptrdiff_t(3 * sizeof(uint32_t))) {
+		return false;
+	}
+	params.reserve(count);
+	for(uint32_t pid = 0; pid < count; ++pid) {
+		params.emplace_back("");
+		KeyValues & param = params.back();
+		uint32_t valuesCount = 0;
+		if(!readString(data, end, param.key) || !readUInt(data, end, valuesCount)) {
+			return false;
+		}
+		// Each value takes at least its size.
+		if(end - data < std::ptrdiff_t(valuesCount) * std::ptrdiff_t(sizeof(uint32_t))) {
+			return false;
+		}
+		param.values.resize(valuesCount);
+		for(std::string & value : param.values) {
+			if(!readString(data, end, value)) {
+				return false;
+			}
+		}
+		if(!decodeBinary(data, end, param.elements)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 std::string Codable::encode(const std::vector<KeyValues> & params, Prefix prefix, uint level) {
 	std::stringstream str;
 	static const std::map<Prefix, std::string> prefixes = {
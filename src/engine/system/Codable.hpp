@@ -106,8 +106,22 @@ public:
 	 - elements can be nested on the same line: 'elem1: elem2: values'
 	 \param codableFile the text content to parse
 	 \return a hierarchical list of (key, value) tokens
+	 \note The text is tokenized in place, only the final keys and values are copied.
 	 */
 	static std::vector<KeyValues> decode(const std::string & codableFile);
+
+	/** Decode a hierarchical list of (key,values) tuples from its compiled binary representation (see encodeBinary).
+	 \param data the binary content to parse
+	 \param tokens will contain the hierarchical list of (key, value) tokens
+	 \return true if the content was successfully decoded
+	 */
+	static bool decodeBinary(const std::string & data, std::vector<KeyValues> & tokens);
+
+	/** Generate a compiled binary representation of a hierarchical list of (key,values) tuples, faster to decode than the text representation.
+	 \param params a hierarchical list of (key, value) tokens
+	 \return the binary representation
+	 */
+	static std::string encodeBinary(const std::vector<KeyValues> & params);
 	
 	/** Generate a Codable-compatible text representation from a hierarchical list of (key,values) tuples. The following rules are applied:
 	 - elements beginning with a '*' denote root-level objects.
@@ -132,6 +146,20 @@ private:
 		NONE ///< No prefix.
 	};
 	
+	/** Append the binary representation of a list of (key,values) tuples to a string, recursively.
+	 \param params the tuples to encode
+	 \param data the binary representation to append to
+	 */
+	static void encodeBinary(const std::vector<KeyValues> & params, std::string & data);
+
+	/** Decode a list of (key,values) tuples from a binary representation, recursively.
+	 \param data the current position in the binary content, will be advanced
+	 \param end the end of the binary content
+	 \param params will contain the decoded tuples
+	 \return true if the content was successfully decoded
+	 */
+	static bool decodeBinary(const char * & data, const char * end, std::vector<KeyValues> & params);
+
 	/** Generate a Codable-compatible text representation from a hierarchical list of (key,values) tuples.
 	 \param params a hierarchical list of (key, value) tokens
 	 \param prefix the type of prefix character to use (\see Prefix)
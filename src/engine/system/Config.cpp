@@ -216,8 +216,30 @@ RenderingConfig::RenderingConfig(const std::vector<std::string> & argv) :
 			resourcesPath = values[0];
 		} else if(arg.key == "nodebug") {
 			trackDebug = false;
+		} else if(key == "headless") {
+			headless = true;
+		} else if(key == "software") {
+			softwareContext = true;
+		} else if(key == "program-cache" && !values.empty()) {
+			programCache = values[0];
+		} else if(key == "no-program-cache") {
+			programCache = "";
+		} else if(key == "memory-budget" && !values.empty()) {
+			memoryBudget = size_t(std::max(std::stoi(values[0]), 0));
+		} else if(key == "benchmark" && !values.empty()) {
+			benchmarkFrames = size_t(std::max(std::stoi(values[0]), 0));
+		} else if(key == "benchmark-warmup" && !values.empty()) {
+			benchmarkWarmup = size_t(std::max(std::stoi(values[0]), 0));
+		} else if(key == "benchmark-path" && !values.empty()) {
+			benchmarkPath = values[0];
+		} else if(key == "benchmark-output" && !values.empty()) {
+			benchmarkOutput = values[0];
 		}
 	}
+	// Measurements should not be bound by the display refresh rate.
+	if(benchmarkFrames > 0) {
+		vsync = false;
+	}
 
 	registerSection("Rendering");
 	registerArgument("no-vsync", "", "Disable V-sync.");
@@ -228,6 +250,17 @@ RenderingConfig::RenderingConfig(const std::vector<std::string> & argv) :
 	registerArgument("force-aspect", "far", "Force window aspect ratio.");
 	registerArgument("resources", "", "Additional resources directory", "path");
 	registerArgument("nodebug", "", "Disable resources tracking.");
+	registerArgument("headless", "", "Hide the window.");
+	registerArgument("software", "", "Use a software OpenGL context (OSMesa).");
+	registerArgument("program-cache", "", "Compiled programs cache directory.", "path");
+	registerArgument("no-program-cache", "", "Always compile programs from source.");
+	registerArgument("memory-budget", "", "GPU memory budget for meshes and textures (unlimited by default).", "MB");
+
+	registerSection("Benchmark");
+	registerArgument("benchmark", "", "Render and measure a fixed number of frames, then quit (disables V-sync).", "frames");
+	registerArgument("benchmark-warmup", "", "Number of frames rendered before measuring.", "frames");
+	registerArgument("benchmark-path", "", "Camera keyframes file (orbit around the initial view by default).", "path");
+	registerArgument("benchmark-output", "", "Results path prefix, .csv and .json files are generated.", "path");
 }
 
 glm::vec2 RenderingConfig::renderingResolution(){
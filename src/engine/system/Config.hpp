@@ -158,4 +158,31 @@ public:
 
 	/// Should resource tracking and monitoring be enabled.
 	bool trackDebug = true;
+
+	/// Hide the window, for unattended runs.
+	bool headless = false;
+
+	/// Create a software (OSMesa) context instead of a hardware one.
+	bool softwareContext = false;
+
+	/// Directory storing compiled program binaries between runs (disabled if empty).
+	std::string programCache = "./program-cache";
+
+	/// GPU memory budget for meshes and textures in megabytes, least recently used resources are evicted above it (unlimited if 0).
+	size_t memoryBudget = 0;
+
+	/// Number of frames to measure in benchmark mode (disabled if 0).
+	size_t benchmarkFrames = 0;
+
+	/// Number of frames to render before starting benchmark measurements.
+	size_t benchmarkWarmup = 60;
+
+	/// Camera keyframes file for benchmark mode (orbit around the initial view if empty).
+	std::string benchmarkPath;
+
+	/// Benchmark results path, without extension.
+	std::string benchmarkOutput = "./benchmark";
+
+	/// Request the application to stop at the end of the current frame.
+	bool quit = false;
 };
@@ -3,34 +3,257 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
 #include <glm/gtx/io.hpp>
 
 #ifdef _WIN32
 #	include <io.h>
-#	include <cstdio>
 #else
 #	include <unistd.h>
 #endif
 
-// We statically initialize the default logger.
-// We don't really care about its exact construction/destruction moments,
-// but we want it to always be created.
-Log * Log::_defaultLogger = new Log();
+/** \brief Output destination of one or several loggers. Apart from the verbosity, it is only modified by the writer thread. */
+struct Log::Sink {
+	std::ofstream file;					///< The output log file stream.
+	std::atomic<bool> verbose {false};	///< Should verbose messages be output.
+	bool logToStdOut = true;			///< Should the logs be output to standard output.
+	bool useColors	 = false;			///< Should color formatting be used.
+};
+
+/** \brief A log line, or a request to change the output file of a sink. */
+struct Log::Record {
+	std::shared_ptr<Sink> sink;	///< Destination.
+	std::string text;			///< Formatted line, or path of the new output file.
+	double time	  = 0.0;		///< Time since the logger startup, in seconds.
+	uint32_t thread = 0;		///< Emitting thread index.
+	Level level	  = Level::INFO; ///< Criticality level.
+	bool openFile = false;		///< Is this a request to change the output file.
+};
+
+/** \brief Background thread writing records to their outputs. Records are received through a bounded lock-free multiple-producers single-consumer queue.
+ */
+class Log::Writer {
+public:
+
+	/** Constructor, starts the writer thread. */
+	Writer() : _cells(new Cell[_capacity]) {
+		for(size_t cid = 0; cid < _capacity; ++cid) {
+			_cells[cid].sequence.store(cid, std::memory_order_relaxed);
+		}
+		_start = std::chrono::steady_clock::now();
+		_running.store(true);
+		_thread = std::thread(&Writer::run, this);
+		// Make sure all pending lines are written when the application exits.
+		std::atexit([]() { Writer::shared().stop(); });
+	}
+
+	/** Submit a record for writing. If the queue is full, wait for the writer to catch up.
+	 \param record the record to submit
+	 */
+	void push(Record && record) {
+		record.time	  = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+		record.thread = threadIndex();
+		if(!_running.load(std::memory_order_acquire)) {
+			// After shutdown, write synchronously.
+			std::lock_guard<std::mutex> lock(_mutex);
+			write(record);
+			return;
+		}
+		while(!tryPush(record)) {
+			_wake.notify_one();
+			std::this_thread::yield();
+		}
+		if(_sleeping.load(std::memory_order_relaxed)) {
+			_wake.notify_one();
+		}
+	}
+
+	/** Write all pending records and stop the writer thread. */
+	void stop() {
+		if(!_running.exchange(false)) {
+			return;
+		}
+		_wake.notify_one();
+		if(_thread.joinable()) {
+			_thread.join();
+		}
+		// Records submitted while the thread was exiting.
+		Record record;
+		std::lock_guard<std::mutex> lock(_mutex);
+		while(tryPop(record)) {
+			write(record);
+		}
+		std::cout << std::flush;
+		std::cerr << std::flush;
+	}
+
+	/** \return the shared writer */
+	static Writer & shared() {
+		// Never destroyed, so that loggers can be used during static destruction.
+		static Writer * writer = new Writer();
+		return *writer;
+	}
+
+private:
+
+	/** \brief Queue slot, storing a record and its sequence number. */
+	struct Cell {
+		std::atomic<size_t> sequence; ///< Position in the queue the cell is ready for.
+		Record record; ///< Record data.
+	};
+
+	/** Try to append a record at the end of the queue.
+	 \param record the record to move in the queue
+	 \return false if the queue is full
+	 */
+	bool tryPush(Record & record) {
+		size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+		Cell * cell = nullptr;
+		while(true) {
+			cell = &_cells[pos & (_capacity - 1)];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+			if(diff == 0) {
+				// The cell is free, try to reserve it.
+				if(_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if(diff < 0) {
+				// The cell is still used by the previous round.
+				return false;
+			} else {
+				pos = _enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->record = std::move(record);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Retrieve the record at the front of the queue.
+	 \param record will contain the record
+	 \return false if the queue is empty
+	 */
+	bool tryPop(Record & record) {
+		Cell & cell = _cells[_dequeuePos & (_capacity - 1)];
+		const size_t seq = cell.sequence.load(std::memory_order_acquire);
+		if(seq != _dequeuePos + 1) {
+			return false;
+		}
+		record = std::move(cell.record);
+		cell.record.sink.reset();
+		cell.sequence.store(_dequeuePos + _capacity, std::memory_order_release);
+		++_dequeuePos;
+		return true;
+	}
+
+	/** Writer thread loop. */
+	void run() {
+		Record record;
+		while(true) {
+			bool wrote = false;
+			while(tryPop(record)) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				write(record);
+				wrote = true;
+			}
+			if(wrote) {
+				std::cout << std::flush;
+				std::cerr << std::flush;
+				continue;
+			}
+			if(!_running.load(std::memory_order_acquire)) {
+				// Producers might still be finishing a push.
+				if(_enqueuePos.load() == _dequeuePos) {
+					break;
+				}
+				std::this_thread::yield();
+				continue;
+			}
+			// Wait for new records. Producers only notify when we are asleep, the timeout covers missed notifications.
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_sleeping.store(true);
+			_wake.wait_for(lock, std::chrono::milliseconds(10));
+			_sleeping.store(false);
+		}
+	}
+
+	/** Output a record.
+	 \param record the record to write
+	 */
+	void write(const Record & record) {
+		static const std::vector<std::string> colorStrings = {"\x1B[0m\x1B[39m", "\x1B[0m\x1B[33m", "\x1B[0m\x1B[31m", "\x1B[2m\x1B[37m"};
+		Sink & sink = *record.sink;
+
+		if(record.openFile) {
+			if(sink.file.is_open()) {
+				sink.file.close();
+			}
+			sink.file.open(record.text, std::ofstream::app);
+			if(sink.file.is_open()) {
+				sink.file << "-- New session - " << time(nullptr) << " -------------------------------" << std::endl;
+				sink.useColors = false;
+			} else {
+				std::cerr << "[Logger] Unable to create log file at path " << record.text << "." << std::endl;
+			}
+			return;
+		}
+
+		if(sink.logToStdOut) {
+			std::ostream & out = (record.level == Level::INFO || record.level == Level::VERBOSE) ? std::cout : std::cerr;
+			if(sink.useColors) {
+				out << colorStrings[int(record.level)];
+			}
+			out << record.text;
+		}
+		if(sink.file.is_open()) {
+			char prefix[32];
+			std::snprintf(prefix, sizeof(prefix), "[%10.6f][T%u] ", record.time, record.thread);
+			sink.file << prefix << record.text << std::flush;
+		}
+	}
+
+	/** \return a small index identifying the calling thread */
+	static uint32_t threadIndex() {
+		static std::atomic<uint32_t> counter(0);
+		thread_local const uint32_t index = counter.fetch_add(1);
+		return index;
+	}
+
+	static const size_t _capacity = 1024; ///< Maximum number of pending records, power of two.
+	std::unique_ptr<Cell[]> _cells; ///< Queue storage.
+	std::atomic<size_t> _enqueuePos {0}; ///< Next position to write to.
+	size_t _dequeuePos = 0; ///< Next position to read from, only used by the writer thread.
+
+	std::thread _thread; ///< Writer thread.
+	std::mutex _mutex; ///< Serialize outputs after shutdown.
+	std::mutex _sleepMutex; ///< Mutex for the writer wait.
+	std::condition_variable _wake; ///< Notify the writer that records are available.
+	std::atomic<bool> _running {false}; ///< Is the writer thread running.
+	std::atomic<bool> _sleeping {false}; ///< Is the writer thread waiting.
+	std::chrono::time_point<std::chrono::steady_clock> _start; ///< Logger startup time.
+};
 
 void Log::set(Level l) {
 	_level		  = l;
 	_appendPrefix = true;
-	if(_level == Level::VERBOSE && !_verbose) {
+	if(_level == Level::VERBOSE && !_sink->verbose.load(std::memory_order_relaxed)) {
 		// In this case, we want to ignore until the next flush.
 		_ignoreUntilFlush = true;
 		_appendPrefix	 = false;
 	}
 }
 
-Log::Log() {
+Log::Log() : _sink(std::make_shared<Sink>()) {
 
-	// Setup glm objects delimiters.
-	_stream << glm::io::delimeter<char>('(', ')', ',');
+	setupStream();
 
 	// Check if the output is indeed a terminal, and not piped.
 #ifdef _WIN32
@@ -48,7 +271,7 @@ Log::Log() {
 		const std::string term(env_p);
 		for(const auto & possibleTerm : terms) {
 			if(term == possibleTerm) {
-				_useColors = true;
+				_sink->useColors = true;
 				break;
 			}
 		}
@@ -56,12 +279,22 @@ Log::Log() {
 }
 
 Log::Log(const std::string & filePath, bool logToStdin, bool verbose) :
-	_logToStdOut(logToStdin), _verbose(verbose) {
+	_sink(std::make_shared<Sink>()) {
+	_sink->logToStdOut = logToStdin;
+	_sink->verbose.store(verbose);
+	setupStream();
+	// Create file if it doesnt exist.
+	setFile(filePath, false);
+}
 
+Log::Log(const std::shared_ptr<Sink> & sink) :
+	_sink(sink) {
+	setupStream();
+}
+
+void Log::setupStream() {
 	// Setup glm objects delimiters.
 	_stream << glm::io::delimeter<char>('(', ')', ',');
-	// Create file if it doesnt exist.
-	setFile(filePath, false);
 }
 
 void Log::setFile(const std::string & filePath, bool flushExisting) {
@@ -69,64 +302,68 @@ void Log::setFile(const std::string & filePath, bool flushExisting) {
 		_stream << std::endl;
 		flush();
 	}
-	if(_file.is_open()) {
-		_file.close();
-	}
-	_file.open(filePath, std::ofstream::app);
-	if(_file.is_open()) {
-		_file << "-- New session - " << time(nullptr) << " -------------------------------" << std::endl;
-		_useColors = false;
-	} else {
-		std::cerr << "[Logger] Unable to create log file at path " << filePath << "." << std::endl;
-	}
+	// The file is opened by the writer thread, after all previous lines have been written.
+	Record record;
+	record.sink		= _sink;
+	record.text		= filePath;
+	record.openFile = true;
+	Writer::shared().push(std::move(record));
 }
 
 void Log::setVerbose(bool verbose) {
-	_verbose = verbose;
+	_sink->verbose.store(verbose);
+}
+
+const std::shared_ptr<Log::Sink> & Log::defaultSink() {
+	// Never destroyed, so that loggers can be used during static destruction.
+	static std::shared_ptr<Sink> * sink = new std::shared_ptr<Sink>(Log()._sink);
+	return *sink;
+}
+
+Log & Log::defaultLogger() {
+	thread_local Log logger(defaultSink());
+	return logger;
 }
 
 void Log::setDefaultFile(const std::string & filePath) {
-	_defaultLogger->setFile(filePath);
+	defaultLogger().setFile(filePath);
 }
 
 void Log::setDefaultVerbose(bool verbose) {
-	_defaultLogger->setVerbose(verbose);
+	defaultLogger().setVerbose(verbose);
 }
 
 Log & Log::Info() {
-	_defaultLogger->set(Level::INFO);
-	return *_defaultLogger;
+	Log & logger = defaultLogger();
+	logger.set(Level::INFO);
+	return logger;
 }
 
 Log & Log::Warning() {
-	_defaultLogger->set(Level::WARNING);
-	return *_defaultLogger;
+	Log & logger = defaultLogger();
+	logger.set(Level::WARNING);
+	return logger;
 }
 
 Log & Log::Error() {
-	_defaultLogger->set(Level::ERROR);
-	return *_defaultLogger;
+	Log & logger = defaultLogger();
+	logger.set(Level::ERROR);
+	return logger;
 }
 
 Log & Log::Verbose() {
-	_defaultLogger->set(Level::VERBOSE);
-	return *_defaultLogger;
+	Log & logger = defaultLogger();
+	logger.set(Level::VERBOSE);
+	return logger;
 }
 
 void Log::flush() {
 	if(!_ignoreUntilFlush) {
-		const std::string finalStr = _stream.str();
-
-		if(_logToStdOut) {
-			if(_level == Level::INFO || _level == Level::VERBOSE) {
-				std::cout << finalStr << std::flush;
-			} else {
-				std::cerr << finalStr << std::flush;
-			}
-		}
-		if(_file.is_open()) {
-			_file << finalStr << std::flush;
-		}
+		Record record;
+		record.sink	 = _sink;
+		record.text	 = _stream.str();
+		record.level = _level;
+		Writer::shared().push(std::move(record));
 	}
 	_ignoreUntilFlush = false;
 	_appendPrefix	 = false;
@@ -138,18 +375,12 @@ void Log::flush() {
 void Log::appendIfNeeded() {
 	if(_appendPrefix) {
 		_appendPrefix = false;
-		if(_useColors) {
-			_stream << _colorStrings[int(_level)];
-		}
 		_stream << _levelStrings[int(_level)];
 	}
 }
 
 Log & Log::operator<<(const Domain & domain) {
 
-	if(_appendPrefix && _useColors) {
-		_stream << _colorStrings[int(_level)];
-	}
 	_stream << "[" << _domainStrings[domain] << "] ";
 
 	if(_appendPrefix) {
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <memory>
 
 // Fix for Windows headers.
 #ifdef ERROR
@@ -12,6 +13,7 @@
 
 /**
  \brief Provides logging utilities, either to the standard/error output or to a file, with multiple criticality levels.
+ \details Each thread formats messages in its own logger. Completed lines are timestamped, tagged with the emitting thread and pushed to a bounded lock-free queue, from which a background thread writes them to their outputs. This ensures that logging from parallel tasks is cheap and that lines are never interleaved.
  \ingroup System
  */
 class Log {
@@ -45,7 +47,14 @@ private:
 
 	const std::vector<std::string> _levelStrings = {"", "(!) ", "(X) ", ""}; ///< Levels prefix strings.
 
-	const std::vector<std::string> _colorStrings = {"\x1B[0m\x1B[39m", "\x1B[0m\x1B[33m", "\x1B[0m\x1B[31m", "\x1B[2m\x1B[37m"}; ///< Colors prefix strings.
+	struct Sink;
+	struct Record;
+	class Writer;
+
+	/** Constructor, sharing an existing output.
+	 \param sink the output to write to
+	 */
+	explicit Log(const std::shared_ptr<Sink> & sink);
 
 public:
 	/** Default constructor, will use standard output */
@@ -93,7 +102,27 @@ public:
 	 */
 	Log & operator<<(std::ios_base & (*modif)(std::ios_base &));
 
+	/** Destructor. */
+	~Log() = default;
+
+	/** Copy constructor.*/
+	Log(const Log &) = delete;
+
+	/** Copy assignment.
+	 \return a reference to the object assigned to
+	 */
+	Log & operator=(const Log &) = delete;
+
+	/** Move constructor.*/
+	Log(Log &&) = delete;
+
+	/** Move assignment.
+	 \return a reference to the object assigned to
+	 */
+	Log & operator=(Log &&) = delete;
+
 	/** \name Default logger
+	 \note Each thread uses its own default logger, all writing to the same output.
 	 @{ */
 
 	/** Set the default logger output file.
@@ -135,7 +164,7 @@ private:
 	 */
 	void setFile(const std::string & filePath, bool flushExisting = true);
 
-	/** Flush the log stream.
+	/** Send the current line to the writer thread.
 	 */
 	void flush();
 
@@ -143,14 +172,18 @@ private:
 	 */
 	void appendIfNeeded();
 
+	/** Setup the stream formatting options. */
+	void setupStream();
+
+	/** \return the default logger of the calling thread */
+	static Log & defaultLogger();
+
+	/** \return the output shared by all default loggers */
+	static const std::shared_ptr<Sink> & defaultSink();
+
 	Level _level	  = Level::INFO; ///< The current criticality level.
-	bool _logToStdOut = true;		 ///< Should the logs be output to standard output.
-	std::ofstream _file;			 ///< The output log file stream.
+	std::shared_ptr<Sink> _sink;	 ///< The output shared with the writer thread.
 	std::stringstream _stream;		 ///< Internal log string stream.
-	bool _verbose		   = false;  ///< Is the logger verbose.
 	bool _ignoreUntilFlush = false;  ///< Internal flag to ignore the current line if it is verbose.
 	bool _appendPrefix	 = false;  ///< Should a domain or level prefix be appended to the current line.
-	bool _useColors		   = false;  ///< Should color formatting be used.
-
-	static Log * _defaultLogger; ///< Default static logger.
 };
@@ -4,9 +4,8 @@
 
 #include <GLFW/glfw3.h>
 
-#ifndef _WIN32
-#	include <sys/stat.h>
-#endif
+#include <sys/types.h>
+#include <sys/stat.h>
 
 
 
@@ -50,12 +49,28 @@ bool System::createDirectory(const std::string & directory) {
 	return CreateDirectoryW(widen(directory), nullptr) != 0;
 }
 
+uint64_t System::modificationTime(const std::string & path) {
+	struct _stat64 infos;
+	if(_wstat64(widen(path), &infos) != 0) {
+		return 0;
+	}
+	return uint64_t(infos.st_mtime);
+}
+
 #else
 
 bool System::createDirectory(const std::string & directory) {
 	return mkdir(directory.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) == 0;
 }
 
+uint64_t System::modificationTime(const std::string & path) {
+	struct stat infos;
+	if(stat(path.c_str(), &infos) != 0) {
+		return 0;
+	}
+	return uint64_t(infos.st_mtime);
+}
+
 #endif
 
 void System::ping() {
@@ -35,6 +35,12 @@ public:
 		 */
 	static bool createDirectory(const std::string & directory);
 
+	/** Query the last modification time of a file.
+	 \param path the path to the file
+	 \return the modification time in seconds since the epoch, or 0 if it is unavailable.
+	 */
+	static uint64_t modificationTime(const std::string & path);
+
 	/** Notify the user by sending a 'Bell' signal. */
 	static void ping();
 	
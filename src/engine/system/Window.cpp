@@ -4,6 +4,11 @@
 #include "input/Input.hpp"
 #include "graphics/GLUtilities.hpp"
 #include "graphics/Framebuffer.hpp"
+#include "graphics/Profiler.hpp"
+#include "graphics/AsyncReadback.hpp"
+#include "graphics/FramebufferPool.hpp"
+#include "resources/ResourcesManager.hpp"
+#include "system/System.hpp"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_opengl3.h>
@@ -23,11 +28,16 @@ Window::Window(const std::string & name, RenderingConfig & config, bool convertT
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, openGLMajor);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, openGLMinor);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	// OSMesa does not support forward-compatible contexts.
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, _config.softwareContext ? GL_FALSE : GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_VISIBLE, hidden ? GLFW_FALSE : GLFW_TRUE);
-	glfwWindowHint(GLFW_FOCUSED, hidden ? GLFW_FALSE : GLFW_TRUE);
+	const bool hideWindow = hidden || _config.headless;
+	glfwWindowHint(GLFW_VISIBLE, hideWindow ? GLFW_FALSE : GLFW_TRUE);
+	glfwWindowHint(GLFW_FOCUSED, hideWindow ? GLFW_FALSE : GLFW_TRUE);
 	glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
+	if(_config.softwareContext) {
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+	}
 
 	if(config.fullscreen) {
 		const GLFWvidmode * mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
@@ -54,7 +64,9 @@ Window::Window(const std::string & name, RenderingConfig & config, bool convertT
 	// Bind the OpenGL context and the new window.
 	glfwMakeContextCurrent(_window);
 
-	if(gl3wInit()) {
+	// A software context does not expose its functions through the system GL library.
+	const int gl3wStatus = _config.softwareContext ? gl3wInit2(reinterpret_cast<GL3WGetProcAddressProc>(glfwGetProcAddress)) : gl3wInit();
+	if(gl3wStatus) {
 		Log::Error() << Log::OpenGL << "Failed to initialize OpenGL" << std::endl;
 		return;
 	}
@@ -67,6 +79,9 @@ Window::Window(const std::string & name, RenderingConfig & config, bool convertT
 	// Setup the GPU state.
 	GLUtilities::setup();
 	GLUtilities::setSRGBState(_convertToSRGB);
+	GLUtilities::setupProgramCache(_config.programCache);
+	Resources::manager().setBudget(_config.memoryBudget * 1024 * 1024);
+	_startTime = System::time();
 
 	// Setup callbacks for various interactions and inputs.
 	glfwSetFramebufferSizeCallback(_window, resize_callback);		  // Resizing the window
@@ -158,6 +173,7 @@ void Window::perform(Action action) {
 bool Window::nextFrame() {
 	if(_frameStarted){
 		// Render the interface.
+		Profiler::manager().begin("Interface");
 		ImGui::Render();
 		// ImGui is not sRGB aware, we have to disable linear to
 		// sRGB conversion when writing to the backbuffer.
@@ -166,17 +182,31 @@ bool Window::nextFrame() {
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		// ...and restore.
 		GLUtilities::setSRGBState(_convertToSRGB);
+		Profiler::manager().end();
 		
 		//Display the result for the current rendering loop.
 		glfwSwapBuffers(_window);
+
+		// Report startup time once all programs used by the first frame are ready.
+		if(!_startupLogged) {
+			size_t compiled = 0;
+			size_t cached	= 0;
+			GLUtilities::programStatistics(compiled, cached);
+			Log::Info() << Log::OpenGL << "First frame after " << (System::time() - _startTime) << "s (" << compiled << " program(s) compiled, " << cached << " loaded from cache)." << std::endl;
+			_startupLogged = true;
+		}
 	}
 	// Notify GPU for book-keeping.
 	GLUtilities::nextFrame();
+	Profiler::manager().nextFrame();
+	AsyncReadback::manager().update();
+	FramebufferPool::manager().update();
+	Resources::manager().update();
 
 	// Update events (inputs,...).
 	Input::manager().update();
 	// Handle quitting.
-	if(_allowEscape && Input::manager().pressed(Input::Key::Escape)) {
+	if(_config.quit || (_allowEscape && Input::manager().pressed(Input::Key::Escape))) {
 		perform(Action::Quit);
 	}
 	// Check if the backbuffer was resized.
@@ -199,6 +229,11 @@ Window::~Window() {
 		ImGui::EndFrame();
 	}
 	GLUtilities::sync();
+	// Release profiling queries, readback buffers and transient framebuffers while the context still exists.
+	Profiler::manager().clean();
+	AsyncReadback::manager().clean();
+	Log::Info() << Log::OpenGL << "Framebuffers peak memory: " << (double(Framebuffer::peakMemory()) / 1048576.0) << "MB." << std::endl;
+	FramebufferPool::manager().clean();
 	// Clean the interface.
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
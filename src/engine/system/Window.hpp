@@ -66,4 +66,6 @@ private:
 	bool _frameStarted = false; ///< Has a frame been started.
 	bool _allowEscape = false; ///< Can the window be closed by pressing escape.
 	bool _convertToSRGB = false; ///< Should writes to the backbuffer be considered linear.
+	double _startTime = 0.0; ///< Time at which the context was ready.
+	bool _startupLogged = false; ///< Has the startup time been reported.
 };
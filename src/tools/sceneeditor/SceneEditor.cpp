@@ -1,6 +1,7 @@
 #include "SceneEditor.hpp"
 #include "graphics/GLUtilities.hpp"
 #include "graphics/ScreenQuad.hpp"
+#include "system/System.hpp"
 
 SceneEditor::SceneEditor(RenderingConfig & config) : CameraApp(config) {
 	_passthrough = Resources::manager().getProgram2D("passthrough");
@@ -103,6 +104,12 @@ void SceneEditor::update() {
 			const auto tokens = _scenes[_currentScene]->encode();
 			Log::Info() << Codable::encode(tokens) << std::endl;
 		}
+		ImGui::SameLine();
+		std::string outPath;
+		if(ImGui::Button("Save compiled") && System::showPicker(System::Picker::Save, "", outPath, "scenebin")) {
+			std::string data = Codable::encodeBinary(_scenes[_currentScene]->encode());
+			Resources::saveRawDataToExternalFile(outPath, &data[0], data.size());
+		}
 		ImGui::Separator();
 		ImGui::Checkbox("Pause animations", &_paused);
 		// Camera settings.